@@ -719,6 +719,8 @@ bool DictionaryEntry_Android::isEqual(DictionaryEntryRef inOther) const
             return false;
             break;
     }
+    
+    return false;
 }
 
 }
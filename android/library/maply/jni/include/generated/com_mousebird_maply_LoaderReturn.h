@@ -47,6 +47,22 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_LoaderReturn_getFrame
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LoaderReturn_setGeneration
   (JNIEnv *, jobject, jint);
 
+/*
+ * Class:     com_mousebird_maply_LoaderReturn
+ * Method:    setHasError
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoaderReturn_setHasError
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_LoaderReturn
+ * Method:    setElevationGrid
+ * Signature: ([FII)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoaderReturn_setElevationGrid
+  (JNIEnv *, jobject, jfloatArray, jint, jint);
+
 /*
  * Class:     com_mousebird_maply_LoaderReturn
  * Method:    getGeneration
@@ -31,6 +31,22 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_QuadLoaderBase_getFlipY
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setDebugMode
   (JNIEnv *, jobject, jboolean);
 
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    setMaxFetchesInFlight
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setMaxFetchesInFlight
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_QuadLoaderBase
+ * Method:    getMaxFetchesInFlight
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadLoaderBase_getMaxFetchesInFlight
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_QuadLoaderBase
  * Method:    geoBoundsForTileNative
@@ -89,6 +89,30 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_hasChanges
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setPerfInterval
   (JNIEnv *, jobject, jint);
 
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setChangeBudget
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setChangeBudget
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    setProfilingEnabled
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setProfilingEnabled
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_RenderController
+ * Method:    exportProfile
+ * Signature: (Ljava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_exportProfile
+  (JNIEnv *, jobject, jstring);
+
 /*
  * Class:     com_mousebird_maply_RenderController
  * Method:    addLight
@@ -71,6 +71,38 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setMaxTiles
 JNIEXPORT jint JNICALL Java_com_mousebird_maply_SamplingParams_getMaxTiles
   (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setPrefetchLookAhead
+ * Signature: (D)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setPrefetchLookAhead
+  (JNIEnv *, jobject, jdouble);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getPrefetchLookAhead
+ * Signature: ()D
+ */
+JNIEXPORT jdouble JNICALL Java_com_mousebird_maply_SamplingParams_getPrefetchLookAhead
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setMaxPrefetchTiles
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setMaxPrefetchTiles
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getMaxPrefetchTiles
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_SamplingParams_getMaxPrefetchTiles
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_SamplingParams
  * Method:    setMinImportance
@@ -143,6 +175,22 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setEdgeMatching
 JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getEdgeMatching
   (JNIEnv *, jobject);
 
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    setIncludeElev
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setIncludeElev
+  (JNIEnv *, jobject, jboolean);
+
+/*
+ * Class:     com_mousebird_maply_SamplingParams
+ * Method:    getIncludeElev
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getIncludeElev
+  (JNIEnv *, jobject);
+
 /*
  * Class:     com_mousebird_maply_SamplingParams
  * Method:    setTesselation
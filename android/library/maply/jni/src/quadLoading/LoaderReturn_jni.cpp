@@ -219,6 +219,42 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_LoaderReturn_getGeneration
 	return 0;
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoaderReturn_setHasError
+		(JNIEnv *env, jobject obj, jboolean hasError)
+{
+	try
+	{
+		QuadLoaderReturnRef *loadReturn = LoaderReturnClassInfo::getClassInfo()->getObject(env,obj);
+		if (!loadReturn)
+			return;
+		(*loadReturn)->hasError = hasError;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in LoaderReturn::setHasError()");
+	}
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LoaderReturn_setElevationGrid
+		(JNIEnv *env, jobject obj, jfloatArray elevArray, jint sizeX, jint sizeY)
+{
+	try
+	{
+		QuadLoaderReturnRef *loadReturn = LoaderReturnClassInfo::getClassInfo()->getObject(env,obj);
+		if (!loadReturn || !elevArray || sizeX < 2 || sizeY < 2)
+			return;
+		std::vector<float> elevs;
+		ConvertFloatArray(env,elevArray,elevs);
+		if (elevs.size() != (size_t)(sizeX*sizeY))
+			return;
+		(*loadReturn)->elevChunk = ElevationChunkRef(new ElevationGridChunk(sizeX,sizeY,std::move(elevs)));
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in LoaderReturn::setElevationGrid()");
+	}
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LoaderReturn_addComponentObjects
 		(JNIEnv *env, jobject obj, jobjectArray compObjs, jboolean isOverlay)
 {
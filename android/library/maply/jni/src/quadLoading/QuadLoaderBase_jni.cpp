@@ -121,6 +121,38 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setDebugMode
     }
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_setMaxFetchesInFlight
+        (JNIEnv *env, jobject obj, jint maxFetches)
+{
+    try {
+        QuadImageFrameLoader_AndroidRef *loader = QuadImageFrameLoaderClassInfo::getClassInfo()->getObject(env,obj);
+        if (!loader)
+            return;
+        (*loader)->setMaxFetchesInFlight(maxFetches);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in QuadLoaderBase::setMaxFetchesInFlight()");
+    }
+}
+
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_QuadLoaderBase_getMaxFetchesInFlight
+        (JNIEnv *env, jobject obj)
+{
+    try {
+        QuadImageFrameLoader_AndroidRef *loader = QuadImageFrameLoaderClassInfo::getClassInfo()->getObject(env,obj);
+        if (!loader)
+            return 0;
+        return (*loader)->getMaxFetchesInFlight();
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in QuadLoaderBase::getMaxFetchesInFlight()");
+    }
+
+    return 0;
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_QuadLoaderBase_geoBoundsForTileNative
         (JNIEnv *env, jobject obj, jint tileX, jint tileY, jint tileLevel, jobject llObj, jobject urObj)
 {
@@ -213,6 +213,74 @@ JNIEXPORT jint JNICALL Java_com_mousebird_maply_SamplingParams_getMaxTiles
 	return 0;
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setPrefetchLookAhead
+  (JNIEnv *env, jobject obj, jdouble lookAhead)
+{
+	try
+	{
+		SamplingParams *params = SamplingParamsClassInfo::getClassInfo()->getObject(env,obj);
+		if (!params)
+		    return;
+		params->prefetchLookAhead = lookAhead;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SamplingParams::setPrefetchLookAhead()");
+	}
+}
+
+JNIEXPORT jdouble JNICALL Java_com_mousebird_maply_SamplingParams_getPrefetchLookAhead
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SamplingParams *params = SamplingParamsClassInfo::getClassInfo()->getObject(env,obj);
+		if (!params)
+		    return 0;
+		return params->prefetchLookAhead;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SamplingParams::getPrefetchLookAhead()");
+	}
+
+	return 0;
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setMaxPrefetchTiles
+  (JNIEnv *env, jobject obj, jint maxTiles)
+{
+	try
+	{
+		SamplingParams *params = SamplingParamsClassInfo::getClassInfo()->getObject(env,obj);
+		if (!params)
+		    return;
+		params->maxPrefetchTiles = maxTiles;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SamplingParams::setMaxPrefetchTiles()");
+	}
+}
+
+JNIEXPORT jint JNICALL Java_com_mousebird_maply_SamplingParams_getMaxPrefetchTiles
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SamplingParams *params = SamplingParamsClassInfo::getClassInfo()->getObject(env,obj);
+		if (!params)
+		    return 0;
+		return params->maxPrefetchTiles;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SamplingParams::getMaxPrefetchTiles()");
+	}
+
+	return 0;
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setMinImportance__D
   (JNIEnv *env, jobject obj, jdouble minImport)
 {
@@ -367,6 +435,40 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getEdgeMatchi
 	return false;
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setIncludeElev
+  (JNIEnv *env, jobject obj, jboolean includeElev)
+{
+	try
+	{
+		SamplingParams *params = SamplingParamsClassInfo::getClassInfo()->getObject(env,obj);
+		if (!params)
+		    return;
+		params->includeElev = includeElev;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SamplingParams::setIncludeElev()");
+	}
+}
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_SamplingParams_getIncludeElev
+  (JNIEnv *env, jobject obj)
+{
+	try
+	{
+		SamplingParams *params = SamplingParamsClassInfo::getClassInfo()->getObject(env,obj);
+		if (!params)
+		    return false;
+		return params->includeElev;
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in SamplingParams::getIncludeElev()");
+	}
+
+	return false;
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_SamplingParams_setTesselation
   (JNIEnv *env, jobject obj, jint tessX, jint tessY)
 {
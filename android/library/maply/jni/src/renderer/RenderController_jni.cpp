@@ -23,6 +23,7 @@
 #import "Scene_jni.h"
 #import "View_jni.h"
 #import "com_mousebird_maply_RenderController.h"
+#import "Profiler.h"
 
 using namespace WhirlyKit;
 
@@ -488,6 +489,56 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setPerfInterval
 	}
 }
 
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setChangeBudget
+		(JNIEnv *env, jobject obj, jint budgetMicros)
+{
+	try
+	{
+        SceneRendererGLES_Android *renderer = SceneRendererInfo::getClassInfo()->getObject(env,obj);
+		if (!renderer)
+			return;
+
+		renderer->setChangeBudget(budgetMicros);
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setChangeBudget()");
+	}
+}
+
+JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_setProfilingEnabled
+		(JNIEnv *env, jobject obj, jboolean enable)
+{
+	try
+	{
+		// The profiler is shared by all the renderers
+		Profiler::SetEnabled(enable);
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::setProfilingEnabled()");
+	}
+}
+
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_RenderController_exportProfile
+		(JNIEnv *env, jobject obj, jstring fileNameStr)
+{
+	try
+	{
+		if (!fileNameStr)
+			return false;
+
+		JavaString fileName(env,fileNameStr);
+		return Profiler::ExportChromeTrace(fileName.cStr);
+	}
+	catch (...)
+	{
+		__android_log_print(ANDROID_LOG_VERBOSE, "Maply", "Crash in RenderController::exportProfile()");
+	}
+
+	return false;
+}
+
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RenderController_addLight
 		(JNIEnv *env, jobject obj, jobject lightObj)
 {
@@ -846,6 +846,9 @@ public class BaseController implements RenderController.TaskManager, RenderContr
 
 			// Debugging output
 			renderControl.setPerfInterval(perfInterval);
+			renderControl.setChangeBudget(changeBudget);
+			if (profilingEnabled)
+				renderControl.setProfilingEnabled(true);
 
 			// Kick off the layout layer
 			layoutLayer = new LayoutLayer(this, renderControl.layoutManager);
@@ -1055,6 +1058,48 @@ public class BaseController implements RenderController.TaskManager, RenderContr
 			renderControl.setPerfInterval(perfInterval);
 	}
 
+	int changeBudget = 0;
+	/**
+	 * Limit the time the renderer spends applying changes each frame, in microseconds.
+	 * Whatever is left over waits for the next frame.  Screen space layout goes ahead
+	 * of tile loading.  Setting this to zero turns it off.
+	 * @param budgetMicros
+	 */
+	public void setChangeBudget(int budgetMicros)
+	{
+		changeBudget = budgetMicros;
+		if (renderWrapper != null && renderWrapper.maplyRender != null)
+			renderControl.setChangeBudget(changeBudget);
+	}
+
+	boolean profilingEnabled = false;
+	/**
+	 * Record where the time goes in the renderer and the loading threads.
+	 * Each thread keeps its most recent timings in a small buffer.  Call exportProfile()
+	 * to write them out.  This is shared by all the controllers in the app.
+	 * @param enable
+	 */
+	public void setProfilingEnabled(boolean enable)
+	{
+		profilingEnabled = enable;
+		if (renderWrapper != null && renderWrapper.maplyRender != null)
+			renderControl.setProfilingEnabled(profilingEnabled);
+	}
+
+	/**
+	 * Write out what's been recorded since profiling was turned on.
+	 * The file is a Chrome trace, which can be opened with chrome://tracing or Perfetto.
+	 * @param fileName Where to write the trace
+	 * @return Returns false if the file couldn't be written or we're not running yet.
+	 */
+	public boolean exportProfile(String fileName)
+	{
+		if (renderWrapper == null || renderWrapper.maplyRender == null)
+			return false;
+
+		return renderControl.exportProfile(fileName);
+	}
+
 	/** Calculate the height that corresponds to a given Mapnik-style map scale.
 	 * <br>
 	 * Figure out the viewer height that corresponds to a given scale denominator (ala Mapnik).
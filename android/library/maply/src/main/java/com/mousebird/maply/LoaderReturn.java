@@ -109,6 +109,18 @@ public class LoaderReturn
      */
     public native int getGeneration();
 
+    /**
+     * Set if the fetch or parsing failed.  The loader will mark the frame as failed.
+     */
+    public native void setHasError(boolean hasError);
+
+    /**
+     * Elevation for the tile as a grid of heights in meters, spanning the tile edge to edge.
+     * Rows run from the north down, the same as image data.
+     * This only displaces the tile geometry if the sampling params have includeElev set.
+     */
+    public native void setElevationGrid(float[] elevs,int sizeX,int sizeY);
+
     /**
      * Merge in the given changes requests to be handled upstream.
      */
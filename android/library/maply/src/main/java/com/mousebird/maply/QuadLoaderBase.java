@@ -76,6 +76,18 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
      */
     public native void setDebugMode(boolean debugMode);
 
+    /**
+     * Limit the number of tile frames being fetched at once.
+     * The rest wait their turn, most important first.
+     * Default is 0, which means no limit.
+     */
+    public native void setMaxFetchesInFlight(int maxFetches);
+
+    /**
+     * Maximum number of tile frames being fetched at once.  0 means no limit.
+     */
+    public native int getMaxFetchesInFlight();
+
     private WeakReference<BaseController> control;
 
     /**
@@ -281,8 +293,8 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
         frameAssets.remove(frameAsset);
     }
 
-    // Start off fetches for all the frames within a given tile
-    // Return an array of corresponding frame assets
+    // Start off fetches for the given frames within a given tile
+    // Frames we're not fetching are null
     public void startTileFetch(QIFBatchOps batchOps,QIFFrameAsset[] inFrameAssets, final int tileX, final int tileY, final int tileLevel, int priority, double importance)
     {
         if (tileInfos.length == 0 || tileInfos.length != inFrameAssets.length)
@@ -295,6 +307,12 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
         int frame = 0;
         final QuadLoaderBase loaderBase = this;
         for (TileInfoNew tileInfo : tileInfos) {
+            // Frames are fetched individually, so we may only be handed some of them
+            if (inFrameAssets[frame] == null) {
+                frame++;
+                continue;
+            }
+
             final int fFrame = frame;
             final int dispFrame = tileInfos.length > 1 ? frame : -1;
 
@@ -339,14 +357,22 @@ public class QuadLoaderBase implements QuadSamplingLayer.ClientInterface
 
                 @Override
                 public void failure(TileFetchRequest fetchRequest, String errorStr) {
+                    // Tell the loader so the frame stops counting as in flight
+                    final LoaderReturn loadReturn = makeLoaderReturn();
+                    loadReturn.setTileID(tileX, tileY, tileLevel);
+                    loadReturn.setFrame(getFrameID(fFrame),fFrame);
+                    loadReturn.errorString = errorStr;
+                    loadReturn.setHasError(true);
+
                     final QuadSamplingLayer layer = samplingLayer.get();
                     if (layer != null) {
                         layer.layerThread.addTask(new Runnable() {
                             @Override
                             public void run() {
                                 ChangeSet changes = new ChangeSet();
-                                mergeLoaderReturn(null, changes);
+                                mergeLoaderReturn(loadReturn, changes);
                                 layer.layerThread.addChanges(changes);
+                                loadReturn.dispose();
                             }
                         });
                     }
@@ -1949,6 +1949,9 @@ public class RenderController implements RenderControllerInterface
     protected native void render();
     protected native boolean hasChanges();
     public native void setPerfInterval(int perfInterval);
+    public native void setChangeBudget(int budgetMicros);
+    public native void setProfilingEnabled(boolean enable);
+    public native boolean exportProfile(String fileName);
     public native void addLight(DirectionalLight light);
     public native void replaceLights(DirectionalLight[] lights);
     protected native void renderToBitmapNative(Bitmap outBitmap);
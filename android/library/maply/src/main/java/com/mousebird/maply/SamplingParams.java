@@ -79,6 +79,28 @@ public class SamplingParams
      */
     public native int getMaxTiles();
 
+    /**
+     * If set, we'll also load tiles for where the camera is headed.
+     * The camera is extrapolated this many seconds out.  0 turns it off (the default).
+     */
+    public native void setPrefetchLookAhead(double lookAhead);
+
+    /**
+     * How far ahead (in seconds) we predict the camera for prefetching.
+     */
+    public native double getPrefetchLookAhead();
+
+    /**
+     * Maximum number of tiles to load ahead of the camera.
+     * This is separate from the maximum number of tiles displayed.
+     */
+    public native void setMaxPrefetchTiles(int maxTiles);
+
+    /**
+     * Maximum number of tiles to load ahead of the camera.
+     */
+    public native int getMaxPrefetchTiles();
+
     /**
      * Size of a tile in scren space (pixels^2).
      * Anything taking up less space than this will not be loaded.
@@ -138,6 +160,18 @@ public class SamplingParams
      */
     public native boolean getEdgeMatching();
 
+    /**
+     * If set, we'll displace the tile geometry by whatever elevation
+     * the loaders provide.
+     */
+    public native void setIncludeElev(boolean includeElev);
+
+    /**
+     * If set, we'll displace the tile geometry by whatever elevation
+     * the loaders provide.
+     */
+    public native boolean getIncludeElev();
+
     /**
      * Each tile will be tesselated into a given number of X and Y grid
      * points.
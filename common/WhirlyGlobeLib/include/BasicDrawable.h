@@ -180,6 +180,10 @@ public:
     virtual SimpleIdentity getProgram() const;
     void setProgram(SimpleIdentity progId);
     
+    /// Copy out the geometry if it's still on the CPU side.  Used for recording.
+    /// Returns false if it's already been handed off to the renderer.
+    virtual bool getGeometry(std::vector<Eigen::Vector3f> &outPts,std::vector<Triangle> &outTris) const;
+    
 public:
     GeometryType type;
     bool on;  // If set, draw.  If not, not
@@ -198,6 +202,7 @@ public:
     SimpleIdentity programId;    // Program to use for rendering
     SimpleIdentity renderTargetID;
     Mbr localMbr;  // Extents in a local space, if we're not using lat/lon/radius
+    bool cullByMbr;  // Set if the geometry lies on the surface within localMbr, so we can cull with it
     std::vector<TexInfo> texInfo;
     float lineWidth;
     // For zBufferOffDefault mode we'll sort this to the end
@@ -264,6 +269,28 @@ protected:
 /// Reference counted version of BasicDrawable
 typedef std::shared_ptr<BasicDrawable> BasicDrawableRef;
 
+/** A triangle list that more than one drawable can point to.
+    Geometry built on a regular grid (tiles, for instance) all has the same
+    topology, so there's no reason for every drawable to carry its own copy.
+    Renderers subclass this to keep a single index buffer on the GPU side.
+  */
+class SharedTriangles
+{
+public:
+    SharedTriangles(const std::vector<BasicDrawable::Triangle> &tris);
+    virtual ~SharedTriangles();
+    
+    /// The triangles themselves.  These don't change once we're constructed.
+    const std::vector<BasicDrawable::Triangle> &getTriangles() const { return tris; }
+    
+    /// Number of triangles
+    int getNumTris() const { return (int)tris.size(); }
+    
+protected:
+    std::vector<BasicDrawable::Triangle> tris;
+};
+typedef std::shared_ptr<SharedTriangles> SharedTrianglesRef;
+
 /// Ask the renderer to change a drawable's color
 class ColorChangeRequest : public DrawableChangeRequest
 {
@@ -272,6 +299,9 @@ public:
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
     
+    /// Write out the change for a recording
+    virtual bool record(MutableRawData *data) const;
+    
 protected:
     unsigned char color[4];
 };
@@ -284,6 +314,9 @@ public:
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
     
+    /// Write out the change for a recording
+    virtual bool record(MutableRawData *data) const;
+    
 protected:
     bool newOnOff;
 };
@@ -296,6 +329,9 @@ public:
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
     
+    /// Write out the change for a recording
+    virtual bool record(MutableRawData *data) const;
+    
 protected:
     float minVis,maxVis;
 };
@@ -308,6 +344,9 @@ public:
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
     
+    /// Write out the change for a recording
+    virtual bool record(MutableRawData *data) const;
+    
 protected:
     TimeInterval fadeUp,fadeDown;
 };
@@ -363,6 +402,9 @@ public:
     
     void execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw);
     
+    /// Write out the change for a recording
+    virtual bool record(MutableRawData *data) const;
+    
 protected:
     int drawPriority;
 };
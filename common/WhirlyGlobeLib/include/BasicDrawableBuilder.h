@@ -57,6 +57,10 @@ public:
     void setLocalMbr(Mbr mbr);
     const Mbr &getLocalMbr();
     
+    /// The renderer culls drawables by their local extents, assuming they sit on the surface.
+    /// Turn this off for geometry that sticks up off the surface or has a size on screen.
+    void setCullByMbr(bool cullByMbr);
+    
     /// Set the viewer based visibility
     virtual void setViewerVisibility(double minViewerDist,double maxViewerDist,const Point3d &viewerCenter);
     
@@ -196,6 +200,10 @@ public:
     /// Add a triangle.  Should point to the vertex IDs.
     virtual void addTriangle(BasicDrawable::Triangle tri);
     
+    /// Use a triangle list shared with other drawables rather than our own.
+    /// Any triangles added with addTriangle() are ignored.
+    virtual void setSharedTriangles(SharedTrianglesRef sharedTris);
+    
     /// Set the uniforms applied to the Program before rendering
     virtual void setUniforms(const SingleVertexAttributeSet &uniforms);
     
@@ -233,6 +241,8 @@ public:
     // Unprocessed data arrays
     std::vector<Eigen::Vector3f> points;
     std::vector<BasicDrawable::Triangle> tris;
+    // If set, we use these instead of tris
+    SharedTrianglesRef sharedTris;
 };
 
 typedef std::shared_ptr<BasicDrawableBuilder> BasicDrawableBuilderRef;
@@ -35,6 +35,29 @@
 namespace WhirlyKit
 {
     
+/** OpenGL version of the shared triangles.
+    The element buffer is set up by the first drawable that needs it
+    and deleted when the last one tears down.
+  */
+class SharedTrianglesGLES : public SharedTriangles
+{
+public:
+    SharedTrianglesGLES(const std::vector<BasicDrawable::Triangle> &tris);
+    virtual ~SharedTrianglesGLES();
+    
+    /// Return the element buffer, setting it up if this is the first user
+    GLuint setupForRenderer(const RenderSetupInfoGLES *setupInfo);
+    
+    /// Drop one user of the element buffer, deleting it if that was the last
+    void teardownForRenderer(const RenderSetupInfoGLES *setupInfo);
+    
+protected:
+    std::mutex lock;
+    int numUsers;
+    GLuint triBuffer;
+};
+typedef std::shared_ptr<SharedTrianglesGLES> SharedTrianglesGLESRef;
+    
 /** OpenGL Version of the BasicDrawable.
   */
 class BasicDrawableGLES : virtual public BasicDrawable, virtual public DrawableGLES
@@ -49,6 +72,9 @@ public:
     /// Clean up any rendering objects you may have (e.g. VBOs).
     virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
     
+    /// Copy out the geometry, if we haven't set up the buffers yet
+    virtual bool getGeometry(std::vector<Eigen::Vector3f> &outPts,std::vector<Triangle> &outTris) const;
+    
     /// Some drawables have a pre-render phase that uses the GPU for calculation
     virtual void calculate(RendererFrameInfoGLES *frameInfo,Scene *scene) { };
     
@@ -72,6 +98,8 @@ public:
     // Unprocessed data arrays
     std::vector<Eigen::Vector3f> points;
     std::vector<Triangle> tris;
+    // If set, we draw with these rather than tris
+    SharedTrianglesGLESRef sharedTris;
 
     // Attribute that should be applied to the given program index if using VAOs
     class VertAttrDefault
@@ -90,6 +118,8 @@ public:
     // Size for a single vertex w/ all its data.  Used by shared buffer
     int vertexSize;
     GLuint pointBuffer,triBuffer,sharedBuffer;
+    // Buffer holding the triangles (at offset triBuffer), if they've been set up
+    GLuint elementBuffer;
     GLuint vertArrayObj;
 };
     
@@ -0,0 +1,174 @@
+/*
+ *  BasicDrawableHeadless.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "BasicDrawable.h"
+#import "BasicDrawableBuilder.h"
+#import "BasicDrawableInstance.h"
+#import "BasicDrawableInstanceBuilder.h"
+#import "BillboardDrawableBuilder.h"
+#import "ScreenSpaceDrawableBuilder.h"
+#import "WideVectorDrawableBuilder.h"
+#import "ParticleSystemDrawable.h"
+#import "ParticleSystemDrawableBuilder.h"
+
+namespace WhirlyKit
+{
+
+/** Headless version of the BasicDrawable.
+    Keeps the geometry around on the CPU, but never sets anything up on a GPU.
+  */
+class BasicDrawableHeadless : virtual public BasicDrawable
+{
+public:
+    BasicDrawableHeadless(const std::string &name);
+    virtual ~BasicDrawableHeadless();
+
+    /// Nothing to set up
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo);
+
+    /// Nothing to tear down
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+
+    /// We always have the geometry
+    virtual bool getGeometry(std::vector<Eigen::Vector3f> &outPts,std::vector<Triangle> &outTris) const;
+
+    /// Number of points, for the recorded draw calls
+    int getNumPoints() const { return (int)points.size(); }
+
+    /// Number of triangles, for the recorded draw calls
+    int getNumTris() const { return (int)tris.size(); }
+
+public:
+    std::vector<Eigen::Vector3f> points;
+    std::vector<Triangle> tris;
+};
+
+/// Headless version of the BasicDrawable Builder
+class BasicDrawableBuilderHeadless : virtual public BasicDrawableBuilder
+{
+public:
+    BasicDrawableBuilderHeadless(const std::string &name,bool setupStandard=true);
+    ~BasicDrawableBuilderHeadless();
+
+    /// Add a new vertex related attribute
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings = -1);
+
+    /// Fill out and return the drawable
+    virtual BasicDrawable *getDrawable();
+
+protected:
+    bool drawableGotten;
+};
+
+/// Headless version of the BasicDrawableInstance
+class BasicDrawableInstanceHeadless : virtual public BasicDrawableInstance
+{
+public:
+    BasicDrawableInstanceHeadless(const std::string &name);
+
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo);
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+};
+
+/// Headless version of the BasicDrawableInstance Builder
+class BasicDrawableInstanceBuilderHeadless : public BasicDrawableInstanceBuilder
+{
+public:
+    BasicDrawableInstanceBuilderHeadless(const std::string &name);
+    ~BasicDrawableInstanceBuilderHeadless();
+
+    /// Fill out and return the drawable
+    virtual BasicDrawableInstance *getDrawable();
+
+protected:
+    bool drawableGotten;
+};
+
+/// Screen space tweaker that doesn't have any uniforms to set
+class ScreenSpaceTweakerHeadless : public ScreenSpaceTweaker
+{
+public:
+    void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) { }
+};
+
+/// Headless version of the ScreenSpaceDrawable Builder
+class ScreenSpaceDrawableBuilderHeadless : virtual public BasicDrawableBuilderHeadless, virtual public ScreenSpaceDrawableBuilder
+{
+public:
+    ScreenSpaceDrawableBuilderHeadless(const std::string &name);
+
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings = -1);
+    virtual ScreenSpaceTweaker *makeTweaker();
+    virtual BasicDrawable *getDrawable();
+};
+
+/// Wide vector tweaker that doesn't have any uniforms to set
+class WideVectorTweakerHeadless : public WideVectorTweaker
+{
+public:
+    void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) { }
+};
+
+/// Headless version of the WideVectorDrawable Builder
+class WideVectorDrawableBuilderHeadless : virtual public BasicDrawableBuilderHeadless, virtual public WideVectorDrawableBuilder
+{
+public:
+    WideVectorDrawableBuilderHeadless(const std::string &name);
+
+    void Init(unsigned int numVert,unsigned int numTri,bool globeMode);
+
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings = -1);
+    virtual WideVectorTweaker *makeTweaker();
+    virtual BasicDrawable *getDrawable();
+};
+
+/// Headless version of the BillboardDrawable Builder
+class BillboardDrawableBuilderHeadless : public BasicDrawableBuilderHeadless, public BillboardDrawableBuilder
+{
+public:
+    BillboardDrawableBuilderHeadless(const std::string &name);
+
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings = -1);
+    virtual BasicDrawable *getDrawable();
+};
+
+/// Headless version of the ParticleSystemDrawable
+class ParticleSystemDrawableHeadless : virtual public ParticleSystemDrawable
+{
+public:
+    ParticleSystemDrawableHeadless(const std::string &name);
+
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo);
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+};
+
+/// Headless version of the ParticleSystemDrawable Builder
+class ParticleSystemDrawableBuilderHeadless : public ParticleSystemDrawableBuilder
+{
+public:
+    ParticleSystemDrawableBuilderHeadless(const std::string &name);
+    virtual ~ParticleSystemDrawableBuilderHeadless();
+
+    ParticleSystemDrawable *getDrawable();
+
+protected:
+    bool drawableGotten;
+};
+
+}
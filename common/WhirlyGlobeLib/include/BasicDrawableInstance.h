@@ -140,7 +140,7 @@ public:
     class TexInfo
     {
     public:
-        TexInfo() : texId(EmptyIdentity), relLevel(0), relX(0), relY(0), size(0), borderTexel(0) { }
+        TexInfo() : texId(EmptyIdentity), size(0), borderTexel(0), relLevel(0), relX(0), relY(0) { }
         
         // Initialize from a basic drawable's version of the tex info
         TexInfo(BasicDrawable::TexInfo &basicTexInfo);
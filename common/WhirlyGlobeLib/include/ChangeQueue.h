@@ -0,0 +1,134 @@
+/*
+ *  ChangeQueue.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <atomic>
+#import <vector>
+#import "ChangeRequest.h"
+
+namespace WhirlyKit
+{
+
+/// Counters for the change queue, useful for tracking down contention
+class ChangeQueueStats
+{
+public:
+    ChangeQueueStats();
+
+    /// Number of batches pushed on the queue
+    uint64_t numBatches;
+    /// Number of individual requests pushed on the queue
+    uint64_t numRequests;
+    /// Number of times a producer had to retry because another thread got there first
+    uint64_t numContended;
+    /// Requests currently in the queue, waiting for the renderer
+    int queueDepth;
+    /// Largest the queue has been
+    int maxQueueDepth;
+    /// Delayed requests waiting for their time to come
+    int numTimed;
+};
+
+/** A multi-producer, single-consumer queue of change requests.
+    Any thread can push a batch of changes without taking a lock.
+    The rendering thread drains everything at once and sorts out the
+    requests that are supposed to run later into a heap it alone owns.
+  */
+class ChangeSetQueue
+{
+public:
+    ChangeSetQueue();
+    ~ChangeSetQueue();
+
+    /// Add a batch of changes.  Can be called from any thread.
+    /// If atomic is set the batch is applied in a single frame, even when the renderer is on a budget.
+    void push(const ChangeSet &changes,bool atomic = false);
+
+    /// Add a single change.  Can be called from any thread.
+    void push(ChangeRequest *change);
+
+    /// Move everything that's been pushed into the given change set, in the order it was pushed.
+    /// Delayed requests go into the timed heap instead.  Requests that need to be pre-executed
+    /// always come out on their own.  What's left of an atomic batch with more than one request
+    /// comes out as a single ChangeGroupReq, so it's never split up.  Rendering thread only.
+    void drain(ChangeSet &changes);
+
+    /// Move the delayed requests that are ready to run into the change set.  Rendering thread only.
+    void drainTimed(TimeInterval now,ChangeSet &changes);
+
+    /// True if anything has been pushed or a delayed request is ready.  Rendering thread only.
+    bool hasChanges(TimeInterval now) const;
+
+    /// Number of requests pushed, but not yet drained.  Can be called from any thread.
+    int getQueueDepth() const { return queueDepth; }
+
+    /// Copy out the counters.  Can be called from any thread.
+    ChangeQueueStats getStats() const;
+
+    /// Delete everything pending, including the delayed requests.  Rendering thread only.
+    void clear();
+
+protected:
+    // A batch as it sits in the queue
+    class Node
+    {
+    public:
+        ChangeSet changes;
+        bool atomic;
+        Node *next;
+    };
+
+    // A delayed request in the heap
+    class TimedEntry
+    {
+    public:
+        TimeInterval when;
+        uint64_t seq;
+        ChangeRequest *req;
+    };
+
+    // Order the heap so the earliest request (then the earliest pushed) is on top
+    class TimedEntrySorter
+    {
+    public:
+        bool operator () (const TimedEntry &a,const TimedEntry &b) const
+        {
+            if (a.when == b.when)
+                return a.seq > b.seq;
+            return a.when > b.when;
+        }
+    };
+
+    void pushNode(Node *node);
+
+    // Most recently pushed batch, linked back to the oldest
+    std::atomic<Node *> head;
+    std::atomic<int> queueDepth;
+    std::atomic<int> maxQueueDepth;
+    std::atomic<uint64_t> numBatches;
+    std::atomic<uint64_t> numRequests;
+    std::atomic<uint64_t> numContended;
+    // Size of the timed heap, for other threads to look at
+    std::atomic<int> numTimed;
+
+    // Rendering thread only
+    std::vector<TimedEntry> timed;
+    uint64_t timedSeq;
+};
+
+}
@@ -0,0 +1,159 @@
+/*
+ *  ChangeRecorder.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <atomic>
+#import <mutex>
+#import <string>
+#import <cstdio>
+#import "WhirlyVector.h"
+#import "RawData.h"
+#import "ChangeRequest.h"
+#import "Drawable.h"
+#import "Texture.h"
+#import "CoordSystem.h"
+
+namespace WhirlyKit
+{
+
+/// Types of change requests we know how to record and replay
+typedef enum {ChangeRecordUnknown=0,ChangeRecordAddTexture,ChangeRecordRemTexture,ChangeRecordAddDrawable,
+    ChangeRecordRemDrawable,ChangeRecordOnOff,ChangeRecordColor,ChangeRecordVisibility,ChangeRecordFade,
+    ChangeRecordDrawPriority,ChangeRecordDrawableState,ChangeRecordBulkDrawableState,ChangeRecordGroup} ChangeRecordType;
+
+/** Records the change requests handed to a Scene, with the time they came in,
+    along with the view state once per frame.
+    The result is a compact binary file that the ChangeReplayer can feed back into
+    a Scene to reproduce a session.
+    Requests that can't be recorded (like RunBlockReq) are noted, but skipped on replay.
+  */
+class ChangeRecorder
+{
+public:
+    ChangeRecorder();
+    ~ChangeRecorder();
+
+    /// Start writing to the given file.  Returns false if we can't open it.
+    bool open(const std::string &fileName);
+
+    /// Finish up the file
+    void close();
+
+    /// True if we're writing a file
+    bool isOpen();
+
+    /// Record a set of changes as they're handed to the Scene.  Thread safe.
+    void recordChanges(const ChangeSet &changes,TimeInterval now);
+
+    /// Record the view state for a frame.  The changes recorded since the last frame go with it.
+    void recordFrame(TimeInterval now,View *view);
+
+    /// Number of requests we've written
+    int getNumRecorded();
+
+    /// Number of requests we couldn't record
+    int getNumUnsupported();
+
+    /// True if any recorder is open.  Change requests use this to grab their data
+    ///  before it's handed off to the renderer.
+    static bool IsRecording();
+
+    /// Write a single change request (time, priority and contents)
+    static bool RecordChange(MutableRawData *data,const ChangeRequest *change);
+
+    /// Write a drawable, including its geometry if it's still on the CPU side.
+    /// Only basic drawables can be recorded.
+    static bool RecordDrawable(MutableRawData *data,Drawable *draw);
+
+    /// Write a texture, including its data if it's still around
+    static bool RecordTexture(MutableRawData *data,TextureBase *tex);
+
+protected:
+    void writeRecord(int recordType,const MutableRawData &data);
+
+    std::mutex lock;
+    FILE *fp;
+    int numRecorded,numUnsupported;
+
+    static std::atomic<int> numOpen;
+};
+typedef std::shared_ptr<ChangeRecorder> ChangeRecorderRef;
+
+/// A single frame from a recording, along with the changes that came in before it
+class ChangeReplayFrame
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    ChangeReplayFrame();
+
+    /// Time the frame was rendered (or the changes came in, if there's no view)
+    TimeInterval time;
+    /// Set if the view state is valid.  The changes at the end of a recording won't have one.
+    bool hasView;
+    /// Eye position in display coordinates
+    Eigen::Vector3d eyePos;
+    /// Height above the surface
+    double heightAboveSurface;
+    /// Model matrix for the view
+    Eigen::Matrix4d modelMat;
+    /// Changes recorded since the last frame.  The caller is responsible for these.
+    ChangeSet changes;
+};
+
+/** Reads a file written by the ChangeRecorder and recreates the change requests
+    with the given renderer's drawable and texture types.
+    Drawables and textures keep the IDs they were recorded with, so later changes find them.
+    If geometry or texture data had already been handed to the renderer when it was recorded,
+    we make up placeholder data of the same size.
+  */
+class ChangeReplayer
+{
+public:
+    ChangeReplayer(SceneRenderer *renderer,CoordSystemDisplayAdapter *coordAdapter);
+    ~ChangeReplayer();
+
+    /// Open a recording.  Returns false if it's not there or isn't a recording.
+    bool open(const std::string &fileName);
+
+    /// Done with the file
+    void close();
+
+    /// Read the next frame and the changes that came before it.
+    /// Returns false at the end of the file.
+    bool nextFrame(ChangeReplayFrame &frame);
+
+    /// Number of requests we've recreated
+    int getNumReplayed() { return numReplayed; }
+
+    /// Number of requests that were recorded, but we couldn't recreate
+    int getNumSkipped() { return numSkipped; }
+
+protected:
+    // Read a single change.  valid is cleared if the data is bad and we can't go on.
+    ChangeRequest *readChange(RawDataReader &reader,bool &valid);
+    Drawable *readDrawable(RawDataReader &reader);
+    TextureBaseRef readTexture(RawDataReader &reader);
+
+    SceneRenderer *renderer;
+    CoordSystemDisplayAdapter *coordAdapter;
+    FILE *fp;
+    int numReplayed,numSkipped;
+};
+
+}
@@ -38,6 +38,7 @@ public:
     
 class Scene;
 class SceneRenderer;
+class MutableRawData;
     
 /** This is the base clase for a change request.  Change requests
  are how we modify things in the scene.  The renderer is running
@@ -63,14 +64,66 @@ public:
     /// Set this if you need to be run before the active models are run
     virtual bool needPreExecute();
     
+    /// Write out enough to recreate this request when replaying a recording.
+    /// Return false (without writing anything) if this type can't be recorded.
+    virtual bool record(MutableRawData *data) const;
+    
     /// If non-zero we'll execute this request after the given absolute time
     TimeInterval when;
+    
+    /// When the renderer is limiting how long it spends on changes, higher priority requests go first.
+    /// Requests with the same priority run in the order they came in.
+    /// Requests from one producer should all get the same priority, so they stay in order.
+    /// Only raise it for requests that don't depend on anything with a lower priority.
+    int priority;
 };
 
 /// Representation of a list of changes.  Might get more complex in the future.
 typedef std::vector<ChangeRequest *> ChangeSet;
 typedef std::shared_ptr<ChangeSet> ChangeSetRef;
 
+/// Priority for tile loading and the changes that follow from it.  These can wait a frame or two.
+static const int ChangePriorityLoading = -10;
+/// Priority for changes the user is waiting to see, like screen space layout.
+static const int ChangePriorityInteractive = 10;
+
+/// Set the priority on the change requests in a set, starting from the given one
+void SetChangePriority(ChangeSet &changes,int priority,size_t start = 0);
+
+/** A group of change requests that have to be executed together, in the same frame.
+    Use this for things like tile swaps where the old and new data should never show up
+    on their own.  The group takes ownership of the requests.
+    It runs at the latest time and highest priority of the requests in it.
+  */
+class ChangeGroupReq : public ChangeRequest
+{
+public:
+    ChangeGroupReq(const ChangeSet &changes);
+    virtual ~ChangeGroupReq();
+    
+    /// True if any of the requests in the group need a flush
+    virtual bool needsFlush();
+    
+    /// True if any of the requests in the group need to run before the active models.
+    /// The whole group runs early in that case.
+    virtual bool needPreExecute();
+    
+    /// Set up all the requests in the group
+    virtual void setupForRenderer(const RenderSetupInfo *);
+    
+    /// Run all the requests in the group
+    virtual void execute(Scene *scene,SceneRenderer *renderer,View *view);
+    
+    /// Record the requests in the group
+    virtual bool record(MutableRawData *data) const;
+    
+    /// Number of requests in the group
+    int numChanges() const { return (int)changes.size(); }
+    
+protected:
+    ChangeSet changes;
+};
+
 typedef struct
 {
     bool operator () (const ChangeRequest *a,const ChangeRequest *b) const
@@ -95,7 +95,7 @@ class CoordSystemDisplayAdapter : public DelayedDeletable
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
 
-    CoordSystemDisplayAdapter(CoordSystem *coordSys,Point3d center) : coordSys(coordSys), center(0.0,0.0,0.0), scale(1.0,1.0,1.0) { }
+    CoordSystemDisplayAdapter(CoordSystem *coordSys,Point3d center) : center(0.0,0.0,0.0), scale(1.0,1.0,1.0), coordSys(coordSys) { }
     virtual ~CoordSystemDisplayAdapter() { }
     
     /// If the subclass can support a bounding box, this returns true
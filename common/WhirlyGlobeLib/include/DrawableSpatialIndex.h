@@ -0,0 +1,151 @@
+/*
+ *  DrawableSpatialIndex.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <vector>
+#import <unordered_map>
+#import "WhirlyVector.h"
+#import "CoordSystem.h"
+#import "Drawable.h"
+
+namespace WhirlyKit
+{
+
+/** Tests a bounding box (from the spatial index) against a view frustum.
+    Drawable MBRs are a mix of local and geographic coordinates depending on
+    who built them, so for flat maps we check both interpretations and keep
+    the node if either one is visible.
+  */
+class DrawableCullTest
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    /// Construct with the display adapter and the full model/view/projection matrix (including offsets)
+    DrawableCullTest(CoordSystemDisplayAdapter *coordAdapter,const Eigen::Matrix4d &mvpMat);
+
+    /// Returns true if the given MBR could overlap the frustum
+    bool operator () (const MbrD &mbr) const;
+
+protected:
+    // Test a display space bounding box against the frustum
+    bool boxVisible(const Point3d &ll,const Point3d &ur) const;
+    // Calculate a display space box for the MBR
+    void calcDisplayBox(const MbrD &mbr,bool isGeo,Point3d &ll,Point3d &ur) const;
+
+    CoordSystemDisplayAdapter *coordAdapter;
+    CoordSystem *coordSys;
+    Eigen::Matrix4d mvpMat;
+    bool isFlat;
+};
+
+/** A loose quad tree over the drawables in the scene, sorted by their local MBR.
+    The renderer uses this to cut down on the number of drawables it has to consider.
+    Drawables without a valid MBR (or that move around) are always returned.
+  */
+class DrawableSpatialIndex
+{
+public:
+    DrawableSpatialIndex();
+    ~DrawableSpatialIndex();
+
+    /// Set the area we're indexing.  Anything already in the index is redistributed.
+    void setBounds(const MbrD &bounds);
+
+    /// Add a drawable.  If cullable is false, it'll be returned by every query.
+    void addDrawable(Drawable *draw,bool cullable);
+
+    /// Remove a drawable by ID
+    void removeDrawable(SimpleIdentity drawID);
+
+    /// Clear everything out
+    void clear();
+
+    /// Find the drawables whose MBRs could pass the given test.  Results are appended.
+    template<typename TestType>
+    void findDrawables(const TestType &test,std::vector<Drawable *> &draws) const
+    {
+        draws.insert(draws.end(),unbounded.begin(),unbounded.end());
+        if (nodes.find(makeKey(0,0,0)) != nodes.end())
+            findDrawablesRecurse(test,0,0,0,draws);
+    }
+
+    /// Number of drawables sorted into the tree
+    int numIndexed() const { return (int)drawNodes.size() - (int)unbounded.size(); }
+
+    /// Number of drawables we always return
+    int numUnbounded() const { return (int)unbounded.size(); }
+
+protected:
+    // A single node in the loose quad tree
+    class Node
+    {
+    public:
+        Node() : numInTree(0) { }
+
+        // Drawables that live at this level
+        std::vector<Drawable *> draws;
+        // Number of drawables at or below this node
+        int numInTree;
+    };
+
+    static uint64_t makeKey(int level,int x,int y)
+    {
+        return ((uint64_t)level << 58) | ((uint64_t)x << 29) | (uint64_t)y;
+    }
+
+    // Loose bounds for the given node
+    MbrD nodeBounds(int level,int x,int y) const;
+
+    // Figure out which node a drawable MBR belongs in
+    bool placeMbr(const Mbr &mbr,int &level,int &x,int &y) const;
+
+    // Add or remove a count from the node and its parents
+    void adjustCounts(int level,int x,int y,int delta);
+
+    template<typename TestType>
+    void findDrawablesRecurse(const TestType &test,int level,int x,int y,std::vector<Drawable *> &draws) const
+    {
+        auto it = nodes.find(makeKey(level,x,y));
+        if (it == nodes.end() || it->second.numInTree == 0)
+            return;
+        if (!test(nodeBounds(level,x,y)))
+            return;
+
+        const Node &node = it->second;
+        draws.insert(draws.end(),node.draws.begin(),node.draws.end());
+        if ((int)node.draws.size() < node.numInTree && level < MaxLevel)
+            for (int iy=0;iy<2;iy++)
+                for (int ix=0;ix<2;ix++)
+                    findDrawablesRecurse(test,level+1,2*x+ix,2*y+iy,draws);
+    }
+
+    static const int MaxLevel = 16;
+    static const uint64_t UnboundedKey = (uint64_t)-1;
+
+    MbrD bounds;
+    std::unordered_map<uint64_t,Node> nodes;
+    // Drawables that always get returned
+    std::vector<Drawable *> unbounded;
+    // Where each drawable lives (node key and position within the node)
+    std::unordered_map<SimpleIdentity,std::pair<uint64_t,int> > drawNodes;
+    // Everything we know about, used when the bounds change
+    std::unordered_map<SimpleIdentity,std::pair<Drawable *,bool> > allDraws;
+};
+
+}
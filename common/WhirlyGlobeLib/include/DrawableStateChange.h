@@ -0,0 +1,175 @@
+/*
+ *  DrawableStateChange.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <vector>
+#import "WhirlyVector.h"
+#import "Drawable.h"
+#import "VertexAttribute.h"
+#import "ChangeRequest.h"
+
+namespace WhirlyKit
+{
+
+class Scene;
+class SceneRenderer;
+
+/// Turn a drawable on or off.  Works for basic drawables, instances and particle systems.
+void SetDrawableOnOff(Drawable *draw,bool onOff);
+/// Set the override color on a basic drawable or the color on an instance
+void SetDrawableColor(Drawable *draw,const RGBAColor &color);
+/// Set the visible range on a basic drawable or instance
+void SetDrawableVisibleRange(Drawable *draw,float minVis,float maxVis);
+/// Set the fade up and down times on a basic drawable.  Doesn't tell the renderer.
+void SetDrawableFade(Drawable *draw,TimeInterval fadeUp,TimeInterval fadeDown);
+/// Set the line width on a basic drawable or instance
+void SetDrawableLineWidth(Drawable *draw,float lineWidth);
+/// Change the draw priority.  The renderer needs to know about this one, so it takes the ref.
+void SetDrawableDrawPriority(SceneRenderer *renderer,DrawableRef draw,int drawPriority);
+/// Reset the uniforms on a basic drawable or instance
+void SetDrawableUniforms(Drawable *draw,const SingleVertexAttributeSet &uniforms);
+
+/// A single, compact drawable change.  Which field is valid depends on the type.
+class DrawableStateRecord
+{
+public:
+    typedef enum {OnOff,Color,Visibility,Fade,DrawPriority,LineWidth} Type;
+
+    SimpleIdentity drawID;
+    Type type;
+    union {
+        bool onOff;
+        unsigned char color[4];
+        float visRange[2];
+        TimeInterval fade[2];
+        int drawPriority;
+        float lineWidth;
+    };
+};
+
+/** A batch of common drawable changes (on/off, color, visibility, fade,
+    draw priority, line width) kept in one contiguous buffer.
+    It does the same thing as a pile of OnOffChangeRequest, ColorChangeRequest
+    and so on, but without an allocation per change.  The changes are run
+    in the order they were added.
+  */
+class DrawableStateChangeRequest : public ChangeRequest
+{
+public:
+    DrawableStateChangeRequest();
+    virtual ~DrawableStateChangeRequest();
+
+    /// Return the state change request at the end of the change set, adding one if needed.
+    /// Use this to gather up a bunch of changes while keeping them in order with the others.
+    static DrawableStateChangeRequest *AddTo(ChangeSet &changes);
+
+    /// Make room for the given number of changes, to avoid reallocating
+    void reserve(size_t numChanges);
+
+    /// Turn a drawable on or off
+    void addOnOff(SimpleIdentity drawID,bool onOff);
+    /// Change a drawable's color
+    void addColor(SimpleIdentity drawID,const RGBAColor &color);
+    /// Change a drawable's visible range
+    void addVisibility(SimpleIdentity drawID,float minVis,float maxVis);
+    /// Change a drawable's fade up and down times
+    void addFade(SimpleIdentity drawID,TimeInterval fadeUp,TimeInterval fadeDown);
+    /// Change a drawable's draw priority
+    void addDrawPriority(SimpleIdentity drawID,int drawPriority);
+    /// Change a drawable's line width
+    void addLineWidth(SimpleIdentity drawID,float lineWidth);
+
+    /// Number of changes in here
+    size_t numChanges() const { return records.size(); }
+
+    /// Run through the changes in one go
+    virtual void execute(Scene *scene,SceneRenderer *renderer,View *view);
+
+    /// Write the changes out for a recording
+    virtual bool record(MutableRawData *data) const;
+
+protected:
+    DrawableStateRecord &addRecord(SimpleIdentity drawID,DrawableStateRecord::Type type);
+
+    std::vector<DrawableStateRecord> records;
+};
+
+/** A set of changes to apply to a whole group of drawables at once.
+    Only the parts that have been set are applied.
+  */
+class DrawableState
+{
+public:
+    DrawableState();
+
+    /// Turn the drawables on or off
+    void setOnOff(bool onOff);
+    /// Set the fade up and down times
+    void setFade(TimeInterval fadeUp,TimeInterval fadeDown);
+    /// Change the draw priority
+    void setDrawPriority(int drawPriority);
+    /// Reset the uniforms
+    void setUniforms(const SingleVertexAttributeSet &uniforms);
+    /// Remove the drawables from the scene, after any other changes
+    void setRemove();
+
+    /// True if this would do the same thing as the other one.  Uniforms never match.
+    bool matches(const DrawableState &that) const;
+
+    bool hasOnOff;
+    bool onOff;
+    bool hasFade;
+    TimeInterval fadeUp,fadeDown;
+    bool hasDrawPriority;
+    int drawPriority;
+    bool hasUniforms;
+    SingleVertexAttributeSet uniforms;
+    bool remove;
+};
+
+/** Apply the same state change to a list of drawables.
+    The scene looks up all the IDs in one pass and then makes the changes.
+  */
+class BulkDrawableStateReq : public ChangeRequest
+{
+public:
+    BulkDrawableStateReq(const DrawableState &state,TimeInterval when = 0.0);
+    virtual ~BulkDrawableStateReq();
+
+    /// Return a request at the end of the change set with the same state (and time),
+    /// or add a new one.  This lets several callers share the same request.
+    static BulkDrawableStateReq *AddTo(ChangeSet &changes,const DrawableState &state,TimeInterval when = 0.0);
+
+    /// Add a single drawable ID
+    void addDrawID(SimpleIdentity drawID) { drawIDs.push_back(drawID); }
+
+    /// Add a whole set of drawable IDs
+    void addDrawIDs(const SimpleIDSet &ids) { drawIDs.insert(drawIDs.end(),ids.begin(),ids.end()); }
+
+    /// Hand the whole list to the scene
+    virtual void execute(Scene *scene,SceneRenderer *renderer,View *view);
+
+    /// Write the state and IDs out for a recording.  Uniforms can't be recorded.
+    virtual bool record(MutableRawData *data) const;
+
+protected:
+    DrawableState state;
+    std::vector<SimpleIdentity> drawIDs;
+};
+
+}
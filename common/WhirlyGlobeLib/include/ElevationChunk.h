@@ -0,0 +1,94 @@
+/*
+ *  ElevationChunk.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <vector>
+#import <memory>
+#import "WhirlyVector.h"
+
+namespace WhirlyKit
+{
+
+/** Elevation data for a single tile.
+    Subclasses wrap a particular encoding (heightmap, quantized mesh and so on)
+    and answer height queries in meters.  Positions within the tile are fractions,
+    (0,0) at the lower left and (1,1) at the upper right.
+  */
+class ElevationChunk
+{
+public:
+    ElevationChunk();
+    virtual ~ElevationChunk();
+
+    // Height at the given position within the tile
+    virtual double interpolateElevation(double x,double y) const = 0;
+
+    // Fill in heights for a regular grid of (tessX+1)*(tessY+1) points covering the given part of the tile.
+    // Rows start at the bottom, the same as the tile geometry.
+    virtual void sampleGrid(const Point2d &ll,const Point2d &ur,int tessX,int tessY,std::vector<float> &elevs) const;
+
+    // Height range over the given part of the tile.
+    // The default is the range for the whole tile, which is conservative.
+    virtual void getElevationRange(const Point2d &ll,const Point2d &ur,double &minZ,double &maxZ) const;
+
+    // Height range over the whole tile
+    double getMinElevation() const;
+    double getMaxElevation() const;
+
+protected:
+    double minElev,maxElev;
+};
+typedef std::shared_ptr<ElevationChunk> ElevationChunkRef;
+
+/** Heightmap elevation.  A regular grid of samples spanning the tile edge to edge.
+    Rows run from the top (north) down, the same as image data.
+  */
+class ElevationGridChunk : public ElevationChunk
+{
+public:
+    ElevationGridChunk(int sizeX,int sizeY,const std::vector<float> &elevs);
+    ElevationGridChunk(int sizeX,int sizeY,std::vector<float> &&elevs);
+
+    // Bilinear interpolation between the samples
+    virtual double interpolateElevation(double x,double y) const;
+
+    // Works out the sample weights once per row and column rather than per point
+    virtual void sampleGrid(const Point2d &ll,const Point2d &ur,int tessX,int tessY,std::vector<float> &elevs) const;
+
+    // Looks up the range from a min/max pyramid when the area lines up with a quad tree child
+    virtual void getElevationRange(const Point2d &ll,const Point2d &ur,double &minZ,double &maxZ) const;
+
+    int getSizeX() const;
+    int getSizeY() const;
+
+protected:
+    void setupRanges();
+    // Range over the samples in the given (inclusive) index bounds
+    void scanRange(int sx0,int sy0,int sx1,int sy1,float &minZ,float &maxZ) const;
+    // Sample with the row counted from the bottom
+    float sampleAt(int ix,int iy) const { return elevs[(sizeY-1-iy)*sizeX+ix]; }
+
+    int sizeX,sizeY;
+    std::vector<float> elevs;
+
+    // Min/max for each cell of a 2^level by 2^level split of the tile, coarsest first
+    std::vector<std::vector<std::pair<float,float> > > ranges;
+};
+typedef std::shared_ptr<ElevationGridChunk> ElevationGridChunkRef;
+
+}
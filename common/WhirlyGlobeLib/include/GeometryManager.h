@@ -140,7 +140,7 @@ class GeometryInstance : public Identifiable
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
 
-    GeometryInstance() : mat(mat.Identity()), colorOverride(false), selectable(false), duration(0.0) { }
+    GeometryInstance() : duration(0.0), mat(mat.Identity()), colorOverride(false), selectable(false) { }
     
     // Center for the instance
     Point3d center;
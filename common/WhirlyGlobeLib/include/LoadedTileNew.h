@@ -23,7 +23,14 @@
 #import "Scene.h"
 #import "GlobeMath.h"
 #import "QuadTreeNew.h"
+#import "QuadTreeNodeMap.h"
 #import "SceneRenderer.h"
+#import "BasicDrawable.h"
+#import "ElevationChunk.h"
+#import <list>
+#import <map>
+#import <tuple>
+#import <unordered_map>
 
 namespace WhirlyKit
 {
@@ -56,7 +63,7 @@ public:
     int drawPriorityPerLevel;
     // If set, we'll just build lines for debugging
     bool lineMode;
-    // If set, we'll include the elevation data
+    // If set, we'll displace the geometry by any elevation data we have
     bool includeElev;
     // If set, we'll enable/disable geometry associated with tiles.
     // Otherwise we'll just always leave it off, assuming someone else is instancing it
@@ -67,6 +74,30 @@ public:
 
 class TileGeomManager;
 
+/* Tessellated grid for a tile, in display coordinates.
+   Tiles in the same row at the same level have the same shape up to a rotation
+   around the globe's axis (or a translation in flat mode), so we build one of these
+   per row and move it into place for the rest.
+  */
+class TileGeomTemplate
+{
+public:
+    TileGeomTemplate();
+
+    // Move this grid onto the tile whose first and last grid points are given, filling in display coordinates.
+    // Returns false if the tile isn't a rigid transform of the one we were built from.
+    bool place(const Point3d &firstPt,const Point3d &lastPt,bool flat,Point3dVector &outLocs) const;
+
+    // Samples in X and Y
+    int tessX,tessY;
+    // Grid points, (tessX+1)*(tessY+1) of them
+    Point3dVector locs;
+    std::vector<TexCoord> texCoords;
+    // Two triangles per cell
+    std::vector<BasicDrawable::Triangle> tris;
+};
+typedef std::shared_ptr<TileGeomTemplate> TileGeomTemplateRef;
+
 /* Wraps a single tile that we've loaded into memory.
   */
 class LoadedTileNew
@@ -80,7 +111,8 @@ public:
     // Build the drawable(s) to represent this one tile
     void makeDrawables(SceneRenderer *sceneRender,TileGeomManager *geomManage,TileGeomSettings &geomSettings,ChangeSet &changes);
 
-    // Utility routine to build skirts around the edges
+    // Utility routine to build skirts around the edges.
+    // With elevation, the skirts drop straight down to skirtFactor (as a radius) rather than being scaled by it.
     void buildSkirt(BasicDrawableBuilderRef &draw,Point3dVector &pts,std::vector<TexCoord> &texCoords,double skirtFactor,bool haveElev,const Point3d &theCenter);
 
     // Enable associated drawables
@@ -102,6 +134,8 @@ public:
         int drawPriority;       // Draw priority we gave it
     };
     bool enabled;
+    // Level of the elevation chunk we were displaced by, or -1 if we weren't
+    int elevLevel;
     QuadTreeNew::ImportantNode ident;
     MbrD mbr;
     std::vector<DrawableInfo> drawInfo;
@@ -152,6 +186,37 @@ public:
     // Remove all the various geometry
     void cleanup(ChangeSet &changes);
     
+    // Fill in a tile's grid points in display coordinates and return the template they came from.
+    // Unclipped tiles share a template with the rest of their row.
+    TileGeomTemplateRef buildGrid(const QuadTreeNew::Node &ident,int tessX,int tessY,const MbrD &theMbr,const Point2d &texScale,bool clipped,Point3dVector &locs);
+    
+    // Displace a tile's grid points by its elevation, if we have any, passing back the range of heights used
+    //  and the level of the chunk it came from.
+    // Returns false if there was no elevation for the tile.
+    bool applyElevation(const QuadTreeNew::Node &ident,int tessX,int tessY,const MbrD &theMbr,Point3dVector &locs,double &minZ,double &maxZ,int &elevLevel);
+    
+    // Maximum number of row templates we'll keep around
+    void setMaxGeomTemplates(int maxTemplates);
+    int getMaxGeomTemplates();
+    
+    // Triangles shared by every tile drawable of the given kind and sample counts.
+    // The triangles passed in are used if this is the first we've seen of that topology.
+    SharedTrianglesRef getSharedTriangles(LoadedTileNew::DrawableKind kind,int tessX,int tessY,const std::vector<BasicDrawable::Triangle> &tris);
+    
+    // Elevation for a tile, as delivered by a loader.
+    // Tiles are displaced by it, or by their nearest ancestor's if they don't have their own.
+    // The tile and any descendants not built from finer elevation are rebuilt and passed back.
+    LoadedTileVec addElevationChunk(const QuadTreeNew::Node &ident,ElevationChunkRef chunk,ChangeSet &changes);
+    // The tile the elevation came from is gone.  We hang on to it until its descendants are too.
+    void removeElevationChunk(const QuadTreeNew::Node &ident);
+    
+    // Find the elevation covering a tile, looking up through its ancestors.
+    // Passes back the part of the chunk the tile covers, as fractions of the chunk, and optionally its level.
+    ElevationChunkRef findElevationChunk(const QuadTreeNew::Node &ident,Point2d &ll,Point2d &ur,int *chunkLevel=NULL);
+    
+    // Height range over a tile.  Returns false if we don't have any elevation for it.
+    bool getElevationRange(const QuadTreeNew::Node &ident,double &minZ,double &maxZ);
+    
     TileGeomSettings settings;
     
     SceneRenderer *sceneRender;
@@ -175,7 +240,51 @@ public:
     // Bounding box of the whole area
     MbrD mbr;
     
-    std::map<QuadTreeNew::Node,LoadedTileNewRef> tileMap;
+    QuadTreeNodeMap<LoadedTileNewRef> tileMap;
+    
+protected:
+    // Convert a point in the tile coordinate system to display coordinates
+    Point3d localToDisplayGrid(const Point2d &pt);
+
+    // Build a new template from the given tile
+    TileGeomTemplateRef makeGeomTemplate(int tessX,int tessY,const MbrD &theMbr,const Point2d &texScale);
+    
+    class GeomTemplateKey
+    {
+    public:
+        bool operator == (const GeomTemplateKey &that) const;
+
+        int level,y;
+        int tessX,tessY;
+    };
+    class GeomTemplateKeyHash
+    {
+    public:
+        size_t operator () (const GeomTemplateKey &key) const;
+    };
+    class GeomTemplateEntry
+    {
+    public:
+        GeomTemplateKey key;
+        TileGeomTemplateRef geomTemplate;
+    };
+    typedef std::list<GeomTemplateEntry> GeomTemplateList;
+
+    int maxGeomTemplates;
+    // Most recently used at the front
+    GeomTemplateList geomTemplates;
+    std::unordered_map<GeomTemplateKey,GeomTemplateList::iterator,GeomTemplateKeyHash> geomTemplateMap;
+    
+    // Index buffers for each drawable kind and sample counts.  There are only ever a handful.
+    std::map<std::tuple<int,int,int>,SharedTrianglesRef> sharedTris;
+    
+    // Drop elevation for tiles that are gone and have no descendants left to use it
+    void pruneElevationChunks();
+    
+    // Elevation we've been handed, by tile
+    QuadTreeNodeMap<ElevationChunkRef> elevChunks;
+    // Elevation whose tile was removed, but that descendants may still be using
+    QuadTreeNew::NodeSet orphanElevChunks;
 };
 
 }
@@ -20,7 +20,9 @@
 
 #import "Dictionary.h"
 #import "QuadTreeNew.h"
+#import "MapboxVectorTileAttributes.h"
 #import <string>
+#import <map>
 
 namespace WhirlyKit
 {
@@ -66,6 +68,90 @@ public:
 
     /// @brief For All and Any these are the MapboxVectorFilters to evaluate
     std::vector<MapboxVectorFilterRef> subFilters;
+
+protected:
+    friend class MapboxVectorFilterSet;
+
+    /// @brief Set if we compare against a single attribute value (rather than geometry or sub-filters)
+    bool usesAttrValue() const { return geomType == MBGeomNone && filterType < MBFilterAll; }
+
+    /// @brief Test with the compact vector tile attributes, if that's what we've got
+    bool testFeature(DictionaryRef attrs,const MVTFeatureAttributes *featAttrs,const QuadTreeIdentifier &tileID);
+
+    /// @brief Test with the attribute value already looked up, if we could
+    bool testFeature(DictionaryRef attrs,const MVTFeatureAttributes *featAttrs,
+                     bool haveFeatVal,const MVTAttributeTable::Value *featVal,
+                     const QuadTreeIdentifier &tileID);
+
+    /// @brief Attribute name and string values as IDs, for comparing against vector tile attributes
+    StringIdentity attrNameID;
+    bool attrValIsString;
+    StringIdentity attrValStrID;
+    std::string attrValStr;
+    double attrValDouble;
+    std::vector<StringIdentity> attrValStrIDs;
+    std::vector<std::string> attrValStrs;
+};
+
+class MapboxVectorFilterSet;
+typedef std::shared_ptr<MapboxVectorFilterSet> MapboxVectorFilterSetRef;
+
+/** @brief Filters for a group of style layers, compiled together.
+    @details Style sheets repeat the same tests (class == "road") across lots of layers.
+    Each distinct test or combination of tests becomes a single node and is evaluated
+    at most once per feature.  Tests on the same attribute share the lookup.
+  */
+class MapboxVectorFilterSet
+{
+public:
+    MapboxVectorFilterSet();
+
+    /// @brief Add the filter for the next layer.  No filter means the layer takes everything.
+    void addFilter(MapboxVectorFilterRef filter);
+
+    /// @brief Number of filters added
+    int numFilters() const { return roots.size(); }
+
+    /// @brief Number of distinct tests and combinations after sharing
+    int numNodes() const { return nodes.size(); }
+
+    /// @brief Test a feature against a group of the filters at once
+    /// @details Which filters to test are given as indices in the order they were added, as are the ones that pass.
+    void testFeature(DictionaryRef attrs,const QuadTreeIdentifier &tileID,const std::vector<int> &which,std::vector<int> &passed) const;
+
+protected:
+    // A single test or a combination of tests
+    class Node
+    {
+    public:
+        MapboxVectorFilterType filterType;
+        // The test itself.  Only used for comparisons.
+        MapboxVectorFilter *filter;
+        // Attribute lookup shared with other tests, or -1
+        int slot;
+        // Sub-nodes for all and any
+        unsigned int firstChild,numChildren;
+    };
+
+    // Results for a single feature
+    class EvalState;
+
+    // Add a filter and its sub-filters, sharing anything we've already got
+    int addNode(MapboxVectorFilterRef filter);
+
+    // Evaluate a node, or use the result we've already got
+    bool evalNode(int which,EvalState &state) const;
+
+    // The filters we were given.  Nodes point into these.
+    std::vector<MapboxVectorFilterRef> filters;
+    std::vector<Node> nodes;
+    std::vector<int> children;
+    // Top level node for each filter we were given, or -1 for no filter
+    std::vector<int> roots;
+    // Attribute looked up for each slot
+    std::vector<StringIdentity> slotKeyIDs;
+    // Nodes by a description of what they test, for sharing
+    std::map<std::string,int> nodesByKey;
 };
 
 }
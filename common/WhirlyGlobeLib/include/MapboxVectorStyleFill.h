@@ -52,6 +52,9 @@ public:
                               std::vector<VectorObjectRef> &vecObjs,
                               VectorTileDataRef tileInfo);
     
+    // Tessellation and vector building are all ours, so these can go on a worker thread
+    virtual bool threadSafeBuild();
+    
     virtual void cleanup(PlatformThreadInfo *inst,ChangeSet &changes);
     
 public:
@@ -69,6 +69,9 @@ public:
     
     virtual void buildObjects(PlatformThreadInfo *inst,std::vector<VectorObjectRef> &vecObjs,VectorTileDataRef tileInfo);
     
+    // Can go on a worker thread, unless we're subdividing the (shared) vector objects in place
+    virtual bool threadSafeBuild();
+    
     virtual void cleanup(PlatformThreadInfo *inst,ChangeSet &changes);
     
 public:
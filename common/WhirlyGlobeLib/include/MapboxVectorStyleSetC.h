@@ -26,6 +26,7 @@
 #import "MapboxVectorTileParser.h"
 #import "MaplyVectorStyleC.h"
 #import "MapboxVectorStyleSpritesImpl.h"
+#import "MapboxVectorFilter.h"
 #import <set>
 
 namespace WhirlyKit
@@ -130,6 +131,29 @@ typedef enum {
     MBResolveColorOpacityMultiply
 } MBResolveColorType;
 
+// Styles that use a single source layer, set up for matching features quickly
+class MapboxVectorSourceLayerStyles
+{
+public:
+    // Look up the styles that could draw anything for a tile at the given level
+    const std::vector<int> &layersForLevel(int level,bool useZoomLevels) const;
+    
+    // Styles that use this source layer, in style sheet order
+    std::vector<MapboxVectorStyleLayerRef> layers;
+    
+    // Filters for the layers, compiled together
+    MapboxVectorFilterSetRef filterSet;
+    
+    // Indices of all the layers
+    std::vector<int> allLayers;
+    
+    // Indices of the layers that can draw at each level, if we're using the style's zoom levels.
+    // A tile is never displayed below its own level, so maxzoom rules layers out.
+    // It can be displayed well above it once we run out of levels, so minzoom doesn't.
+    // Visibility can be changed at any time, so callers check that themselves.
+    std::vector<std::vector<int> > layersByLevel;
+};
+
 /**
   Holds the low level implementation for Mapbox Style Sheet parsing and object construction.
  */
@@ -213,6 +237,9 @@ public:
     // Return a list of all the styles in no particular order.  Needed for categories and indexing
     virtual std::vector<VectorStyleImplRef> allStyles();
 
+    /// We only read attributes through the Dictionary interface
+    virtual bool usesSharedAttributes() { return true; }
+
     
     /** Platform specific implementation **/
     
@@ -264,6 +291,9 @@ public:
     /// @brief Layers sorted by source layer name
     std::map<std::string, std::vector<MapboxVectorStyleLayerRef> > layersBySource;
 
+    /// @brief Layers, their compiled filters and which ones can draw at which levels, by source layer name
+    std::map<std::string, MapboxVectorSourceLayerStyles> stylesBySource;
+
     VectorManager *vecManage;
     WideVectorManager *wideVecManage;
     MarkerManager *markerManage;
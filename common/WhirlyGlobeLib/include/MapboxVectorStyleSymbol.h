@@ -59,6 +59,8 @@ public:
         // Possible key names in the data. Tried in this order.
         // Not set if this is a simple string
         std::vector<std::string> keys;
+        // The same keys as string IDs, for vector tile attributes
+        std::vector<StringIdentity> keyIDs;
     };
 
     float layoutImportance;
@@ -0,0 +1,151 @@
+/*
+ *  MapboxVectorTileAttributes.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "Dictionary.h"
+#import "MapboxVectorTileReader.h"
+#import "StringIndexer.h"
+#import <unordered_map>
+
+namespace WhirlyKit
+{
+
+/** Keys and values for one layer of a vector tile.
+    These are decoded once per layer and shared by all the features in it.
+    Keys and string values are matched up with the StringIndexer, so filters
+    can compare IDs instead of strings.
+  */
+class MVTAttributeTable
+{
+public:
+    MVTAttributeTable(const MVTLayer &layer,int layerOrder);
+
+    /// A single value out of the table
+    class Value
+    {
+    public:
+        Value() : type(DictTypeNone), strID(0), intVal(0), doubleVal(0.0) { }
+
+        /// String, Int or Double
+        DictionaryType type;
+        std::string str;
+        /// Global string ID.  Strings nobody had indexed yet get the table's numStrings.
+        StringIdentity strID;
+        int intVal;
+        double doubleVal;
+    };
+
+    /// Index of the key in this layer or -1
+    int findKey(const std::string &name) const;
+    /// Index of the key with the given global ID in this layer or -1
+    int findKey(StringIdentity keyID) const;
+
+    /// Compare a string value to a string we know the ID for
+    bool stringEquals(const Value &val,StringIdentity strID,const std::string &str) const
+    {
+        // Strings indexed after we were set up may still be in here, just without IDs
+        if (strID >= numStrings)
+            return val.str == str;
+        return val.strID == strID;
+    }
+
+    std::string layerName;
+    int layerOrder;
+    std::vector<std::string> keys;
+    std::vector<Value> values;
+    /// Set if one of the keys is layer_name, layer_order or geometry_type, which we normally fill in
+    bool shadowsBuiltIns;
+
+protected:
+    std::unordered_map<std::string,int> keyIndex;
+    std::unordered_map<StringIdentity,int> keyIDIndex;
+    StringIdentity numStrings;
+};
+typedef std::shared_ptr<MVTAttributeTable> MVTAttributeTableRef;
+
+/** Attributes for a single feature in a vector tile.
+    Rather than copying strings around we keep key/value index pairs into the layer's
+    shared table.  The first time somebody modifies them we copy everything out into
+    a regular platform dictionary and work from that.
+  */
+class MVTFeatureAttributes : public MutableDictionary
+{
+public:
+    /// Tags are key/value index pairs as they come out of the tile
+    MVTFeatureAttributes(MVTAttributeTableRef table,int geomType,const std::vector<uint32_t> &tags);
+    virtual ~MVTFeatureAttributes() { }
+
+    /// Look up a value by global key ID, without touching any strings.
+    /// Returns false if the answer has to come from the regular lookup (built in fields, modified attributes).
+    bool findValue(StringIdentity keyID,const MVTAttributeTable::Value *&val) const;
+
+    /// Geometry type, if it can be read directly
+    bool findGeometryType(int &geomType) const;
+
+    /// The shared table, for comparing values
+    const MVTAttributeTable *getTable() const { return table.get(); }
+
+    /// Number of tags that pointed outside the tables
+    int getNumBadTags() const { return numBadTags; }
+
+    /// Make a platform dictionary with the same contents
+    virtual MutableDictionaryRef copy();
+
+    virtual bool hasField(const std::string &name) const;
+    virtual DictionaryType getType(const std::string &name) const;
+    virtual int getInt(const std::string &name,int defVal=0.0) const;
+    virtual SimpleIdentity getIdentity(const std::string &name) const;
+    virtual bool getBool(const std::string &name,bool defVal=false) const;
+    virtual RGBAColor getColor(const std::string &name,const RGBAColor &defVal) const;
+    virtual double getDouble(const std::string &name,double defVal=0.0) const;
+    virtual std::string getString(const std::string &name) const;
+    virtual std::string getString(const std::string &name,const std::string &defVal) const;
+    virtual DictionaryRef getDict(const std::string &name) const;
+    virtual DictionaryEntryRef getEntry(const std::string &name) const;
+    virtual std::vector<DictionaryEntryRef> getArray(const std::string &name) const;
+    virtual std::vector<std::string> getKeys() const;
+
+    virtual void clear();
+    virtual void removeField(const std::string &name);
+    virtual void setInt(const std::string &name,int val);
+    virtual void setIdentifiable(const std::string &name,SimpleIdentity val);
+    virtual void setDouble(const std::string &name,double val);
+    virtual void setString(const std::string &name,const std::string &val);
+    virtual void addEntries(const Dictionary *other);
+
+protected:
+    typedef MVTAttributeTable::Value Value;
+
+    // Find a value by name, filling in tmp for the built in fields
+    const Value *findValue(const std::string &name,Value &tmp) const;
+    // Platform dictionary holding just the one value, for the conversions we don't do ourselves
+    MutableDictionaryRef singleEntryDict(const std::string &name) const;
+    // Copy everything into a platform dictionary, which takes over from here
+    void makeMutable();
+
+    MVTAttributeTableRef table;
+    int geomType;
+    int numBadTags;
+    // Key and value indices, one pair per key
+    std::vector<std::pair<uint32_t,uint32_t> > tags;
+    // Once we've been modified, this has everything
+    MutableDictionaryRef dict;
+};
+typedef std::shared_ptr<MVTFeatureAttributes> MVTFeatureAttributesRef;
+
+}
@@ -18,11 +18,11 @@
  *
  */
 
-#import "vector_tile.pb.h"
 #import "VectorObject.h"
 #import "QuadTreeNew.h"
 #import "ImageTile.h"
 #import "ComponentManager.h"
+#import "WorkerPool.h"
 
 namespace WhirlyKit
 {
@@ -112,6 +112,11 @@ public:
     /// Parse everything, even if there's no style for it
     bool parseAll;
     
+    /// If set, styles that can build off the calling thread are built in parallel on this pool.
+    /// buildForStyle is called from the pool threads for those, so subclasses that override it
+    ///  to do something platform specific shouldn't set this.
+    WorkerPoolRef buildPool;
+    
     // Add a category for a particulary style ID
     // These are used for sorting later on
     void addCategory(const std::string &category,long long styleID);
@@ -0,0 +1,134 @@
+/*
+ *  MapboxVectorTileReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <stdint.h>
+#import <string>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/// A run of characters in someone else's buffer.
+/// Only good for as long as that buffer is around.
+class MVTStringRef
+{
+public:
+    MVTStringRef() : data(NULL), len(0) { }
+    MVTStringRef(const char *data,size_t len) : data(data), len(len) { }
+
+    bool empty() const { return len == 0; }
+    std::string str() const { return std::string(data,len); }
+    bool operator == (const std::string &that) const { return that.size() == len && (len == 0 || !that.compare(0,len,data,len)); }
+    bool operator != (const std::string &that) const { return !operator==(that); }
+
+    const char *data;
+    size_t len;
+};
+
+/// One entry in a layer's value table.  Strings point back into the tile data.
+class MVTValue
+{
+public:
+    typedef enum {Unknown,String,Float,Double,Int,UInt,SInt,Bool} Type;
+
+    MVTValue() : type(Unknown), doubleVal(0.0), intVal(0) { }
+
+    Type type;
+    MVTStringRef stringVal;
+    // Float and Double
+    double doubleVal;
+    // Int, UInt, SInt and Bool
+    int64_t intVal;
+};
+
+/** A single feature within a layer.
+    The tags and geometry stay encoded until asked for.
+  */
+class MVTFeature
+{
+public:
+    MVTFeature();
+
+    // Decode the tags as pairs of key and value indices into the layer tables.
+    // Returns false if the data is bad.
+    bool decodeTags(std::vector<uint32_t> &tags) const;
+
+    // Decode the geometry command stream.  Returns false if the data is bad.
+    bool decodeGeometry(std::vector<uint32_t> &geom) const;
+
+    bool hasId;
+    uint64_t id;
+    // One of the MapnikGeometryType values
+    int geomType;
+
+    // The encoded feature
+    const uint8_t *start,*end;
+};
+
+/** A single layer within a tile.
+    Only the name, extent and version are read up front.  Everything else waits
+    until someone asks, so layers nobody wants cost very little.
+  */
+class MVTLayer
+{
+public:
+    MVTLayer();
+
+    // Decode the key and value tables, which the feature tags index into
+    bool decodeTables();
+
+    // Move on to the next feature.  Returns false at the end of the layer or on bad data.
+    bool nextFeature(MVTFeature &feature);
+
+    MVTStringRef name;
+    uint32_t extent;
+    uint32_t version;
+
+    // Filled in by decodeTables
+    std::vector<MVTStringRef> keys;
+    std::vector<MVTValue> values;
+
+    // Set if we ran into bad data
+    bool error;
+
+    // The encoded layer and where we are in it
+    const uint8_t *start,*end,*pos;
+};
+
+/** Walks the Mapbox Vector Tile wire format directly over the encoded data.
+    Nothing is copied out of the buffer, so it has to outlive the reader and
+    anything it hands back.
+  */
+class MapboxVectorTileReader
+{
+public:
+    MapboxVectorTileReader(const void *data,size_t len);
+
+    // Move on to the next layer.  Returns false at the end of the tile or on bad data.
+    bool nextLayer(MVTLayer &layer);
+
+    // Set if we ran into bad data
+    bool hasError() const;
+
+protected:
+    const uint8_t *pos,*end;
+    bool error;
+};
+
+}
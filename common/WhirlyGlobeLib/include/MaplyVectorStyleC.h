@@ -123,6 +123,11 @@ public:
     
     /// Return the background color for a given zoom level
     virtual RGBAColorRef backgroundColor(double zoom) = 0;
+    
+    /// Return true if the styles only look at attributes through the Dictionary interface.
+    /// The parser can then hand them compact attributes backed by shared per-layer tables
+    ///  rather than building a platform dictionary for every feature.
+    virtual bool usesSharedAttributes() { return false; }
 };
 typedef std::shared_ptr<VectorStyleDelegateImpl> VectorStyleDelegateImplRef;
 
@@ -144,6 +149,10 @@ public:
 
     /// Construct objects related to this style based on the input data.
     virtual void buildObjects(PlatformThreadInfo *inst, std::vector<VectorObjectRef> &vecObjs,VectorTileDataRef tileInfo) = 0;
+    
+    /// Return true if buildObjects can run on a worker thread alongside the other styles for a tile.
+    /// It gets no PlatformThreadInfo there and mustn't modify the vector objects, which the styles share.
+    virtual bool threadSafeBuild() { return false; }
 };
 
 }
@@ -19,13 +19,18 @@
  */
 
 #import <string>
-#import <map>
+#import <unordered_map>
+#import <vector>
 #import "WhirlyTypes.h"
+#import "Profiler.h"
 
 namespace WhirlyKit
 {
     
-/// Simple performance timing class
+/** Simple performance timing class.
+    Timings and counts are tracked by interned ID so the per-frame cost is an array lookup.
+    If the Profiler is turned on, everything is also recorded there for export.
+  */
 class PerformanceTimer
 {
 public:
@@ -59,13 +64,18 @@ public:
     };
     
     /// Start timing the given thing
-    void startTiming(const std::string &);
+    void startTiming(ProfileID what);
     
     /// Stop timing the given thing and add it to the existing timings
-    void stopTiming(const std::string &);
+    void stopTiming(ProfileID what);
     
     /// Add a count for a particular instance
-    void addCount(const std::string &what,int count);
+    void addCount(ProfileID what,int count);
+    
+    /// Versions that look up the name first.  Use the ProfileID versions in anything called every frame.
+    void startTiming(const std::string &what) { startTiming(lookupName(what)); }
+    void stopTiming(const std::string &what) { stopTiming(lookupName(what)); }
+    void addCount(const std::string &what,int count) { addCount(lookupName(what),count); }
     
     /// Print out a string
     void report(const std::string &what);
@@ -77,10 +87,16 @@ public:
     void log();
     
 protected:
-    std::map<std::string,TimeInterval> actives;
-    std::map<std::string,TimeEntry> timeEntries;
-    std::map<std::string,CountEntry> countEntries;
+    // Find the ID for a name, only going to the Profiler the first time we see it
+    ProfileID lookupName(const std::string &what);
+
+    // Names we've already looked up
+    std::unordered_map<std::string,ProfileID> nameIDs;
+    // Start times in nanoseconds, indexed by ID.  Zero if not active.
+    std::vector<uint64_t> actives;
+    // Indexed by ID, with empty entries for IDs we haven't seen
+    std::vector<TimeEntry> timeEntries;
+    std::vector<CountEntry> countEntries;
 };
     
 }
-
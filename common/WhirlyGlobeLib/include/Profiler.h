@@ -0,0 +1,123 @@
+/*
+ *  Profiler.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <atomic>
+#import <string>
+#import <vector>
+#import <stdint.h>
+
+namespace WhirlyKit
+{
+
+/// Names are interned once and referred to by ID after that
+typedef int ProfileID;
+
+/// A single timing or count, as recorded by one thread
+class ProfileEvent
+{
+public:
+    typedef enum {Timing,Count} Type;
+
+    ProfileID nameID;
+    Type type;
+    /// Renderer frame this was recorded during
+    unsigned int frame;
+    /// Which thread recorded it (in order of first use)
+    unsigned int thread;
+    /// Start time in nanoseconds (steady clock)
+    uint64_t startNanos;
+    /// Duration in nanoseconds for timings, the count otherwise
+    int64_t value;
+};
+
+/** Low overhead profiling, meant to be left in place.
+    Each thread records into its own fixed size ring buffer, so recording is a
+    few stores and nothing is ever locked on the hot path.  The buffers can be
+    pulled out at any time and exported as a Chrome trace (chrome://tracing).
+    A thread's buffer is freed when the thread exits, keeping only its most recent events.
+    When profiling is disabled, recording is a single flag check.
+  */
+class Profiler
+{
+public:
+    /// Look up (or create) the ID for a name.  This locks, so do it once and keep the ID around.
+    static ProfileID RegisterName(const std::string &name);
+
+    /// Return the name for a given ID
+    static std::string GetName(ProfileID nameID);
+
+    /// Turn recording on or off
+    static void SetEnabled(bool enable);
+    static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /// Number of events each thread keeps around.  Only affects threads that haven't recorded yet.
+    static void SetBufferSize(int numEvents);
+
+    /// Called by the renderer at the start of each frame
+    static void BeginFrame() { curFrame.fetch_add(1,std::memory_order_relaxed); }
+    static unsigned int CurrentFrame() { return curFrame.load(std::memory_order_relaxed); }
+
+    /// Current time in nanoseconds from a steady clock
+    static uint64_t NowNanos();
+
+    /// Record a timing that's already finished
+    static void RecordTiming(ProfileID nameID,uint64_t startNanos,uint64_t endNanos);
+
+    /// Record a count, such as the number of drawables drawn
+    static void RecordCount(ProfileID nameID,int64_t count);
+
+    /// Copy out everything currently in the ring buffers, sorted by start time
+    static void CollectEvents(std::vector<ProfileEvent> &events);
+
+    /// Write everything currently in the ring buffers out as Chrome trace JSON
+    static bool ExportChromeTrace(const std::string &fileName);
+
+    /// Throw out everything recorded so far
+    static void Clear();
+
+protected:
+    static std::atomic<bool> enabled;
+    static std::atomic<unsigned int> curFrame;
+};
+
+/** Times the enclosing scope, if profiling is turned on.
+    Typical use is with a static ID:
+        static const ProfileID profID = Profiler::RegisterName("Draw");
+        ProfileScope scope(profID);
+  */
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileID nameID)
+    : nameID(nameID), startNanos(Profiler::IsEnabled() ? Profiler::NowNanos() : 0)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (startNanos && Profiler::IsEnabled())
+            Profiler::RecordTiming(nameID,startNanos,Profiler::NowNanos());
+    }
+
+protected:
+    ProfileID nameID;
+    uint64_t startNanos;
+};
+
+}
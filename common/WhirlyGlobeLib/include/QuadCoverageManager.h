@@ -0,0 +1,89 @@
+/*
+ *  QuadCoverageManager.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "Scene.h"
+#import "QuadSamplingParams.h"
+#import "QuadDisplayControllerNew.h"
+
+namespace WhirlyKit
+{
+
+/** Coverage shared between quad display controllers with the same sampling parameters.
+    The first controller to ask about a given view does the evaluation.
+    The rest get the same set of nodes back and diff it against their own.
+  */
+class QuadCoverageShare
+{
+public:
+    QuadCoverageShare(const SamplingParams &params);
+    
+    /// Parameters we were set up with
+    const SamplingParams &getParams() { return params; }
+    
+    /// Return the target level and nodes for the given view.
+    /// If nobody's evaluated this view yet, the controller does it.
+    std::tuple<int,QuadTreeNew::ImportantNodeSet> getCoverage(QuadDisplayControllerNew *control,ViewStateRef viewState,const Point2f &frameSize,bool keepMinLevel,bool &evaluated);
+    
+    /// Number of times we actually evaluated the quad tree
+    int getNumEvaluated();
+    
+    /// Number of times we handed back an existing evaluation
+    int getNumShared();
+    
+protected:
+    friend class QuadCoverageManager;
+    
+    std::mutex lock;
+    SamplingParams params;
+    int numUsers;
+    
+    // Last view we evaluated and what we got
+    ViewStateRef viewState;
+    Point2f frameSize;
+    bool keepMinLevel;
+    int targetLevel;
+    QuadTreeNew::ImportantNodeSet nodes;
+    
+    int numEvaluated,numShared;
+};
+typedef std::shared_ptr<QuadCoverageShare> QuadCoverageShareRef;
+
+#define kWKQuadCoverageManager "WKQuadCoverageManager"
+
+/** Hands out shared coverage evaluations to quad sampling controllers.
+    Controllers with the same coverage parameters get the same QuadCoverageShare.
+  */
+class QuadCoverageManager : public SceneManager
+{
+public:
+    QuadCoverageManager();
+    virtual ~QuadCoverageManager();
+    
+    /// Find (or make) the coverage share for the given parameters
+    QuadCoverageShareRef addUser(const SamplingParams &params);
+    
+    /// Done with the given coverage share
+    void removeUser(QuadCoverageShareRef share);
+    
+protected:
+    std::mutex lock;
+    std::vector<QuadCoverageShareRef> shares;
+};
+
+}
@@ -26,10 +26,13 @@
 #import "ScreenImportance.h"
 #import "WhirlyKitView.h"
 #import "QuadTreeNew.h"
+#import "QuadTreeNodeMap.h"
 
 namespace WhirlyKit
 {
 class QuadDisplayControllerNew;
+class QuadCoverageShare;
+typedef std::shared_ptr<QuadCoverageShare> QuadCoverageShareRef;
 
 /** Quad tree based data structure.  Fill this in to provide structure and
  extents for the quad tree.
@@ -56,20 +59,25 @@ public:
     /// Return the maximum quad tree zoom level.  Must be at least minZoom
     virtual int getMaxZoom() = 0;
     
-    /// Return an importance value for the given tile
+    /// Return an importance value for the given tile.
+    /// The display solid is cached by the caller between view updates.
+    /// Fill it in if it's empty, otherwise reuse it.
     virtual double importanceForTile(const QuadTreeIdentifier &ident,
                                              const Mbr &mbr,
                                              ViewStateRef viewState,
-                                             const Point2f &frameSize) = 0;
+                                             const Point2f &frameSize,
+                                             DisplaySolidRef &dispSolid) = 0;
     
     /// Called when the view state changes.  If you're caching info, do it here.
     virtual void newViewState(ViewStateRef viewState) = 0;
     
-    /// Return true if the tile is visible, false otherwise
+    /// Return true if the tile is visible, false otherwise.
+    /// Display solid is treated the same as in importanceForTile.
     virtual bool visibilityForTile(const QuadTreeIdentifier &ident,
                                            const Mbr &mbr,
                                            ViewStateRef viewState,
-                                           const Point2f &frameSize) = 0;
+                                           const Point2f &frameSize,
+                                           DisplaySolidRef &dispSolid) = 0;
 };
 
 /** The Quad Display Layer (New) calls an object with this protocol.
@@ -146,12 +154,28 @@ public:
     std::vector<double> getMinImportancePerLevel();
     void setMinImportancePerLevel(const std::vector<double> &imports);
     
+    /// Also load tiles for where the camera is headed, extrapolated lookAhead seconds out.
+    /// Those come out of their own budget (maxPrefetchTiles) and sort behind visible tiles.
+    /// A lookAhead of 0 turns this off (the default).
+    void setPrefetch(TimeInterval lookAhead,int maxPrefetchTiles);
+    TimeInterval getPrefetchLookAhead();
+    
+    /// True if we're only loading this tile because of where the camera is headed.
+    /// Loaders shouldn't wait on these before switching levels.
+    bool isPrefetchOnly(const QuadTreeNew::Node &node);
+    
     /// Return the geometry information being used
     QuadDataStructure *getDataStructure();
     
     /// Return the current view state, if there is one
     ViewStateRef getViewState();
     
+    /// Share coverage evaluation with other controllers that have the same settings
+    void setCoverageShare(QuadCoverageShareRef share);
+    
+    /// Work out the target level and the nodes to load for the current view state
+    std::tuple<int,QuadTreeNew::ImportantNodeSet> evalCoverage(bool keepMinLevel);
+    
     // Notify any attached loaders and generally get ready to party
     virtual void start();
     
@@ -189,6 +213,54 @@ protected:
     QuadTreeNew::ImportantNodeSet currentNodes;
 
     ViewStateRef viewState;
+    Point2f frameSize;
+    QuadCoverageShareRef coverageShare;
+
+    /// What we remember about a node between view updates
+    class NodeCacheEntry
+    {
+    public:
+        NodeCacheEntry() : importance(0.0), viewGen(-1), predictImportance(0.0), predictGen(-1), lastUpdate(-1) { }
+
+        // Display solids don't depend on the view, so we keep them as long as the node is evaluated
+        DisplaySolidRef dispSolid;
+        // Importance is good as long as the view hasn't moved
+        double importance;
+        int viewGen;
+        // Same, but for the predicted view
+        double predictImportance;
+        int predictGen;
+        int lastUpdate;
+    };
+    typedef QuadTreeNodeMap<NodeCacheEntry> NodeCache;
+
+    /// Look up (or create) the cache entry for a node
+    NodeCacheEntry &cacheEntryForNode(const Node &node);
+    
+    /// Extrapolate the camera from the previous view state to the current one and beyond
+    ViewStateRef predictViewState(ViewStateRef prevState,TimeInterval dt);
+    
+    /// Figure out the tiles we'd want for the predicted view that we're not already loading
+    void updatePrefetch(ViewStateRef prevState,TimeInterval dt,bool keepMinLevel,const QuadTreeNew::ImportantNodeSet &newNodes);
+
+    NodeCache nodeCache;
+    /// Incremented every time the view (or frame size) actually changes
+    int viewGen;
+    /// Incremented for every predicted view
+    int predictGen;
+    /// Set while we're evaluating the predicted view
+    bool predicting;
+    /// Incremented on every view update.  Nodes not touched in an update are dropped.
+    int updateCount;
+    
+    TimeInterval prefetchLookAhead;
+    int maxPrefetchTiles;
+    /// When the view last actually changed
+    TimeInterval viewChangeTime;
+    /// Tiles we're loading ahead of the camera
+    QuadTreeNew::ImportantNodeSet prefetchNodes;
+    /// Keys of the prefetch tiles that aren't also visible, sorted
+    std::vector<uint64_t> prefetchOnlyKeys;
 };
     
 typedef std::shared_ptr<QuadDisplayControllerNew> QuadDisplayControllerNewRef;
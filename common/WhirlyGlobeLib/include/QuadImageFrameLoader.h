@@ -79,7 +79,7 @@ public:
     virtual void loadFailed(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader);
     
     // We're not bothering to load it, but pretend like it succeeded
-    virtual void loadSkipped();
+    virtual void loadSkipped(QuadImageFrameLoader *loader);
 
     // Store the raw data for use later
     virtual void setLoadReturn(const RawDataRef &data);
@@ -94,6 +94,9 @@ public:
     virtual void clearLoadReturn();
     
 protected:
+    // Change the state, keeping the loader's count of fetches in flight up to date
+    void setState(QuadImageFrameLoader *loader,State newState);
+    
     State state;
     
     int priority;
@@ -154,6 +157,12 @@ public:
     
     // Check if we've already loaded any of the given frames
     virtual bool anyFramesLoaded(const std::set<QuadFrameInfoRef> &frameInfos);
+    
+    typedef enum {FramesLoading=1<<0,FramesLoaded=1<<1} FrameStatusBits;
+    
+    // Loading and loaded status over the active frames, in a single pass.
+    // activeFrames is indexed the same way as the frames.  Returns a mask of FrameStatusBits.
+    virtual int activeFrameStatus(const std::vector<bool> &activeFrames);
 
     // True if the given frame is loading
     virtual bool isFrameLoading(QuadFrameInfoRef frameInfo);
@@ -183,6 +192,13 @@ public:
                                const std::vector<SimpleIdentity> &shaderIDs,
                                ChangeSet &changes);
     
+    // The tile geometry was rebuilt, so replace the instances that mirror it
+    virtual void resetContents(QuadImageFrameLoader *loader,
+                               LoadedTileNewRef loadedTile,
+                               int defaultDrawPriority,
+                               const std::vector<SimpleIdentity> &shaderIDs,
+                               ChangeSet &changes);
+    
     // Change the color immediately
     virtual void setColor(QuadImageFrameLoader *loader,
                           const RGBAColor &newColor,
@@ -234,7 +250,21 @@ protected:
 };
 
 typedef std::shared_ptr<QIFTileAsset> QIFTileAssetRef;
-typedef std::map<QuadTreeNew::Node,QIFTileAssetRef> QIFTileAssetMap;
+typedef QuadTreeNodeMap<QIFTileAssetRef> QIFTileAssetMap;
+
+// A fetch we want to make, but haven't handed to the tile fetcher yet
+class QIFPendingFetch
+{
+public:
+    QIFPendingFetch();
+    
+    // Frame indices waiting to go out.  -1 means the tile as a whole (no frames).
+    std::set<int> frames;
+    
+    // When the fetch was first queued.  Older fetches get a boost.
+    TimeInterval queueTime;
+};
+typedef QuadTreeNodeMap<QIFPendingFetch> QIFPendingFetchMap;
 
 // Information about a single tile and its current state
 class QIFTileState
@@ -305,6 +335,7 @@ public:
   */
 class QuadImageFrameLoader : public QuadTileBuilderDelegate, public ActiveModel
 {
+    friend class QIFFrameAsset;
 public:
     typedef enum {SingleFrame,MultiFrame,Object} Mode;
     
@@ -334,6 +365,15 @@ public:
     
     // Calculate the load priority for a given tile, respecting the rules
     int calcLoadPriority(const QuadTreeNew::ImportantNode &ident,int frame);
+    
+    // Calculate the order we'll fetch a given tile frame in.  Higher goes first.
+    // Takes importance, level, distance from the current frame, and time spent waiting into account.
+    double calcFetchScore(const QuadTreeNew::ImportantNode &ident,int frame,TimeInterval age);
+    
+    /// Limit the number of frame fetches we'll have outstanding at once.
+    /// The rest wait, best score first.  0 (the default) means no limit.
+    void setMaxFetchesInFlight(int maxFetches);
+    int getMaxFetchesInFlight();
 
     /// Recalculate the loading default priorites
     void updatePriorityDefaults();
@@ -527,6 +567,15 @@ protected:
     virtual void removeTile(PlatformThreadInfo *threadInfo,const QuadTreeNew::Node &ident, QIFBatchOps *batchOps, ChangeSet &changes);
     QIFTileAssetRef addNewTile(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident,QIFBatchOps *batchOps,ChangeSet &changes);
     
+    // Queue up a fetch for one frame of a tile, or all of them if frame is NULL
+    void queueFetch(const QuadTreeNew::Node &ident,QuadFrameInfoRef frame,TimeInterval now);
+    
+    // Hand the best scoring queued fetches over to the fetcher, up to the in-flight limit
+    void dispatchFetches(PlatformThreadInfo *threadInfo,QIFBatchOps *batchOps,ChangeSet &changes);
+    
+    // Number of frame fetches outstanding with the fetcher
+    int numFetchesInFlight() { return numFetching; }
+    
     Mode mode;
     LoadMode loadMode;
     
@@ -563,6 +612,12 @@ protected:
     // Tiles in various states of loading or loaded
     QIFTileAssetMap tiles;
     
+    // Fetches waiting their turn.  Tiles that go away are dropped from here before we ever ask for them.
+    QIFPendingFetchMap pendingFetches;
+    int maxFetchesInFlight;
+    // Frames in the Loading state, kept up to date by the frames themselves
+    int numFetching;
+    
     // The builder this is a delegate of
     QuadDisplayControllerNew *control;
     QuadTileBuilder *builder;
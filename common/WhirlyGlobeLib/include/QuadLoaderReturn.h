@@ -24,6 +24,7 @@
 #import "ComponentManager.h"
 #import "ImageTile.h"
 #import "QuadTreeNew.h"
+#import "ElevationChunk.h"
 
 namespace WhirlyKit
 {
@@ -62,6 +63,9 @@ public:
     // Overlay component objects added for a tile
     std::vector<ComponentObjectRef> ovlCompObjs;
     
+    // Elevation for the tile, if the loader has any.  The tile geometry is displaced by it.
+    ElevationChunkRef elevChunk;
+    
     // If we make changes directly with the managers, they are reflected in this change set
     ChangeSet changes;
     
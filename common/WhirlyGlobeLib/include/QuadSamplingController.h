@@ -81,7 +81,8 @@ public:
     virtual double importanceForTile(const QuadTreeIdentifier &ident,
                                      const Mbr &mbr,
                                      ViewStateRef viewState,
-                                     const Point2f &frameSize);
+                                     const Point2f &frameSize,
+                                     DisplaySolidRef &dispSolid);
     
     /// Called when the view state changes.  If you're caching info, do it here.
     virtual void newViewState(ViewStateRef viewState);
@@ -90,7 +91,8 @@ public:
     virtual bool visibilityForTile(const QuadTreeIdentifier &ident,
                                    const Mbr &mbr,
                                    ViewStateRef viewState,
-                                   const Point2f &frameSize);
+                                   const Point2f &frameSize,
+                                   DisplaySolidRef &dispSolid);
     
     /// **** QuadTileBuilderDelegate methods ****
 
@@ -120,6 +122,9 @@ public:
     virtual bool builderIsLoading();
 
 protected:
+    /// Find the display solid for a tile, rebuilding it if the tile's height range has changed
+    void updateDisplaySolid(const QuadTreeIdentifier &ident,const Mbr &mbr,DisplaySolidRef &dispSolid);
+    
     bool debugMode;
 
     std::mutex lock;
@@ -129,6 +134,8 @@ protected:
 
     WhirlyKit::Scene *scene;
     SceneRenderer *renderer;
+    DisplaySolidCache *solidCache;
+    QuadCoverageShareRef coverageShare;
 
     QuadTileBuilderRef builder;
     std::vector<QuadTileBuilderDelegateRef> builderDelegates;
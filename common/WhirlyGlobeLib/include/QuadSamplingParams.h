@@ -38,6 +38,10 @@ public:
     
     bool operator == (const SamplingParams &) const;
     
+    /// True if the two would pick the same tiles for any given view.
+    /// Unlike ==, this ignores how the tiles are built (geometry, tessellation, skirts, poles).
+    bool coverageSameAs(const SamplingParams &) const;
+    
     /// The coordinate system we'll be sampling from.
     CoordSystemRef coordSys;
     /// Bounding box for the coordinate system
@@ -65,6 +69,9 @@ public:
     /// If set, generate skirt geometry to hide the edges between levels
     bool edgeMatching;
     
+    /// If set, displace the tile geometry by whatever elevation the loaders provide
+    bool includeElev;
+    
     /// Tesselation values per level for breaking down the coordinate system (e.g. globe)
     int tessX,tessY;
     
@@ -98,6 +105,12 @@ public:
     void setImportanceLevel(double minImportance,int level);
     
     std::vector<double> importancePerLevel;
+    
+    /// If non-zero, also load tiles for where the camera will be this many seconds out
+    double prefetchLookAhead;
+    
+    /// Maximum number of tiles to load ahead of the camera.  Separate from maxTiles.
+    int maxPrefetchTiles;
 };
 
     
@@ -115,6 +115,18 @@ public:
     void setDrawPriorityPerLevel(int);
     int getDrawPriorityPerLevel() const;
     
+    // If set, we'll displace the tile geometry by any elevation the loaders hand us
+    void setIncludeElev(bool);
+    bool getIncludeElev() const;
+    
+    // Elevation for a single tile.  Tiles use it, or their nearest ancestor's.
+    // Passes back the tiles that had to be rebuilt to pick it up.
+    LoadedTileVec addElevationChunk(const QuadTreeNew::Node &ident,ElevationChunkRef chunk,ChangeSet &changes);
+    void removeElevationChunk(const QuadTreeNew::Node &ident);
+    
+    // Height range for a tile, if we have any elevation covering it
+    bool getElevationRange(const QuadTreeNew::Node &ident,double &minZ,double &maxZ);
+    
     // Set if we're using single level loading logic
     void setSingleLevel(bool);
     bool getSingleLevel() const;
@@ -66,9 +66,10 @@ public:
     public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
 
-        Node() { }
+        Node() : x(0), y(0), level(0) { }
         Node(const QuadTreeIdentifier &that) : x(that.x), y(that.y), level(that.level) { }
         Node(const Node &that) : x(that.x), y(that.y), level(that.level) { }
+        Node &operator = (const Node &that) { x = that.x;  y = that.y;  level = that.level;  return *this; }
         /// Construct with the cell coordinates and level.
         Node(int x,int y,int level) : x(x), y(y), level(level) { }
         
@@ -81,6 +82,14 @@ public:
         /// Not equal operator
         bool operator != (const Node &that) const;
         
+        /// Pack the node into a single 64 bit key.
+        /// The level goes in the top 6 bits with x and y interleaved (Morton order) below.
+        /// Good for up to level 29.
+        uint64_t key() const;
+        
+        /// Unpack a node from a key generated by key()
+        static Node FromKey(uint64_t key);
+        
         /// Spatial subdivision along the X axis relative to the space
         int x;
         /// Spatial subdivision along tye Y axis relative to the space
@@ -114,6 +123,7 @@ public:
         First figure out the highest level we could load.
         Try to load all visible tiles at that level.
         If it's too many, back off a level. Repeat.
+        This is done in a single pass over the tree, evaluating each node once.
       */
     std::tuple<int,ImportantNodeSet> calcCoverageVisible(const std::vector<double> &minImportance,int maxNodes,const std::vector<int> &levelLoads,bool keepMinLevel);
     
@@ -127,8 +137,6 @@ public:
     
     // Recursively visit the quad tree evaluating as we go
     void evalNodeImportance(ImportantNode node,const std::vector<double> &minImportance,ImportantNodeSet &importSet);
-    // This version uses pure visiblity and goes down to a predefined level
-    bool evalNodeVisible(ImportantNode node,const std::vector<double> &minImportance,int maxNodes,const std::set<int> &levelsToLoad,int maxLevel,ImportantNodeSet &visibleSet);
     
     /// Bounding box
     MbrD mbr;
@@ -0,0 +1,217 @@
+/*
+ *  QuadTreeNodeMap.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <vector>
+#import <utility>
+#import "QuadTreeNew.h"
+
+namespace WhirlyKit
+{
+
+/** Hash map from quad tree nodes to values.
+    Nodes are packed into their 64 bit key and stored in a single flat
+    table with linear probing.  That avoids the per-entry allocation and
+    pointer chasing of a std::map, which adds up when the map holds
+    hundreds of tiles and gets hit on every view update.
+    Iteration order is arbitrary.
+  */
+template<typename T>
+class QuadTreeNodeMap
+{
+public:
+    typedef std::pair<QuadTreeNew::Node,T> value_type;
+
+protected:
+    class Slot
+    {
+    public:
+        Slot() : used(false), key(0) { }
+        bool used;
+        uint64_t key;
+        value_type entry;
+    };
+
+    template<typename SlotPtr,typename ValueType>
+    class IteratorBase
+    {
+    public:
+        IteratorBase() : slot(NULL), end(NULL) { }
+        IteratorBase(SlotPtr slot,SlotPtr end) : slot(slot), end(end) { skip(); }
+
+        ValueType &operator * () const { return slot->entry; }
+        ValueType *operator -> () const { return &slot->entry; }
+        IteratorBase &operator ++ () { slot++;  skip();  return *this; }
+        bool operator == (const IteratorBase &that) const { return slot == that.slot; }
+        bool operator != (const IteratorBase &that) const { return slot != that.slot; }
+
+    protected:
+        friend class QuadTreeNodeMap;
+
+        // Move forward to the next slot in use
+        void skip() { while (slot != end && !slot->used) slot++; }
+
+        SlotPtr slot,end;
+    };
+
+public:
+    typedef IteratorBase<Slot *,value_type> iterator;
+    typedef IteratorBase<const Slot *,const value_type> const_iterator;
+
+    QuadTreeNodeMap() : num(0) { }
+
+    iterator begin() { return iterator(slots.data(),slots.data()+slots.size()); }
+    iterator end() { return iterator(slots.data()+slots.size(),slots.data()+slots.size()); }
+    const_iterator begin() const { return const_iterator(slots.data(),slots.data()+slots.size()); }
+    const_iterator end() const { return const_iterator(slots.data()+slots.size(),slots.data()+slots.size()); }
+
+    size_t size() const { return num; }
+    bool empty() const { return num == 0; }
+
+    /// Remove everything, but keep the table around for reuse
+    void clear()
+    {
+        for (auto &slot : slots)
+            slot = Slot();
+        num = 0;
+    }
+
+    /// Make room for the given number of entries without growing
+    void reserve(size_t count)
+    {
+        size_t newSize = 16;
+        while (newSize * 3 < count * 4)
+            newSize *= 2;
+        if (newSize > slots.size())
+            rehash(newSize);
+    }
+
+    iterator find(const QuadTreeNew::Node &node)
+    {
+        const size_t which = findSlot(node.key());
+        return which == NotFound ? end() : iterator(slots.data()+which,slots.data()+slots.size());
+    }
+
+    const_iterator find(const QuadTreeNew::Node &node) const
+    {
+        const size_t which = findSlot(node.key());
+        return which == NotFound ? end() : const_iterator(slots.data()+which,slots.data()+slots.size());
+    }
+
+    size_t count(const QuadTreeNew::Node &node) const { return findSlot(node.key()) == NotFound ? 0 : 1; }
+
+    /// Return the value for the node, adding a default one if it's not there
+    T &operator [] (const QuadTreeNew::Node &node)
+    {
+        const uint64_t key = node.key();
+        size_t which = findSlot(key);
+        if (which != NotFound)
+            return slots[which].entry.second;
+
+        if ((num+1) * 4 > slots.size() * 3)
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        which = hashKey(key) & (slots.size()-1);
+        while (slots[which].used)
+            which = (which+1) & (slots.size()-1);
+        Slot &slot = slots[which];
+        slot.used = true;
+        slot.key = key;
+        slot.entry.first = node;
+        num++;
+
+        return slot.entry.second;
+    }
+
+    /// Remove the entry the iterator points to.
+    /// Other entries may move, so don't keep iterating afterwards.
+    void erase(iterator it)
+    {
+        eraseSlot(it.slot - slots.data());
+    }
+
+    /// Remove the entry for the given node, if it's there
+    size_t erase(const QuadTreeNew::Node &node)
+    {
+        const size_t which = findSlot(node.key());
+        if (which == NotFound)
+            return 0;
+        eraseSlot(which);
+        return 1;
+    }
+
+protected:
+    static const size_t NotFound = (size_t)-1;
+
+    // Node keys are very regular, so mix the bits up before we use them
+    static size_t hashKey(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return (size_t)key;
+    }
+
+    size_t findSlot(uint64_t key) const
+    {
+        if (slots.empty())
+            return NotFound;
+        const size_t mask = slots.size()-1;
+        for (size_t which = hashKey(key) & mask;slots[which].used;which = (which+1) & mask)
+            if (slots[which].key == key)
+                return which;
+        return NotFound;
+    }
+
+    // Backward shift deletion, so we never need tombstones
+    void eraseSlot(size_t hole)
+    {
+        const size_t mask = slots.size()-1;
+        for (size_t next = (hole+1) & mask;slots[next].used;next = (next+1) & mask) {
+            // Move the entry back if the hole is between its home slot and where it is now
+            const size_t home = hashKey(slots[next].key) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                slots[hole] = std::move(slots[next]);
+                hole = next;
+            }
+        }
+        slots[hole] = Slot();
+        num--;
+    }
+
+    void rehash(size_t newSize)
+    {
+        std::vector<Slot> oldSlots(newSize);
+        oldSlots.swap(slots);
+        const size_t mask = slots.size()-1;
+        for (auto &slot : oldSlots) {
+            if (!slot.used)
+                continue;
+            size_t which = hashKey(slot.key) & mask;
+            while (slots[which].used)
+                which = (which+1) & mask;
+            slots[which] = std::move(slot);
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t num;
+};
+
+}
@@ -77,6 +77,10 @@ public:
     bool getDouble(double &val);
     // Read a string
     bool getString(std::string &str);
+    // Read a 64 bit integer
+    bool getInt64(int64_t &val);
+    // Copy out the given number of bytes
+    bool getBytes(void *bytes,unsigned long len);
     
 protected:
     const RawData *rawData;
@@ -108,6 +112,10 @@ public:
     virtual void addDouble(double dVal);
     // Add a string
     virtual void addString(const std::string &str);
+    // Add a 64 bit integer
+    virtual void addInt64(int64_t iVal);
+    // Add a blob of bytes, no length included
+    virtual void addBytes(const void *bytes,unsigned long len);
     
 protected:
     std::vector<unsigned char> data;
@@ -27,6 +27,10 @@
 #import "BasicDrawableInstance.h"
 #import "ActiveModel.h"
 #import "CoordSystem.h"
+#import "DrawableSpatialIndex.h"
+#import "ChangeQueue.h"
+#import "DrawableStateChange.h"
+#import "ChangeRecorder.h"
 
 namespace WhirlyKit
 {
@@ -63,9 +67,14 @@ public:
 	
     /// Only use this if you've thought it out
     TextureBase *getTex();
+    
+    /// Write out the texture for a recording
+    virtual bool record(MutableRawData *data) const;
 
 protected:
     TextureBaseRef texRef;
+    /// If we're recording, the texture as it was before the renderer got it
+    MutableRawDataRef recordData;
 };
 
 /// Remove a texture referred to by ID
@@ -79,6 +88,9 @@ public:
 
     /// Remove from the renderer.  Never call this.
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
+    
+    /// Write out the texture ID for a recording
+    virtual bool record(MutableRawData *data) const;
 	
 protected:
 	SimpleIdentity texture;
@@ -102,9 +114,14 @@ public:
 
 	/// Add to the renderer.  Never call this
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
+    
+    /// Write out the drawable for a recording
+    virtual bool record(MutableRawData *data) const;
 	
 protected:
     DrawableRef drawRef;
+    /// If we're recording, the drawable as it was before the renderer got it
+    MutableRawDataRef recordData;
 };
 
 /// Ask the renderer to remove the drawable from the scene
@@ -118,6 +135,9 @@ public:
 
     /// Remove the drawable.  Never call this
 	void execute(Scene *scene,SceneRenderer *renderer,View *view);
+    
+    /// Write out the drawable ID for a recording
+    virtual bool record(MutableRawData *data) const;
 	
 protected:	
 	SimpleIdentity drawID;
@@ -223,6 +243,26 @@ protected:
     SceneRenderer *renderer;
 };
 
+/// Stats on change requests the renderer didn't get to in a single frame
+class ChangeProcessingStats
+{
+public:
+    ChangeProcessingStats();
+    
+    /// Requests left over after the last frame
+    int backlog;
+    /// Largest backlog we've seen
+    int maxBacklog;
+    /// Frames the current backlog has been around for
+    int backlogFrames;
+    /// How many frames it took to clear the last backlog
+    int lastDrainFrames;
+    /// Most frames it's taken to clear a backlog
+    int maxDrainFrames;
+    /// Total frames that ended with requests left over
+    uint64_t totalBacklogFrames;
+};
+
 /** This is the top level scene object for WhirlyKit.
     It keeps track of the drawables and the change requests, which
      consist of pretty much everything that can happen.
@@ -240,16 +280,20 @@ public:
     /// You can get the coordinate system we're using from that.
     CoordSystemDisplayAdapter *getCoordAdapter();
     
-    /// Add a single change request.  You can call this from any thread, it locks.
+    /// Add a single change request.  You can call this from any thread, it doesn't lock.
     /// If you have more than one, don't iterate, use the other version.
     void addChangeRequest(ChangeRequest *newChange);
     /// Add a list of change requets.  You can call this from any thread.
-    /// This is the faster option if you have more than one change request
-    void addChangeRequests(const ChangeSet &newchanges);
+    /// This is the faster option if you have more than one change request.
+    /// Set atomic if the changes have to show up in the same frame, like a tile swap.
+    void addChangeRequests(const ChangeSet &newchanges,bool atomic = false);
     
     /// Process change requests
     /// Only the renderer should call this in the rendering thread
-    int processChanges(View *view,SceneRenderer *renderer,TimeInterval now);
+    /// If budgetMicros is non-zero we stop once we've used up that much time and leave
+    ///  the rest for the next frame, highest priority first.  At least one request is always run
+    ///  and the requests from an atomic addChangeRequests call always run in the same frame.
+    int processChanges(View *view,SceneRenderer *renderer,TimeInterval now,int budgetMicros = 0);
     
     /// Some changes generate other changes, so they go first
     int preProcessChanges(View *view,SceneRenderer *renderer,TimeInterval now);
@@ -257,6 +301,22 @@ public:
     /// True if there are pending updates
     bool hasChanges(TimeInterval now);
     
+    /// Number of change requests waiting to be processed (not counting delayed ones)
+    int getNumChangeRequests();
+    
+    /// Counters from the change request queue
+    ChangeQueueStats getChangeQueueStats();
+    
+    /// Stats on the change requests left over from one frame to the next.  Rendering thread only.
+    const ChangeProcessingStats &getChangeProcessingStats() { return changeStats; }
+    
+    /// Record all the change requests handed to us (and the view, once a frame) with the given recorder.
+    /// Pass in an empty one to stop.
+    void setChangeRecorder(ChangeRecorderRef recorder);
+    
+    /// Return the change recorder, if we're recording
+    ChangeRecorderRef getChangeRecorder();
+    
     /// Add sub texture mappings.
     /// These are mappings from images to parts of texture atlases.
     /// They're here so we can use SimpleIdentity's to point into larger
@@ -281,6 +341,19 @@ public:
     
     /// Remove a drawable from the scene
     virtual void remDrawable(DrawableRef drawable);
+    
+    /// Stop culling the given drawable by its MBR, because its geometry no longer stays within it.
+    /// Rendering thread only.
+    void stopCullingDrawable(Drawable *drawable);
+    
+    /// Apply the same state change to a list of drawables.
+    /// IDs are resolved in one pass and missing drawables are skipped.  Rendering thread only.
+    void applyDrawableStates(SceneRenderer *renderer,const SimpleIdentity *drawIDs,size_t numIDs,const DrawableState &state);
+    
+    /// Return the drawables that might be visible with the given model/view/projection matrix.
+    /// Drawables without a usable MBR are always included.  Only call this from the rendering pass.
+    /// It doesn't modify anything, so several threads can query at once while the renderer waits.
+    void findDrawablesInView(const Eigen::Matrix4d &mvpMat,std::vector<Drawable *> &draws);
 
     /// Called once by the renderer so we can reset any managers that care
     void setRenderer(SceneRenderer *renderer);
@@ -347,6 +420,9 @@ public:
     /// All the drawables we've been handed, sorted by ID
     DrawableRefSet drawables;
     
+    /// The same drawables, sorted spatially for culling
+    DrawableSpatialIndex drawIndex;
+    
     typedef std::unordered_map<SimpleIdentity,TextureBaseRef> TextureRefSet;
     /// Textures, sorted by ID
     TextureRefSet textures;
@@ -354,11 +430,13 @@ public:
     /// Mutex for accessing textures
     std::mutex textureLock;
     
-    std::mutex changeRequestLock;
-    /// We keep a list of change requests to execute
-    /// This can be accessed in multiple threads, so we lock it
+    /// Change requests come in from any thread through this queue
+    ChangeSetQueue changeQueue;
+    /// Change requests pulled off the queue, waiting to be run.  Rendering thread only.
     ChangeSet changeRequests;
-    SortedChangeSet timedChangeRequests;
+    ChangeProcessingStats changeStats;
+    /// If set, we're recording the changes as they come in
+    ChangeRecorderRef changeRecorder;
     
     std::mutex subTexLock;
     typedef std::set<SubTexture> SubTextureSet;
@@ -398,6 +476,9 @@ public:
     
 protected:
     
+    // Reset the spatial index bounds from the coordinate adapter
+    void updateDrawIndexBounds();
+    
     // If time is being set externally
     TimeInterval currentTime;
 
@@ -24,6 +24,7 @@
 #import "PerformanceTimer.h"
 #import "Lighting.h"
 #import "RenderTarget.h"
+#import "WorkerPool.h"
 
 namespace WhirlyKit
 {
@@ -179,8 +180,8 @@ public:
     SceneRenderer();
     virtual ~SceneRenderer();
     
-    /// Renderer type.  Just two for now.
-    typedef enum {RenderGLES,RenderMetal} Type;
+    /// Renderer type.  Headless is for testing and benchmarking without a GPU.
+    typedef enum {RenderGLES,RenderMetal,RenderHeadless} Type;
     virtual Type getType() = 0;
     
     /// Set the render until time.  This is used by things like fade to keep
@@ -252,6 +253,13 @@ public:
     /// If set, we'll use the view changes to trigger rendering
     virtual void setUseViewChanged(bool newVal);
     
+    /// If set, we'll use the scene's spatial index to skip drawables outside the view.  On by default.
+    virtual void setUseDrawableCulling(bool newVal);
+    
+    /// Limit the time spent on change requests each frame (in microseconds).
+    /// Whatever doesn't fit is left for the next frame.  0 (the default) means no limit.
+    virtual void setChangeBudget(int budgetMicros);
+    
     /// Current view (opengl view) we're tied to
     virtual void setView(View *newView);
     
@@ -259,6 +267,9 @@ public:
     virtual void addDrawable(DrawableRef newDrawable);
     /// Remove the given drawable from
     virtual void removeDrawable(DrawableRef draw,bool teardown);
+    
+    /// A drawable's textures or program changed, so it may need to move in the draw order
+    void drawableSortKeysChanged(SimpleIdentity drawID);
         
     /// Move things around as required by outside updates
     virtual void updateWorkGroups(RendererFrameInfo *frameInfo);
@@ -311,6 +322,12 @@ public:
     
     /// Construct a renderer-specific dynamic texture
     virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const = 0;
+    
+    /// Construct a renderer-specific texture
+    virtual TextureRef makeTexture(const std::string &name) const = 0;
+    
+    /// Construct a renderer-specific triangle list that drawables can share
+    virtual SharedTrianglesRef makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const = 0;
 
     /// The pixel width of the CAEAGLLayer.
     int framebufferWidth;
@@ -361,6 +378,12 @@ protected:
     /// Force a draw at the next opportunity
     bool triggerDraw;
     
+    /// Cull drawables against the view using the scene's spatial index
+    bool useDrawableCulling;
+    
+    /// Time we're allowed to spend on change requests per frame (microseconds, 0 for no limit)
+    int changeBudget;
+    
     unsigned int frameCount;
     unsigned int frameCountLastChanged;
     TimeInterval frameCountStart;
@@ -390,6 +413,106 @@ protected:
     TimeInterval lightsLastUpdated;
     Material defaultMat;    
     std::vector<DirectionalLight> lights;
+    
+protected:
+    friend class DrawListSortStruct;
+    
+    /// Matrices for a drawable (or a whole offset) in the form we hand to the shaders
+    class DrawMatrices
+    {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        
+        Eigen::Matrix4f mvpMat,mvpInvMat,mvMat,mvNormalMat;
+    };
+    typedef std::vector<DrawMatrices,Eigen::aligned_allocator<DrawMatrices> > DrawMatricesVector;
+    
+    /// Matrices for one of the offsets (only one if we're not wrapping)
+    class OffsetMatrices : public DrawMatrices
+    {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        
+        Eigen::Matrix4d mvpMat4d,mvMat4d,mvNormalMat4d;
+        Eigen::Matrix4d pvMat4d;
+    };
+    typedef std::vector<OffsetMatrices,Eigen::aligned_allocator<OffsetMatrices> > OffsetMatricesVector;
+    
+    /// A single drawable in the retained draw list along with its sort keys and cached matrices
+    class DrawListEntry
+    {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        
+        DrawListEntry(Drawable *draw);
+        
+        /// Read the sort keys from the drawable again.  Returns true if any changed.
+        bool updateSortKeys();
+        
+        Drawable *drawable;
+        // Sort keys, captured when the drawable was added and when it changes
+        unsigned int drawPriority;
+        bool requestZBuffer;
+        SimpleIdentity programID,texID;
+        
+        // Offsets this drawable is visible in, valid if frameStamp matches the current frame
+        unsigned int frameStamp;
+        uint64_t offsetMask;
+        bool isOn;
+        
+        // Matrix products for drawables with their own matrix, one per offset
+        unsigned int matViewVersion;
+        Eigen::Matrix4d localMat;
+        DrawMatricesVector localMats;
+    };
+    typedef std::vector<DrawListEntry,Eigen::aligned_allocator<DrawListEntry> > DrawList;
+    
+    /// Start tracking a drawable in the retained draw list.
+    /// Renderers that draw from the list call this from addDrawable.
+    void addToDrawList(Drawable *draw);
+    
+    /// Stop tracking a drawable in the retained draw list
+    void removeFromDrawList(SimpleIdentity drawID);
+    
+    /// Forget everything in the draw list, for when the scene goes away
+    void clearDrawList();
+    
+    /// Compact and sort the draw list if anything has been added or removed
+    void updateDrawList();
+    
+    /// Cull the draw list against each of the offset matrices in the frame info.
+    /// Visible entries get the current frameStamp and a mask of the offsets they show up in.
+    /// Returns the number of candidates the spatial index turned up.
+    int cullDrawList(RendererFrameInfo *frameInfo);
+    
+    /// True if the entry should be drawn this frame
+    bool entryIsVisible(const DrawListEntry &entry) const { return entry.frameStamp == frameStamp && entry.offsetMask; }
+    
+    /// Return the matrices to use for the given drawable and offset, recalculating if needed
+    const DrawMatrices &matricesForEntry(DrawListEntry &entry,unsigned int off);
+    
+    /// Work out the matrices and candidate drawables for a single offset.  Safe to run in parallel.
+    void setupOffset(unsigned int off,const Eigen::Matrix4d &offsetMat,const Eigen::Matrix4d &modelTrans4d,const Eigen::Matrix4d &viewTrans4d,const Eigen::Matrix4d &projMat4d);
+    
+    // Drawables we know about, sorted by render order
+    DrawList drawList;
+    // Where each drawable lives in the draw list
+    std::unordered_map<SimpleIdentity,unsigned int> drawListPos;
+    bool drawListDirty;
+    WhirlyKitSceneRendererZBufferMode drawListZBufferMode;
+    
+    // Incremented every frame and every time the view matrices change
+    unsigned int frameStamp;
+    unsigned int viewVersion;
+    
+    // Working storage for the frame, retained to avoid allocation
+    std::vector<std::vector<Drawable *> > offsetCandidates;
+    std::vector<char> offsetChanged;
+    std::vector<Eigen::Matrix4d> offsetMatStore;
+    OffsetMatricesVector offsetInfo;
+    
+    // Used to set up the offsets for wrapped maps in parallel
+    WorkerPoolRef offsetPool;
 };
 
 typedef std::shared_ptr<SceneRenderer> SceneRendererRef;
@@ -32,6 +32,7 @@
 namespace WhirlyKit
 {
 class SceneRendererGLES;
+class DrawableGLES;
 
 /** Renderer Frame Info.
  Data about the current frame, passed around by the renderer.
@@ -80,6 +81,12 @@ public:
     /// Draw stuff (the whole point!)
     void render(TimeInterval period);
     
+    /// Add a drawable to the renderer and the retained draw list
+    virtual void addDrawable(DrawableRef newDrawable);
+    
+    /// Remove the drawable from the renderer and the retained draw list
+    virtual void removeDrawable(DrawableRef draw,bool teardown);
+    
     /// Construct a basic drawable builder for the appropriate rendering type
     virtual BasicDrawableBuilderRef makeBasicDrawableBuilder(const std::string &name) const;
     
@@ -103,6 +110,10 @@ public:
     
     /// Construct a renderer-specific dynamic texture
     virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const;
+    
+    /// Construct a renderer-specific texture
+    virtual TextureRef makeTexture(const std::string &name) const;
+    virtual SharedTrianglesRef makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const;
 
     /** Return the snapshot for the given render target.
      *  EmptyIdentity refers to the whole
@@ -0,0 +1,140 @@
+/*
+ *  SceneRendererHeadless.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "SceneRenderer.h"
+#import "RenderTarget.h"
+#import "BasicDrawableHeadless.h"
+#import "TextureHeadless.h"
+
+namespace WhirlyKit
+{
+
+/** Headless version of the Scene.
+    There's nothing to clean up on a GPU, so this just lets go of things.
+  */
+class SceneHeadless : public Scene
+{
+public:
+    SceneHeadless(CoordSystemDisplayAdapter *adapter);
+
+    /// Tear down the drawables and textures
+    virtual void teardown();
+};
+
+/// Render target that just remembers its settings
+class RenderTargetHeadless : public RenderTarget
+{
+public:
+    RenderTargetHeadless();
+    RenderTargetHeadless(SimpleIdentity newID);
+
+    virtual bool init(SceneRenderer *renderer,Scene *scene,SimpleIdentity targetTexID);
+    virtual bool setTargetTexture(SceneRenderer *renderer,Scene *scene,SimpleIdentity newTargetTexID);
+    virtual void setClearColor(const RGBAColor &color);
+    virtual void clear();
+
+protected:
+    SimpleIdentity targetTexID;
+};
+
+/// A single draw call, as recorded by the headless renderer
+class HeadlessDrawCommand
+{
+public:
+    SimpleIdentity drawID;
+    SimpleIdentity programID;
+    SimpleIdentity texID;
+    SimpleIdentity renderTargetID;
+    unsigned int drawPriority;
+    /// Which of the wrapping offset matrices this is for
+    int offset;
+    /// Geometry size, if we know it
+    int numPoints,numTris;
+};
+
+/// What happened in the last frame rendered
+class HeadlessFrameStats
+{
+public:
+    HeadlessFrameStats();
+
+    int numChanges;
+    int numActiveModels;
+    int numOffsets;
+    int numCandidates;
+    int numCommands;
+    int numProgramChanges;
+    int numTextureChanges;
+};
+
+/** A scene renderer that doesn't need a GPU.
+    It runs the same frame pipeline as the real renderers (change processing,
+    active models, culling, sorting) but records draw calls instead of issuing them.
+    This is for benchmarking and testing the rest of the toolkit on machines
+    without a display.
+  */
+class SceneRendererHeadless : public SceneRenderer
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    SceneRendererHeadless(int width,int height);
+    virtual ~SceneRendererHeadless();
+
+    /// Headless, obviously
+    virtual Type getType();
+
+    /// There's nothing interesting in here for headless
+    virtual const RenderSetupInfo *getRenderSetupInfo() const;
+
+    /// Add the drawable to the retained draw list as well
+    virtual void addDrawable(DrawableRef newDrawable);
+
+    /// Take the drawable out of the retained draw list as well
+    virtual void removeDrawable(DrawableRef draw,bool teardown);
+
+    /// Run a full frame and record the draw calls
+    void render(TimeInterval period);
+
+    /// Draw calls from the last frame, in the order they'd be issued
+    const std::vector<HeadlessDrawCommand> &getCommands() const { return commands; }
+
+    /// Statistics for the last frame
+    const HeadlessFrameStats &getFrameStats() const { return frameStats; }
+
+    virtual BasicDrawableBuilderRef makeBasicDrawableBuilder(const std::string &name) const;
+    virtual BasicDrawableInstanceBuilderRef makeBasicDrawableInstanceBuilder(const std::string &name) const;
+    virtual BillboardDrawableBuilderRef makeBillboardDrawableBuilder(const std::string &name) const;
+    virtual ScreenSpaceDrawableBuilderRef makeScreenSpaceDrawableBuilder(const std::string &name) const;
+    virtual ParticleSystemDrawableBuilderRef  makeParticleSystemDrawableBuilder(const std::string &name) const;
+    virtual WideVectorDrawableBuilderRef makeWideVectorDrawableBuilder(const std::string &name) const;
+    virtual RenderTargetRef makeRenderTarget() const;
+    virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const;
+    virtual TextureRef makeTexture(const std::string &name) const;
+    virtual SharedTrianglesRef makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const;
+
+protected:
+    RenderSetupInfo setupInfo;
+    std::vector<HeadlessDrawCommand> commands;
+    HeadlessFrameStats frameStats;
+};
+
+typedef std::shared_ptr<SceneRendererHeadless> SceneRendererHeadlessRef;
+
+}
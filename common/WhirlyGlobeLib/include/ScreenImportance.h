@@ -27,6 +27,8 @@
 #import "GlobeMath.h"
 #import "QuadTreeNew.h"
 #import "SceneRenderer.h"
+#import <list>
+#import <unordered_map>
 
 
 namespace WhirlyKit
@@ -55,16 +57,104 @@ public:
     /// Set by the constructor
     bool valid;
     
+    /// Height range we were built with
+    float minZ,maxZ;
+    
     /// The area sampled into representative polygons
     std::vector<Point3dVector > polys;
     /// Normals for all 5 or 6 planes
     Point3dVector normals;
     /// Normals for the surface.  We use these to make sure the solid is pointing towards us.
     Point3dVector surfNormals;
+    
+protected:
+    /// Project all the sample points to clip space at once for the given view matrix
+    void projectPoints(ViewState *viewState,int offi,Eigen::Matrix<double,4,Eigen::Dynamic> &clipPts);
+    
+    /// Sample points in display space (homogeneous), shared between the polygons
+    Eigen::Matrix<double,4,Eigen::Dynamic> dispPts;
+    /// Indices into dispPts for each of the polygons
+    std::vector<std::vector<int> > polyIndices;
 };
     
 typedef std::shared_ptr<DisplaySolid> DisplaySolidRef;
 
+#define kWKDisplaySolidCache "WKDisplaySolidCache"
+
+/** Display solids don't depend on the view, just the tile and the coordinate systems.
+    This keeps a bounded set of them around, dropping the least recently used,
+    so they can be shared between view updates and between quad sampling controllers.
+    It lives in the Scene, since the solids depend on the Scene's display adapter.
+  */
+class DisplaySolidCache : public SceneManager
+{
+public:
+    DisplaySolidCache(int maxEntries = 4096);
+    virtual ~DisplaySolidCache();
+    
+    /// Return the display solid for the given tile, building it if it's not already here
+    DisplaySolidRef getDisplaySolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMbr,float minZ,float maxZ,CoordSystemRef srcSystem,CoordSystemDisplayAdapter *coordAdapter);
+    
+    /// Maximum number of display solids we'll keep
+    void setMaxEntries(int maxEntries);
+    int getMaxEntries();
+    
+    /// Number of display solids in the cache right now
+    int getNumEntries();
+    
+    /// Number of lookups that found an existing display solid
+    int64_t getNumHits();
+    
+    /// Number of lookups that had to build a new display solid
+    int64_t getNumMisses();
+    
+    /// Clear out the display solids and the stats
+    void clear();
+    
+protected:
+    class Key
+    {
+    public:
+        bool operator == (const Key &that) const;
+        
+        CoordSystem *srcSystem;
+        CoordSystemDisplayAdapter *coordAdapter;
+        int x,y,level;
+        float minZ,maxZ;
+        Point2f ll,ur;
+    };
+    class KeyHash
+    {
+    public:
+        size_t operator () (const Key &key) const;
+    };
+    class Entry
+    {
+    public:
+        Key key;
+        // Keeps the coordinate system (and so the key) valid while we're holding on to this
+        CoordSystemRef srcSystem;
+        DisplaySolidRef dispSolid;
+    };
+    typedef std::list<Entry> EntryList;
+    
+    // Trim back to the max size.  Lock must be held.
+    void trimNoLock();
+    
+    // Return the coordinate system we've already seen that's the same as this one, so equal
+    //  systems share a key.  Lock must be held.
+    CoordSystemRef canonicalSystemNoLock(CoordSystemRef srcSystem);
+    
+    std::mutex lock;
+    int maxEntries;
+    // Most recently used at the front
+    EntryList entries;
+    std::unordered_map<Key,EntryList::iterator,KeyHash> entryMap;
+    // One of each distinct coordinate system we've been handed
+    std::vector<CoordSystemRef> srcSystems;
+    int64_t numHits,numMisses;
+};
+
 /// Check if any part of the given tile is on screen
 bool TileIsOnScreen(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f &frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,const WhirlyKit::Mbr &nodeMbr,const QuadTreeIdentifier &nodeIdent,DisplaySolidRef &dispSold);
 
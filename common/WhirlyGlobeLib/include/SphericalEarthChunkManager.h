@@ -26,6 +26,7 @@
 #import "BaseInfo.h"
 #import "ImageTile.h"
 #import "BasicDrawableBuilder.h"
+#import "DrawableStateChange.h"
 
 namespace WhirlyKit
 {
@@ -52,17 +53,19 @@ public:
     // Enable drawables
     void enable(ChangeSet &changes)
     {
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
         for (SimpleIDSet::iterator it = drawIDs.begin();
              it != drawIDs.end(); ++it)
-            changes.push_back(new OnOffChangeRequest(*it, true));
+            stateReq->addOnOff(*it, true);
     }
     
     // Disable drawables
     void disable(ChangeSet &changes)
     {
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
         for (SimpleIDSet::iterator it = drawIDs.begin();
              it != drawIDs.end(); ++it)
-            changes.push_back(new OnOffChangeRequest(*it, false));
+            stateReq->addOnOff(*it, false);
     }
 };
     
@@ -101,6 +101,13 @@ public:
     
     // Return the string for a string identity
     static std::string getString(StringIdentity);
+
+    // Return the identity for a string we've already indexed, without adding it
+    static bool findStringID(const std::string &,StringIdentity &strID);
+    
+    // Look up a batch of strings we may have already indexed.
+    // Missing ones are set to the returned count, which is also where new IDs will start.
+    static StringIdentity findStringIDs(const std::vector<std::string> &strs,std::vector<StringIdentity> &strIDs);
     
 public:
     StringIndexer(StringIndexer const&)     = delete;
@@ -0,0 +1,61 @@
+/*
+ *  TextureHeadless.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "Texture.h"
+#import "DynamicTextureAtlas.h"
+
+namespace WhirlyKit
+{
+
+/** Headless version of the Texture.
+    Does the same CPU side conversion a real renderer would, then throws the data out.
+  */
+class TextureHeadless : virtual public Texture
+{
+public:
+    TextureHeadless(const std::string &name);
+    TextureHeadless(const std::string &name,RawDataRef texData,bool isPVRTC);
+
+    /// Convert the data as if we were handing it to a GPU
+    virtual bool createInRenderer(const RenderSetupInfo *setupInfo);
+
+    /// Nothing to clean up
+    virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+
+    /// Size of the converted data, as it would have been uploaded
+    size_t getUploadSize() const { return uploadSize; }
+
+protected:
+    bool created;
+    size_t uploadSize;
+};
+
+/// Headless version of the dynamic texture.  Accepts data, but doesn't keep it.
+class DynamicTextureHeadless : virtual public DynamicTexture
+{
+public:
+    DynamicTextureHeadless(const std::string &name);
+
+    virtual bool createInRenderer(const RenderSetupInfo *setupInfo);
+    virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene);
+    virtual void addTextureData(int startX,int startY,int width,int height,RawDataRef data);
+    virtual void clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData);
+};
+
+}
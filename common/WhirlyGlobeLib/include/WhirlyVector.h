@@ -23,6 +23,7 @@
 //#define EIGEN_DISABLE_UNALIGNED_ARRAY_ASSERT 1
 
 #import <Eigen/Eigen>
+#import <memory>
 #import <vector>
 
 namespace WhirlyKit
@@ -0,0 +1,74 @@
+/*
+ *  WorkerPool.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <atomic>
+#import <condition_variable>
+#import <functional>
+#import <memory>
+#import <mutex>
+#import <thread>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/** A small, fixed set of worker threads for splitting up short, CPU bound jobs.
+    The caller blocks in parallelFor() and does some of the work itself, so
+    this is meant for things like per-frame calculations rather than long
+    running background tasks.
+  */
+class WorkerPool
+{
+public:
+    /// Construct with the number of extra threads to start
+    WorkerPool(int numThreads);
+    ~WorkerPool();
+
+    /// A reasonable number of worker threads for this device, leaving room for the caller
+    static int DefaultNumThreads(int maxThreads);
+
+    /// Number of threads in the pool (not counting the caller)
+    int getNumThreads() const { return (int)threads.size(); }
+
+    /// Run func(ii) for every ii in [0,count).  Returns once they've all finished.
+    /// Jobs may run in any order and on any thread, including the caller's.
+    /// If someone else's jobs already have the pool, the caller just runs its own rather than wait.
+    void parallelFor(int count,const std::function<void(int)> &func);
+
+protected:
+    void workerMain();
+
+    std::vector<std::thread> threads;
+
+    // Only one parallelFor at a time
+    std::mutex runLock;
+
+    std::mutex lock;
+    std::condition_variable workCond,doneCond;
+    const std::function<void(int)> *curFunc;
+    int curCount;
+    std::atomic<int> nextJob;
+    // Workers that haven't yet checked in for the current round
+    int pending;
+    unsigned int generation;
+    bool shutdown;
+};
+typedef std::shared_ptr<WorkerPool> WorkerPoolRef;
+
+}
@@ -31,7 +31,7 @@
 #include <GLES3/gl3.h>
 #endif
 #include <EGL/egl.h>
-#else
+#elif defined(__APPLE__)
 
 // iOS
 #import <OpenGLES/ES1/gl.h>
@@ -41,6 +41,12 @@
 #import <OpenGLES/ES3/gl.h>
 #import <OpenGLES/ES3/glext.h>
 
+#else
+
+// Desktop builds (the benchmarks) use the system GLES 3 headers
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+
 #endif
 
 extern bool hasVertexArraySupport;
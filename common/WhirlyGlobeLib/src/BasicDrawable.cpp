@@ -23,6 +23,8 @@
 #import "BasicDrawableInstance.h"
 #import "ParticleSystemDrawable.h"
 #import "SceneRenderer.h"
+#import "DrawableStateChange.h"
+#import "ChangeRecorder.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -39,8 +41,17 @@ BasicDrawable::Triangle::Triangle(unsigned short v0,unsigned short v1,unsigned s
     verts[0] = v0;  verts[1] = v1;  verts[2] = v2;
 }
     
+SharedTriangles::SharedTriangles(const std::vector<BasicDrawable::Triangle> &tris)
+: tris(tris)
+{
+}
+
+SharedTriangles::~SharedTriangles()
+{
+}
+
 BasicDrawable::BasicDrawable(const std::string &name)
-: Drawable(name), motion(false)
+: Drawable(name), motion(false), cullByMbr(true)
 {
 }
 
@@ -235,6 +246,11 @@ SimpleIdentity BasicDrawable::getCalculationProgram() const
 /// Return the active transform matrix, if we have one
 const Eigen::Matrix4d *BasicDrawable::getMatrix() const
 { if (hasMatrix) return &mat;  return NULL; }
+
+bool BasicDrawable::getGeometry(std::vector<Eigen::Vector3f> &outPts,std::vector<Triangle> &outTris) const
+{
+    return false;
+}
     
 void BasicDrawable::setUniforms(const SingleVertexAttributeSet &newUniforms)
 {
@@ -322,15 +338,16 @@ ColorChangeRequest::ColorChangeRequest(SimpleIdentity drawId,RGBAColor inColor)
 
 void ColorChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
-    {
-        basicDrawable->setOverrideColor(color);
-    } else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        if (basicDrawInst)
-            basicDrawInst->setColor(RGBAColor(color[0],color[1],color[2],color[3]));
-    }
+    SetDrawableColor(draw.get(),RGBAColor(color[0],color[1],color[2],color[3]));
+}
+
+bool ColorChangeRequest::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordColor);
+    data->addInt64(drawId);
+    data->addBytes(color,4);
+    
+    return true;
 }
 
 OnOffChangeRequest::OnOffChangeRequest(SimpleIdentity drawId,bool OnOff)
@@ -341,20 +358,16 @@ OnOffChangeRequest::OnOffChangeRequest(SimpleIdentity drawId,bool OnOff)
 
 void OnOffChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable) {
-        basicDrawable->setOnOff(newOnOff);
-    }
-    else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        if (basicDrawInst)
-            basicDrawInst->setEnable(newOnOff);
-        else {
-            ParticleSystemDrawableRef partSys = std::dynamic_pointer_cast<ParticleSystemDrawable>(draw);
-            if (partSys)
-                partSys->setOnOff(newOnOff);
-        }
-    }
+    SetDrawableOnOff(draw.get(),newOnOff);
+}
+
+bool OnOffChangeRequest::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordOnOff);
+    data->addInt64(drawId);
+    data->addInt(newOnOff);
+    
+    return true;
 }
 
 VisibilityChangeRequest::VisibilityChangeRequest(SimpleIdentity drawId,float minVis,float maxVis)
@@ -364,13 +377,17 @@ VisibilityChangeRequest::VisibilityChangeRequest(SimpleIdentity drawId,float min
 
 void VisibilityChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
-        basicDrawable->setVisibleRange(minVis,maxVis);
-    else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        basicDrawInst->setVisibleRange(minVis, maxVis);
-    }
+    SetDrawableVisibleRange(draw.get(),minVis,maxVis);
+}
+
+bool VisibilityChangeRequest::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordVisibility);
+    data->addInt64(drawId);
+    data->addDouble(minVis);
+    data->addDouble(maxVis);
+    
+    return true;
 }
 
 FadeChangeRequest::FadeChangeRequest(SimpleIdentity drawId,TimeInterval fadeUp,TimeInterval fadeDown)
@@ -382,17 +399,23 @@ FadeChangeRequest::FadeChangeRequest(SimpleIdentity drawId,TimeInterval fadeUp,T
 void FadeChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
     // Fade it out, then remove it
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
-    {
-        basicDrawable->setFade(fadeDown, fadeUp);
-    }
+    SetDrawableFade(draw.get(),fadeUp,fadeDown);
     
     // And let the renderer know
     renderer->setRenderUntil(fadeDown);
     renderer->setRenderUntil(fadeUp);
 }
 
+bool FadeChangeRequest::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordFade);
+    data->addInt64(drawId);
+    data->addDouble(fadeUp);
+    data->addDouble(fadeDown);
+    
+    return true;
+}
+
 DrawTexChangeRequest::DrawTexChangeRequest(SimpleIdentity drawId,unsigned int which,SimpleIdentity newTexId)
 : DrawableChangeRequest(drawId), which(which), newTexId(newTexId), relSet(false), relLevel(0), relX(0), relY(0)
 {
@@ -412,6 +435,9 @@ void DrawTexChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,Drawabl
             basicDrawable->setTexRelative(which, size, borderTexel, relLevel, relX, relY);
         else
             basicDrawable->setTexRelative(which, 0, 0, 0, 0, 0);
+        // The renderer groups drawables by texture
+        if (renderer)
+            renderer->drawableSortKeysChanged(drawId);
     } else {
         BasicDrawableInstanceRef refDrawable = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
         if (refDrawable) {
@@ -439,8 +465,11 @@ DrawTexturesChangeRequest::DrawTexturesChangeRequest(SimpleIdentity drawId,const
 void DrawTexturesChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
     BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
+    if (basicDrawable) {
         basicDrawable->setTexIDs(newTexIDs);
+        if (renderer)
+            renderer->drawableSortKeysChanged(drawId);
+    }
 }
 
 TransformChangeRequest::TransformChangeRequest(SimpleIdentity drawId,const Matrix4d *newMat)
@@ -452,7 +481,14 @@ void TransformChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,Drawa
 {
     BasicDrawableRef basicDraw = std::dynamic_pointer_cast<BasicDrawable>(draw);
     if (basicDraw.get())
+    {
         basicDraw->setMatrix(&newMat);
+        
+        // Its MBR doesn't say where it is any more
+        basicDraw->cullByMbr = false;
+        if (scene)
+            scene->stopCullingDrawable(basicDraw.get());
+    }
 }
 
 DrawPriorityChangeRequest::DrawPriorityChangeRequest(SimpleIdentity drawId,int drawPriority)
@@ -462,18 +498,16 @@ DrawPriorityChangeRequest::DrawPriorityChangeRequest(SimpleIdentity drawId,int d
 
 void DrawPriorityChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    renderer->removeDrawable(draw,false);
-
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
-        basicDrawable->setDrawPriority(drawPriority);
-    else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        if (basicDrawInst)
-            basicDrawInst->setDrawPriority(drawPriority);
-    }
+    SetDrawableDrawPriority(renderer,draw,drawPriority);
+}
 
-    renderer->addDrawable(draw);
+bool DrawPriorityChangeRequest::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordDrawPriority);
+    data->addInt64(drawId);
+    data->addInt(drawPriority);
+    
+    return true;
 }
 
 LineWidthChangeRequest::LineWidthChangeRequest(SimpleIdentity drawId,float lineWidth)
@@ -483,14 +517,7 @@ LineWidthChangeRequest::LineWidthChangeRequest(SimpleIdentity drawId,float lineW
 
 void LineWidthChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
-        basicDrawable->setLineWidth(lineWidth);
-    else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        if (basicDrawInst)
-            basicDrawInst->setLineWidth(lineWidth);
-    }
+    SetDrawableLineWidth(draw.get(),lineWidth);
 }
     
 DrawUniformsChangeRequest::DrawUniformsChangeRequest(SimpleIdentity drawID,const SingleVertexAttributeSet &attrs)
@@ -500,14 +527,7 @@ DrawUniformsChangeRequest::DrawUniformsChangeRequest(SimpleIdentity drawID,const
     
 void DrawUniformsChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,DrawableRef draw)
 {
-    BasicDrawableRef basicDrawable = std::dynamic_pointer_cast<BasicDrawable>(draw);
-    if (basicDrawable)
-        basicDrawable->setUniforms(attrs);
-    else {
-        BasicDrawableInstanceRef basicDrawInst = std::dynamic_pointer_cast<BasicDrawableInstance>(draw);
-        if (basicDrawInst)
-            basicDrawInst->setUniforms(attrs);
-    }
+    SetDrawableUniforms(draw.get(),attrs);
 }
 
 RenderTargetChangeRequest::RenderTargetChangeRequest(SimpleIdentity drawID,SimpleIdentity targetID)
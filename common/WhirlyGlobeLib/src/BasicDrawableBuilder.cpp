@@ -79,6 +79,7 @@ void BasicDrawableBuilder::Init()
     basicDraw->renderTargetID = EmptyIdentity;
     
     basicDraw->clipCoords = false;
+    basicDraw->cullByMbr = true;
     
     basicDraw->hasMatrix = false;
     basicDraw->motion = false;
@@ -159,6 +160,11 @@ const Mbr &BasicDrawableBuilder::getLocalMbr()
     return basicDraw->localMbr;
 }
 
+void BasicDrawableBuilder::setCullByMbr(bool cullByMbr)
+{
+    basicDraw->cullByMbr = cullByMbr;
+}
+
 void BasicDrawableBuilder::setViewerVisibility(double inMinViewerDist,double inMaxViewerDist,const Point3d &inViewerCenter)
 {
     basicDraw->minViewerDist = inMinViewerDist;
@@ -327,6 +333,8 @@ unsigned int BasicDrawableBuilder::getNumPoints()
 
 unsigned int BasicDrawableBuilder::getNumTris()
 {
+    if (sharedTris)
+        return sharedTris->getNumTris();
     return tris.size();
 }
 
@@ -490,6 +498,9 @@ void BasicDrawableBuilder::addAttributeValue(int attrId,float val)
 void BasicDrawableBuilder::addTriangle(BasicDrawable::Triangle tri)
 { tris.push_back(tri); }
 
+void BasicDrawableBuilder::setSharedTriangles(SharedTrianglesRef inSharedTris)
+{ sharedTris = inSharedTris; }
+
 void BasicDrawableBuilder::setUniforms(const SingleVertexAttributeSet &uniforms)
 {
     basicDraw->uniforms = uniforms;
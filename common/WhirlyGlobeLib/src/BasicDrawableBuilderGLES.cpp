@@ -59,7 +59,12 @@ BasicDrawable *BasicDrawableBuilderGLES::getDrawable()
     
     if (!drawableGotten) {
         draw->points = points;
-        draw->tris = tris;
+        if (sharedTris) {
+            draw->sharedTris = std::dynamic_pointer_cast<SharedTrianglesGLES>(sharedTris);
+            if (!draw->sharedTris)
+                draw->tris = sharedTris->getTriangles();
+        } else
+            draw->tris = tris;
         draw->vertexSize = draw->singleVertexSize();
         
         drawableGotten = true;
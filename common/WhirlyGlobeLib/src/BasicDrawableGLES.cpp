@@ -26,9 +26,52 @@ using namespace Eigen;
 namespace WhirlyKit
 {
     
+SharedTrianglesGLES::SharedTrianglesGLES(const std::vector<BasicDrawable::Triangle> &tris)
+: SharedTriangles(tris), numUsers(0), triBuffer(0)
+{
+}
+
+SharedTrianglesGLES::~SharedTrianglesGLES()
+{
+    if (triBuffer)
+        wkLogLevel(Warn, "SharedTrianglesGLES deleted with its buffer still set up");
+}
+
+GLuint SharedTrianglesGLES::setupForRenderer(const RenderSetupInfoGLES *setupInfo)
+{
+    if (tris.empty())
+        return 0;
+    
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (numUsers++ > 0)
+        return triBuffer;
+    
+    int bufferSize = tris.size()*sizeof(BasicDrawable::Triangle);
+    triBuffer = setupInfo->memManager->getBufferID(0,GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, triBuffer);
+    glBufferData(GL_ARRAY_BUFFER, bufferSize, &tris[0], GL_STATIC_DRAW);
+    CheckGLError("SharedTrianglesGLES::setupForRenderer() glBufferData");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    return triBuffer;
+}
+
+void SharedTrianglesGLES::teardownForRenderer(const RenderSetupInfoGLES *setupInfo)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (numUsers <= 0)
+        return;
+    
+    if (--numUsers == 0)
+    {
+        setupInfo->memManager->removeBufferID(triBuffer);
+        triBuffer = 0;
+    }
+}
+    
 BasicDrawableGLES::BasicDrawableGLES(const std::string &name)
-: BasicDrawable(name), Drawable(name), isSetupGL(false), usingBuffers(false), vertexSize(-1),
-    pointBuffer(0), triBuffer(0), sharedBuffer(0), vertArrayObj(0)
+: Drawable(name), BasicDrawable(name), isSetupGL(false), usingBuffers(false), vertexSize(-1),
+    pointBuffer(0), triBuffer(0), sharedBuffer(0), elementBuffer(0), vertArrayObj(0)
 {
 }
 
@@ -121,6 +164,7 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo)
     
     pointBuffer = triBuffer = 0;
     sharedBuffer = 0;
+    elementBuffer = 0;
     
     // We'll set up a single buffer for everything.
     // The other buffer pointers are now strides
@@ -175,10 +219,20 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo)
     
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     
+    if (sharedTris)
+    {
+        // Triangles live in their own buffer, which other drawables are using too
+        elementBuffer = sharedTris->setupForRenderer(setupInfo);
+        triBuffer = 0;
+        numTris = sharedTris->getNumTris();
+    } else {
+        elementBuffer = triBuffer ? sharedBuffer : 0;
+        numTris = (int)tris.size();
+    }
+    
     // Clear out the arrays, since we won't need them again
     numPoints = (int)points.size();
     points.clear();
-    numTris = (int)tris.size();
     tris.clear();
     for (unsigned int ii=0;ii<vertexAttributes.size();ii++)
         vertexAttributes[ii]->clear();
@@ -187,6 +241,18 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo)
     isSetupGL = true;
 }
 
+bool BasicDrawableGLES::getGeometry(std::vector<Eigen::Vector3f> &outPts,std::vector<Triangle> &outTris) const
+{
+    // Once the data's in the buffers, we toss it
+    if (points.empty())
+        return false;
+    
+    outPts = points;
+    outTris = sharedTris ? sharedTris->getTriangles() : tris;
+    
+    return true;
+}
+
 // Tear down the VBOs we set up
 void BasicDrawableGLES::teardownForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
 {
@@ -209,6 +275,9 @@ void BasicDrawableGLES::teardownForRenderer(const RenderSetupInfo *inSetupInfo,S
     }
     pointBuffer = 0;
     triBuffer = 0;
+    if (sharedTris && elementBuffer)
+        sharedTris->teardownForRenderer(setupInfo);
+    elementBuffer = 0;
     for (unsigned int ii=0;ii<vertexAttributes.size();ii++)
         ((VertexAttributeGLES *)vertexAttributes[ii])->buffer = 0;
 }
@@ -261,10 +330,10 @@ GLuint BasicDrawableGLES::setupVAO(ProgramGLES *prog)
     
     // Bind the element array
     bool boundElements = false;
-    if (type == Triangles && triBuffer)
+    if (type == Triangles && elementBuffer)
     {
         boundElements = true;
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
         CheckGLError("BasicDrawable::setupVAO() glBindBuffer");
     }
     
@@ -546,10 +615,10 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         }
         
         // Bind the element array
-        if (type == Triangles && sharedBuffer)
+        if (type == Triangles && elementBuffer)
         {
             boundElements = true;
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
             //            WHIRLYKIT_LOGD("BasicDrawable glBindBuffer %d",sharedBuffer);
             CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
         }
@@ -594,10 +663,10 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         {
             case Triangles:
             {
-                if (triBuffer)
+                if (elementBuffer)
                 {
                     if (!boundElements)
-                        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triBuffer);
+                        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
                     CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
                     glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, (void *)((uintptr_t)triBuffer));
                     CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
@@ -0,0 +1,234 @@
+/*
+ *  BasicDrawableHeadless.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "BasicDrawableHeadless.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+BasicDrawableHeadless::BasicDrawableHeadless(const std::string &name)
+: Drawable(name), BasicDrawable(name)
+{
+}
+
+BasicDrawableHeadless::~BasicDrawableHeadless()
+{
+}
+
+void BasicDrawableHeadless::setupForRenderer(const RenderSetupInfo *setupInfo)
+{
+}
+
+void BasicDrawableHeadless::teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene)
+{
+}
+
+bool BasicDrawableHeadless::getGeometry(std::vector<Eigen::Vector3f> &outPts,std::vector<Triangle> &outTris) const
+{
+    outPts = points;
+    outTris = tris;
+
+    return true;
+}
+
+BasicDrawableBuilderHeadless::BasicDrawableBuilderHeadless(const std::string &name,bool setupStandard)
+: BasicDrawableBuilder(name), drawableGotten(false)
+{
+    basicDraw = new BasicDrawableHeadless(name);
+    BasicDrawableBuilder::Init();
+    if (setupStandard)
+        setupStandardAttributes();
+}
+
+BasicDrawableBuilderHeadless::~BasicDrawableBuilderHeadless()
+{
+    if (!drawableGotten && basicDraw)
+        delete basicDraw;
+}
+
+int BasicDrawableBuilderHeadless::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings)
+{
+    VertexAttribute *attr = new VertexAttribute(dataType,nameID);
+    if (numThings > 0)
+        attr->reserve(numThings);
+    basicDraw->vertexAttributes.push_back(attr);
+
+    return (unsigned int)(basicDraw->vertexAttributes.size()-1);
+}
+
+BasicDrawable *BasicDrawableBuilderHeadless::getDrawable()
+{
+    if (!basicDraw)
+        return NULL;
+
+    BasicDrawableHeadless *draw = dynamic_cast<BasicDrawableHeadless *>(basicDraw);
+
+    if (!drawableGotten) {
+        draw->points = points;
+        // Nothing to share without a GPU, so just copy them
+        draw->tris = sharedTris ? sharedTris->getTriangles() : tris;
+
+        drawableGotten = true;
+    }
+
+    return draw;
+}
+
+BasicDrawableInstanceHeadless::BasicDrawableInstanceHeadless(const std::string &name)
+: Drawable(name), BasicDrawableInstance(name)
+{
+}
+
+void BasicDrawableInstanceHeadless::setupForRenderer(const RenderSetupInfo *setupInfo)
+{
+}
+
+void BasicDrawableInstanceHeadless::teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene)
+{
+}
+
+BasicDrawableInstanceBuilderHeadless::BasicDrawableInstanceBuilderHeadless(const std::string &name)
+: BasicDrawableInstanceBuilder(name), drawableGotten(false)
+{
+    drawInst = new BasicDrawableInstanceHeadless(name);
+    Init();
+}
+
+BasicDrawableInstanceBuilderHeadless::~BasicDrawableInstanceBuilderHeadless()
+{
+    if (!drawableGotten && drawInst)
+        delete drawInst;
+}
+
+BasicDrawableInstance *BasicDrawableInstanceBuilderHeadless::getDrawable()
+{
+    drawableGotten = true;
+    return drawInst;
+}
+
+ScreenSpaceDrawableBuilderHeadless::ScreenSpaceDrawableBuilderHeadless(const std::string &name)
+: BasicDrawableBuilderHeadless(name,true)
+{
+}
+
+int ScreenSpaceDrawableBuilderHeadless::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings)
+{
+    return BasicDrawableBuilderHeadless::addAttribute(dataType, nameID, numThings);
+}
+
+ScreenSpaceTweaker *ScreenSpaceDrawableBuilderHeadless::makeTweaker()
+{
+    return new ScreenSpaceTweakerHeadless();
+}
+
+BasicDrawable *ScreenSpaceDrawableBuilderHeadless::getDrawable()
+{
+    if (drawableGotten)
+        return BasicDrawableBuilderHeadless::getDrawable();
+
+    BasicDrawable *theDraw = BasicDrawableBuilderHeadless::getDrawable();
+    setupTweaker(theDraw);
+
+    return theDraw;
+}
+
+WideVectorDrawableBuilderHeadless::WideVectorDrawableBuilderHeadless(const std::string &name)
+: BasicDrawableBuilderHeadless(name,false)
+{
+}
+
+void WideVectorDrawableBuilderHeadless::Init(unsigned int numVert,unsigned int numTri,bool globeMode)
+{
+    // The constructor made an empty one we don't need
+    if (basicDraw)
+        delete basicDraw;
+    basicDraw = new BasicDrawableHeadless("Wide Vector");
+    WideVectorDrawableBuilder::Init(numVert,numTri,globeMode);
+}
+
+int WideVectorDrawableBuilderHeadless::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings)
+{
+    return BasicDrawableBuilderHeadless::addAttribute(dataType, nameID, numThings);
+}
+
+WideVectorTweaker *WideVectorDrawableBuilderHeadless::makeTweaker()
+{
+    return new WideVectorTweakerHeadless();
+}
+
+BasicDrawable *WideVectorDrawableBuilderHeadless::getDrawable()
+{
+    if (drawableGotten)
+        return BasicDrawableBuilderHeadless::getDrawable();
+
+    BasicDrawable *theDraw = BasicDrawableBuilderHeadless::getDrawable();
+    setupTweaker(theDraw);
+
+    return theDraw;
+}
+
+BillboardDrawableBuilderHeadless::BillboardDrawableBuilderHeadless(const std::string &name)
+: BasicDrawableBuilderHeadless(name,true)
+{
+}
+
+int BillboardDrawableBuilderHeadless::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int numThings)
+{
+    return BasicDrawableBuilderHeadless::addAttribute(dataType, nameID, numThings);
+}
+
+BasicDrawable *BillboardDrawableBuilderHeadless::getDrawable()
+{
+    return BasicDrawableBuilderHeadless::getDrawable();
+}
+
+ParticleSystemDrawableHeadless::ParticleSystemDrawableHeadless(const std::string &name)
+: Drawable(name), ParticleSystemDrawable(name)
+{
+}
+
+void ParticleSystemDrawableHeadless::setupForRenderer(const RenderSetupInfo *setupInfo)
+{
+}
+
+void ParticleSystemDrawableHeadless::teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene)
+{
+}
+
+ParticleSystemDrawableBuilderHeadless::ParticleSystemDrawableBuilderHeadless(const std::string &name)
+: ParticleSystemDrawableBuilder(name), drawableGotten(false)
+{
+    draw = new ParticleSystemDrawableHeadless(name);
+}
+
+ParticleSystemDrawableBuilderHeadless::~ParticleSystemDrawableBuilderHeadless()
+{
+    if (!drawableGotten && draw)
+        delete draw;
+}
+
+ParticleSystemDrawable *ParticleSystemDrawableBuilderHeadless::getDrawable()
+{
+    drawableGotten = true;
+    return draw;
+}
+
+}
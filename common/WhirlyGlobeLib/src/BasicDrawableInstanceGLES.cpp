@@ -515,10 +515,10 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
             glBindVertexArray(0);
         } else {
             // Bind the element array
-            if (basicDrawGL->type == Triangles && basicDrawGL->sharedBuffer)
+            if (basicDrawGL->type == Triangles && basicDrawGL->elementBuffer)
             {
                 boundElements = true;
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, basicDrawGL->sharedBuffer);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, basicDrawGL->elementBuffer);
                 //            WHIRLYKIT_LOGD("BasicDrawable glBindBuffer %d",sharedBuffer);
                 CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
             }
@@ -528,10 +528,10 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
             {
                 case Triangles:
                 {
-                    if (basicDrawGL->triBuffer)
+                    if (basicDrawGL->elementBuffer)
                     {
                         if (!boundElements)
-                            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, basicDrawGL->triBuffer);
+                            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, basicDrawGL->elementBuffer);
                         CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
                         if (instBuffer)
                         {
@@ -21,6 +21,7 @@
 #import "BillboardManager.h"
 #import "WhirlyKitLog.h"
 #import "SharedAttributes.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 
@@ -275,8 +276,9 @@ void BillboardManager::enableBillboards(SimpleIDSet &billIDs,bool enable,ChangeS
         if (it != sceneReps.end())
         {
             BillboardSceneRep *billRep = *it;
+            DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
             for (SimpleIDSet::iterator dit = billRep->drawIDs.begin(); dit != billRep->drawIDs.end(); ++dit)
-                changes.push_back(new OnOffChangeRequest((*dit), enable));
+                stateReq->addOnOff((*dit), enable);
                 
             if (selectManager && !billRep->selectIDs.empty())
                 selectManager->enableSelectables(billRep->selectIDs, enable);
@@ -303,8 +305,9 @@ void BillboardManager::removeBillboards(SimpleIDSet &billIDs,ChangeSet &changes)
             TimeInterval removeTime = 0.0;
             if (sceneRep->fade > 0.0)
             {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (SimpleIDSet::iterator it = sceneRep->drawIDs.begin(); it != sceneRep->drawIDs.end(); ++it)
-                    changes.push_back(new FadeChangeRequest(*it, curTime, curTime+sceneRep->fade));
+                    stateReq->addFade(*it, curTime, curTime+sceneRep->fade);
                 
                 removeTime = curTime + sceneRep->fade;
             }
@@ -0,0 +1,183 @@
+/*
+ *  ChangeQueue.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import "ChangeQueue.h"
+
+namespace WhirlyKit
+{
+
+ChangeQueueStats::ChangeQueueStats()
+: numBatches(0), numRequests(0), numContended(0), queueDepth(0), maxQueueDepth(0), numTimed(0)
+{
+}
+
+ChangeSetQueue::ChangeSetQueue()
+: head(NULL), queueDepth(0), maxQueueDepth(0), numBatches(0), numRequests(0), numContended(0), numTimed(0), timedSeq(0)
+{
+}
+
+ChangeSetQueue::~ChangeSetQueue()
+{
+    clear();
+}
+
+void ChangeSetQueue::push(const ChangeSet &changes,bool atomic)
+{
+    Node *node = new Node();
+    node->atomic = atomic;
+    node->changes.reserve(changes.size());
+    for (ChangeRequest *change : changes)
+        if (change)
+            node->changes.push_back(change);
+    if (node->changes.empty())
+    {
+        delete node;
+        return;
+    }
+
+    pushNode(node);
+}
+
+void ChangeSetQueue::push(ChangeRequest *change)
+{
+    if (!change)
+        return;
+
+    Node *node = new Node();
+    node->atomic = false;
+    node->changes.push_back(change);
+    pushNode(node);
+}
+
+void ChangeSetQueue::pushNode(Node *node)
+{
+    int numChanges = (int)node->changes.size();
+
+    // The consumer takes the whole list at once, so there's no ABA to worry about
+    node->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(node->next,node,std::memory_order_release,std::memory_order_relaxed))
+        numContended.fetch_add(1,std::memory_order_relaxed);
+
+    numBatches.fetch_add(1,std::memory_order_relaxed);
+    numRequests.fetch_add(numChanges,std::memory_order_relaxed);
+    int depth = queueDepth.fetch_add(numChanges,std::memory_order_relaxed) + numChanges;
+    int maxDepth = maxQueueDepth.load(std::memory_order_relaxed);
+    while (depth > maxDepth && !maxQueueDepth.compare_exchange_weak(maxDepth,depth,std::memory_order_relaxed))
+        ;
+}
+
+void ChangeSetQueue::drain(ChangeSet &changes)
+{
+    Node *node = head.exchange(NULL,std::memory_order_acquire);
+    if (!node)
+        return;
+
+    // The list runs newest to oldest, so flip it around
+    Node *oldest = NULL;
+    while (node)
+    {
+        Node *next = node->next;
+        node->next = oldest;
+        oldest = node;
+        node = next;
+    }
+
+    int numChanges = 0;
+    ChangeSet batch;
+    for (node = oldest;node;)
+    {
+        batch.clear();
+        for (ChangeRequest *change : node->changes)
+        {
+            if (change->when > 0.0)
+            {
+                TimedEntry entry;
+                entry.when = change->when;
+                entry.seq = timedSeq++;
+                entry.req = change;
+                timed.push_back(entry);
+                std::push_heap(timed.begin(),timed.end(),TimedEntrySorter());
+            } else if (node->atomic && !change->needPreExecute())
+                batch.push_back(change);
+            else
+                changes.push_back(change);
+        }
+        // Keep the rest of an atomic batch together so nobody sees half of it
+        if (batch.size() > 1)
+            changes.push_back(new ChangeGroupReq(batch));
+        else if (!batch.empty())
+            changes.push_back(batch.front());
+        numChanges += (int)node->changes.size();
+
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+    queueDepth.fetch_sub(numChanges,std::memory_order_relaxed);
+    numTimed.store((int)timed.size(),std::memory_order_relaxed);
+}
+
+void ChangeSetQueue::drainTimed(TimeInterval now,ChangeSet &changes)
+{
+    while (!timed.empty() && now >= timed.front().when)
+    {
+        changes.push_back(timed.front().req);
+        std::pop_heap(timed.begin(),timed.end(),TimedEntrySorter());
+        timed.pop_back();
+    }
+    numTimed.store((int)timed.size(),std::memory_order_relaxed);
+}
+
+bool ChangeSetQueue::hasChanges(TimeInterval now) const
+{
+    if (head.load(std::memory_order_relaxed))
+        return true;
+
+    return !timed.empty() && now >= timed.front().when;
+}
+
+ChangeQueueStats ChangeSetQueue::getStats() const
+{
+    ChangeQueueStats stats;
+    stats.numBatches = numBatches;
+    stats.numRequests = numRequests;
+    stats.numContended = numContended;
+    stats.queueDepth = queueDepth;
+    stats.maxQueueDepth = maxQueueDepth;
+    stats.numTimed = numTimed;
+
+    return stats;
+}
+
+void ChangeSetQueue::clear()
+{
+    ChangeSet changes;
+    drain(changes);
+    for (const TimedEntry &entry : timed)
+        changes.push_back(entry.req);
+    timed.clear();
+    numTimed.store(0,std::memory_order_relaxed);
+
+    // Note: Tear down change requests?
+    for (ChangeRequest *change : changes)
+        delete change;
+}
+
+}
@@ -0,0 +1,751 @@
+/*
+ *  ChangeRecorder.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "ChangeRecorder.h"
+#import "Scene.h"
+#import "SceneRenderer.h"
+#import "BasicDrawable.h"
+#import "BasicDrawableBuilder.h"
+#import "DrawableStateChange.h"
+#import "WhirlyKitLog.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+// Identifies a recording, followed by the version
+static const int ChangeRecordMagic = 0x52434b57;
+static const int ChangeRecordVersion = 2;
+
+// The file is a series of these, each followed by its length and data
+typedef enum {ChangeRecordBlockChanges=1,ChangeRecordBlockFrame} ChangeRecordBlockType;
+
+std::atomic<int> ChangeRecorder::numOpen(0);
+
+ChangeRecorder::ChangeRecorder()
+: fp(NULL), numRecorded(0), numUnsupported(0)
+{
+}
+
+ChangeRecorder::~ChangeRecorder()
+{
+    close();
+}
+
+bool ChangeRecorder::open(const std::string &fileName)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (fp)
+        return false;
+    fp = fopen(fileName.c_str(),"wb");
+    if (!fp)
+    {
+        wkLogLevel(Warn,"ChangeRecorder: Unable to open %s",fileName.c_str());
+        return false;
+    }
+
+    int header[2] = {ChangeRecordMagic,ChangeRecordVersion};
+    fwrite(header,sizeof(int),2,fp);
+    numOpen++;
+
+    return true;
+}
+
+void ChangeRecorder::close()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!fp)
+        return;
+    fclose(fp);
+    fp = NULL;
+    numOpen--;
+}
+
+bool ChangeRecorder::isOpen()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    return fp != NULL;
+}
+
+void ChangeRecorder::recordChanges(const ChangeSet &changes,TimeInterval now)
+{
+    // Serialize outside the lock, since this can be big
+    MutableRawData data;
+    data.addDouble(now);
+    int numChanges = 0;
+    for (auto change : changes)
+        if (change)
+            numChanges++;
+    data.addInt(numChanges);
+    int numGood = 0;
+    for (auto change : changes)
+        if (change && RecordChange(&data,change))
+            numGood++;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    numRecorded += numGood;
+    numUnsupported += numChanges - numGood;
+    writeRecord(ChangeRecordBlockChanges,data);
+}
+
+void ChangeRecorder::recordFrame(TimeInterval now,View *view)
+{
+    MutableRawData data;
+    data.addDouble(now);
+    if (view)
+    {
+        Vector3d eyePos = view->eyePos();
+        Matrix4d modelMat = view->calcModelMatrix();
+        data.addInt(1);
+        for (int ii=0;ii<3;ii++)
+            data.addDouble(eyePos[ii]);
+        data.addDouble(view->heightAboveSurface());
+        data.addBytes(modelMat.data(),sizeof(double)*16);
+    } else
+        data.addInt(0);
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    writeRecord(ChangeRecordBlockFrame,data);
+}
+
+int ChangeRecorder::getNumRecorded()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    return numRecorded;
+}
+
+int ChangeRecorder::getNumUnsupported()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    return numUnsupported;
+}
+
+bool ChangeRecorder::IsRecording()
+{
+    return numOpen > 0;
+}
+
+void ChangeRecorder::writeRecord(int recordType,const MutableRawData &data)
+{
+    if (!fp)
+        return;
+
+    int header[2] = {recordType,(int)data.getLen()};
+    fwrite(header,sizeof(int),2,fp);
+    if (data.getLen() > 0)
+        fwrite(data.getRawData(),data.getLen(),1,fp);
+}
+
+bool ChangeRecorder::RecordChange(MutableRawData *data,const ChangeRequest *change)
+{
+    data->addDouble(change->when);
+    data->addInt(change->priority);
+    if (change->record(data))
+        return true;
+
+    data->addInt(ChangeRecordUnknown);
+    return false;
+}
+
+bool ChangeRecorder::RecordDrawable(MutableRawData *data,Drawable *draw)
+{
+    // Instances, particle systems and such aren't basic drawables
+    BasicDrawable *basicDraw = dynamic_cast<BasicDrawable *>(draw);
+    if (!basicDraw)
+        return false;
+
+    data->addInt64(basicDraw->getId());
+    data->addInt(basicDraw->type);
+    data->addInt(basicDraw->on);
+    data->addInt(basicDraw->drawPriority);
+    data->addInt64(basicDraw->programId);
+    data->addInt64(basicDraw->renderTargetID);
+    data->addDouble(basicDraw->localMbr.ll().x());  data->addDouble(basicDraw->localMbr.ll().y());
+    data->addDouble(basicDraw->localMbr.ur().x());  data->addDouble(basicDraw->localMbr.ur().y());
+    data->addDouble(basicDraw->minVisible);  data->addDouble(basicDraw->maxVisible);
+    data->addDouble(basicDraw->drawOffset);
+    data->addDouble(basicDraw->lineWidth);
+    data->addInt(basicDraw->isAlpha);
+    data->addInt(basicDraw->requestZBuffer);
+    data->addInt(basicDraw->writeZBuffer);
+    data->addInt(basicDraw->cullByMbr);
+    data->addBytes(&basicDraw->color,sizeof(RGBAColor));
+    data->addInt(basicDraw->hasMatrix);
+    if (basicDraw->hasMatrix)
+        data->addBytes(basicDraw->mat.data(),sizeof(double)*16);
+    data->addInt((int)basicDraw->texInfo.size());
+    for (const auto &texInfo : basicDraw->texInfo)
+        data->addInt64(texInfo.texId);
+
+    // Geometry is only around until it's handed to the renderer, so we may just have the sizes
+    std::vector<Vector3f> pts;
+    std::vector<BasicDrawable::Triangle> tris;
+    bool hasGeom = basicDraw->getGeometry(pts,tris);
+    data->addInt(hasGeom);
+    if (hasGeom)
+    {
+        data->addInt((int)pts.size());
+        data->addInt((int)tris.size());
+        data->addBytes(&pts[0],sizeof(Vector3f)*pts.size());
+        data->addBytes(&tris[0],sizeof(BasicDrawable::Triangle)*tris.size());
+    } else {
+        data->addInt(basicDraw->numPoints);
+        data->addInt(basicDraw->numTris);
+    }
+
+    // Vertex attributes that still have data
+    int numAttrs = 0;
+    for (auto attr : basicDraw->vertexAttributes)
+        if (attr->numElements() > 0)
+            numAttrs++;
+    data->addInt(numAttrs);
+    for (auto attr : basicDraw->vertexAttributes)
+    {
+        int numElements = attr->numElements();
+        if (numElements == 0)
+            continue;
+        data->addInt(attr->dataType);
+        data->addString(StringIndexer::getString(attr->nameID));
+        data->addInt(numElements);
+        data->addBytes(attr->addressForElement(0),attr->size()*numElements);
+    }
+
+    return true;
+}
+
+bool ChangeRecorder::RecordTexture(MutableRawData *data,TextureBase *texBase)
+{
+    Texture *tex = dynamic_cast<Texture *>(texBase);
+    if (!tex)
+        return false;
+
+    data->addInt64(tex->getId());
+    data->addInt(tex->getWidth());
+    data->addInt(tex->getHeight());
+    data->addInt(tex->getFormat());
+    data->addInt(tex->getInterpType());
+    // The renderer tosses the data once it's been uploaded
+    if (tex->texData)
+    {
+        data->addInt((int)tex->texData->getLen());
+        data->addBytes(tex->texData->getRawData(),tex->texData->getLen());
+    } else
+        data->addInt(0);
+
+    return true;
+}
+
+ChangeReplayFrame::ChangeReplayFrame()
+: time(0.0), hasView(false), eyePos(0.0,0.0,0.0), heightAboveSurface(0.0), modelMat(Matrix4d::Identity())
+{
+}
+
+ChangeReplayer::ChangeReplayer(SceneRenderer *renderer,CoordSystemDisplayAdapter *coordAdapter)
+: renderer(renderer), coordAdapter(coordAdapter), fp(NULL), numReplayed(0), numSkipped(0)
+{
+}
+
+ChangeReplayer::~ChangeReplayer()
+{
+    close();
+}
+
+bool ChangeReplayer::open(const std::string &fileName)
+{
+    close();
+    fp = fopen(fileName.c_str(),"rb");
+    if (!fp)
+        return false;
+
+    int header[2];
+    if (fread(header,sizeof(int),2,fp) != 2 || header[0] != ChangeRecordMagic || header[1] != ChangeRecordVersion)
+    {
+        wkLogLevel(Warn,"ChangeReplayer: %s isn't a recording we can read",fileName.c_str());
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void ChangeReplayer::close()
+{
+    if (fp)
+        fclose(fp);
+    fp = NULL;
+}
+
+bool ChangeReplayer::nextFrame(ChangeReplayFrame &frame)
+{
+    frame.hasView = false;
+    frame.changes.clear();
+    if (!fp)
+        return false;
+
+    bool gotSomething = false;
+    int header[2];
+    while (fread(header,sizeof(int),2,fp) == 2)
+    {
+        RawDataRef data;
+        if (header[1] > 0)
+        {
+            data = RawDataRef(RawDataFromFile(fp,header[1]));
+            if (!data)
+                break;
+        } else
+            data = RawDataRef(new MutableRawData());
+        RawDataReader reader(data.get());
+        gotSomething = true;
+
+        if (header[0] == ChangeRecordBlockFrame)
+        {
+            int hasView = 0;
+            reader.getDouble(frame.time);
+            reader.getInt(hasView);
+            if (hasView)
+            {
+                for (int ii=0;ii<3;ii++)
+                    reader.getDouble(frame.eyePos[ii]);
+                reader.getDouble(frame.heightAboveSurface);
+                frame.hasView = reader.getBytes(frame.modelMat.data(),sizeof(double)*16);
+            }
+            return true;
+        } else if (header[0] == ChangeRecordBlockChanges)
+        {
+            int numChanges = 0;
+            reader.getDouble(frame.time);
+            reader.getInt(numChanges);
+            for (int ii=0;ii<numChanges;ii++)
+            {
+                bool valid = true;
+                ChangeRequest *change = readChange(reader,valid);
+                if (change)
+                    frame.changes.push_back(change);
+                // Can't pick up where we left off in a block that's gone bad
+                if (!valid)
+                {
+                    numSkipped += numChanges - ii - 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    return gotSomething;
+}
+
+ChangeRequest *ChangeReplayer::readChange(RawDataReader &reader,bool &valid)
+{
+    double when = 0.0;
+    int priority = 0,changeType = ChangeRecordUnknown;
+    if (!reader.getDouble(when) || !reader.getInt(priority) || !reader.getInt(changeType))
+    {
+        valid = false;
+        numSkipped++;
+        return NULL;
+    }
+
+    ChangeRequest *change = NULL;
+    int64_t theID = 0;
+    switch (changeType)
+    {
+        case ChangeRecordAddTexture:
+        {
+            TextureBaseRef tex = readTexture(reader);
+            if (tex)
+                change = new AddTextureReq(tex);
+        }
+            break;
+        case ChangeRecordRemTexture:
+            if (reader.getInt64(theID))
+                change = new RemTextureReq(theID);
+            break;
+        case ChangeRecordAddDrawable:
+        {
+            Drawable *draw = readDrawable(reader);
+            if (draw)
+                change = new AddDrawableReq(draw);
+        }
+            break;
+        case ChangeRecordRemDrawable:
+            if (reader.getInt64(theID))
+                change = new RemDrawableReq(theID);
+            break;
+        case ChangeRecordOnOff:
+        {
+            int onOff;
+            if (reader.getInt64(theID) && reader.getInt(onOff))
+                change = new OnOffChangeRequest(theID,onOff);
+        }
+            break;
+        case ChangeRecordColor:
+        {
+            RGBAColor color;
+            if (reader.getInt64(theID) && reader.getBytes(&color,sizeof(RGBAColor)))
+                change = new ColorChangeRequest(theID,color);
+        }
+            break;
+        case ChangeRecordVisibility:
+        {
+            double minVis,maxVis;
+            if (reader.getInt64(theID) && reader.getDouble(minVis) && reader.getDouble(maxVis))
+                change = new VisibilityChangeRequest(theID,minVis,maxVis);
+        }
+            break;
+        case ChangeRecordFade:
+        {
+            double fadeUp,fadeDown;
+            if (reader.getInt64(theID) && reader.getDouble(fadeUp) && reader.getDouble(fadeDown))
+                change = new FadeChangeRequest(theID,fadeUp,fadeDown);
+        }
+            break;
+        case ChangeRecordDrawPriority:
+        {
+            int drawPriority;
+            if (reader.getInt64(theID) && reader.getInt(drawPriority))
+                change = new DrawPriorityChangeRequest(theID,drawPriority);
+        }
+            break;
+        case ChangeRecordDrawableState:
+        {
+            int numRecords = 0;
+            if (!reader.getInt(numRecords) || numRecords < 0)
+                break;
+            std::vector<DrawableStateRecord> records(numRecords);
+            if (numRecords > 0 && !reader.getBytes(&records[0],sizeof(DrawableStateRecord)*numRecords))
+                break;
+            DrawableStateChangeRequest *stateChange = new DrawableStateChangeRequest();
+            stateChange->reserve(numRecords);
+            for (const auto &rec : records)
+                switch (rec.type)
+                {
+                    case DrawableStateRecord::OnOff:
+                        stateChange->addOnOff(rec.drawID,rec.onOff);
+                        break;
+                    case DrawableStateRecord::Color:
+                        stateChange->addColor(rec.drawID,RGBAColor(rec.color[0],rec.color[1],rec.color[2],rec.color[3]));
+                        break;
+                    case DrawableStateRecord::Visibility:
+                        stateChange->addVisibility(rec.drawID,rec.visRange[0],rec.visRange[1]);
+                        break;
+                    case DrawableStateRecord::Fade:
+                        stateChange->addFade(rec.drawID,rec.fade[0],rec.fade[1]);
+                        break;
+                    case DrawableStateRecord::DrawPriority:
+                        stateChange->addDrawPriority(rec.drawID,rec.drawPriority);
+                        break;
+                    case DrawableStateRecord::LineWidth:
+                        stateChange->addLineWidth(rec.drawID,rec.lineWidth);
+                        break;
+                }
+            change = stateChange;
+        }
+            break;
+        case ChangeRecordBulkDrawableState:
+        {
+            DrawableState state;
+            int hasOnOff,onOff,hasFade,hasDrawPriority,drawPriority,remove,numIDs;
+            double fadeUp,fadeDown;
+            if (!reader.getInt(hasOnOff) || !reader.getInt(onOff) ||
+                !reader.getInt(hasFade) || !reader.getDouble(fadeUp) || !reader.getDouble(fadeDown) ||
+                !reader.getInt(hasDrawPriority) || !reader.getInt(drawPriority) ||
+                !reader.getInt(remove) || !reader.getInt(numIDs) || numIDs < 0)
+                break;
+            std::vector<SimpleIdentity> drawIDs(numIDs);
+            if (numIDs > 0 && !reader.getBytes(&drawIDs[0],sizeof(SimpleIdentity)*numIDs))
+                break;
+            if (hasOnOff)
+                state.setOnOff(onOff);
+            if (hasFade)
+                state.setFade(fadeUp,fadeDown);
+            if (hasDrawPriority)
+                state.setDrawPriority(drawPriority);
+            if (remove)
+                state.setRemove();
+            BulkDrawableStateReq *bulkChange = new BulkDrawableStateReq(state,when);
+            for (auto drawID : drawIDs)
+                bulkChange->addDrawID(drawID);
+            change = bulkChange;
+        }
+            break;
+        case ChangeRecordGroup:
+        {
+            int numChanges = 0;
+            if (!reader.getInt(numChanges))
+                break;
+            ChangeSet changes;
+            bool groupValid = true;
+            for (int ii=0;ii<numChanges && groupValid;ii++)
+            {
+                ChangeRequest *subChange = readChange(reader,groupValid);
+                if (subChange)
+                    changes.push_back(subChange);
+            }
+            if (!groupValid)
+            {
+                for (auto subChange : changes)
+                    delete subChange;
+                break;
+            }
+            change = new ChangeGroupReq(changes);
+        }
+            break;
+        case ChangeRecordUnknown:
+            // Recorded, but there was nothing we could write for it
+            numSkipped++;
+            return NULL;
+        default:
+            break;
+    }
+
+    if (!change)
+    {
+        valid = false;
+        numSkipped++;
+        return NULL;
+    }
+
+    change->when = when;
+    change->priority = priority;
+    // The requests in a group have already been counted
+    if (changeType != ChangeRecordGroup)
+        numReplayed++;
+
+    return change;
+}
+
+// Input size for a texture, when we have to make up the data
+static int TexturePixelSize(TextureType format)
+{
+    switch (format)
+    {
+        case TexTypeDoubleFloat32:
+        case TexTypeQuadFloat16:
+        case TexTypeDoubleUInt32:
+            return 8;
+        case TexTypeQuadFloat32:
+        case TexTypeQuadUInt32:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+TextureBaseRef ChangeReplayer::readTexture(RawDataReader &reader)
+{
+    int64_t texID;
+    int width,height,format,interpType,dataLen;
+    if (!reader.getInt64(texID) || !reader.getInt(width) || !reader.getInt(height) ||
+        !reader.getInt(format) || !reader.getInt(interpType) || !reader.getInt(dataLen) ||
+        width < 0 || height < 0 || dataLen < 0)
+        return TextureBaseRef();
+
+    MutableRawDataRef texData;
+    if (dataLen > 0)
+    {
+        std::vector<unsigned char> bytes(dataLen);
+        if (!reader.getBytes(&bytes[0],dataLen))
+            return TextureBaseRef();
+        texData = MutableRawDataRef(new MutableRawData(&bytes[0],dataLen));
+    } else
+        texData = MutableRawDataRef(new MutableRawData(width*height*TexturePixelSize((TextureType)format)));
+
+    TextureRef tex = renderer->makeTexture("Replay Texture");
+    tex->setId(texID);
+    tex->setWidth(width);
+    tex->setHeight(height);
+    tex->setFormat((TextureType)format);
+    tex->setInterpType((TextureInterpType)interpType);
+    tex->texData = texData;
+
+    return tex;
+}
+
+// Strings are padded out to 4 bytes when they're written, so drop the padding
+static bool ReadString(RawDataReader &reader,std::string &str)
+{
+    if (!reader.getString(str))
+        return false;
+    str.erase(str.find_last_not_of('\0')+1);
+
+    return true;
+}
+
+Drawable *ChangeReplayer::readDrawable(RawDataReader &reader)
+{
+    int64_t drawID,programID,renderTargetID;
+    int type,onOff,drawPriority,isAlpha,requestZBuffer,writeZBuffer,cullByMbr,hasMatrix,numTex;
+    double llX,llY,urX,urY,minVis,maxVis,drawOffset,lineWidth;
+    RGBAColor color;
+    Matrix4d mat;
+    if (!reader.getInt64(drawID) || !reader.getInt(type) || !reader.getInt(onOff) || !reader.getInt(drawPriority) ||
+        !reader.getInt64(programID) || !reader.getInt64(renderTargetID) ||
+        !reader.getDouble(llX) || !reader.getDouble(llY) || !reader.getDouble(urX) || !reader.getDouble(urY) ||
+        !reader.getDouble(minVis) || !reader.getDouble(maxVis) || !reader.getDouble(drawOffset) || !reader.getDouble(lineWidth) ||
+        !reader.getInt(isAlpha) || !reader.getInt(requestZBuffer) || !reader.getInt(writeZBuffer) || !reader.getInt(cullByMbr) ||
+        !reader.getBytes(&color,sizeof(RGBAColor)) || !reader.getInt(hasMatrix))
+        return NULL;
+    if (hasMatrix && !reader.getBytes(mat.data(),sizeof(double)*16))
+        return NULL;
+    if (!reader.getInt(numTex) || numTex < 0)
+        return NULL;
+    std::vector<SimpleIdentity> texIDs(numTex);
+    for (int ii=0;ii<numTex;ii++)
+    {
+        int64_t texID;
+        if (!reader.getInt64(texID))
+            return NULL;
+        texIDs[ii] = texID;
+    }
+
+    int hasGeom,numPoints,numTris;
+    if (!reader.getInt(hasGeom) || !reader.getInt(numPoints) || !reader.getInt(numTris) || numPoints < 0 || numTris < 0)
+        return NULL;
+
+    BasicDrawableBuilderRef builder = renderer->makeBasicDrawableBuilder("Replay");
+    builder->setType((GeometryType)type);
+    builder->setOnOff(onOff);
+    builder->setDrawPriority(drawPriority);
+    builder->setProgram(programID);
+    builder->setRenderTarget(renderTargetID);
+    Mbr localMbr(Point2f(llX,llY),Point2f(urX,urY));
+    builder->setLocalMbr(localMbr);
+    builder->setCullByMbr(cullByMbr);
+    builder->setVisibleRange(minVis,maxVis);
+    builder->setDrawOffset(drawOffset);
+    builder->setLineWidth(lineWidth);
+    builder->setAlpha(isAlpha);
+    builder->setRequestZBuffer(requestZBuffer);
+    builder->setWriteZBuffer(writeZBuffer);
+    builder->setColor(color);
+    if (hasMatrix)
+        builder->setMatrix(&mat);
+    builder->setTexIDs(texIDs);
+
+    if (hasGeom)
+    {
+        builder->points.resize(numPoints);
+        builder->tris.resize(numTris);
+        if ((numPoints > 0 && !reader.getBytes(&builder->points[0],sizeof(Vector3f)*numPoints)) ||
+            (numTris > 0 && !reader.getBytes(&builder->tris[0],sizeof(BasicDrawable::Triangle)*numTris)))
+            return NULL;
+    } else if (numPoints > 0)
+    {
+        // Make up a grid of points over the bounds so the renderer has the same amount to chew on
+        int gridSize = std::max((int)ceil(sqrt((double)numPoints)),2);
+        for (int ii=0;ii<numPoints;ii++)
+        {
+            Point3d localPt(llX + (ii % gridSize) * (urX-llX) / (gridSize-1),llY + (ii / gridSize) * (urY-llY) / (gridSize-1),0.0);
+            builder->points.push_back(localMbr.valid() && coordAdapter ? Vector3f(coordAdapter->localToDisplay(localPt).cast<float>()) : Vector3f(0.0,0.0,0.0));
+        }
+        for (int ii=0;ii<numTris;ii++)
+            builder->tris.push_back(BasicDrawable::Triangle(ii % numPoints,(ii+1) % numPoints,(ii+2) % numPoints));
+    }
+
+    // Copy the vertex attributes into the matching ones on the new drawable
+    int numAttrs;
+    if (!reader.getInt(numAttrs))
+        return NULL;
+    for (int ii=0;ii<numAttrs;ii++)
+    {
+        int dataType,numElements;
+        std::string attrName;
+        if (!reader.getInt(dataType) || !ReadString(reader,attrName) || !reader.getInt(numElements) || numElements < 0)
+            return NULL;
+        StringIdentity nameID = StringIndexer::getStringID(attrName);
+        VertexAttribute *attr = NULL;
+        for (auto thisAttr : builder->basicDraw->vertexAttributes)
+            if (thisAttr->nameID == nameID && thisAttr->dataType == dataType)
+            {
+                attr = thisAttr;
+                break;
+            }
+        if (!attr)
+            attr = builder->basicDraw->vertexAttributes[builder->addAttribute((BDAttributeDataType)dataType,nameID,numElements)];
+        attr->clear();
+        attr->reserve(numElements);
+        for (int jj=0;jj<numElements;jj++)
+        {
+            bool ok = true;
+            switch (dataType)
+            {
+                case BDFloat4Type:
+                {
+                    Vector4f vec;
+                    ok = reader.getBytes(vec.data(),sizeof(float)*4);
+                    attr->addVector4f(vec);
+                }
+                    break;
+                case BDFloat3Type:
+                {
+                    Vector3f vec;
+                    ok = reader.getBytes(vec.data(),sizeof(float)*3);
+                    attr->addVector3f(vec);
+                }
+                    break;
+                case BDFloat2Type:
+                {
+                    Vector2f vec;
+                    ok = reader.getBytes(vec.data(),sizeof(float)*2);
+                    attr->addVector2f(vec);
+                }
+                    break;
+                case BDChar4Type:
+                {
+                    RGBAColor attrColor;
+                    ok = reader.getBytes(&attrColor,sizeof(RGBAColor));
+                    attr->addColor(attrColor);
+                }
+                    break;
+                case BDFloatType:
+                {
+                    float val;
+                    ok = reader.getBytes(&val,sizeof(float));
+                    attr->addFloat(val);
+                }
+                    break;
+                case BDIntType:
+                {
+                    int val;
+                    ok = reader.getInt(val);
+                    attr->addInt(val);
+                }
+                    break;
+                default:
+                    ok = false;
+                    break;
+            }
+            if (!ok)
+                return NULL;
+        }
+    }
+
+    BasicDrawable *draw = builder->getDrawable();
+    draw->setId(drawID);
+
+    return draw;
+}
+
+}
@@ -18,12 +18,14 @@
  *
  */
 
+#import <algorithm>
 #import "ChangeRequest.h"
+#import "ChangeRecorder.h"
 
 namespace WhirlyKit
 {
 
-ChangeRequest::ChangeRequest() : when(0.0) { }
+ChangeRequest::ChangeRequest() : when(0.0), priority(0) { }
 
 ChangeRequest::~ChangeRequest()
 {
@@ -35,4 +37,75 @@ void ChangeRequest::setupForRenderer(const RenderSetupInfo *) { }
 
 bool ChangeRequest::needPreExecute() { return false; }
 
+bool ChangeRequest::record(MutableRawData *data) const { return false; }
+
+void SetChangePriority(ChangeSet &changes,int priority,size_t start)
+{
+    for (size_t ii=start;ii<changes.size();ii++)
+        if (changes[ii])
+            changes[ii]->priority = priority;
+}
+
+ChangeGroupReq::ChangeGroupReq(const ChangeSet &inChanges)
+{
+    // The group runs once all of its requests are ready, and as early as the most important one
+    bool first = true;
+    for (ChangeRequest *change : inChanges)
+        if (change)
+        {
+            changes.push_back(change);
+            when = std::max(when,change->when);
+            priority = first ? change->priority : std::max(priority,change->priority);
+            first = false;
+        }
+}
+
+ChangeGroupReq::~ChangeGroupReq()
+{
+    for (ChangeRequest *change : changes)
+        delete change;
+    changes.clear();
+}
+
+bool ChangeGroupReq::needsFlush()
+{
+    for (ChangeRequest *change : changes)
+        if (change->needsFlush())
+            return true;
+    
+    return false;
+}
+
+bool ChangeGroupReq::needPreExecute()
+{
+    for (ChangeRequest *change : changes)
+        if (change->needPreExecute())
+            return true;
+    
+    return false;
+}
+
+void ChangeGroupReq::setupForRenderer(const RenderSetupInfo *setupInfo)
+{
+    for (ChangeRequest *change : changes)
+        change->setupForRenderer(setupInfo);
+}
+
+void ChangeGroupReq::execute(Scene *scene,SceneRenderer *renderer,View *view)
+{
+    for (ChangeRequest *change : changes)
+        change->execute(scene,renderer,view);
+}
+
+bool ChangeGroupReq::record(MutableRawData *data) const
+{
+    // The ones we can't record are skipped on replay
+    data->addInt(ChangeRecordGroup);
+    data->addInt((int)changes.size());
+    for (ChangeRequest *change : changes)
+        ChangeRecorder::RecordChange(data,change);
+    
+    return true;
+}
+
 }
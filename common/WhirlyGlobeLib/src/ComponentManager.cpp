@@ -138,16 +138,23 @@ void ComponentManager::removeComponentObjects(PlatformThreadInfo *threadInfo,con
         }
     }
     
+    // Vectors tend to be the bulk of it, so do them all at once
+    SimpleIDSet vectorIDs,wideVectorIDs;
+    for (ComponentObjectRef compObj : compRefs) {
+        vectorIDs.insert(compObj->vectorIDs.begin(),compObj->vectorIDs.end());
+        wideVectorIDs.insert(compObj->wideVectorIDs.begin(),compObj->wideVectorIDs.end());
+    }
+    if (!vectorIDs.empty())
+        vectorManager->removeVectors(vectorIDs, changes);
+    if (!wideVectorIDs.empty())
+        wideVectorManager->removeVectors(wideVectorIDs, changes);
+
     for (ComponentObjectRef compObj : compRefs) {
         // Get rid of the various layer objects
         if (!compObj->markerIDs.empty())
             markerManager->removeMarkers(compObj->markerIDs, changes);
         if (!compObj->labelIDs.empty())
             labelManager->removeLabels(threadInfo,compObj->labelIDs, changes);
-        if (!compObj->vectorIDs.empty())
-            vectorManager->removeVectors(compObj->vectorIDs, changes);
-        if (!compObj->wideVectorIDs.empty())
-            wideVectorManager->removeVectors(compObj->wideVectorIDs, changes);
         if (!compObj->shapeIDs.empty())
             shapeManager->removeShapes(compObj->shapeIDs, changes);
         if (!compObj->loftIDs.empty())
@@ -209,16 +216,23 @@ void ComponentManager::enableComponentObjects(const SimpleIDSet &compIDs,bool en
         }
     }
     
+    // Vectors tend to be the bulk of it, so do them all at once
+    SimpleIDSet vectorIDs,wideVectorIDs;
+    for (ComponentObjectRef compObj : compRefs) {
+        vectorIDs.insert(compObj->vectorIDs.begin(),compObj->vectorIDs.end());
+        wideVectorIDs.insert(compObj->wideVectorIDs.begin(),compObj->wideVectorIDs.end());
+    }
+    if (!vectorIDs.empty())
+        vectorManager->enableVectors(vectorIDs, enable, changes);
+    if (!wideVectorIDs.empty())
+        wideVectorManager->enableVectors(wideVectorIDs, enable, changes);
+
     for (ComponentObjectRef compObj: compRefs)
     {
         // Note: Should lock just around this component object
         //       But I'm not sure I want one std::mutex per object
         compObj->enable = enable;
 
-        if (!compObj->vectorIDs.empty())
-            vectorManager->enableVectors(compObj->vectorIDs, enable, changes);
-        if (!compObj->wideVectorIDs.empty())
-            wideVectorManager->enableVectors(compObj->wideVectorIDs, enable, changes);
         if (!compObj->markerIDs.empty())
             markerManager->enableMarkers(compObj->markerIDs, enable, changes);
         if (!compObj->labelIDs.empty())
@@ -0,0 +1,259 @@
+/*
+ *  DrawableSpatialIndex.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "DrawableSpatialIndex.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+DrawableCullTest::DrawableCullTest(CoordSystemDisplayAdapter *coordAdapter,const Eigen::Matrix4d &mvpMat)
+: coordAdapter(coordAdapter), mvpMat(mvpMat)
+{
+    coordSys = coordAdapter->getCoordSystem();
+    isFlat = coordAdapter->isFlat();
+}
+
+void DrawableCullTest::calcDisplayBox(const MbrD &mbr,bool isGeo,Point3d &ll,Point3d &ur) const
+{
+    // A 3x3 grid catches most of the curvature
+    bool first = true;
+    for (int iy=0;iy<3;iy++)
+        for (int ix=0;ix<3;ix++)
+        {
+            Point2d pt(mbr.ll().x() + ix * (mbr.ur().x()-mbr.ll().x()) / 2.0,
+                       mbr.ll().y() + iy * (mbr.ur().y()-mbr.ll().y()) / 2.0);
+            Point3d localPt = isGeo ? coordSys->geographicToLocal(pt) : Point3d(pt.x(),pt.y(),0.0);
+            Point3d dispPt = coordAdapter->localToDisplay(localPt);
+            if (first)
+            {
+                ll = dispPt;  ur = dispPt;
+                first = false;
+            } else {
+                ll = ll.cwiseMin(dispPt);
+                ur = ur.cwiseMax(dispPt);
+            }
+        }
+
+    // Pad the box out to account for curvature and things sitting a bit above the surface
+    double pad = 0.25 * (ur-ll).maxCoeff();
+    if (!isFlat)
+    {
+        double span = std::max(mbr.ur().x()-mbr.ll().x(),mbr.ur().y()-mbr.ll().y());
+        pad += 1.0 - cos(span/2.0);
+    }
+    ll -= Point3d(pad,pad,pad);
+    ur += Point3d(pad,pad,pad);
+}
+
+bool DrawableCullTest::boxVisible(const Point3d &ll,const Point3d &ur) const
+{
+    // If all the corners are outside any one clip plane, it's not visible
+    int outside[6] = {0,0,0,0,0,0};
+    for (int ii=0;ii<8;ii++)
+    {
+        Vector4d pt(ii & 1 ? ur.x() : ll.x(),ii & 2 ? ur.y() : ll.y(),ii & 4 ? ur.z() : ll.z(),1.0);
+        Vector4d clipPt = mvpMat * pt;
+        if (clipPt.x() < -clipPt.w())  outside[0]++;
+        if (clipPt.x() > clipPt.w())  outside[1]++;
+        if (clipPt.y() < -clipPt.w())  outside[2]++;
+        if (clipPt.y() > clipPt.w())  outside[3]++;
+        if (clipPt.z() < -clipPt.w())  outside[4]++;
+        if (clipPt.z() > clipPt.w())  outside[5]++;
+    }
+
+    for (int ii=0;ii<6;ii++)
+        if (outside[ii] == 8)
+            return false;
+
+    return true;
+}
+
+bool DrawableCullTest::operator () (const MbrD &mbr) const
+{
+    // Big chunks of a globe are too curved to bother with
+    if (!isFlat && (mbr.ur().x()-mbr.ll().x() > M_PI/2.0 || mbr.ur().y()-mbr.ll().y() > M_PI/2.0))
+        return true;
+
+    Point3d ll,ur;
+    calcDisplayBox(mbr,true,ll,ur);
+    if (boxVisible(ll,ur))
+        return true;
+
+    // For the globe local and geographic are the same thing
+    if (isFlat)
+    {
+        calcDisplayBox(mbr,false,ll,ur);
+        if (boxVisible(ll,ur))
+            return true;
+    }
+
+    return false;
+}
+
+const int DrawableSpatialIndex::MaxLevel;
+const uint64_t DrawableSpatialIndex::UnboundedKey;
+
+DrawableSpatialIndex::DrawableSpatialIndex()
+: bounds(Point2d(-M_PI,-M_PI),Point2d(M_PI,M_PI))
+{
+}
+
+DrawableSpatialIndex::~DrawableSpatialIndex()
+{
+}
+
+void DrawableSpatialIndex::setBounds(const MbrD &newBounds)
+{
+    bounds = newBounds;
+
+    // Redistribute anything we've already got
+    auto oldDraws = allDraws;
+    clear();
+    for (auto it : oldDraws)
+        addDrawable(it.second.first,it.second.second);
+}
+
+void DrawableSpatialIndex::clear()
+{
+    nodes.clear();
+    unbounded.clear();
+    drawNodes.clear();
+    allDraws.clear();
+}
+
+MbrD DrawableSpatialIndex::nodeBounds(int level,int x,int y) const
+{
+    double cellX = (bounds.ur().x() - bounds.ll().x()) / (1<<level);
+    double cellY = (bounds.ur().y() - bounds.ll().y()) / (1<<level);
+
+    // Loose bounds are the cell expanded by half on each side
+    Point2d ll(bounds.ll().x() + (x - 0.5) * cellX,bounds.ll().y() + (y - 0.5) * cellY);
+    Point2d ur(bounds.ll().x() + (x + 1.5) * cellX,bounds.ll().y() + (y + 1.5) * cellY);
+
+    return MbrD(ll,ur);
+}
+
+bool DrawableSpatialIndex::placeMbr(const Mbr &mbr,int &level,int &x,int &y) const
+{
+    Point2d mid(mbr.mid().x(),mbr.mid().y());
+    if (mid.x() < bounds.ll().x() || mid.y() < bounds.ll().y() ||
+        mid.x() >= bounds.ur().x() || mid.y() >= bounds.ur().y())
+        return false;
+
+    // Deepest level where the drawable is no bigger than a cell
+    double sizeX = bounds.ur().x() - bounds.ll().x();
+    double sizeY = bounds.ur().y() - bounds.ll().y();
+    Point2f span = mbr.span();
+    level = MaxLevel;
+    if (span.x() > 0.0)
+        level = std::min(level,(int)floor(log2(sizeX / span.x())));
+    if (span.y() > 0.0)
+        level = std::min(level,(int)floor(log2(sizeY / span.y())));
+    if (level < 0)
+        level = 0;
+
+    int numCells = 1<<level;
+    x = std::min((int)((mid.x() - bounds.ll().x()) / sizeX * numCells),numCells-1);
+    y = std::min((int)((mid.y() - bounds.ll().y()) / sizeY * numCells),numCells-1);
+
+    return true;
+}
+
+void DrawableSpatialIndex::adjustCounts(int level,int x,int y,int delta)
+{
+    for (;level >= 0;level--,x/=2,y/=2)
+    {
+        auto it = nodes.find(makeKey(level,x,y));
+        if (it == nodes.end())
+        {
+            if (delta < 0)
+                continue;
+            it = nodes.insert(std::make_pair(makeKey(level,x,y),Node())).first;
+        }
+        it->second.numInTree += delta;
+        if (it->second.numInTree <= 0)
+            nodes.erase(it);
+    }
+}
+
+void DrawableSpatialIndex::addDrawable(Drawable *draw,bool cullable)
+{
+    SimpleIdentity drawID = draw->getId();
+    if (drawNodes.find(drawID) != drawNodes.end())
+        removeDrawable(drawID);
+    allDraws[drawID] = std::make_pair(draw,cullable);
+
+    int level,x,y;
+    Mbr mbr = draw->getLocalMbr();
+    if (!cullable || !mbr.valid() || !placeMbr(mbr,level,x,y))
+    {
+        drawNodes[drawID] = std::make_pair(UnboundedKey,(int)unbounded.size());
+        unbounded.push_back(draw);
+        return;
+    }
+
+    adjustCounts(level,x,y,1);
+    uint64_t key = makeKey(level,x,y);
+    std::vector<Drawable *> &draws = nodes[key].draws;
+    drawNodes[drawID] = std::make_pair(key,(int)draws.size());
+    draws.push_back(draw);
+}
+
+void DrawableSpatialIndex::removeDrawable(SimpleIdentity drawID)
+{
+    auto it = drawNodes.find(drawID);
+    if (it == drawNodes.end())
+        return;
+    uint64_t key = it->second.first;
+    int pos = it->second.second;
+    drawNodes.erase(it);
+    allDraws.erase(drawID);
+
+    std::vector<Drawable *> *draws = NULL;
+    if (key == UnboundedKey)
+        draws = &unbounded;
+    else {
+        auto nit = nodes.find(key);
+        if (nit == nodes.end())
+            return;
+        draws = &nit->second.draws;
+    }
+
+    // Swap the last one into this slot
+    if (pos < (int)draws->size())
+    {
+        Drawable *last = draws->back();
+        (*draws)[pos] = last;
+        draws->pop_back();
+        if (last->getId() != drawID)
+            drawNodes[last->getId()].second = pos;
+    }
+
+    if (key != UnboundedKey)
+    {
+        int level = (int)(key >> 58);
+        int x = (int)((key >> 29) & ((1<<29)-1));
+        int y = (int)(key & ((1<<29)-1));
+        adjustCounts(level,x,y,-1);
+    }
+}
+
+}
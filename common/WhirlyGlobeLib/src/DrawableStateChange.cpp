@@ -0,0 +1,344 @@
+/*
+ *  DrawableStateChange.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "DrawableStateChange.h"
+#import "BasicDrawable.h"
+#import "BasicDrawableInstance.h"
+#import "ParticleSystemDrawable.h"
+#import "SceneRenderer.h"
+#import "Scene.h"
+#import "ChangeRecorder.h"
+
+namespace WhirlyKit
+{
+
+void SetDrawableOnOff(Drawable *draw,bool onOff)
+{
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw);
+    if (basicDrawable) {
+        basicDrawable->setOnOff(onOff);
+    } else {
+        BasicDrawableInstance *basicDrawInst = dynamic_cast<BasicDrawableInstance *>(draw);
+        if (basicDrawInst)
+            basicDrawInst->setEnable(onOff);
+        else {
+            ParticleSystemDrawable *partSys = dynamic_cast<ParticleSystemDrawable *>(draw);
+            if (partSys)
+                partSys->setOnOff(onOff);
+        }
+    }
+}
+
+void SetDrawableColor(Drawable *draw,const RGBAColor &color)
+{
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw);
+    if (basicDrawable) {
+        basicDrawable->setOverrideColor(color);
+    } else {
+        BasicDrawableInstance *basicDrawInst = dynamic_cast<BasicDrawableInstance *>(draw);
+        if (basicDrawInst)
+            basicDrawInst->setColor(color);
+    }
+}
+
+void SetDrawableVisibleRange(Drawable *draw,float minVis,float maxVis)
+{
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw);
+    if (basicDrawable) {
+        basicDrawable->setVisibleRange(minVis,maxVis);
+    } else {
+        BasicDrawableInstance *basicDrawInst = dynamic_cast<BasicDrawableInstance *>(draw);
+        if (basicDrawInst)
+            basicDrawInst->setVisibleRange(minVis,maxVis);
+    }
+}
+
+void SetDrawableFade(Drawable *draw,TimeInterval fadeUp,TimeInterval fadeDown)
+{
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw);
+    if (basicDrawable)
+        basicDrawable->setFade(fadeDown,fadeUp);
+}
+
+void SetDrawableLineWidth(Drawable *draw,float lineWidth)
+{
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw);
+    if (basicDrawable) {
+        basicDrawable->setLineWidth(lineWidth);
+    } else {
+        BasicDrawableInstance *basicDrawInst = dynamic_cast<BasicDrawableInstance *>(draw);
+        if (basicDrawInst)
+            basicDrawInst->setLineWidth(lineWidth);
+    }
+}
+
+void SetDrawableDrawPriority(SceneRenderer *renderer,DrawableRef draw,int drawPriority)
+{
+    // The renderer sorts by priority, so it needs to take this out and put it back
+    renderer->removeDrawable(draw,false);
+    
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw.get());
+    if (basicDrawable) {
+        basicDrawable->setDrawPriority(drawPriority);
+    } else {
+        BasicDrawableInstance *basicDrawInst = dynamic_cast<BasicDrawableInstance *>(draw.get());
+        if (basicDrawInst)
+            basicDrawInst->setDrawPriority(drawPriority);
+    }
+    
+    renderer->addDrawable(draw);
+}
+
+void SetDrawableUniforms(Drawable *draw,const SingleVertexAttributeSet &uniforms)
+{
+    BasicDrawable *basicDrawable = dynamic_cast<BasicDrawable *>(draw);
+    if (basicDrawable) {
+        basicDrawable->setUniforms(uniforms);
+    } else {
+        BasicDrawableInstance *basicDrawInst = dynamic_cast<BasicDrawableInstance *>(draw);
+        if (basicDrawInst)
+            basicDrawInst->setUniforms(uniforms);
+    }
+}
+
+DrawableStateChangeRequest::DrawableStateChangeRequest()
+{
+}
+
+DrawableStateChangeRequest::~DrawableStateChangeRequest()
+{
+}
+
+DrawableStateChangeRequest *DrawableStateChangeRequest::AddTo(ChangeSet &changes)
+{
+    if (!changes.empty())
+    {
+        DrawableStateChangeRequest *lastReq = dynamic_cast<DrawableStateChangeRequest *>(changes.back());
+        if (lastReq && lastReq->when == 0.0)
+            return lastReq;
+    }
+    
+    DrawableStateChangeRequest *newReq = new DrawableStateChangeRequest();
+    changes.push_back(newReq);
+    
+    return newReq;
+}
+
+void DrawableStateChangeRequest::reserve(size_t numChanges)
+{
+    records.reserve(records.size() + numChanges);
+}
+
+DrawableStateRecord &DrawableStateChangeRequest::addRecord(SimpleIdentity drawID,DrawableStateRecord::Type type)
+{
+    records.resize(records.size()+1);
+    DrawableStateRecord &rec = records.back();
+    rec.drawID = drawID;
+    rec.type = type;
+    
+    return rec;
+}
+
+void DrawableStateChangeRequest::addOnOff(SimpleIdentity drawID,bool onOff)
+{
+    addRecord(drawID,DrawableStateRecord::OnOff).onOff = onOff;
+}
+
+void DrawableStateChangeRequest::addColor(SimpleIdentity drawID,const RGBAColor &color)
+{
+    DrawableStateRecord &rec = addRecord(drawID,DrawableStateRecord::Color);
+    color.asUChar4(rec.color);
+}
+
+void DrawableStateChangeRequest::addVisibility(SimpleIdentity drawID,float minVis,float maxVis)
+{
+    DrawableStateRecord &rec = addRecord(drawID,DrawableStateRecord::Visibility);
+    rec.visRange[0] = minVis;
+    rec.visRange[1] = maxVis;
+}
+
+void DrawableStateChangeRequest::addFade(SimpleIdentity drawID,TimeInterval fadeUp,TimeInterval fadeDown)
+{
+    DrawableStateRecord &rec = addRecord(drawID,DrawableStateRecord::Fade);
+    rec.fade[0] = fadeUp;
+    rec.fade[1] = fadeDown;
+}
+
+void DrawableStateChangeRequest::addDrawPriority(SimpleIdentity drawID,int drawPriority)
+{
+    addRecord(drawID,DrawableStateRecord::DrawPriority).drawPriority = drawPriority;
+}
+
+void DrawableStateChangeRequest::addLineWidth(SimpleIdentity drawID,float lineWidth)
+{
+    addRecord(drawID,DrawableStateRecord::LineWidth).lineWidth = lineWidth;
+}
+
+void DrawableStateChangeRequest::execute(Scene *scene,SceneRenderer *renderer,View *view)
+{
+    TimeInterval renderUntil = 0.0;
+    
+    for (const DrawableStateRecord &rec : records)
+    {
+        auto it = scene->drawables.find(rec.drawID);
+        if (it == scene->drawables.end())
+            continue;
+        Drawable *draw = it->second.get();
+        
+        switch (rec.type)
+        {
+            case DrawableStateRecord::OnOff:
+                SetDrawableOnOff(draw,rec.onOff);
+                break;
+            case DrawableStateRecord::Color:
+                SetDrawableColor(draw,RGBAColor(rec.color[0],rec.color[1],rec.color[2],rec.color[3]));
+                break;
+            case DrawableStateRecord::Visibility:
+                SetDrawableVisibleRange(draw,rec.visRange[0],rec.visRange[1]);
+                break;
+            case DrawableStateRecord::Fade:
+                SetDrawableFade(draw,rec.fade[0],rec.fade[1]);
+                renderUntil = std::max(renderUntil,std::max(rec.fade[0],rec.fade[1]));
+                break;
+            case DrawableStateRecord::DrawPriority:
+                SetDrawableDrawPriority(renderer,it->second,rec.drawPriority);
+                break;
+            case DrawableStateRecord::LineWidth:
+                SetDrawableLineWidth(draw,rec.lineWidth);
+                break;
+        }
+    }
+    
+    // Let the renderer know to keep going for the fades
+    if (renderUntil > 0.0)
+        renderer->setRenderUntil(renderUntil);
+}
+
+bool DrawableStateChangeRequest::record(MutableRawData *data) const
+{
+    // The records are plain data, so they go out as is
+    data->addInt(ChangeRecordDrawableState);
+    data->addInt((int)records.size());
+    if (!records.empty())
+        data->addBytes(&records[0],sizeof(DrawableStateRecord)*records.size());
+    
+    return true;
+}
+
+DrawableState::DrawableState()
+: hasOnOff(false), onOff(true), hasFade(false), fadeUp(0.0), fadeDown(0.0),
+hasDrawPriority(false), drawPriority(0), hasUniforms(false), remove(false)
+{
+}
+
+void DrawableState::setOnOff(bool inOnOff)
+{
+    hasOnOff = true;
+    onOff = inOnOff;
+}
+
+void DrawableState::setFade(TimeInterval inFadeUp,TimeInterval inFadeDown)
+{
+    hasFade = true;
+    fadeUp = inFadeUp;
+    fadeDown = inFadeDown;
+}
+
+void DrawableState::setDrawPriority(int inDrawPriority)
+{
+    hasDrawPriority = true;
+    drawPriority = inDrawPriority;
+}
+
+void DrawableState::setUniforms(const SingleVertexAttributeSet &inUniforms)
+{
+    hasUniforms = true;
+    uniforms = inUniforms;
+}
+
+void DrawableState::setRemove()
+{
+    remove = true;
+}
+
+bool DrawableState::matches(const DrawableState &that) const
+{
+    if (hasUniforms || that.hasUniforms)
+        return false;
+    
+    return hasOnOff == that.hasOnOff && (!hasOnOff || onOff == that.onOff) &&
+           hasFade == that.hasFade && (!hasFade || (fadeUp == that.fadeUp && fadeDown == that.fadeDown)) &&
+           hasDrawPriority == that.hasDrawPriority && (!hasDrawPriority || drawPriority == that.drawPriority) &&
+           remove == that.remove;
+}
+
+BulkDrawableStateReq::BulkDrawableStateReq(const DrawableState &state,TimeInterval inWhen)
+: state(state)
+{
+    when = inWhen;
+}
+
+BulkDrawableStateReq::~BulkDrawableStateReq()
+{
+}
+
+BulkDrawableStateReq *BulkDrawableStateReq::AddTo(ChangeSet &changes,const DrawableState &state,TimeInterval when)
+{
+    if (!changes.empty())
+    {
+        BulkDrawableStateReq *lastReq = dynamic_cast<BulkDrawableStateReq *>(changes.back());
+        if (lastReq && lastReq->when == when && lastReq->state.matches(state))
+            return lastReq;
+    }
+    
+    BulkDrawableStateReq *newReq = new BulkDrawableStateReq(state,when);
+    changes.push_back(newReq);
+    
+    return newReq;
+}
+
+void BulkDrawableStateReq::execute(Scene *scene,SceneRenderer *renderer,View *view)
+{
+    if (!drawIDs.empty())
+        scene->applyDrawableStates(renderer,&drawIDs[0],drawIDs.size(),state);
+}
+
+bool BulkDrawableStateReq::record(MutableRawData *data) const
+{
+    // We'd lose the uniforms, which could change the look of the replay
+    if (state.hasUniforms)
+        return false;
+
+    data->addInt(ChangeRecordBulkDrawableState);
+    data->addInt(state.hasOnOff);
+    data->addInt(state.onOff);
+    data->addInt(state.hasFade);
+    data->addDouble(state.fadeUp);
+    data->addDouble(state.fadeDown);
+    data->addInt(state.hasDrawPriority);
+    data->addInt(state.drawPriority);
+    data->addInt(state.remove);
+    data->addInt((int)drawIDs.size());
+    if (!drawIDs.empty())
+        data->addBytes(&drawIDs[0],sizeof(SimpleIdentity)*drawIDs.size());
+
+    return true;
+}
+
+}
@@ -0,0 +1,235 @@
+/*
+ *  ElevationChunk.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import <cmath>
+#import "ElevationChunk.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+ElevationChunk::ElevationChunk()
+: minElev(0.0), maxElev(0.0)
+{
+}
+
+ElevationChunk::~ElevationChunk()
+{
+}
+
+void ElevationChunk::sampleGrid(const Point2d &ll,const Point2d &ur,int tessX,int tessY,std::vector<float> &elevs) const
+{
+    elevs.resize((tessX+1)*(tessY+1));
+    for (int iy=0;iy<=tessY;iy++)
+    {
+        double y = ll.y() + (ur.y()-ll.y()) * iy / tessY;
+        for (int ix=0;ix<=tessX;ix++)
+            elevs[iy*(tessX+1)+ix] = interpolateElevation(ll.x() + (ur.x()-ll.x()) * ix / tessX, y);
+    }
+}
+
+void ElevationChunk::getElevationRange(const Point2d &ll,const Point2d &ur,double &minZ,double &maxZ) const
+{
+    minZ = minElev;
+    maxZ = maxElev;
+}
+
+double ElevationChunk::getMinElevation() const
+{
+    return minElev;
+}
+
+double ElevationChunk::getMaxElevation() const
+{
+    return maxElev;
+}
+
+ElevationGridChunk::ElevationGridChunk(int inSizeX,int inSizeY,const std::vector<float> &inElevs)
+: sizeX(inSizeX), sizeY(inSizeY), elevs(inElevs)
+{
+    setupRanges();
+}
+
+ElevationGridChunk::ElevationGridChunk(int inSizeX,int inSizeY,std::vector<float> &&inElevs)
+: sizeX(inSizeX), sizeY(inSizeY), elevs(std::move(inElevs))
+{
+    setupRanges();
+}
+
+int ElevationGridChunk::getSizeX() const
+{
+    return sizeX;
+}
+
+int ElevationGridChunk::getSizeY() const
+{
+    return sizeY;
+}
+
+void ElevationGridChunk::scanRange(int sx0,int sy0,int sx1,int sy1,float &minZ,float &maxZ) const
+{
+    minZ = maxZ = sampleAt(sx0,sy0);
+    for (int iy=sy0;iy<=sy1;iy++)
+        for (int ix=sx0;ix<=sx1;ix++)
+        {
+            float elev = sampleAt(ix,iy);
+            minZ = std::min(minZ,elev);
+            maxZ = std::max(maxZ,elev);
+        }
+}
+
+void ElevationGridChunk::setupRanges()
+{
+    if (sizeX < 2 || sizeY < 2 || elevs.size() < (size_t)sizeX*sizeY)
+    {
+        wkLogLevel(Warn,"ElevationGridChunk: Expecting %d by %d samples, got %d",sizeX,sizeY,(int)elevs.size());
+        sizeX = sizeY = 0;
+        elevs.clear();
+        return;
+    }
+
+    // Finest level has at least one grid cell per range cell.  No need to go very deep.
+    int numLevels = 1;
+    while (numLevels < 7 && (1<<numLevels) <= std::min(sizeX,sizeY)-1)
+        numLevels++;
+    ranges.resize(numLevels);
+
+    // Scan the samples for the finest level.  Cells share the samples along their edges.
+    int level = numLevels-1;
+    int num = 1<<level;
+    ranges[level].resize(num*num);
+    for (int cy=0;cy<num;cy++)
+    {
+        int sy0 = cy*(sizeY-1)/num, sy1 = ((cy+1)*(sizeY-1)+num-1)/num;
+        for (int cx=0;cx<num;cx++)
+        {
+            int sx0 = cx*(sizeX-1)/num, sx1 = ((cx+1)*(sizeX-1)+num-1)/num;
+            auto &range = ranges[level][cy*num+cx];
+            scanRange(sx0,sy0,sx1,sy1,range.first,range.second);
+        }
+    }
+
+    // Then merge children for the rest
+    for (level=numLevels-2;level>=0;level--)
+    {
+        num = 1<<level;
+        ranges[level].resize(num*num);
+        const auto &children = ranges[level+1];
+        for (int cy=0;cy<num;cy++)
+            for (int cx=0;cx<num;cx++)
+            {
+                auto &range = ranges[level][cy*num+cx];
+                range = children[(2*cy)*2*num+2*cx];
+                for (int child : {(2*cy)*2*num+2*cx+1, (2*cy+1)*2*num+2*cx, (2*cy+1)*2*num+2*cx+1})
+                {
+                    range.first = std::min(range.first,children[child].first);
+                    range.second = std::max(range.second,children[child].second);
+                }
+            }
+    }
+
+    minElev = ranges[0][0].first;
+    maxElev = ranges[0][0].second;
+}
+
+double ElevationGridChunk::interpolateElevation(double x,double y) const
+{
+    if (elevs.empty())
+        return 0.0;
+
+    double fx = std::min(std::max(x,0.0),1.0) * (sizeX-1);
+    double fy = std::min(std::max(y,0.0),1.0) * (sizeY-1);
+    int ix = std::min((int)fx,sizeX-2);
+    int iy = std::min((int)fy,sizeY-2);
+    double tx = fx - ix, ty = fy - iy;
+
+    double bot = sampleAt(ix,iy) * (1.0-tx) + sampleAt(ix+1,iy) * tx;
+    double top = sampleAt(ix,iy+1) * (1.0-tx) + sampleAt(ix+1,iy+1) * tx;
+    return bot * (1.0-ty) + top * ty;
+}
+
+void ElevationGridChunk::sampleGrid(const Point2d &ll,const Point2d &ur,int tessX,int tessY,std::vector<float> &outElevs) const
+{
+    outElevs.resize((tessX+1)*(tessY+1));
+    if (elevs.empty())
+    {
+        std::fill(outElevs.begin(),outElevs.end(),0.0f);
+        return;
+    }
+
+    // Every row uses the same columns and vice versa
+    std::vector<int> colIdx(tessX+1),rowIdx(tessY+1);
+    std::vector<float> colT(tessX+1),rowT(tessY+1);
+    for (int ix=0;ix<=tessX;ix++)
+    {
+        double fx = std::min(std::max(ll.x() + (ur.x()-ll.x()) * ix / tessX,0.0),1.0) * (sizeX-1);
+        colIdx[ix] = std::min((int)fx,sizeX-2);
+        colT[ix] = fx - colIdx[ix];
+    }
+    for (int iy=0;iy<=tessY;iy++)
+    {
+        double fy = std::min(std::max(ll.y() + (ur.y()-ll.y()) * iy / tessY,0.0),1.0) * (sizeY-1);
+        rowIdx[iy] = std::min((int)fy,sizeY-2);
+        rowT[iy] = fy - rowIdx[iy];
+    }
+
+    for (int iy=0;iy<=tessY;iy++)
+    {
+        const float *bot = &elevs[(sizeY-1-rowIdx[iy])*sizeX];
+        const float *top = &elevs[(sizeY-2-rowIdx[iy])*sizeX];
+        float ty = rowT[iy];
+        for (int ix=0;ix<=tessX;ix++)
+        {
+            int sx = colIdx[ix];
+            float tx = colT[ix];
+            float botElev = bot[sx] * (1.0f-tx) + bot[sx+1] * tx;
+            float topElev = top[sx] * (1.0f-tx) + top[sx+1] * tx;
+            outElevs[iy*(tessX+1)+ix] = botElev * (1.0f-ty) + topElev * ty;
+        }
+    }
+}
+
+void ElevationGridChunk::getElevationRange(const Point2d &ll,const Point2d &ur,double &minZ,double &maxZ) const
+{
+    if (ranges.empty())
+    {
+        minZ = maxZ = 0.0;
+        return;
+    }
+
+    // Look for the smallest cell that holds the whole area.  Level 0 always does.
+    for (int level=(int)ranges.size()-1;level>=0;level--)
+    {
+        int num = 1<<level;
+        int cx0 = std::min(std::max((int)(ll.x()*num),0),num-1);
+        int cy0 = std::min(std::max((int)(ll.y()*num),0),num-1);
+        int cx1 = std::min(std::max((int)std::ceil(ur.x()*num-1e-9)-1,0),num-1);
+        int cy1 = std::min(std::max((int)std::ceil(ur.y()*num-1e-9)-1,0),num-1);
+        if (level == 0 || (cx0 == cx1 && cy0 == cy1))
+        {
+            const auto &range = ranges[level][cy0*num+cx0];
+            minZ = range.first;
+            maxZ = range.second;
+            return;
+        }
+    }
+}
+
+}
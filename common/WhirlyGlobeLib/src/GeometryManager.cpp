@@ -23,6 +23,7 @@
 #import "BaseInfo.h"
 #import "BasicDrawableInstanceBuilder.h"
 #import "SharedAttributes.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -68,9 +69,11 @@ void GeomSceneRep::clearContents(SelectionManager *selectManager,ChangeSet &chan
 
 void GeomSceneRep::enableContents(SelectionManager *selectManager,bool enable,ChangeSet &changes)
 {
+    DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+    stateReq->reserve(drawIDs.size());
     for (SimpleIDSet::iterator it = drawIDs.begin();
          it != drawIDs.end(); ++it)
-        changes.push_back(new OnOffChangeRequest(*it, enable));
+        stateReq->addOnOff(*it, enable);
     if (selectManager && !selectIDs.empty())
         selectManager->enableSelectables(selectIDs, enable);
 }
@@ -999,9 +1002,10 @@ void GeometryManager::removeGeometry(SimpleIDSet &geomIDs,ChangeSet &changes)
             TimeInterval removeTime = 0.0;
             if (sceneRep->fade > 0.0)
             {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (SimpleIDSet::iterator it = sceneRep->drawIDs.begin();
                      it != sceneRep->drawIDs.end(); ++it)
-                    changes.push_back(new FadeChangeRequest(*it, curTime, curTime+sceneRep->fade));
+                    stateReq->addFade(*it, curTime, curTime+sceneRep->fade);
                 
                 removeTime = curTime + sceneRep->fade;
             }
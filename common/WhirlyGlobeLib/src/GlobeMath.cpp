@@ -19,6 +19,7 @@
  */
 
 
+#import <mutex>
 #import "GlobeMath.h"
 #import "FlatMath.h"
 #import "proj_api.h"
@@ -18,6 +18,7 @@
  *
  */
 
+#import <cmath>
 #import "Platform.h"
 #import "WhirlyVector.h"
 #import "GlobeView.h"
@@ -76,7 +77,7 @@ void GlobeView::setRotQuat(Eigen::Quaterniond newRotQuat,bool updateWatchers)
     x = newRotQuat.coeffs().x();
     y = newRotQuat.coeffs().y();
     z = newRotQuat.coeffs().z();
-    if (isnan(w) || isnan(x) || isnan(y) || isnan(z))
+    if (std::isnan(w) || std::isnan(x) || std::isnan(y) || std::isnan(z))
         return;
     
     lastChangedTime = TimeGetCurrent();
@@ -87,7 +88,7 @@ void GlobeView::setRotQuat(Eigen::Quaterniond newRotQuat,bool updateWatchers)
 
 void GlobeView::setTilt(double newTilt)
 {
-    if (isnan(newTilt))
+    if (std::isnan(newTilt))
         return;
 
     tilt = newTilt;
@@ -95,7 +96,7 @@ void GlobeView::setTilt(double newTilt)
 
 void GlobeView::setRoll(double newRoll,bool updateWatchers)
 {
-    if (isnan(newRoll))
+    if (std::isnan(newRoll))
         return;
     
     roll = newRoll;
@@ -149,7 +150,7 @@ void GlobeView::setHeightAboveGlobe(double newH,bool updateWatchers)
 
 void GlobeView::setHeightAboveGlobeNoLimits(double newH,bool updateWatchers)
 {
-    if (isnan(newH))
+    if (std::isnan(newH))
         return;
 
     heightAboveGlobe = newH;
@@ -180,7 +181,7 @@ void GlobeView::setHeightAboveGlobeNoLimits(double newH,bool updateWatchers)
 // Also keep track of when we did it
 void GlobeView::privateSetHeightAboveGlobe(double newH,bool updateWatchers)
 {
-    if (isnan(newH))
+    if (std::isnan(newH))
         return;
 
     double minH = minHeightAboveGlobe();
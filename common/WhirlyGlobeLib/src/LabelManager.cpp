@@ -25,6 +25,7 @@
 #import "FontTextureManager.h"
 
 #import "LabelManager.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 
@@ -148,11 +149,12 @@ void LabelManager::changeLabel(PlatformThreadInfo *threadInfo,SimpleIdentity lab
     {
         LabelSceneRep *sceneRep = *it;
         
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
         for (SimpleIDSet::iterator idIt = sceneRep->drawIDs.begin();
              idIt != sceneRep->drawIDs.end(); ++idIt)
         {
             // Changed visibility
-            changes.push_back(new VisibilityChangeRequest(*idIt, labelInfo.minVis, labelInfo.maxVis));
+            stateReq->addVisibility(*idIt, labelInfo.minVis, labelInfo.maxVis);
         }
     }
 }
@@ -171,9 +173,10 @@ void LabelManager::enableLabels(SimpleIDSet labelIDs,bool enable,ChangeSet &chan
         if (it != labelReps.end())
         {
             LabelSceneRep *sceneRep = *it;
+            DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
             for (SimpleIDSet::iterator idIt = sceneRep->drawIDs.begin();
                  idIt != sceneRep->drawIDs.end(); ++idIt)
-                changes.push_back(new OnOffChangeRequest(*idIt,enable));
+                stateReq->addOnOff(*idIt,enable);
             if (!sceneRep->selectIDs.empty() && selectManager)
                 selectManager->enableSelectables(sceneRep->selectIDs, enable);
             if (!sceneRep->layoutIDs.empty() && layoutManager)
@@ -204,9 +207,10 @@ void LabelManager::removeLabels(PlatformThreadInfo *threadInfo,SimpleIDSet &labe
             // We need to fade them out, then delete
             if (labelRep->fadeOut > 0.0)
             {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (SimpleIDSet::iterator idIt = labelRep->drawIDs.begin();
                      idIt != labelRep->drawIDs.end(); ++idIt)
-                    changes.push_back(new FadeChangeRequest(*idIt,curTime,curTime+labelRep->fadeOut));
+                    stateReq->addFade(*idIt,curTime,curTime+labelRep->fadeOut);
                 
                 removeTime = curTime+labelRep->fadeOut;
             }
@@ -787,6 +787,8 @@ void LayoutManager::updateLayout(ViewStateRef viewState,ChangeSet &changes)
 
     if (hasUpdates || layoutChanges)
     {
+        const size_t firstChange = changes.size();
+
         // Get rid of the last set of drawables
         for (SimpleIDSet::iterator it = drawIDs.begin(); it != drawIDs.end(); ++it)
             changes.push_back(new RemDrawableReq(*it));
@@ -900,6 +902,9 @@ void LayoutManager::updateLayout(ViewStateRef viewState,ChangeSet &changes)
         ssBuild.flushChanges(changes, drawIDs);
         
 //        NSLog(@"  Adding new drawIDs = %lu",drawIDs.size());
+
+        // Layout only touches its own drawables, so it can jump ahead of loading
+        SetChangePriority(changes, ChangePriorityInteractive, firstChange);
     }
     
     hasUpdates = false;
@@ -21,6 +21,9 @@
 #import "LoadedTileNew.h"
 #import "BasicDrawableBuilder.h"
 #import "WhirlyKitLog.h"
+#import "DrawableStateChange.h"
+#import "Profiler.h"
+#import "FlatMath.h"
 
 using namespace Eigen;
 
@@ -37,8 +40,47 @@ TileGeomSettings::TileGeomSettings()
 {
 }
     
+TileGeomTemplate::TileGeomTemplate()
+: tessX(0), tessY(0)
+{
+}
+
+bool TileGeomTemplate::place(const Point3d &firstPt,const Point3d &lastPt,bool flat,Point3dVector &outLocs) const
+{
+    if (locs.empty())
+        return false;
+    const Point3d &oldFirst = locs.front(), &oldLast = locs.back();
+
+    // On the globe tiles in a row differ by a rotation around the axis.  In flat mode, just a translation.
+    Matrix3d rot = Matrix3d::Identity();
+    Point3d offset(0,0,0);
+    if (flat)
+        offset = firstPt - oldFirst;
+    else {
+        // Measure the angle off whichever corner isn't sitting on the axis
+        const bool useFirst = oldFirst.x()*oldFirst.x()+oldFirst.y()*oldFirst.y() > oldLast.x()*oldLast.x()+oldLast.y()*oldLast.y();
+        const Point3d &oldPt = useFirst ? oldFirst : oldLast;
+        const Point3d &newPt = useFirst ? firstPt : lastPt;
+        const double ang = atan2(newPt.y(),newPt.x()) - atan2(oldPt.y(),oldPt.x());
+        if (ang != 0.0)
+            rot = AngleAxisd(ang,Vector3d::UnitZ()).toRotationMatrix();
+    }
+
+    // Both corners have to land where they should, otherwise the rows aren't rigid in this coordinate system
+    const double tol = 1e-6 * (lastPt-firstPt).norm();
+    if ((rot*oldFirst+offset-firstPt).norm() > tol ||
+        (rot*oldLast+offset-lastPt).norm() > tol)
+        return false;
+
+    outLocs.resize(locs.size());
+    for (unsigned int ii=0;ii<locs.size();ii++)
+        outLocs[ii] = rot*locs[ii] + offset;
+
+    return true;
+}
+
 LoadedTileNew::LoadedTileNew(const QuadTreeNew::ImportantNode &ident,const MbrD &mbr)
-    : ident(ident), mbr(mbr), enabled(false)
+    : enabled(false), elevLevel(-1), ident(ident), mbr(mbr)
 {
 }
     
@@ -62,21 +104,26 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     // Scale texture coordinates if we're clipping this tile
     Point2d texScale(1.0,1.0);
     Point2d texOffset(0.0,0.0);   // Note: Not using this
+    bool clipped = false;
     
     // Snap to the designated area
     if (theMbr.ll().x() < geomManage->mbr.ll().x()) {
         theMbr.ll().x() = geomManage->mbr.ll().x();
+        clipped = true;
     }
     if (theMbr.ur().x() > geomManage->mbr.ur().x()) {
         texScale.x() = (geomManage->mbr.ur().x()-theMbr.ll().x())/(theMbr.ur().x()-theMbr.ll().x());
         theMbr.ur().x() = geomManage->mbr.ur().x();
+        clipped = true;
     }
     if (theMbr.ll().y() < geomManage->mbr.ll().y()) {
         theMbr.ll().y() = geomManage->mbr.ll().y();
+        clipped = true;
     }
     if (theMbr.ur().y() > geomManage->mbr.ur().y()) {
         texScale.y() = (geomManage->mbr.ur().y()-theMbr.ll().y())/(theMbr.ur().y()-theMbr.ll().y());
         theMbr.ur().y() = geomManage->mbr.ur().y();
+        clipped = true;
     }
     
     // Calculate a center for the tile
@@ -195,34 +242,21 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             }
     } else {
         chunk->setType(Triangles);
-        // Generate point, texture coords, and normals
-        Point3dVector locs((sphereTessX+1)*(sphereTessY+1));
-        std::vector<float> elevs;
-        if (geomSettings.includeElev)
-            elevs.resize((sphereTessX+1)*(sphereTessY+1));
-        std::vector<TexCoord> texCoords((sphereTessX+1)*(sphereTessY+1));
-        for (unsigned int iy=0;iy<sphereTessY+1;iy++)
-        {
-            for (unsigned int ix=0;ix<sphereTessX+1;ix++)
-            {
-                float locZ = 0.0;
-                Point3d loc3D = geomManage->coordAdapter->localToDisplay(CoordSystemConvert3d(geomManage->coordSys.get(),sceneCoordSys,Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),locZ)));
-                if (geomManage->coordAdapter->isFlat())
-                    loc3D.z() = locZ;
-                
-                // Use Z priority to sort the levels
-                //                    if (singleLevel != -1)
-                //                        loc3D.z() = (drawPriority + nodeInfo->ident.level * 0.01)/10000;
-                
-                locs[iy*(sphereTessX+1)+ix] = loc3D;
-                
-                // Do the texture coordinate seperately
-                TexCoord texCoord(ix*texIncr.x(),1.0-(iy*texIncr.y()));
-                texCoords[iy*(sphereTessX+1)+ix] = texCoord;
-            }
+        // Generate points and texture coords.  Tiles in the same row share these, up to a rotation.
+        Point3dVector locs;
+        TileGeomTemplateRef geomTemplate = geomManage->buildGrid(ident,sphereTessX,sphereTessY,theMbr,texScale,clipped,locs);
+        const std::vector<TexCoord> &texCoords = geomTemplate->texCoords;
+        
+        // Terrain gets applied on top of the shared grid
+        double minElev = 0.0, maxElev = 0.0;
+        bool haveElev = geomSettings.includeElev && geomManage->applyElevation(ident,sphereTessX,sphereTessY,theMbr,locs,minElev,maxElev,elevLevel);
+        // The geographic bounds don't account for the heights
+        if (haveElev) {
+            chunk->setCullByMbr(false);
+            if (separatePoleChunk)
+                poleChunk->setCullByMbr(false);
         }
         
-        // Without elevation data we can share the vertices
         for (unsigned int iy=0;iy<sphereTessY+1;iy++)
         {
             for (unsigned int ix=0;ix<sphereTessX+1;ix++)
@@ -236,7 +270,7 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
                 else
                     norm3D = loc3D;
                 
-                TexCoord &texCoord = texCoords[iy*(sphereTessX+1)+ix];
+                const TexCoord &texCoord = texCoords[iy*(sphereTessX+1)+ix];
                 
                 chunk->addPoint(Point3d(loc3D-chunkMidDisp));
                 chunk->addNormal(norm3D);
@@ -244,22 +278,16 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             }
         }
         
-        // Two triangles per cell
-        for (unsigned int iy=0;iy<sphereTessY;iy++)
+        // Two triangles per cell.  Every tile with this grid can share them, unless we're adding pole caps.
+        int maxY = 1 << ident.level;
+        bool poleTrisInChunk = geomManage->coverPoles && !geomManage->coordAdapter->isFlat() && !separatePoleChunk &&
+                                (ident.y == 0 || ident.y == maxY-1);
+        if (poleTrisInChunk)
         {
-            for (unsigned int ix=0;ix<sphereTessX;ix++)
-            {
-                BasicDrawable::Triangle triA,triB;
-                triA.verts[0] = (iy+1)*(sphereTessX+1)+ix;
-                triA.verts[1] = iy*(sphereTessX+1)+ix;
-                triA.verts[2] = (iy+1)*(sphereTessX+1)+(ix+1);
-                triB.verts[0] = triA.verts[2];
-                triB.verts[1] = triA.verts[1];
-                triB.verts[2] = iy*(sphereTessX+1)+(ix+1);
-                chunk->addTriangle(triA);
-                chunk->addTriangle(triB);
-            }
-        }
+            for (const auto &tri : geomTemplate->tris)
+                chunk->addTriangle(tri);
+        } else
+            chunk->setSharedTriangles(geomManage->getSharedTriangles(DrawableGeom,sphereTessX,sphereTessY,geomTemplate->tris));
         
         if (geomManage->buildSkirts && !geomManage->coordAdapter->isFlat())
         {
@@ -277,6 +305,8 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             skirtChunk->setType(Triangles);
             // We need the skirts rendered with the z buffer on, even if we're doing (mostly) pure sorting
             skirtChunk->setRequestZBuffer(true);
+            if (haveElev)
+                skirtChunk->setCullByMbr(false);
             skirtChunk->setProgram(geomSettings.programID);
             skirtChunk->setOnOff(false);
             drawInfo.push_back(DrawableInfo(DrawableSkirt,skirtChunk->getDrawableID(),skirtChunk->getDrawablePriority()));
@@ -284,7 +314,10 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             // We'll vary the skirt size a bit.  Otherwise the fill gets ridiculous when we're looking
             //  at the very highest levels.  On the other hand, this doesn't fix a really big large/small
             //  disparity
-            float skirtFactor = 1.0 - 0.2 / (1<<ident.level);
+            double skirtFactor = 1.0 - 0.2 / (1<<ident.level);
+            // Neighbors may have been built from different elevation, so drop below our lowest point by our relief
+            if (haveElev)
+                skirtFactor *= 1.0 + (2.0*minElev - maxElev) / EarthRadius;
             
             // Bottom skirt
             Point3dVector skirtLocs;
@@ -294,7 +327,7 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
                 skirtLocs.push_back(locs[ix]);
                 skirtTexCoords.push_back(texCoords[ix]);
             }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
+            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,haveElev,chunkMidDisp);
             // Top skirt
             skirtLocs.clear();
             skirtTexCoords.clear();
@@ -303,7 +336,7 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
                 skirtLocs.push_back(locs[(sphereTessY)*(sphereTessX+1)+ix]);
                 skirtTexCoords.push_back(texCoords[(sphereTessY)*(sphereTessX+1)+ix]);
             }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
+            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,haveElev,chunkMidDisp);
             // Left skirt
             skirtLocs.clear();
             skirtTexCoords.clear();
@@ -312,7 +345,7 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
                 skirtLocs.push_back(locs[(sphereTessX+1)*iy+0]);
                 skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+0]);
             }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
+            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,haveElev,chunkMidDisp);
             // right skirt
             skirtLocs.clear();
             skirtTexCoords.clear();
@@ -321,13 +354,15 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
                 skirtLocs.push_back(locs[(sphereTessX+1)*iy+(sphereTessX)]);
                 skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+(sphereTessX)]);
             }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
+            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,haveElev,chunkMidDisp);
+            
+            // The skirts all have the same layout for a given grid
+            skirtChunk->setSharedTriangles(geomManage->getSharedTriangles(DrawableSkirt,sphereTessX,sphereTessY,skirtChunk->tris));
         }
         
         if (geomManage->coverPoles && !geomManage->coordAdapter->isFlat())
         {
             // If we're at the top, toss in a few more triangles to represent that
-            int maxY = 1 << ident.level;
             if (ident.y == maxY-1)
             {
                 TexCoord singleTexCoord(0.5,0.0);
@@ -428,12 +463,12 @@ void LoadedTileNew::buildSkirt(BasicDrawableBuilderRef &draw,Point3dVector &pts,
         corners[1] = pts[ii+1];
         cornerTex[1] = texCoords[ii+1];
         if (haveElev)
-            corners[2] = pts[ii+1].normalized();
+            corners[2] = pts[ii+1].normalized() * skirtFactor;
             else
                 corners[2] = pts[ii+1] * skirtFactor;
                 cornerTex[2] = texCoords[ii+1];
                 if (haveElev)
-                    corners[3] = pts[ii].normalized();
+                    corners[3] = pts[ii].normalized() * skirtFactor;
                     else
                         corners[3] = pts[ii] * skirtFactor;
                         cornerTex[3] = texCoords[ii];
@@ -457,19 +492,23 @@ void LoadedTileNew::buildSkirt(BasicDrawableBuilderRef &draw,Point3dVector &pts,
     
 void LoadedTileNew::enable(TileGeomSettings &geomSettings,ChangeSet &changes)
 {
-    if (geomSettings.enableGeom && !enabled)
+    if (geomSettings.enableGeom && !enabled && !drawInfo.empty()) {
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
         for (auto di : drawInfo) {
-            changes.push_back(new OnOffChangeRequest(di.drawID,true));
+            stateReq->addOnOff(di.drawID,true);
         }
+    }
     enabled = true;
 }
 
 void LoadedTileNew::disable(TileGeomSettings &geomSettings,ChangeSet &changes)
 {
-    if (geomSettings.enableGeom && enabled)
+    if (geomSettings.enableGeom && enabled && !drawInfo.empty()) {
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
         for (auto di : drawInfo) {
-            changes.push_back(new OnOffChangeRequest(di.drawID,false));
+            stateReq->addOnOff(di.drawID,false);
         }
+    }
     enabled = false;
 }
     
@@ -484,7 +523,7 @@ TileGeomManager::TileGeomManager()
 : sceneRender(NULL), quadTree(NULL), coordAdapter(NULL), coverPoles(false),
     useNorthPoleColor(false), northPoleColor(255,255,255,255),
     useSouthPoleColor(false), southPoleColor(255,255,255,255),
-    buildSkirts(false)
+    buildSkirts(false), maxGeomTemplates(256)
 {
 }
     
@@ -496,6 +535,11 @@ void TileGeomManager::setup(SceneRenderer *inSceneRender,TileGeomSettings &geomS
     coordAdapter = inCoordAdapter;
     coordSys = inCoordSys;
     mbr = inMbr;
+
+    // Templates depend on the coordinate systems and shared triangles on the renderer
+    geomTemplates.clear();
+    geomTemplateMap.clear();
+    sharedTris.clear();
 }
     
 TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(const QuadTreeNew::ImportantNodeSet &addTiles,const QuadTreeNew::NodeSet &removeTiles,ChangeSet &changes)
@@ -510,6 +554,8 @@ TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(const QuadTreeNew::
             tileMap.erase(it);
         }
     }
+    if (!removeTiles.empty() && !orphanElevChunks.empty())
+        pruneElevationChunks();
 
     for (auto ident: addTiles) {
         // Look for an existing tile
@@ -540,6 +586,308 @@ void TileGeomManager::cleanup(ChangeSet &changes)
     }
     
     tileMap.clear();
+    elevChunks.clear();
+    orphanElevChunks.clear();
+    geomTemplates.clear();
+    geomTemplateMap.clear();
+    sharedTris.clear();
+}
+
+bool TileGeomManager::GeomTemplateKey::operator == (const GeomTemplateKey &that) const
+{
+    return level == that.level && y == that.y && tessX == that.tessX && tessY == that.tessY;
+}
+
+size_t TileGeomManager::GeomTemplateKeyHash::operator () (const GeomTemplateKey &key) const
+{
+    size_t hash = std::hash<int>()(key.level);
+    hash = hash * 31 + std::hash<int>()(key.y);
+    hash = hash * 31 + std::hash<int>()(key.tessX);
+    hash = hash * 31 + std::hash<int>()(key.tessY);
+    return hash;
+}
+
+Point3d TileGeomManager::localToDisplayGrid(const Point2d &pt)
+{
+    float locZ = 0.0;
+    Point3d loc3D = coordAdapter->localToDisplay(CoordSystemConvert3d(coordSys.get(),coordAdapter->getCoordSystem(),Point3d(pt.x(),pt.y(),locZ)));
+    if (coordAdapter->isFlat())
+        loc3D.z() = locZ;
+    
+    return loc3D;
+}
+
+TileGeomTemplateRef TileGeomManager::makeGeomTemplate(int tessX,int tessY,const MbrD &theMbr,const Point2d &texScale)
+{
+    TileGeomTemplateRef geomTemplate(new TileGeomTemplate());
+    geomTemplate->tessX = tessX;
+    geomTemplate->tessY = tessY;
+
+    Point2d chunkLL = theMbr.ll();
+    Point2d chunkSize = theMbr.ur() - theMbr.ll();
+    Point2d incr(chunkSize.x()/tessX,chunkSize.y()/tessY);
+    TexCoord texIncr(1.0/(float)tessX * texScale.x(),1.0/(float)tessY * texScale.y());
+
+    geomTemplate->locs.resize((tessX+1)*(tessY+1));
+    geomTemplate->texCoords.resize((tessX+1)*(tessY+1));
+    for (int iy=0;iy<tessY+1;iy++)
+    {
+        for (int ix=0;ix<tessX+1;ix++)
+        {
+            geomTemplate->locs[iy*(tessX+1)+ix] = localToDisplayGrid(Point2d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y()));
+            
+            // Do the texture coordinate seperately
+            geomTemplate->texCoords[iy*(tessX+1)+ix] = TexCoord(ix*texIncr.x(),1.0-(iy*texIncr.y()));
+        }
+    }
+
+    geomTemplate->tris.reserve(2*tessX*tessY);
+    for (int iy=0;iy<tessY;iy++)
+    {
+        for (int ix=0;ix<tessX;ix++)
+        {
+            BasicDrawable::Triangle triA,triB;
+            triA.verts[0] = (iy+1)*(tessX+1)+ix;
+            triA.verts[1] = iy*(tessX+1)+ix;
+            triA.verts[2] = (iy+1)*(tessX+1)+(ix+1);
+            triB.verts[0] = triA.verts[2];
+            triB.verts[1] = triA.verts[1];
+            triB.verts[2] = iy*(tessX+1)+(ix+1);
+            geomTemplate->tris.push_back(triA);
+            geomTemplate->tris.push_back(triB);
+        }
+    }
+
+    return geomTemplate;
+}
+
+TileGeomTemplateRef TileGeomManager::buildGrid(const QuadTreeNew::Node &ident,int tessX,int tessY,const MbrD &theMbr,const Point2d &texScale,bool clipped,Point3dVector &locs)
+{
+    static const ProfileID profHitID = Profiler::RegisterName("Tile Geom Template Hit");
+    static const ProfileID profMissID = Profiler::RegisterName("Tile Geom Template Miss");
+
+    // Clipped tiles are one-offs
+    if (!clipped && maxGeomTemplates > 0)
+    {
+        GeomTemplateKey key;
+        key.level = ident.level;  key.y = ident.y;
+        key.tessX = tessX;  key.tessY = tessY;
+
+        auto it = geomTemplateMap.find(key);
+        if (it != geomTemplateMap.end())
+        {
+            TileGeomTemplateRef geomTemplate = it->second->geomTemplate;
+            // Just the corners get converted, the rest we move into place
+            Point3d firstPt = localToDisplayGrid(theMbr.ll());
+            Point3d lastPt = localToDisplayGrid(theMbr.ur());
+            if (geomTemplate->place(firstPt,lastPt,coordAdapter->isFlat(),locs))
+            {
+                Profiler::RecordCount(profHitID,1);
+                // Move it to the front
+                geomTemplates.splice(geomTemplates.begin(),geomTemplates,it->second);
+                return geomTemplate;
+            }
+        } else {
+            Profiler::RecordCount(profMissID,1);
+            GeomTemplateEntry entry;
+            entry.key = key;
+            entry.geomTemplate = makeGeomTemplate(tessX,tessY,theMbr,texScale);
+            geomTemplates.push_front(entry);
+            geomTemplateMap[key] = geomTemplates.begin();
+            while (geomTemplates.size() > (size_t)maxGeomTemplates)
+            {
+                geomTemplateMap.erase(geomTemplates.back().key);
+                geomTemplates.pop_back();
+            }
+
+            locs = entry.geomTemplate->locs;
+            return entry.geomTemplate;
+        }
+    }
+
+    // Build one just for this tile
+    Profiler::RecordCount(profMissID,1);
+    TileGeomTemplateRef geomTemplate = makeGeomTemplate(tessX,tessY,theMbr,texScale);
+    locs = geomTemplate->locs;
+    
+    return geomTemplate;
+}
+
+SharedTrianglesRef TileGeomManager::getSharedTriangles(LoadedTileNew::DrawableKind kind,int tessX,int tessY,const std::vector<BasicDrawable::Triangle> &tris)
+{
+    auto key = std::make_tuple((int)kind,tessX,tessY);
+    auto it = sharedTris.find(key);
+    if (it != sharedTris.end())
+        return it->second;
+    
+    SharedTrianglesRef newTris = sceneRender->makeSharedTriangles(tris);
+    sharedTris[key] = newTris;
+    
+    return newTris;
+}
+
+// True if the node is the given ancestor or falls underneath it
+static bool IsNodeUnder(const QuadTreeNew::Node &node,const QuadTreeNew::Node &ancestor)
+{
+    if (node.level < ancestor.level)
+        return false;
+    int delta = node.level - ancestor.level;
+    return (node.x >> delta) == ancestor.x && (node.y >> delta) == ancestor.y;
+}
+
+LoadedTileVec TileGeomManager::addElevationChunk(const QuadTreeNew::Node &ident,ElevationChunkRef chunk,ChangeSet &changes)
+{
+    LoadedTileVec rebuiltTiles;
+
+    orphanElevChunks.erase(ident);
+    if (!chunk)
+    {
+        elevChunks.erase(ident);
+        return rebuiltTiles;
+    }
+    elevChunks[ident] = chunk;
+    
+    if (!settings.includeElev || !settings.buildGeom)
+        return rebuiltTiles;
+    
+    // Anything not built from finer elevation gets rebuilt.  That includes an older copy of this chunk.
+    for (auto entry : tileMap)
+    {
+        auto tile = entry.second;
+        if (tile->elevLevel > ident.level || !IsNodeUnder(entry.first,ident))
+            continue;
+        
+        bool wasEnabled = tile->enabled;
+        tile->removeDrawables(changes);
+        tile->drawInfo.clear();
+        tile->elevLevel = -1;
+        tile->makeDrawables(sceneRender,this,settings,changes);
+        tile->enabled = false;
+        if (wasEnabled)
+            tile->enable(settings,changes);
+        rebuiltTiles.push_back(tile);
+    }
+    
+    return rebuiltTiles;
+}
+
+void TileGeomManager::removeElevationChunk(const QuadTreeNew::Node &ident)
+{
+    if (elevChunks.find(ident) == elevChunks.end())
+        return;
+    
+    orphanElevChunks.insert(ident);
+    pruneElevationChunks();
+}
+
+void TileGeomManager::pruneElevationChunks()
+{
+    for (auto it = orphanElevChunks.begin(); it != orphanElevChunks.end();)
+    {
+        bool inUse = false;
+        for (auto entry : tileMap)
+            if (entry.first.level > it->level && IsNodeUnder(entry.first,*it))
+            {
+                inUse = true;
+                break;
+            }
+        if (inUse)
+            ++it;
+        else {
+            elevChunks.erase(*it);
+            it = orphanElevChunks.erase(it);
+        }
+    }
+}
+
+ElevationChunkRef TileGeomManager::findElevationChunk(const QuadTreeNew::Node &ident,Point2d &ll,Point2d &ur,int *chunkLevel)
+{
+    if (elevChunks.empty())
+        return ElevationChunkRef();
+    
+    // Walk up until we find some elevation, keeping track of where we are within it
+    QuadTreeNew::Node node = ident;
+    for (int delta=0;node.level>=0;delta++)
+    {
+        auto it = elevChunks.find(node);
+        if (it != elevChunks.end())
+        {
+            double scale = 1.0 / (double)(1<<delta);
+            ll = Point2d((ident.x - (node.x<<delta)) * scale,(ident.y - (node.y<<delta)) * scale);
+            ur = ll + Point2d(scale,scale);
+            if (chunkLevel)
+                *chunkLevel = node.level;
+            return it->second;
+        }
+        node.x /= 2;  node.y /= 2;  node.level--;
+    }
+    
+    return ElevationChunkRef();
+}
+
+bool TileGeomManager::getElevationRange(const QuadTreeNew::Node &ident,double &minZ,double &maxZ)
+{
+    Point2d ll,ur;
+    ElevationChunkRef elevChunk = findElevationChunk(ident,ll,ur);
+    if (!elevChunk)
+        return false;
+    
+    elevChunk->getElevationRange(ll,ur,minZ,maxZ);
+    return true;
+}
+
+bool TileGeomManager::applyElevation(const QuadTreeNew::Node &ident,int tessX,int tessY,const MbrD &theMbr,Point3dVector &locs,double &minZ,double &maxZ,int &elevLevel)
+{
+    Point2d chunkLL,chunkUR;
+    ElevationChunkRef elevChunk = findElevationChunk(ident,chunkLL,chunkUR,&elevLevel);
+    if (!elevChunk)
+        return false;
+    
+    static const ProfileID profID = Profiler::RegisterName("Tile Elevation");
+    ProfileScope profScope(profID);
+    
+    // The grid may have been clipped, so work out which part of the chunk it covers
+    MbrD tileMbr = quadTree->generateMbrForNode(ident);
+    Point2d tileSize = tileMbr.ur() - tileMbr.ll();
+    Point2d chunkSize = chunkUR - chunkLL;
+    Point2d ll(chunkLL.x() + chunkSize.x() * (theMbr.ll().x() - tileMbr.ll().x()) / tileSize.x(),
+               chunkLL.y() + chunkSize.y() * (theMbr.ll().y() - tileMbr.ll().y()) / tileSize.y());
+    Point2d ur(chunkLL.x() + chunkSize.x() * (theMbr.ur().x() - tileMbr.ll().x()) / tileSize.x(),
+               chunkLL.y() + chunkSize.y() * (theMbr.ur().y() - tileMbr.ll().y()) / tileSize.y());
+    
+    std::vector<float> elevs;
+    elevChunk->sampleGrid(ll,ur,tessX,tessY,elevs);
+    
+    // Heights are in meters and display space is scaled to the earth's radius
+    bool flat = coordAdapter->isFlat();
+    minZ = maxZ = elevs[0];
+    for (unsigned int ii=0;ii<locs.size();ii++)
+    {
+        double elev = elevs[ii];
+        minZ = std::min(minZ,elev);
+        maxZ = std::max(maxZ,elev);
+        if (flat)
+            locs[ii].z() += elev / EarthRadius;
+        else
+            locs[ii] *= 1.0 + elev / EarthRadius;
+    }
+    
+    return true;
+}
+
+void TileGeomManager::setMaxGeomTemplates(int maxTemplates)
+{
+    maxGeomTemplates = std::max(maxTemplates,0);
+    while (geomTemplates.size() > (size_t)maxGeomTemplates)
+    {
+        geomTemplateMap.erase(geomTemplates.back().key);
+        geomTemplates.pop_back();
+    }
+}
+
+int TileGeomManager::getMaxGeomTemplates()
+{
+    return maxGeomTemplates;
 }
     
 std::vector<LoadedTileNewRef> TileGeomManager::getTiles(const QuadTreeNew::NodeSet &tiles)
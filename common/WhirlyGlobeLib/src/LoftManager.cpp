@@ -24,6 +24,7 @@
 #import "Tesselator.h"
 #import "BaseInfo.h"
 #import "SharedAttributes.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -109,6 +110,8 @@ public:
             
             drawable = sceneRender->makeBasicDrawableBuilder("Lofted Poly");
             drawable->setType(primType);
+            // Lofted polys stick up off the surface
+            drawable->setCullByMbr(false);
             // Adjust according to the vector info
             //            drawable->setOnOff(polyInfo.enable);
             //            drawable->setDrawOffset(vecInfo->drawOffset);
@@ -551,9 +554,10 @@ void LoftManager::enableLoftedPolys(const SimpleIDSet &polyIDs,bool enable,Chang
         if (it != loftReps.end())
         {
             LoftedPolySceneRep *sceneRep = *it;
+            DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
             for (SimpleIDSet::iterator dIt = sceneRep->drawIDs.begin();
                  dIt != sceneRep->drawIDs.end(); ++dIt)
-                changes.push_back(new OnOffChangeRequest(*dIt,enable));
+                stateReq->addOnOff(*dIt,enable);
         }
     }
 }
@@ -576,9 +580,10 @@ void LoftManager::removeLoftedPolys(const SimpleIDSet &polyIDs,ChangeSet &change
             {
                 TimeInterval curTime = scene->getCurrentTime();
                                 
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (SimpleIDSet::iterator idIt = sceneRep->drawIDs.begin();
                      idIt != sceneRep->drawIDs.end(); ++idIt)
-                    changes.push_back(new FadeChangeRequest(*idIt,curTime,curTime+sceneRep->fade));
+                    stateReq->addFade(*idIt,curTime,curTime+sceneRep->fade);
 
                 removeTime = curTime + sceneRep->fade;
             }
@@ -21,11 +21,13 @@
 #import "MapboxVectorFilter.h"
 #import "MapboxVectorStyleSetC.h"
 #import "WhirlyKitLog.h"
+#import <algorithm>
 
 namespace WhirlyKit
 {
 
 MapboxVectorFilter::MapboxVectorFilter()
+: attrNameID(0), attrValIsString(false), attrValStrID(0), attrValDouble(0.0)
 {
 }
 
@@ -69,6 +71,12 @@ bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArra
         attrVal = filterArray[2];
         if (!attrVal)
             return false;
+        attrValIsString = attrVal->getType() == DictTypeString;
+        if (attrValIsString) {
+            attrValStr = attrVal->getString();
+            attrValStrID = StringIndexer::getStringID(attrValStr);
+        }
+        attrValDouble = attrVal->getDouble();
     } else if (filterType <= MBFilterNotIn) {
         // Filters with inclusion
         std::vector<DictionaryEntryRef> inclVals;
@@ -85,6 +93,11 @@ bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArra
             if (!val)
                 return false;
             inclVals.push_back(val);
+            // Only strings can match a string value
+            if (val->getType() == DictTypeString) {
+                attrValStrs.push_back(val->getString());
+                attrValStrIDs.push_back(StringIndexer::getStringID(attrValStrs.back()));
+            }
         }
         attrVals = inclVals;
     } else if (filterType <= MBFilterNotHas)
@@ -108,17 +121,61 @@ bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArra
         }
     }
     
+    if (!attrName.empty())
+        attrNameID = StringIndexer::getStringID(attrName);
+    
     return true;
 }
 
+// Numeric comparison for the equality related operators
+static bool CompareNumbers(MapboxVectorFilterType filterType,double val1,double val2)
+{
+    switch (filterType)
+    {
+        case MBFilterEqual:
+            return val1 == val2;
+        case MBFilterNotEqual:
+            return val1 != val2;
+        case MBFilterGreaterThan:
+            return val1 > val2;
+        case MBFilterGreaterThanEqual:
+            return val1 >= val2;
+        case MBFilterLessThan:
+            return val1 < val2;
+        case MBFilterLessThanEqual:
+            return val1 <= val2;
+        default:
+            return true;
+    }
+}
+
 bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifier &tileID)
+{
+    return testFeature(attrs, dynamic_cast<const MVTFeatureAttributes *>(attrs.get()), tileID);
+}
+
+bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const MVTFeatureAttributes *featAttrs,const QuadTreeIdentifier &tileID)
+{
+    // Vector tile attributes can answer most questions with IDs rather than strings
+    const MVTAttributeTable::Value *featVal = NULL;
+    bool haveFeatVal = featAttrs && usesAttrValue() && featAttrs->findValue(attrNameID, featVal);
+
+    return testFeature(attrs, featAttrs, haveFeatVal, featVal, tileID);
+}
+
+bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const MVTFeatureAttributes *featAttrs,
+                                     bool haveFeatVal,const MVTAttributeTable::Value *featVal,
+                                     const QuadTreeIdentifier &tileID)
 {
     bool ret = true;
 
     // Compare geometry type
     if (geomType != MBGeomNone)
     {
-        int attrGeomType = attrs->getInt("geometry_type") - 1;
+        int attrGeomType;
+        if (!featAttrs || !featAttrs->findGeometryType(attrGeomType))
+            attrGeomType = attrs->getInt("geometry_type");
+        attrGeomType -= 1;
         switch (filterType)
         {
             case MBFilterEqual:
@@ -137,7 +194,7 @@ bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifie
         {
             for (auto filter : subFilters)
             {
-                ret &= filter->testFeature(attrs, tileID);
+                ret &= filter->testFeature(attrs, featAttrs, tileID);
                 if (!ret)
                     break;
             }
@@ -146,7 +203,7 @@ bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifie
             ret = false;
             for (auto filter : subFilters)
             {
-                ret |= filter->testFeature(attrs, tileID);
+                ret |= filter->testFeature(attrs, featAttrs, tileID);
                 if (ret)
                     break;
             }
@@ -157,10 +214,21 @@ bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifie
         // Check for attribute value membership
         bool isIn = false;
 
-        // Note: Not dealing with differing types well
-        DictionaryEntryRef featAttrVal = attrs->getEntry(attrName);
-        if (featAttrVal)
+        if (haveFeatVal && (!featVal || featVal->type == DictTypeString))
         {
+            if (featVal)
+            {
+                const MVTAttributeTable *table = featAttrs->getTable();
+                for (unsigned int ii=0;ii<attrValStrIDs.size();ii++)
+                    if (table->stringEquals(*featVal, attrValStrIDs[ii], attrValStrs[ii]))
+                    {
+                        isIn = true;
+                        break;
+                    }
+            }
+        } else if (DictionaryEntryRef featAttrVal = attrs->getEntry(attrName))
+        {
+            // Note: Not dealing with differing types well
             for (auto match : attrVals)
             {
                 if (match->isEqual(featAttrVal))
@@ -177,11 +245,28 @@ bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifie
         // Check for attribute existence
         bool canHas = false;
 
-        DictionaryEntryRef featAttrVal = attrs->getEntry(attrName);
-        if (featAttrVal)
+        if (haveFeatVal)
+            canHas = featVal != NULL;
+        else if (attrs->hasField(attrName))
             canHas = true;
 
         ret = (filterType == MBFilterHas ? canHas : !canHas);
+    } else if (haveFeatVal)
+    {
+        // Equality related operators, using the vector tile attributes directly
+        if (!featVal)
+        {
+            // No attribute means no pass, but a missing value and != is valid
+            ret = filterType == MBFilterNotEqual;
+        } else if (featVal->type == DictTypeString)
+        {
+            bool isEqual = attrValIsString && featAttrs->getTable()->stringEquals(*featVal, attrValStrID, attrValStr);
+            if (filterType == MBFilterEqual)
+                ret = isEqual;
+            else if (filterType == MBFilterNotEqual)
+                ret = !isEqual;
+        } else
+            ret = CompareNumbers(filterType, featVal->type == DictTypeInt ? featVal->intVal : featVal->doubleVal, attrValDouble);
     } else {
         // Equality related operators
         DictionaryEntryRef featAttrVal = attrs->getEntry(attrName);
@@ -204,31 +289,7 @@ bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifie
             } else {
                 if (featAttrVal->getType() == DictTypeDouble || featAttrVal->getType() == DictTypeInt)
                 {
-                    double val1 = featAttrVal->getDouble();
-                    double val2 = attrVal->getDouble();
-                    switch (filterType)
-                    {
-                        case MBFilterEqual:
-                            ret = val1 == val2;
-                            break;
-                        case MBFilterNotEqual:
-                            ret = val1 != val2;
-                            break;
-                        case MBFilterGreaterThan:
-                            ret = val1 > val2;
-                            break;
-                        case MBFilterGreaterThanEqual:
-                            ret = val1 >= val2;
-                            break;
-                        case MBFilterLessThan:
-                            ret = val1 < val2;
-                            break;
-                        case MBFilterLessThanEqual:
-                            ret = val1 <= val2;
-                            break;
-                        default:
-                            break;
-                    }
+                    ret = CompareNumbers(filterType, featAttrVal->getDouble(), attrVal->getDouble());
                 } else {
                     wkLogLevel(Warn,"MapboxVectorFilter: Found numeric comparison that doesn't use numbers.");
                 }
@@ -246,4 +307,164 @@ bool MapboxVectorFilter::testFeature(DictionaryRef attrs,const QuadTreeIdentifie
     return ret;
 }
 
+// Description of a filter value for sharing tests.  Only simple values count.
+static bool ValueKey(DictionaryEntryRef val,std::string &key)
+{
+    char str[64];
+    if (!val) {
+        key += "null;";
+        return true;
+    }
+    switch (val->getType())
+    {
+        case DictTypeString:
+        {
+            std::string valStr = val->getString();
+            key += "s" + std::to_string(valStr.size()) + ":" + valStr + ";";
+        }
+            break;
+        case DictTypeInt:
+            key += "i" + std::to_string(val->getInt()) + ";";
+            break;
+        case DictTypeDouble:
+            snprintf(str, sizeof(str), "d%.17g;", val->getDouble());
+            key += str;
+            break;
+        default:
+            return false;
+    }
+    
+    return true;
+}
+
+// Description of a single comparison, or false if we can't share it
+static bool FilterKey(const MapboxVectorFilter &filter,std::string &key)
+{
+    key = "t" + std::to_string(filter.filterType) + "g" + std::to_string(filter.geomType) + "a" + std::to_string(filter.attrName.size()) + ":" + filter.attrName + ";";
+    if (!ValueKey(filter.attrVal, key))
+        return false;
+    for (auto val : filter.attrVals)
+        if (!ValueKey(val, key))
+            return false;
+    
+    return true;
+}
+
+class MapboxVectorFilterSet::EvalState
+{
+public:
+    EvalState(DictionaryRef attrs,const QuadTreeIdentifier &tileID,int numNodes,int numSlots)
+    : attrs(attrs), featAttrs(dynamic_cast<const MVTFeatureAttributes *>(attrs.get())), tileID(tileID),
+      nodeResults(numNodes,0), slotResults(numSlots,0), slotVals(numSlots,NULL)
+    { }
+    
+    DictionaryRef attrs;
+    const MVTFeatureAttributes *featAttrs;
+    const QuadTreeIdentifier &tileID;
+    // 0 for not evaluated, then 1 for false and 2 for true
+    std::vector<unsigned char> nodeResults;
+    // 0 for not looked up, 1 if the attributes couldn't tell us, 2 if we have the value
+    std::vector<unsigned char> slotResults;
+    std::vector<const MVTAttributeTable::Value *> slotVals;
+};
+
+MapboxVectorFilterSet::MapboxVectorFilterSet()
+{
+}
+
+void MapboxVectorFilterSet::addFilter(MapboxVectorFilterRef filter)
+{
+    roots.push_back(filter ? addNode(filter) : -1);
+}
+
+int MapboxVectorFilterSet::addNode(MapboxVectorFilterRef filter)
+{
+    Node node;
+    node.filterType = filter->filterType;
+    node.filter = NULL;
+    node.slot = -1;
+    node.firstChild = 0;
+    node.numChildren = 0;
+
+    // Combinations are the same if they combine the same nodes
+    std::string key;
+    std::vector<int> subNodes;
+    bool canShare = true;
+    if (filter->filterType == MBFilterAll || filter->filterType == MBFilterAny) {
+        key = filter->filterType == MBFilterAll ? "all" : "any";
+        for (auto subFilter : filter->subFilters) {
+            subNodes.push_back(addNode(subFilter));
+            key += "," + std::to_string(subNodes.back());
+        }
+    } else {
+        node.filter = filter.get();
+        canShare = FilterKey(*filter, key);
+        if (filter->usesAttrValue()) {
+            auto it = std::find(slotKeyIDs.begin(), slotKeyIDs.end(), filter->attrNameID);
+            node.slot = it - slotKeyIDs.begin();
+            if (it == slotKeyIDs.end())
+                slotKeyIDs.push_back(filter->attrNameID);
+        }
+    }
+    
+    if (canShare) {
+        auto it = nodesByKey.find(key);
+        if (it != nodesByKey.end())
+            return it->second;
+    }
+    
+    filters.push_back(filter);
+    node.firstChild = children.size();
+    node.numChildren = subNodes.size();
+    children.insert(children.end(), subNodes.begin(), subNodes.end());
+    nodes.push_back(node);
+    
+    int which = nodes.size()-1;
+    if (canShare)
+        nodesByKey[key] = which;
+    
+    return which;
+}
+
+bool MapboxVectorFilterSet::evalNode(int which,EvalState &state) const
+{
+    if (state.nodeResults[which])
+        return state.nodeResults[which] == 2;
+
+    const Node &node = nodes[which];
+    bool ret = true;
+    if (node.filterType == MBFilterAll) {
+        for (unsigned int ii=0;ii<node.numChildren;ii++)
+            if (!evalNode(children[node.firstChild+ii], state)) {
+                ret = false;
+                break;
+            }
+    } else if (node.filterType == MBFilterAny) {
+        ret = false;
+        for (unsigned int ii=0;ii<node.numChildren;ii++)
+            if (evalNode(children[node.firstChild+ii], state)) {
+                ret = true;
+                break;
+            }
+    } else if (node.slot >= 0 && state.featAttrs) {
+        // Look the attribute up once for every test that uses it
+        if (!state.slotResults[node.slot])
+            state.slotResults[node.slot] = state.featAttrs->findValue(slotKeyIDs[node.slot], state.slotVals[node.slot]) ? 2 : 1;
+        ret = node.filter->testFeature(state.attrs, state.featAttrs, state.slotResults[node.slot] == 2, state.slotVals[node.slot], state.tileID);
+    } else
+        ret = node.filter->testFeature(state.attrs, state.featAttrs, state.tileID);
+    
+    state.nodeResults[which] = ret ? 2 : 1;
+    return ret;
+}
+
+void MapboxVectorFilterSet::testFeature(DictionaryRef attrs,const QuadTreeIdentifier &tileID,const std::vector<int> &which,std::vector<int> &passed) const
+{
+    passed.clear();
+    EvalState state(attrs,tileID,nodes.size(),slotKeyIDs.size());
+    for (int ii : which)
+        if (roots[ii] < 0 || evalNode(roots[ii], state))
+            passed.push_back(ii);
+}
+
 }
@@ -67,6 +67,11 @@ void MapboxVectorLayerFill::cleanup(PlatformThreadInfo *inst,ChangeSet &changes)
 {
 }
 
+bool MapboxVectorLayerFill::threadSafeBuild()
+{
+    return true;
+}
+
 void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
                                          std::vector<VectorObjectRef> &vecObjs,
                                          VectorTileDataRef tileInfo)
@@ -124,6 +124,11 @@ void MapboxVectorLayerLine::cleanup(PlatformThreadInfo *inst,ChangeSet &changes)
 {
 }
 
+bool MapboxVectorLayerLine::threadSafeBuild()
+{
+    return subdivToGlobe <= 0.0;
+}
+
 void MapboxVectorLayerLine::buildObjects(PlatformThreadInfo *inst,
                                          std::vector<VectorObjectRef> &inVecObjs,
                                          VectorTileDataRef tileInfo)
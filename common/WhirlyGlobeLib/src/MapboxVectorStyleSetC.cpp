@@ -220,6 +220,17 @@ RGBAColor MapboxTransColor::colorForZoom(double zoom)
     return theColor;
 }
 
+// Levels we work out the layers for.  Anything deeper uses the last one.
+static const int MaxStyleLevels = 32;
+
+const std::vector<int> &MapboxVectorSourceLayerStyles::layersForLevel(int level,bool useZoomLevels) const
+{
+    if (!useZoomLevels || layersByLevel.empty())
+        return allLayers;
+    
+    return layersByLevel[std::min(std::max(level,0),(int)layersByLevel.size()-1)];
+}
+
 MapboxVectorStyleSetImpl::MapboxVectorStyleSetImpl(Scene *inScene,CoordSystem *coordSys,VectorStyleSettingsImplRef settings)
 : scene(inScene), currentID(0), tileStyleSettings(settings), coordSys(coordSys)
 {
@@ -280,6 +291,23 @@ bool MapboxVectorStyleSetImpl::parse(PlatformThreadInfo *inst,DictionaryRef styl
         which++;
     }
     
+    // Compile the filters for each source layer together so features can be tested in one go.
+    // Also work out which layers could draw anything at each level, so we can skip the rest.
+    for (auto it : layersBySource) {
+        MapboxVectorSourceLayerStyles &styles = stylesBySource[it.first];
+        styles.layers = it.second;
+        styles.filterSet = MapboxVectorFilterSetRef(new MapboxVectorFilterSet());
+        styles.layersByLevel.resize(MaxStyleLevels);
+        for (unsigned int ii=0;ii<styles.layers.size();ii++) {
+            MapboxVectorStyleLayerRef layer = styles.layers[ii];
+            styles.filterSet->addFilter(layer->filter);
+            styles.allLayers.push_back(ii);
+            for (int level=0;level<MaxStyleLevels;level++)
+                if (layer->maxzoom < 0 || level < layer->maxzoom)
+                    styles.layersByLevel[level].push_back(ii);
+        }
+    }
+    
     return true;
 }
 
@@ -635,6 +663,8 @@ RGBAColorRef MapboxVectorStyleSetImpl::resolveColor(MapboxTransColorRef color,Ma
             return RGBAColorRef(new RGBAColor(vals[0]*255,vals[1]*255,vals[2]*255,thisOpacity*255));
             break;
     }
+    
+    return RGBAColorRef();
 }
 
 RGBAColor MapboxVectorStyleSetImpl::color(RGBAColor color,double opacity)
@@ -674,11 +704,17 @@ std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::stylesForFeature(Dicti
 {
     std::vector<VectorStyleImplRef> styles;
     
-    auto it = layersBySource.find(layerName);
-    if (it != layersBySource.end()) {
-        for (auto layer : it->second)
-            if (!layer->filter || layer->filter->testFeature(attrs, tileID))
-                styles.push_back(layer);
+    auto it = stylesBySource.find(layerName);
+    if (it != stylesBySource.end()) {
+        const MapboxVectorSourceLayerStyles &sourceStyles = it->second;
+        const std::vector<int> &candidates = sourceStyles.layersForLevel(tileID.level, tileStyleSettings->useZoomLevels);
+        if (!candidates.empty()) {
+            std::vector<int> passed;
+            sourceStyles.filterSet->testFeature(attrs, tileID, candidates, passed);
+            for (int which : passed)
+                if (sourceStyles.layers[which]->visible)
+                    styles.push_back(sourceStyles.layers[which]);
+        }
     }
     
     return styles;
@@ -688,8 +724,17 @@ std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::stylesForFeature(Dicti
 bool MapboxVectorStyleSetImpl::layerShouldDisplay(const std::string &layerName,
                                                   const QuadTreeNew::Node &tileID)
 {
-    auto it = layersBySource.find(layerName);
-    return it != layersBySource.end();
+    auto it = stylesBySource.find(layerName);
+    if (it == stylesBySource.end())
+        return false;
+    
+    // Only worth parsing if some visible style could draw it at this level
+    const MapboxVectorSourceLayerStyles &sourceStyles = it->second;
+    for (int which : sourceStyles.layersForLevel(tileID.level, tileStyleSettings->useZoomLevels))
+        if (sourceStyles.layers[which]->visible)
+            return true;
+    
+    return false;
 }
 
 /// Return the style associated with the given UUID.
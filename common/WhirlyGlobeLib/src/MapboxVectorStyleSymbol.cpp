@@ -19,6 +19,7 @@
  */
 
 #import "MapboxVectorStyleSymbol.h"
+#import "MapboxVectorTileAttributes.h"
 #import "Dictionary.h"
 #import "WhirlyKitLog.h"
 #import <vector>
@@ -55,6 +56,8 @@ bool MapboxVectorSymbolLayout::RegexField::parse(const std::string &fieldName,
                 std::string textVariant = regexChunk;
                 std::regex_replace(textVariant, std::regex(":"), "_");
                 textChunk.keys.push_back(textVariant);
+                for (const auto &key : textChunk.keys)
+                    textChunk.keyIDs.push_back(StringIndexer::getStringID(key));
             }
             chunks.push_back(textChunk);
             isJustText = !isJustText;
@@ -70,11 +73,27 @@ std::string MapboxVectorSymbolLayout::RegexField::build(DictionaryRef attrs)
 {
     std::string text = "";
     
-    for (auto chunk : chunks) {
+    // Vector tile attributes let us skip the string lookups
+    const MVTFeatureAttributes *featAttrs = dynamic_cast<const MVTFeatureAttributes *>(attrs.get());
+    
+    for (const auto &chunk : chunks) {
         if (!chunk.str.empty())
             text += chunk.str;
         else {
-            for (auto key : chunk.keys) {
+            for (unsigned int ii=0;ii<chunk.keys.size();ii++) {
+                const std::string &key = chunk.keys[ii];
+                const MVTAttributeTable::Value *val = NULL;
+                if (featAttrs && featAttrs->findValue(chunk.keyIDs[ii], val)) {
+                    if (!val)
+                        continue;
+                    if (val->type == DictTypeString) {
+                        if (!val->str.empty()) {
+                            text += val->str;
+                            break;
+                        }
+                        continue;
+                    }
+                }
                 if (attrs->hasField(key)) {
                     std::string keyVal = attrs->getString(key);
                     if (!keyVal.empty()) {
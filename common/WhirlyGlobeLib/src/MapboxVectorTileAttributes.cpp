@@ -0,0 +1,456 @@
+/*
+ *  MapboxVectorTileAttributes.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "MapboxVectorTileAttributes.h"
+#import <algorithm>
+
+namespace WhirlyKit
+{
+
+// Fields we fill in for every feature
+static const char *GeometryTypeName = "geometry_type";
+static const char *LayerNameName = "layer_name";
+static const char *LayerOrderName = "layer_order";
+
+static bool IsBuiltInName(const std::string &name)
+{
+    return name == GeometryTypeName || name == LayerNameName || name == LayerOrderName;
+}
+
+static bool IsBuiltInID(StringIdentity keyID)
+{
+    static const StringIdentity geomTypeID = StringIndexer::getStringID(GeometryTypeName);
+    static const StringIdentity layerNameID = StringIndexer::getStringID(LayerNameName);
+    static const StringIdentity layerOrderID = StringIndexer::getStringID(LayerOrderName);
+    
+    return keyID == geomTypeID || keyID == layerNameID || keyID == layerOrderID;
+}
+
+// Put a single value into a platform dictionary
+static void SetValue(MutableDictionary *dict,const std::string &name,const MVTAttributeTable::Value &val)
+{
+    switch (val.type)
+    {
+        case DictTypeString:
+            dict->setString(name, val.str);
+            break;
+        case DictTypeInt:
+            dict->setInt(name, val.intVal);
+            break;
+        case DictTypeDouble:
+            dict->setDouble(name, val.doubleVal);
+            break;
+        default:
+            break;
+    }
+}
+
+MVTAttributeTable::MVTAttributeTable(const MVTLayer &layer,int layerOrder)
+: layerName(layer.name.str()), layerOrder(layerOrder), shadowsBuiltIns(false), numStrings(0)
+{
+    keys.reserve(layer.keys.size());
+    for (const auto &key : layer.keys) {
+        keys.push_back(key.str());
+        shadowsBuiltIns |= IsBuiltInName(keys.back());
+    }
+    
+    values.resize(layer.values.size());
+    for (unsigned int ii=0;ii<layer.values.size();ii++) {
+        const MVTValue &inVal = layer.values[ii];
+        Value &val = values[ii];
+        switch (inVal.type)
+        {
+            case MVTValue::String:
+                val.type = DictTypeString;
+                val.str = inVal.stringVal.str();
+                break;
+            case MVTValue::Float:
+            case MVTValue::Double:
+                val.type = DictTypeDouble;
+                val.doubleVal = inVal.doubleVal;
+                break;
+            case MVTValue::Int:
+            case MVTValue::UInt:
+            case MVTValue::SInt:
+            case MVTValue::Bool:
+                val.type = DictTypeInt;
+                val.intVal = (int)inVal.intVal;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // Match the keys and strings up with anything already indexed, all in one go.
+    // Filters and such index their strings when they're set up, so anything
+    //  we don't find can't be compared against.
+    std::vector<std::string> strs(keys);
+    for (const auto &val : values)
+        if (val.type == DictTypeString)
+            strs.push_back(val.str);
+    std::vector<StringIdentity> strIDs;
+    numStrings = StringIndexer::findStringIDs(strs, strIDs);
+    
+    keyIndex.reserve(keys.size());
+    for (unsigned int ii=0;ii<keys.size();ii++) {
+        keyIndex.insert(std::make_pair(keys[ii],ii));
+        if (strIDs[ii] < numStrings)
+            keyIDIndex.insert(std::make_pair(strIDs[ii],ii));
+    }
+    unsigned int which = keys.size();
+    for (auto &val : values)
+        if (val.type == DictTypeString)
+            val.strID = strIDs[which++];
+}
+
+int MVTAttributeTable::findKey(const std::string &name) const
+{
+    auto it = keyIndex.find(name);
+    return it == keyIndex.end() ? -1 : it->second;
+}
+
+int MVTAttributeTable::findKey(StringIdentity keyID) const
+{
+    auto it = keyIDIndex.find(keyID);
+    return it == keyIDIndex.end() ? -1 : it->second;
+}
+
+MVTFeatureAttributes::MVTFeatureAttributes(MVTAttributeTableRef table,int geomType,const std::vector<uint32_t> &inTags)
+: table(table), geomType(geomType), numBadTags(0)
+{
+    tags.reserve(inTags.size()/2);
+    for (unsigned int ii=0;ii+1<inTags.size();ii+=2) {
+        uint32_t key = inTags[ii], value = inTags[ii+1];
+        if (key >= table->keys.size() || value >= table->values.size()) {
+            numBadTags++;
+            continue;
+        }
+        if (table->keys[key].empty() || table->values[value].type == DictTypeNone)
+            continue;
+        
+        // Later values for the same key win
+        bool found = false;
+        for (auto &tag : tags)
+            if (tag.first == key) {
+                tag.second = value;
+                found = true;
+                break;
+            }
+        if (!found)
+            tags.push_back(std::make_pair(key,value));
+    }
+}
+
+bool MVTFeatureAttributes::findValue(StringIdentity keyID,const MVTAttributeTable::Value *&val) const
+{
+    if (dict || IsBuiltInID(keyID))
+        return false;
+    
+    val = NULL;
+    int key = table->findKey(keyID);
+    if (key < 0)
+        return true;
+    for (const auto &tag : tags)
+        if (tag.first == (uint32_t)key) {
+            val = &table->values[tag.second];
+            break;
+        }
+    
+    return true;
+}
+
+bool MVTFeatureAttributes::findGeometryType(int &retGeomType) const
+{
+    if (dict || table->shadowsBuiltIns)
+        return false;
+    
+    retGeomType = geomType;
+    return true;
+}
+
+const MVTAttributeTable::Value *MVTFeatureAttributes::findValue(const std::string &name,Value &tmp) const
+{
+    int key = table->findKey(name);
+    if (key >= 0) {
+        for (const auto &tag : tags)
+            if (tag.first == (uint32_t)key)
+                return &table->values[tag.second];
+    }
+    
+    if (name == GeometryTypeName) {
+        tmp.type = DictTypeInt;
+        tmp.intVal = geomType;
+    } else if (name == LayerNameName) {
+        tmp.type = DictTypeString;
+        tmp.str = table->layerName;
+    } else if (name == LayerOrderName) {
+        tmp.type = DictTypeInt;
+        tmp.intVal = table->layerOrder;
+    } else
+        return NULL;
+    
+    return &tmp;
+}
+
+MutableDictionaryRef MVTFeatureAttributes::singleEntryDict(const std::string &name) const
+{
+    MutableDictionaryRef ret = MutableDictionaryMake();
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    if (val)
+        SetValue(ret.get(), name, *val);
+    
+    return ret;
+}
+
+void MVTFeatureAttributes::makeMutable()
+{
+    if (dict)
+        return;
+    
+    dict = copy();
+    tags.clear();
+}
+
+MutableDictionaryRef MVTFeatureAttributes::copy()
+{
+    if (dict)
+        return dict->copy();
+    
+    MutableDictionaryRef ret = MutableDictionaryMake();
+    ret->setInt(GeometryTypeName, geomType);
+    ret->setString(LayerNameName, table->layerName);
+    ret->setInt(LayerOrderName, table->layerOrder);
+    for (const auto &tag : tags)
+        SetValue(ret.get(), table->keys[tag.first], table->values[tag.second]);
+    
+    return ret;
+}
+
+bool MVTFeatureAttributes::hasField(const std::string &name) const
+{
+    if (dict)
+        return dict->hasField(name);
+    
+    Value tmp;
+    return findValue(name, tmp) != NULL;
+}
+
+DictionaryType MVTFeatureAttributes::getType(const std::string &name) const
+{
+    if (dict)
+        return dict->getType(name);
+    
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    return val ? val->type : DictTypeNone;
+}
+
+int MVTFeatureAttributes::getInt(const std::string &name,int defVal) const
+{
+    if (dict)
+        return dict->getInt(name, defVal);
+    
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    if (!val)
+        return defVal;
+    switch (val->type)
+    {
+        case DictTypeInt:
+            return val->intVal;
+        case DictTypeDouble:
+            return (int)val->doubleVal;
+        default:
+            return singleEntryDict(name)->getInt(name, defVal);
+    }
+}
+
+SimpleIdentity MVTFeatureAttributes::getIdentity(const std::string &name) const
+{
+    if (dict)
+        return dict->getIdentity(name);
+    
+    return singleEntryDict(name)->getIdentity(name);
+}
+
+bool MVTFeatureAttributes::getBool(const std::string &name,bool defVal) const
+{
+    if (dict)
+        return dict->getBool(name, defVal);
+    
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    if (!val)
+        return defVal;
+    switch (val->type)
+    {
+        case DictTypeInt:
+            return val->intVal != 0;
+        case DictTypeDouble:
+            return (int)val->doubleVal != 0;
+        default:
+            return singleEntryDict(name)->getBool(name, defVal);
+    }
+}
+
+RGBAColor MVTFeatureAttributes::getColor(const std::string &name,const RGBAColor &defVal) const
+{
+    if (dict)
+        return dict->getColor(name, defVal);
+    
+    return singleEntryDict(name)->getColor(name, defVal);
+}
+
+double MVTFeatureAttributes::getDouble(const std::string &name,double defVal) const
+{
+    if (dict)
+        return dict->getDouble(name, defVal);
+    
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    if (!val)
+        return defVal;
+    switch (val->type)
+    {
+        case DictTypeInt:
+            return val->intVal;
+        case DictTypeDouble:
+            return val->doubleVal;
+        default:
+            return singleEntryDict(name)->getDouble(name, defVal);
+    }
+}
+
+std::string MVTFeatureAttributes::getString(const std::string &name) const
+{
+    if (dict)
+        return dict->getString(name);
+    
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    if (!val)
+        return "";
+    if (val->type == DictTypeString)
+        return val->str;
+    
+    return singleEntryDict(name)->getString(name);
+}
+
+std::string MVTFeatureAttributes::getString(const std::string &name,const std::string &defVal) const
+{
+    if (dict)
+        return dict->getString(name, defVal);
+    
+    Value tmp;
+    const Value *val = findValue(name, tmp);
+    if (!val)
+        return defVal;
+    if (val->type == DictTypeString)
+        return val->str;
+    
+    return singleEntryDict(name)->getString(name, defVal);
+}
+
+DictionaryRef MVTFeatureAttributes::getDict(const std::string &name) const
+{
+    // We never have dictionaries in here
+    if (dict)
+        return dict->getDict(name);
+    
+    return DictionaryRef();
+}
+
+DictionaryEntryRef MVTFeatureAttributes::getEntry(const std::string &name) const
+{
+    if (dict)
+        return dict->getEntry(name);
+    
+    // Entries only compare against their own kind, so these have to come from the platform
+    return singleEntryDict(name)->getEntry(name);
+}
+
+std::vector<DictionaryEntryRef> MVTFeatureAttributes::getArray(const std::string &name) const
+{
+    // Or arrays
+    if (dict)
+        return dict->getArray(name);
+    
+    return std::vector<DictionaryEntryRef>();
+}
+
+std::vector<std::string> MVTFeatureAttributes::getKeys() const
+{
+    if (dict)
+        return dict->getKeys();
+    
+    std::vector<std::string> ret;
+    ret.reserve(tags.size()+3);
+    for (const auto &tag : tags)
+        ret.push_back(table->keys[tag.first]);
+    for (const char *name : {GeometryTypeName,LayerNameName,LayerOrderName})
+        if (!table->shadowsBuiltIns || std::find(ret.begin(),ret.end(),name) == ret.end())
+            ret.push_back(name);
+    
+    return ret;
+}
+
+void MVTFeatureAttributes::clear()
+{
+    dict = MutableDictionaryMake();
+    tags.clear();
+}
+
+void MVTFeatureAttributes::removeField(const std::string &name)
+{
+    makeMutable();
+    dict->removeField(name);
+}
+
+void MVTFeatureAttributes::setInt(const std::string &name,int val)
+{
+    makeMutable();
+    dict->setInt(name, val);
+}
+
+void MVTFeatureAttributes::setIdentifiable(const std::string &name,SimpleIdentity val)
+{
+    makeMutable();
+    dict->setIdentifiable(name, val);
+}
+
+void MVTFeatureAttributes::setDouble(const std::string &name,double val)
+{
+    makeMutable();
+    dict->setDouble(name, val);
+}
+
+void MVTFeatureAttributes::setString(const std::string &name,const std::string &val)
+{
+    makeMutable();
+    dict->setString(name, val);
+}
+
+void MVTFeatureAttributes::addEntries(const Dictionary *other)
+{
+    makeMutable();
+    dict->addEntries(other);
+}
+
+}
@@ -21,7 +21,8 @@
 #import "MapboxVectorTileParser.h"
 #import "MaplyVectorStyleC.h"
 #import "VectorObject.h"
-#import "vector_tile.pb.h"
+#import "MapboxVectorTileReader.h"
+#import "MapboxVectorTileAttributes.h"
 #import <vector>
 
 static double MAX_EXTENT = 20037508.342789244;
@@ -139,177 +140,241 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,RawData *rawDat
     
     unsigned featureCount = 0;
     
-    int unknownAttributeCount = 0;
     int badAttributeCount = 0;
     int unknownCommandTypes = 0;
     int parseErrors = 0;
     
-    //now attempt to open protobuf
-    vector_tile::Tile tile;
-    if(tile.ParseFromArray(rawData->getRawData(), (int)rawData->getLen())) {
-        // Run through layers
-        for (unsigned i=0;i<tile.layers_size();++i) {
-            vector_tile::Tile_Layer const& tileLayer = tile.layers(i);
-            scale = tileLayer.extent() / 256.0;
+    // Anything we add before hitting bad data has to come back out
+    size_t startVecObjs = tileData->vecObjs.size();
+    bool badData = false;
+    
+    // Scratch space reused for every feature
+    std::vector<uint32_t> tags;
+    std::vector<uint32_t> geom;
+    
+    // Features can share their layer's attribute tables, unless someone outside the styles
+    //  is going to see them.  They'll be expecting platform dictionaries.
+    bool sharedAttrs = styleDelegate->usesSharedAttributes() && !keepVectors;
+    
+    // Walk the encoded data directly, only decoding the layers somebody wants
+    MapboxVectorTileReader reader(rawData->getRawData(),rawData->getLen());
+    MVTLayer tileLayer;
+    for (unsigned i=0;!badData && reader.nextLayer(tileLayer);++i) {
+        scale = tileLayer.extent / 256.0;
 
-            std::string layerName = tileLayer.name();
+        std::string layerName = tileLayer.name.str();
+        
+        // if we dont have any styles for a layer, dont bother parsing the features
+        if (!styleDelegate->layerShouldDisplay(layerName, tileData->ident))
+            continue;
+        
+        if (!tileLayer.decodeTables()) {
+            badData = true;
+            break;
+        }
+        MVTAttributeTableRef attrTable(new MVTAttributeTable(tileLayer,i));
+        
+        // Work through features
+        MVTFeature f;
+        while (tileLayer.nextFeature(f)) {
+            featureCount++;
+            g_type = static_cast<MapnikGeometryType>(f.geomType);
+            
+            if (!f.decodeTags(tags)) {
+                badData = true;
+                break;
+            }
             
-            // if we dont have any styles for a layer, dont bother parsing the features
-            if (!styleDelegate->layerShouldDisplay(layerName, tileData->ident))
+            //Parse attributes
+            MVTFeatureAttributesRef featAttrs(new MVTFeatureAttributes(attrTable,(int)g_type,tags));
+            badAttributeCount += featAttrs->getNumBadTags();
+            MutableDictionaryRef attributes = featAttrs;
+            if (!sharedAttrs)
+                attributes = featAttrs->copy();
+            
+            // Ask for the styles that correspond to this feature
+            // If there are none, we can skip this
+            SimpleIDSet styleIDs;
+            // Do a quick inclusion check
+            if (!uuidName.empty()) {
+                std::string uuidVal = attributes->getString(uuidName);
+                if (uuidValues.find(uuidVal) == uuidValues.end())
+                    continue;
+            }
+            std::vector<VectorStyleImplRef> styles = styleDelegate->stylesForFeature(attributes, tileData->ident, layerName);
+            for (auto style: styles) {
+                styleIDs.insert(style->getUuid());
+            }
+            if (styleIDs.empty() && !parseAll)
                 continue;
             
-            // Work through features
-            for (unsigned j=0;j<tileLayer.features_size();++j) {
-                featureCount++;
-                vector_tile::Tile_Feature const & f = tileLayer.features(j);
-                g_type = static_cast<MapnikGeometryType>(f.type());
-                
-                //Parse attributes
-                MutableDictionaryRef attributes = MutableDictionaryMake();
-                attributes->setInt("geometry_type", (int)g_type);
-                attributes->setString("layer_name", layerName);
-                attributes->setInt("layer_order",i);
-                
-                for (int m = 0; m < f.tags_size(); m += 2) {
-                    int32_t key_name = f.tags(m);
-                    int32_t key_value = f.tags(m + 1);
-                    if (key_name < static_cast<std::size_t>(tileLayer.keys_size())
-                        && key_value < static_cast<std::size_t>(tileLayer.values_size())) {
-                        const std::string &key = tileLayer.keys(key_name);
-                        if(key.empty()) {
-                            continue;
-                        }
+            //Parse geometry
+            x = 0;
+            y = 0;
+            if (!f.decodeGeometry(geom)) {
+                badData = true;
+                break;
+            }
+            geometrySize = geom.size();
+            cmd = -1;
+            length = 0;
+            
+            VectorObjectRef vecObj = VectorObjectRef(new VectorObject());
+            
+            try {
+                if(g_type == GeomTypeLineString) {
+                    VectorLinearRef lin;
+                    for (k = 0; k < geometrySize;) {
+                        if (!length) {
+                            cmd_length = geom[k++];
+                            cmd = cmd_length & ((1 << cmd_bits) - 1);
+                            length = cmd_length >> cmd_bits;
+                            // Make room for the whole run of points up front
+                            if (lin && cmd == SEG_LINETO)
+                                lin->pts.reserve(lin->pts.size()+length+1);
+                        }//length is the number of coordinates before the CMD changes
                         
-                        vector_tile::Tile_Value const& value = tileLayer.values(key_value);
-                        if (value.has_string_value()) {
-                            attributes->setString(key, value.string_value());
-                        } else if (value.has_int_value()) {
-                            attributes->setInt(key, value.int_value());
-                        } else if (value.has_double_value()) {
-                            attributes->setDouble(key, value.double_value());
-                        } else if (value.has_float_value()) {
-                            attributes->setDouble(key, value.float_value());
-                        } else if (value.has_bool_value()) {
-                            attributes->setInt(key, (int)value.bool_value());
-                        } else if (value.has_sint_value()) {
-                            attributes->setInt(key, (int)value.sint_value());
-                        } else if (value.has_uint_value()) {
-                            attributes->setInt(key, (int)value.uint_value());
-                        } else {
-                            unknownAttributeCount++;
-                        }
-                    } else {
-                        badAttributeCount++;
-                    }
-                }
-                
-                // Ask for the styles that correspond to this feature
-                // If there are none, we can skip this
-                SimpleIDSet styleIDs;
-                // Do a quick inclusion check
-                if (!uuidName.empty()) {
-                    std::string uuidVal = attributes->getString(uuidName);
-                    if (uuidValues.find(uuidVal) == uuidValues.end())
-                        continue;
-                }
-                std::vector<VectorStyleImplRef> styles = styleDelegate->stylesForFeature(attributes, tileData->ident, tileLayer.name());
-                for (auto style: styles) {
-                    styleIDs.insert(style->getUuid());
-                }
-                if (styleIDs.empty() && !parseAll)
-                    continue;
-                
-                //Parse geometry
-                x = 0;
-                y = 0;
-                geometrySize = f.geometry_size();
-                cmd = -1;
-                length = 0;
-                
-                VectorObjectRef vecObj = VectorObjectRef(new VectorObject());
-                
-                try {
-                    if(g_type == GeomTypeLineString) {
-                        VectorLinearRef lin;
-                        for (k = 0; k < geometrySize;) {
-                            if (!length) {
-                                cmd_length = f.geometry(k++);
-                                cmd = cmd_length & ((1 << cmd_bits) - 1);
-                                length = cmd_length >> cmd_bits;
-                            }//length is the number of coordinates before the CMD changes
-                            
-                            if (length > 0) {
-                                length--;
-                                if (cmd == SEG_MOVETO || cmd == SEG_LINETO) {
-                                    dx = f.geometry(k++);
-                                    dy = f.geometry(k++);
-                                    dx = ((dx >> 1) ^ (-(dx & 1)));
-                                    dy = ((dy >> 1) ^ (-(dy & 1)));
-                                    x += (static_cast<double>(dx) / scale);
-                                    y += (static_cast<double>(dy) / scale);
-                                    //At this point x/y is a coord encoded in tile coord space, from 0 to TILE_SIZE
-                                    //Convert to epsg:3785, then to degrees, then to radians
-                                    Point2f loc((tileOriginX + x / sx),(tileOriginY - y / sy));
-                                    if (localCoords) {
-                                        point = loc;
-                                    } else {
-                                        point.x() = DegToRad((loc.x() / MAX_EXTENT) * 180.0);
-                                        point.y() = 2 * atan(exp(DegToRad((loc.y() / MAX_EXTENT) * 180.0))) - M_PI_2;
-                                    }
+                        if (length > 0) {
+                            length--;
+                            if (cmd == SEG_MOVETO || cmd == SEG_LINETO) {
+                                if (k+1 >= geometrySize) {
+                                    parseErrors++;
+                                    break;
+                                }
+                                dx = geom[k++];
+                                dy = geom[k++];
+                                dx = ((dx >> 1) ^ (-(dx & 1)));
+                                dy = ((dy >> 1) ^ (-(dy & 1)));
+                                x += (static_cast<double>(dx) / scale);
+                                y += (static_cast<double>(dy) / scale);
+                                //At this point x/y is a coord encoded in tile coord space, from 0 to TILE_SIZE
+                                //Convert to epsg:3785, then to degrees, then to radians
+                                Point2f loc((tileOriginX + x / sx),(tileOriginY - y / sy));
+                                if (localCoords) {
+                                    point = loc;
+                                } else {
+                                    point.x() = DegToRad((loc.x() / MAX_EXTENT) * 180.0);
+                                    point.y() = 2 * atan(exp(DegToRad((loc.y() / MAX_EXTENT) * 180.0))) - M_PI_2;
+                                }
 
-                                    if(cmd == SEG_MOVETO) { //move to means we are starting a new segment
-                                        if(lin && lin->pts.size() > 0) { //We've already got a line, finish it
-                                            lin->initGeoMbr();
-                                            vecObj->shapes.insert(lin);
-                                        }
-                                        lin = VectorLinear::createLinear();
-                                        lin->pts.reserve(length);
-                                        firstCoord = point;
-                                    }
-                                    
-                                    lin->pts.push_back(point);
-                                } else if (cmd == (SEG_CLOSE & ((1 << cmd_bits) - 1))) {
-                                    //NSLog(@"Close line, layer:%@", layerName);
-                                    if(lin->pts.size() > 0) { //We've already got a line, finish it
-                                        lin->pts.push_back(firstCoord);
+                                if(cmd == SEG_MOVETO) { //move to means we are starting a new segment
+                                    if(lin && lin->pts.size() > 0) { //We've already got a line, finish it
                                         lin->initGeoMbr();
                                         vecObj->shapes.insert(lin);
-                                        lin.reset();
-                                    } else {
-//                                        NSLog(@"Error: Close line with no points");
                                     }
+                                    lin = VectorLinear::createLinear();
+                                    firstCoord = point;
+                                }
+                                
+                                lin->pts.push_back(point);
+                            } else if (cmd == (SEG_CLOSE & ((1 << cmd_bits) - 1))) {
+                                //NSLog(@"Close line, layer:%@", layerName);
+                                if(lin && lin->pts.size() > 0) { //We've already got a line, finish it
+                                    lin->pts.push_back(firstCoord);
+                                    lin->initGeoMbr();
+                                    vecObj->shapes.insert(lin);
+                                    lin.reset();
                                 } else {
-//                                    NSLog(@"Unknown command type:%i", cmd);
+//                                        NSLog(@"Error: Close line with no points");
                                 }
+                            } else {
+//                                    NSLog(@"Unknown command type:%i", cmd);
                             }
                         }
-                        
-                        if(lin->pts.size() > 0) {
-                            lin->initGeoMbr();
-                            vecObj->shapes.insert(lin);
+                    }
+                    
+                    if(lin && lin->pts.size() > 0) {
+                        lin->initGeoMbr();
+                        vecObj->shapes.insert(lin);
+                    }
+                } else if(g_type == GeomTypePolygon) {
+                    VectorArealRef shape = VectorAreal::createAreal();
+                    VectorRing ring;
+                    
+                    for (k = 0; k < geometrySize;) {
+                        if (!length) {
+                            cmd_length = geom[k++];
+                            cmd = cmd_length & ((1 << cmd_bits) - 1);
+                            length = cmd_length >> cmd_bits;
+                            // Room for the run of points plus closing the loop
+                            if (cmd == SEG_LINETO)
+                                ring.reserve(ring.size()+length+1);
                         }
-                    } else if(g_type == GeomTypePolygon) {
-                        VectorArealRef shape = VectorAreal::createAreal();
-                        VectorRing ring;
                         
-                        for (k = 0; k < geometrySize;) {
-                            if (!length) {
-                                cmd_length = f.geometry(k++);
-                                cmd = cmd_length & ((1 << cmd_bits) - 1);
-                                length = cmd_length >> cmd_bits;
+                        if (length > 0) {
+                            length--;
+                            if (cmd == SEG_MOVETO || cmd == SEG_LINETO) {
+                                if (k+1 >= geometrySize) {
+                                    parseErrors++;
+                                    break;
+                                }
+                                dx = geom[k++];
+                                dy = geom[k++];
+                                dx = ((dx >> 1) ^ (-(dx & 1)));
+                                dy = ((dy >> 1) ^ (-(dy & 1)));
+                                x += (static_cast<double>(dx) / scale);
+                                y += (static_cast<double>(dy) / scale);
+                                //At this point x/y is a coord is encoded in tile coord space, from 0 to TILE_SIZE
+                                //Convert to epsg:3785, then to degrees, then to radians
+                                Point2f loc((tileOriginX + x / sx),(tileOriginY - y / sy));
+                                if (localCoords) {
+                                    point = loc;
+                                } else {
+                                    point.x() = DegToRad((loc.x() / MAX_EXTENT) * 180.0);
+                                    point.y() = 2 * atan(exp(DegToRad((loc.y() / MAX_EXTENT) * 180.0))) - M_PI_2;
+                                }
+
+                                if(cmd == SEG_MOVETO) { //move to means we are starting a new segment
+                                    firstCoord = point;
+                                    //TODO: does this ever happen when we are part way through a shape? holes?
+                                }
+                                
+                                ring.push_back(point);
+                            } else if (cmd == (SEG_CLOSE & ((1 << cmd_bits) - 1))) {
+                                if(ring.size() > 0) { //We've already got a line, finish it
+                                    ring.push_back(firstCoord); //close the loop
+                                    shape->loops.push_back(std::move(ring)); //add loop to shape
+                                    ring.clear(); //start on the next one
+                                }
+                            } else {
+                                unknownCommandTypes++;
                             }
-                            
-                            if (length > 0) {
-                                length--;
-                                if (cmd == SEG_MOVETO || cmd == SEG_LINETO) {
-                                    dx = f.geometry(k++);
-                                    dy = f.geometry(k++);
-                                    dx = ((dx >> 1) ^ (-(dx & 1)));
-                                    dy = ((dy >> 1) ^ (-(dy & 1)));
-                                    x += (static_cast<double>(dx) / scale);
-                                    y += (static_cast<double>(dy) / scale);
-                                    //At this point x/y is a coord is encoded in tile coord space, from 0 to TILE_SIZE
-                                    //Convert to epsg:3785, then to degrees, then to radians
+                        }
+                    }
+                    
+                    if(ring.size() > 0) {
+//                            NSLog(@"Finished polygon loop, and ring has points");
+                    }
+                    //TODO: Is there a posibilty of still having a ring here that hasn't been added by a close command?
+                    
+                    shape->initGeoMbr();
+                    vecObj->shapes.insert(shape);
+                } else if(g_type == GeomTypePoint) {
+                    VectorPointsRef shape = VectorPoints::createPoints();
+                    
+                    for (k = 0; k < geometrySize;) {
+                        if (!length) {
+                            cmd_length = geom[k++];
+                            cmd = cmd_length & ((1 << cmd_bits) - 1);
+                            length = cmd_length >> cmd_bits;
+                        }
+                        
+                        if (length > 0) {
+                            length--;
+                            if (cmd == SEG_MOVETO || cmd == SEG_LINETO) {
+                                if (k+1 >= geometrySize) {
+                                    parseErrors++;
+                                    break;
+                                }
+                                dx = geom[k++];
+                                dy = geom[k++];
+                                dx = ((dx >> 1) ^ (-(dx & 1)));
+                                dy = ((dy >> 1) ^ (-(dy & 1)));
+                                x += (static_cast<double>(dx) / scale);
+                                y += (static_cast<double>(dy) / scale);
+                                //At this point x/y is a coord is encoded in tile coord space, from 0 to TILE_SIZE
+                                //Covert to epsg:3785, then to degrees, then to radians
+                                if(x > 0 && x < 256 && y > 0 && y < 256) {
                                     Point2f loc((tileOriginX + x / sx),(tileOriginY - y / sy));
                                     if (localCoords) {
                                         point = loc;
@@ -317,120 +382,107 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,RawData *rawDat
                                         point.x() = DegToRad((loc.x() / MAX_EXTENT) * 180.0);
                                         point.y() = 2 * atan(exp(DegToRad((loc.y() / MAX_EXTENT) * 180.0))) - M_PI_2;
                                     }
-
-                                    if(cmd == SEG_MOVETO) { //move to means we are starting a new segment
-                                        firstCoord = point;
-                                        //TODO: does this ever happen when we are part way through a shape? holes?
-                                    }
-                                    
-                                    ring.push_back(point);
-                                } else if (cmd == (SEG_CLOSE & ((1 << cmd_bits) - 1))) {
-                                    if(ring.size() > 0) { //We've already got a line, finish it
-                                        ring.push_back(firstCoord); //close the loop
-                                        shape->loops.push_back(ring); //add loop to shape
-                                        ring.clear(); //reuse the ring
-                                    }
-                                } else {
-                                    unknownCommandTypes++;
+                                    shape->pts.push_back(point);
                                 }
+                            } else if (cmd == (SEG_CLOSE & ((1 << cmd_bits) - 1))) {
+//                                    NSLog(@"Close point feature?");
+                            } else {
+                                unknownCommandTypes++;
                             }
                         }
-                        
-                        if(ring.size() > 0) {
-//                            NSLog(@"Finished polygon loop, and ring has points");
-                        }
-                        //TODO: Is there a posibilty of still having a ring here that hasn't been added by a close command?
-                        
+                    }
+                    
+                    if(shape->pts.size() > 0) {
                         shape->initGeoMbr();
                         vecObj->shapes.insert(shape);
-                    } else if(g_type == GeomTypePoint) {
-                        VectorPointsRef shape = VectorPoints::createPoints();
-                        
-                        for (k = 0; k < geometrySize;) {
-                            if (!length) {
-                                cmd_length = f.geometry(k++);
-                                cmd = cmd_length & ((1 << cmd_bits) - 1);
-                                length = cmd_length >> cmd_bits;
-                            }
-                            
-                            if (length > 0) {
-                                length--;
-                                if (cmd == SEG_MOVETO || cmd == SEG_LINETO) {
-                                    dx = f.geometry(k++);
-                                    dy = f.geometry(k++);
-                                    dx = ((dx >> 1) ^ (-(dx & 1)));
-                                    dy = ((dy >> 1) ^ (-(dy & 1)));
-                                    x += (static_cast<double>(dx) / scale);
-                                    y += (static_cast<double>(dy) / scale);
-                                    //At this point x/y is a coord is encoded in tile coord space, from 0 to TILE_SIZE
-                                    //Covert to epsg:3785, then to degrees, then to radians
-                                    if(x > 0 && x < 256 && y > 0 && y < 256) {
-                                        Point2f loc((tileOriginX + x / sx),(tileOriginY - y / sy));
-                                        if (localCoords) {
-                                            point = loc;
-                                        } else {
-                                            point.x() = DegToRad((loc.x() / MAX_EXTENT) * 180.0);
-                                            point.y() = 2 * atan(exp(DegToRad((loc.y() / MAX_EXTENT) * 180.0))) - M_PI_2;
-                                        }
-                                        shape->pts.push_back(point);
-                                    }
-                                } else if (cmd == (SEG_CLOSE & ((1 << cmd_bits) - 1))) {
-//                                    NSLog(@"Close point feature?");
-                                } else {
-                                    unknownCommandTypes++;
-                                }
-                            }
-                        }
-                        
-                        if(shape->pts.size() > 0) {
-                            shape->initGeoMbr();
-                            vecObj->shapes.insert(shape);
-                        }
-                    } else if(g_type == GeomTypeUnknown) {
-//                        NSLog(@"Unknown geom type");
                     }
-                } catch(...) {
-                    parseErrors++;
+                } else if(g_type == GeomTypeUnknown) {
+//                        NSLog(@"Unknown geom type");
                 }
-                
-                if(vecObj->shapes.size() > 0) {
-                    if (keepVectors)
-                        tileData->vecObjs.push_back(vecObj);
+            } catch(...) {
+                parseErrors++;
+            }
+            
+            if(vecObj->shapes.size() > 0) {
+                if (keepVectors)
+                    tileData->vecObjs.push_back(vecObj);
 
-                    // Sort this vector object into the styles that will process it
-                    for (SimpleIdentity styleID : styleIDs) {
-                        std::vector<VectorObjectRef> *vecs = NULL;
-                        auto it = tileData->vecObjsByStyle.find(styleID);
-                        if (it != tileData->vecObjsByStyle.end())
-                            vecs = it->second;
-                        if (!vecs) {
-                            vecs = new std::vector<VectorObjectRef>();
-                            tileData->vecObjsByStyle[styleID] = vecs;
-                        }
-                        vecs->push_back(vecObj);
+                // Sort this vector object into the styles that will process it
+                for (SimpleIdentity styleID : styleIDs) {
+                    std::vector<VectorObjectRef> *vecs = NULL;
+                    auto it = tileData->vecObjsByStyle.find(styleID);
+                    if (it != tileData->vecObjsByStyle.end())
+                        vecs = it->second;
+                    if (!vecs) {
+                        vecs = new std::vector<VectorObjectRef>();
+                        tileData->vecObjsByStyle[styleID] = vecs;
                     }
+                    vecs->push_back(vecObj);
                 }
-                
-                
-                for (auto shape: vecObj->shapes)
-                    shape->setAttrDict(attributes);
             }
+            
+            
+            for (auto shape: vecObj->shapes)
+                shape->setAttrDict(attributes);
         }
-    } else {
+        if (tileLayer.error)
+            badData = true;
+    }
+    
+    if (badData || reader.hasError()) {
+        // Nothing from a bad tile goes out, same as if it had failed to parse up front
+        for (auto it : tileData->vecObjsByStyle)
+            delete it.second;
+        tileData->vecObjsByStyle.clear();
+        tileData->vecObjs.resize(startVecObjs);
         return false;
     }
     
-    // Run the styles over their assembled data
+    // Run the styles over their assembled data.
+    // Each one fills in its own VectorTileData, which we merge back in style order afterward,
+    //  so the results come out the same no matter which thread built them.
+    // Styles that aren't thread safe may modify the vector objects they share with other styles
+    //  (e.g. subdividing for the globe), so those run on their own, in order, between batches of the rest.
+    std::vector<long long> styleIDs;
+    std::vector<std::vector<VectorObjectRef> *> styleVecs;
+    std::vector<VectorTileDataRef> styleDatas;
+    std::vector<int> parallelStyles;
+    auto runParallelStyles = [&]() {
+        if (parallelStyles.empty())
+            return;
+        buildPool->parallelFor((int)parallelStyles.size(),[&](int ii) {
+            int which = parallelStyles[ii];
+            buildForStyle(NULL,styleIDs[which],*styleVecs[which],styleDatas[which]);
+        });
+        parallelStyles.clear();
+    };
     for (auto it : tileData->vecObjsByStyle) {
-        std::vector<VectorObjectRef> *vecs = it.second;
-
+        int which = (int)styleIDs.size();
+        styleIDs.push_back(it.first);
+        styleVecs.push_back(it.second);
         auto styleData = VectorTileDataRef(new VectorTileData(*tileData));
+        styleDatas.push_back(styleData);
+
+        if (buildPool) {
+            VectorStyleImplRef style = styleDelegate->styleForUUID(it.first);
+            if (style && style->threadSafeBuild()) {
+                parallelStyles.push_back(which);
+                continue;
+            }
+            // Everything before this one has to finish first
+            runParallelStyles();
+        }
 
         // Ask the subclass to run the style and fill in the VectorTileData
-        buildForStyle(styleInst,it.first,*vecs,styleData);
-        
+        buildForStyle(styleInst,it.first,*it.second,styleData);
+    }
+    runParallelStyles();
+
+    for (unsigned int which=0;which<styleIDs.size();which++) {
+        VectorTileDataRef styleData = styleDatas[which];
+
         // Sort the results into categories if needed
-        auto catIt = styleCategories.find(it.first);
+        auto catIt = styleCategories.find(styleIDs[which]);
         if (catIt != styleCategories.end() && !styleData->compObjs.empty()) {
             std::string category = catIt->second;
             auto compObjs = styleData->compObjs;
@@ -0,0 +1,434 @@
+/*
+ *  MapboxVectorTileReader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "MapboxVectorTileReader.h"
+#import <string.h>
+
+namespace WhirlyKit
+{
+
+// Protocol buffer wire types we expect to see
+typedef enum {WireVarint = 0,WireFixed64 = 1,WireLength = 2,WireFixed32 = 5} WireType;
+
+static inline bool ReadVarint(const uint8_t *&pos,const uint8_t *end,uint64_t &val)
+{
+    val = 0;
+    for (int shift=0;shift<64 && pos<end;shift+=7)
+    {
+        uint8_t byte = *pos++;
+        val |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    
+    return false;
+}
+
+static inline bool ReadFieldKey(const uint8_t *&pos,const uint8_t *end,uint32_t &field,uint32_t &wireType)
+{
+    uint64_t key;
+    if (!ReadVarint(pos,end,key))
+        return false;
+    field = (uint32_t)(key >> 3);
+    wireType = (uint32_t)(key & 0x7);
+    
+    return true;
+}
+
+// Read the size of a length delimited field and pass back where it ends
+static inline bool ReadLength(const uint8_t *&pos,const uint8_t *end,const uint8_t *&fieldEnd)
+{
+    uint64_t len;
+    if (!ReadVarint(pos,end,len) || len > (uint64_t)(end-pos))
+        return false;
+    fieldEnd = pos + len;
+    
+    return true;
+}
+
+static bool SkipField(const uint8_t *&pos,const uint8_t *end,uint32_t wireType)
+{
+    switch (wireType)
+    {
+        case WireVarint:
+        {
+            uint64_t val;
+            return ReadVarint(pos,end,val);
+        }
+        case WireFixed64:
+            if (end-pos < 8)
+                return false;
+            pos += 8;
+            return true;
+        case WireLength:
+        {
+            const uint8_t *fieldEnd;
+            if (!ReadLength(pos,end,fieldEnd))
+                return false;
+            pos = fieldEnd;
+            return true;
+        }
+        case WireFixed32:
+            if (end-pos < 4)
+                return false;
+            pos += 4;
+            return true;
+        default:
+            // Groups are long gone and nothing else is legal
+            return false;
+    }
+}
+
+// Repeated integers may be packed or not
+static bool ReadRepeated(const uint8_t *&pos,const uint8_t *end,uint32_t wireType,std::vector<uint32_t> &vals)
+{
+    uint64_t val;
+    if (wireType == WireVarint)
+    {
+        if (!ReadVarint(pos,end,val))
+            return false;
+        vals.push_back((uint32_t)val);
+        return true;
+    }
+    if (wireType != WireLength)
+        return false;
+
+    const uint8_t *fieldEnd;
+    if (!ReadLength(pos,end,fieldEnd))
+        return false;
+    // Every value takes at least a byte
+    vals.reserve(vals.size() + (fieldEnd-pos));
+    while (pos < fieldEnd)
+    {
+        if (!ReadVarint(pos,fieldEnd,val))
+            return false;
+        vals.push_back((uint32_t)val);
+    }
+    
+    return true;
+}
+
+static bool ReadValue(const uint8_t *pos,const uint8_t *end,MVTValue &value)
+{
+    while (pos < end)
+    {
+        uint32_t field,wireType;
+        if (!ReadFieldKey(pos,end,field,wireType))
+            return false;
+        uint64_t val;
+        switch (field)
+        {
+            case 1:
+            {
+                const uint8_t *fieldEnd;
+                if (wireType != WireLength || !ReadLength(pos,end,fieldEnd))
+                    return false;
+                value.type = MVTValue::String;
+                value.stringVal = MVTStringRef((const char *)pos,fieldEnd-pos);
+                pos = fieldEnd;
+            }
+                break;
+            case 2:
+            {
+                float fVal;
+                if (wireType != WireFixed32 || end-pos < 4)
+                    return false;
+                memcpy(&fVal,pos,4);
+                pos += 4;
+                value.type = MVTValue::Float;
+                value.doubleVal = fVal;
+            }
+                break;
+            case 3:
+                if (wireType != WireFixed64 || end-pos < 8)
+                    return false;
+                memcpy(&value.doubleVal,pos,8);
+                pos += 8;
+                value.type = MVTValue::Double;
+                break;
+            case 4:
+            case 5:
+            case 6:
+            case 7:
+                if (wireType != WireVarint || !ReadVarint(pos,end,val))
+                    return false;
+                switch (field)
+                {
+                    case 4:
+                        value.type = MVTValue::Int;
+                        value.intVal = (int64_t)val;
+                        break;
+                    case 5:
+                        value.type = MVTValue::UInt;
+                        value.intVal = (int64_t)val;
+                        break;
+                    case 6:
+                        value.type = MVTValue::SInt;
+                        value.intVal = (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+                        break;
+                    case 7:
+                        value.type = MVTValue::Bool;
+                        value.intVal = val != 0;
+                        break;
+                }
+                break;
+            default:
+                if (!SkipField(pos,end,wireType))
+                    return false;
+                break;
+        }
+    }
+    
+    return true;
+}
+
+MVTFeature::MVTFeature()
+: hasId(false), id(0), geomType(0), start(NULL), end(NULL)
+{
+}
+
+bool MVTFeature::decodeTags(std::vector<uint32_t> &tags) const
+{
+    tags.clear();
+    const uint8_t *pos = start;
+    while (pos < end)
+    {
+        uint32_t field,wireType;
+        if (!ReadFieldKey(pos,end,field,wireType))
+            return false;
+        if (field == 2)
+        {
+            if (!ReadRepeated(pos,end,wireType,tags))
+                return false;
+        } else if (!SkipField(pos,end,wireType))
+            return false;
+    }
+    
+    return true;
+}
+
+bool MVTFeature::decodeGeometry(std::vector<uint32_t> &geom) const
+{
+    geom.clear();
+    const uint8_t *pos = start;
+    while (pos < end)
+    {
+        uint32_t field,wireType;
+        if (!ReadFieldKey(pos,end,field,wireType))
+            return false;
+        if (field == 4)
+        {
+            if (!ReadRepeated(pos,end,wireType,geom))
+                return false;
+        } else if (!SkipField(pos,end,wireType))
+            return false;
+    }
+    
+    return true;
+}
+
+MVTLayer::MVTLayer()
+: extent(4096), version(1), error(false), start(NULL), end(NULL), pos(NULL)
+{
+}
+
+bool MVTLayer::decodeTables()
+{
+    keys.clear();
+    values.clear();
+    
+    const uint8_t *fieldPos = start;
+    while (fieldPos < end)
+    {
+        uint32_t field,wireType;
+        if (!ReadFieldKey(fieldPos,end,field,wireType))
+            return false;
+        if ((field == 3 || field == 4) && wireType == WireLength)
+        {
+            const uint8_t *fieldEnd;
+            if (!ReadLength(fieldPos,end,fieldEnd))
+                return false;
+            if (field == 3)
+                keys.push_back(MVTStringRef((const char *)fieldPos,fieldEnd-fieldPos));
+            else {
+                values.resize(values.size()+1);
+                if (!ReadValue(fieldPos,fieldEnd,values.back()))
+                    return false;
+            }
+            fieldPos = fieldEnd;
+        } else if (!SkipField(fieldPos,end,wireType))
+            return false;
+    }
+    
+    return true;
+}
+
+bool MVTLayer::nextFeature(MVTFeature &feature)
+{
+    while (pos < end)
+    {
+        uint32_t field,wireType;
+        if (!ReadFieldKey(pos,end,field,wireType))
+        {
+            error = true;
+            return false;
+        }
+        if (field != 2 || wireType != WireLength)
+        {
+            if (!SkipField(pos,end,wireType))
+            {
+                error = true;
+                return false;
+            }
+            continue;
+        }
+        
+        const uint8_t *featEnd;
+        if (!ReadLength(pos,end,featEnd))
+        {
+            error = true;
+            return false;
+        }
+        feature = MVTFeature();
+        feature.start = pos;
+        feature.end = featEnd;
+        pos = featEnd;
+
+        // Pick up the ID and type now, leaving the rest for later
+        const uint8_t *featPos = feature.start;
+        while (featPos < featEnd)
+        {
+            uint64_t val;
+            if (!ReadFieldKey(featPos,featEnd,field,wireType))
+            {
+                error = true;
+                return false;
+            }
+            if ((field == 1 || field == 3) && wireType == WireVarint)
+            {
+                if (!ReadVarint(featPos,featEnd,val))
+                {
+                    error = true;
+                    return false;
+                }
+                if (field == 1)
+                {
+                    feature.hasId = true;
+                    feature.id = val;
+                } else
+                    feature.geomType = (int)val;
+            } else if (!SkipField(featPos,featEnd,wireType))
+            {
+                error = true;
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    return false;
+}
+
+MapboxVectorTileReader::MapboxVectorTileReader(const void *data,size_t len)
+: pos((const uint8_t *)data), end((const uint8_t *)data + len), error(false)
+{
+}
+
+bool MapboxVectorTileReader::hasError() const
+{
+    return error;
+}
+
+bool MapboxVectorTileReader::nextLayer(MVTLayer &layer)
+{
+    while (pos < end)
+    {
+        uint32_t field,wireType;
+        if (!ReadFieldKey(pos,end,field,wireType))
+        {
+            error = true;
+            return false;
+        }
+        if (field != 3 || wireType != WireLength)
+        {
+            if (!SkipField(pos,end,wireType))
+            {
+                error = true;
+                return false;
+            }
+            continue;
+        }
+        
+        const uint8_t *layerEnd;
+        if (!ReadLength(pos,end,layerEnd))
+        {
+            error = true;
+            return false;
+        }
+        layer = MVTLayer();
+        layer.start = layer.pos = pos;
+        layer.end = layerEnd;
+        pos = layerEnd;
+        
+        // Just the bits that tell us whether anyone wants this layer.  Features and tables get skipped.
+        const uint8_t *layerPos = layer.start;
+        while (layerPos < layerEnd)
+        {
+            uint64_t val;
+            if (!ReadFieldKey(layerPos,layerEnd,field,wireType))
+            {
+                error = true;
+                return false;
+            }
+            if (field == 1 && wireType == WireLength)
+            {
+                const uint8_t *fieldEnd;
+                if (!ReadLength(layerPos,layerEnd,fieldEnd))
+                {
+                    error = true;
+                    return false;
+                }
+                layer.name = MVTStringRef((const char *)layerPos,fieldEnd-layerPos);
+                layerPos = fieldEnd;
+            } else if ((field == 5 || field == 15) && wireType == WireVarint)
+            {
+                if (!ReadVarint(layerPos,layerEnd,val))
+                {
+                    error = true;
+                    return false;
+                }
+                if (field == 5)
+                    layer.extent = (uint32_t)val;
+                else
+                    layer.version = (uint32_t)val;
+            } else if (!SkipField(layerPos,layerEnd,wireType))
+            {
+                error = true;
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    return false;
+}
+
+}
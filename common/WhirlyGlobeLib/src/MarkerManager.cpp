@@ -23,6 +23,7 @@
 #import "ScreenSpaceBuilder.h"
 #import "SharedAttributes.h"
 #import "CoordSystem.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -60,9 +61,11 @@ MarkerSceneRep::MarkerSceneRep()
     
 void MarkerSceneRep::enableContents(SelectionManager *selectManager,LayoutManager *layoutManager,bool enable,ChangeSet &changes)
 {
+    DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+    stateReq->reserve(drawIDs.size());
     for (SimpleIDSet::iterator idIt = drawIDs.begin();
          idIt != drawIDs.end(); ++idIt)
-        changes.push_back(new OnOffChangeRequest(*idIt,enable));
+        stateReq->addOnOff(*idIt,enable);
     
     if (selectManager && !selectIDs.empty())
         selectManager->enableSelectables(selectIDs, enable);
@@ -316,6 +319,8 @@ SimpleIdentity MarkerManager::addMarkers(const std::vector<Marker *> &markers,co
             else {
                 draw = renderer->makeBasicDrawableBuilder("Marker Layer");
                 draw->setType(Triangles);
+                // The MBR only covers the marker locations, not their size
+                draw->setCullByMbr(false);
                 markerInfo.setupBasicDrawable(draw);
                 draw->setColor(markerInfo.color);
                 draw->setTexId(0,*(texIDs.begin()));
@@ -441,9 +446,10 @@ void MarkerManager::removeMarkers(SimpleIDSet &markerIDs,ChangeSet &changes)
             TimeInterval removeTime = 0.0;
             if (markerRep->fadeOut > 0.0)
             {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (SimpleIDSet::iterator idIt = markerRep->drawIDs.begin();
                      idIt != markerRep->drawIDs.end(); ++idIt)
-                    changes.push_back(new FadeChangeRequest(*idIt,curTime,curTime+markerRep->fadeOut));
+                    stateReq->addFade(*idIt,curTime,curTime+markerRep->fadeOut);
                 
                 removeTime = curTime + markerRep->fadeOut;
             }
@@ -20,6 +20,7 @@
 
 #import "ParticleSystemManager.h"
 #import "ParticleSystemDrawable.h"
+#import "DrawableStateChange.h"
 
 namespace WhirlyKit
 {
@@ -69,8 +70,10 @@ void ParticleSystemSceneRep::clearContents(ChangeSet &changes)
     
 void ParticleSystemSceneRep::enableContents(bool enable,ChangeSet &changes)
 {
+    DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+    stateReq->reserve(draws.size());
     for (const ParticleSystemDrawable *it : draws)
-        changes.push_back(new OnOffChangeRequest(it->getId(),enable));
+        stateReq->addOnOff(it->getId(),enable);
 }
     
 ParticleSystemManager::ParticleSystemManager()
@@ -84,41 +84,45 @@ void PerformanceTimer::CountEntry::addCount(int count)
     numRuns++;
 }
 
-void PerformanceTimer::startTiming(const std::string &what)
+ProfileID PerformanceTimer::lookupName(const std::string &what)
 {
-    actives[what] = TimeGetCurrent();
+    auto it = nameIDs.find(what);
+    if (it != nameIDs.end())
+        return it->second;
+    
+    ProfileID nameID = Profiler::RegisterName(what);
+    nameIDs[what] = nameID;
+    
+    return nameID;
+}
+
+void PerformanceTimer::startTiming(ProfileID what)
+{
+    if ((size_t)what >= actives.size())
+        actives.resize(what+1,0);
+    actives[what] = Profiler::NowNanos();
 }
 
-void PerformanceTimer::stopTiming(const std::string &what)
+void PerformanceTimer::stopTiming(ProfileID what)
 {
-    std::map<std::string,TimeInterval>::iterator it = actives.find(what);
-    if (it == actives.end())
+    if ((size_t)what >= actives.size() || actives[what] == 0)
         return;
-    TimeInterval start = it->second;
-    actives.erase(it);
+    uint64_t start = actives[what];
+    uint64_t end = Profiler::NowNanos();
+    actives[what] = 0;
     
-    std::map<std::string,TimeEntry>::iterator eit = timeEntries.find(what);
-    if (eit != timeEntries.end())
-        eit->second.addTime(TimeGetCurrent()-start);
-    else {
-        TimeEntry newEntry;
-        newEntry.addTime(TimeGetCurrent()-start);
-        newEntry.name = what;
-        timeEntries[what] = newEntry;
-    }
+    if ((size_t)what >= timeEntries.size())
+        timeEntries.resize(what+1);
+    timeEntries[what].addTime((end - start) / 1e9);
+    Profiler::RecordTiming(what,start,end);
 }
 
-void PerformanceTimer::addCount(const std::string &what,int count)
-{
-    std::map<std::string,CountEntry>::iterator it = countEntries.find(what);
-    if (it != countEntries.end())
-        it->second.addCount(count);
-    else {
-        CountEntry newEntry;
-        newEntry.addCount(count);
-        newEntry.name = what;
-        countEntries[what] = newEntry;
-    }
+void PerformanceTimer::addCount(ProfileID what,int count)
+{
+    if ((size_t)what >= countEntries.size())
+        countEntries.resize(what+1);
+    countEntries[what].addCount(count);
+    Profiler::RecordCount(what,count);
 }
 
 void PerformanceTimer::clear()
@@ -143,28 +147,28 @@ void PerformanceTimer::log()
     std::vector<TimeEntry> sortedEntries;
     sortedEntries.reserve(timeEntries.size());
     
-    for (std::map<std::string,TimeEntry>::iterator it = timeEntries.begin();
-         it != timeEntries.end(); ++it)
-        sortedEntries.push_back(it->second);
+    for (unsigned int ii=0;ii<timeEntries.size();ii++)
+        if (timeEntries[ii].numRuns > 0)
+        {
+            sortedEntries.push_back(timeEntries[ii]);
+            sortedEntries.back().name = Profiler::GetName(ii);
+        }
     std::sort(sortedEntries.begin(),sortedEntries.end(),TimeEntryByMax);
     for (unsigned int ii=0;ii<sortedEntries.size();ii++)
     {
         TimeEntry &entry = sortedEntries[ii];
-        if (entry.numRuns > 0)
-        {
-            char line[1024];
-            sprintf(line,"%s: min, max, avg = (%.2f,%.2f,%.2f) ms",entry.name.c_str(),1000*entry.minDur,1000*entry.maxDur,1000*entry.avgDur / entry.numRuns);
-            report(line);
-        }
+        char line[1024];
+        sprintf(line,"%s: min, max, avg = (%.2f,%.2f,%.2f) ms",entry.name.c_str(),1000*entry.minDur,1000*entry.maxDur,1000*entry.avgDur / entry.numRuns);
+        report(line);
     }
-    for (std::map<std::string,CountEntry>::iterator it = countEntries.begin();
-         it != countEntries.end(); ++it)
+    for (unsigned int ii=0;ii<countEntries.size();ii++)
     {
-        CountEntry &entry = it->second;
+        CountEntry &entry = countEntries[ii];
         if (entry.numRuns > 0)
         {
             char line[1024];
-            sprintf(line,"%s: min, max, avg = (%d,%d,%2.f,  %d) count",entry.name.c_str(),entry.minCount,entry.maxCount,(float)entry.avgCount / (float)entry.numRuns,entry.avgCount);
+            sprintf(line,"%s: min, max, avg = (%d,%d,%2.f,  %d) count",Profiler::GetName(ii).c_str(),entry.minCount,entry.maxCount,(float)entry.avgCount / (float)entry.numRuns,entry.avgCount);
+            report(line);
         }
     }
 }
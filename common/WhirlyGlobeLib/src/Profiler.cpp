@@ -0,0 +1,311 @@
+/*
+ *  Profiler.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import <chrono>
+#import <deque>
+#import <memory>
+#import <mutex>
+#import <unordered_map>
+#import <stdio.h>
+#import "Profiler.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+std::atomic<bool> Profiler::enabled(false);
+std::atomic<unsigned int> Profiler::curFrame(0);
+
+// Events for a single thread.  Only the owning thread writes, anyone can read.
+class ProfileThreadBuffer
+{
+public:
+    ProfileThreadBuffer(unsigned int thread,int size)
+    : thread(thread), events(size), writePos(0), clearPos(0)
+    {
+    }
+
+    void add(const ProfileEvent &event)
+    {
+        uint64_t pos = writePos.load(std::memory_order_relaxed);
+        ProfileEvent &slot = events[pos % events.size()];
+        slot = event;
+        slot.thread = thread;
+        writePos.store(pos+1,std::memory_order_release);
+    }
+
+    // Copy out the valid events, skipping any that might have been overwritten while we read
+    void collect(std::vector<ProfileEvent> &outEvents) const
+    {
+        uint64_t size = events.size();
+        uint64_t endPos = writePos.load(std::memory_order_acquire);
+        uint64_t startPos = endPos > size ? endPos - size : 0;
+        startPos = std::min(std::max(startPos,clearPos.load(std::memory_order_acquire)),endPos);
+        size_t first = outEvents.size();
+        for (uint64_t pos = startPos; pos < endPos; pos++)
+            outEvents.push_back(events[pos % size]);
+
+        uint64_t newEndPos = writePos.load(std::memory_order_acquire);
+        if (newEndPos + 1 > startPos + size)
+        {
+            uint64_t numLost = std::min(newEndPos + 1 - size - startPos,endPos - startPos);
+            outEvents.erase(outEvents.begin() + first,outEvents.begin() + first + numLost);
+        }
+    }
+
+    // The owning thread may be writing, so just move up where the valid events start
+    void clear()
+    {
+        clearPos.store(writePos.load(std::memory_order_acquire),std::memory_order_release);
+    }
+
+    unsigned int thread;
+    std::vector<ProfileEvent> events;
+    std::atomic<uint64_t> writePos;
+    std::atomic<uint64_t> clearPos;
+};
+typedef std::shared_ptr<ProfileThreadBuffer> ProfileThreadBufferRef;
+
+// Shared state, created on first use to avoid static initialization order problems
+class ProfileRegistry
+{
+public:
+    ProfileRegistry() : bufferSize(8192), nextThread(0) { }
+
+    std::mutex lock;
+    std::unordered_map<std::string,ProfileID> nameIDs;
+    std::deque<std::string> names;
+    std::vector<ProfileThreadBufferRef> buffers;
+    // Most recent events from threads that have exited, at most bufferSize of them
+    std::deque<ProfileEvent> retiredEvents;
+    int bufferSize;
+    unsigned int nextThread;
+};
+
+static ProfileRegistry &GetRegistry()
+{
+    static ProfileRegistry registry;
+    return registry;
+}
+
+static thread_local ProfileThreadBuffer *threadBuffer = NULL;
+
+// Hands a thread's buffer back to the registry when the thread exits
+class ProfileThreadExit
+{
+public:
+    ProfileThreadExit() : buffer(NULL) { }
+
+    ~ProfileThreadExit()
+    {
+        if (!buffer)
+            return;
+
+        // Hang on to the tail end of what it recorded, but not the whole buffer
+        std::vector<ProfileEvent> events;
+        buffer->collect(events);
+
+        ProfileRegistry &registry = GetRegistry();
+        std::lock_guard<std::mutex> guardLock(registry.lock);
+        registry.retiredEvents.insert(registry.retiredEvents.end(),events.begin(),events.end());
+        while (registry.retiredEvents.size() > (size_t)registry.bufferSize)
+            registry.retiredEvents.pop_front();
+        auto it = std::find_if(registry.buffers.begin(),registry.buffers.end(),
+                               [this](const ProfileThreadBufferRef &ref) { return ref.get() == buffer; });
+        if (it != registry.buffers.end())
+            registry.buffers.erase(it);
+        threadBuffer = NULL;
+    }
+
+    ProfileThreadBuffer *buffer;
+};
+
+static ProfileThreadBuffer *GetThreadBuffer()
+{
+    if (!threadBuffer)
+    {
+        ProfileRegistry &registry = GetRegistry();
+        std::lock_guard<std::mutex> guardLock(registry.lock);
+        ProfileThreadBufferRef buffer(new ProfileThreadBuffer(registry.nextThread++,registry.bufferSize));
+        registry.buffers.push_back(buffer);
+        threadBuffer = buffer.get();
+
+        // Only threads that record pay for the exit handler
+        static thread_local ProfileThreadExit threadExit;
+        threadExit.buffer = threadBuffer;
+    }
+
+    return threadBuffer;
+}
+
+ProfileID Profiler::RegisterName(const std::string &name)
+{
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> guardLock(registry.lock);
+    auto it = registry.nameIDs.find(name);
+    if (it != registry.nameIDs.end())
+        return it->second;
+
+    ProfileID nameID = (ProfileID)registry.names.size();
+    registry.names.push_back(name);
+    registry.nameIDs[name] = nameID;
+
+    return nameID;
+}
+
+std::string Profiler::GetName(ProfileID nameID)
+{
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> guardLock(registry.lock);
+    if (nameID < 0 || (size_t)nameID >= registry.names.size())
+        return std::string();
+
+    return registry.names[nameID];
+}
+
+void Profiler::SetEnabled(bool enable)
+{
+    enabled.store(enable,std::memory_order_relaxed);
+}
+
+void Profiler::SetBufferSize(int numEvents)
+{
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> guardLock(registry.lock);
+    registry.bufferSize = std::max(numEvents,16);
+}
+
+uint64_t Profiler::NowNanos()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::RecordTiming(ProfileID nameID,uint64_t startNanos,uint64_t endNanos)
+{
+    if (!IsEnabled())
+        return;
+
+    ProfileEvent event;
+    event.nameID = nameID;
+    event.type = ProfileEvent::Timing;
+    event.frame = CurrentFrame();
+    event.startNanos = startNanos;
+    event.value = (int64_t)(endNanos - startNanos);
+    GetThreadBuffer()->add(event);
+}
+
+void Profiler::RecordCount(ProfileID nameID,int64_t count)
+{
+    if (!IsEnabled())
+        return;
+
+    ProfileEvent event;
+    event.nameID = nameID;
+    event.type = ProfileEvent::Count;
+    event.frame = CurrentFrame();
+    event.startNanos = NowNanos();
+    event.value = count;
+    GetThreadBuffer()->add(event);
+}
+
+void Profiler::CollectEvents(std::vector<ProfileEvent> &events)
+{
+    std::vector<ProfileThreadBufferRef> buffers;
+    {
+        ProfileRegistry &registry = GetRegistry();
+        std::lock_guard<std::mutex> guardLock(registry.lock);
+        buffers = registry.buffers;
+        events.insert(events.end(),registry.retiredEvents.begin(),registry.retiredEvents.end());
+    }
+
+    for (auto buffer : buffers)
+        buffer->collect(events);
+    std::stable_sort(events.begin(),events.end(),
+                     [](const ProfileEvent &a,const ProfileEvent &b) { return a.startNanos < b.startNanos; });
+}
+
+// Names are ours, but be careful anyway
+static void WriteJSONString(FILE *fp,const std::string &str)
+{
+    fputc('"',fp);
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            fputc('\\',fp);
+        if ((unsigned char)c < 0x20)
+            c = ' ';
+        fputc(c,fp);
+    }
+    fputc('"',fp);
+}
+
+bool Profiler::ExportChromeTrace(const std::string &fileName)
+{
+    std::vector<ProfileEvent> events;
+    CollectEvents(events);
+
+    FILE *fp = fopen(fileName.c_str(),"w");
+    if (!fp)
+    {
+        wkLogLevel(Warn,"Profiler: Unable to open %s for writing",fileName.c_str());
+        return false;
+    }
+
+    // Timestamps are in microseconds, relative to the first event
+    uint64_t baseNanos = events.empty() ? 0 : events.front().startNanos;
+    std::unordered_map<ProfileID,std::string> nameCache;
+
+    fprintf(fp,"{\"traceEvents\":[\n");
+    for (unsigned int ii=0;ii<events.size();ii++)
+    {
+        const ProfileEvent &event = events[ii];
+        auto it = nameCache.find(event.nameID);
+        if (it == nameCache.end())
+            it = nameCache.insert(std::make_pair(event.nameID,GetName(event.nameID))).first;
+
+        fprintf(fp,"{\"name\":");
+        WriteJSONString(fp,it->second);
+        double ts = (event.startNanos - baseNanos) / 1000.0;
+        if (event.type == ProfileEvent::Timing)
+            fprintf(fp,",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%u}}",
+                    ts,event.value / 1000.0,event.thread,event.frame);
+        else
+            fprintf(fp,",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}",
+                    ts,event.thread,(long long)event.value);
+        fprintf(fp,"%s\n",ii+1 < events.size() ? "," : "");
+    }
+    fprintf(fp,"]}\n");
+
+    bool success = !ferror(fp);
+    fclose(fp);
+
+    return success;
+}
+
+void Profiler::Clear()
+{
+    ProfileRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> guardLock(registry.lock);
+    for (auto buffer : registry.buffers)
+        buffer->clear();
+    registry.retiredEvents.clear();
+}
+
+}
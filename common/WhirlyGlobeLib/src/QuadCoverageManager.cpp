@@ -0,0 +1,99 @@
+/*
+ *  QuadCoverageManager.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "QuadCoverageManager.h"
+
+namespace WhirlyKit
+{
+
+QuadCoverageShare::QuadCoverageShare(const SamplingParams &params)
+    : params(params), numUsers(0), frameSize(0.0,0.0), keepMinLevel(false), targetLevel(-1),
+    numEvaluated(0), numShared(0)
+{
+}
+
+std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadCoverageShare::getCoverage(QuadDisplayControllerNew *control,ViewStateRef inViewState,const Point2f &inFrameSize,bool inKeepMinLevel,bool &evaluated)
+{
+    // Controllers wait for each other here rather than all doing the same work
+    std::lock_guard<std::mutex> guardLock(lock);
+    
+    if (viewState && inFrameSize == frameSize && inKeepMinLevel == keepMinLevel &&
+        viewState->isSameAs(inViewState.get())) {
+        numShared++;
+        evaluated = false;
+        return std::tuple<int,QuadTreeNew::ImportantNodeSet>(targetLevel,nodes);
+    }
+    
+    std::tie(targetLevel,nodes) = control->evalCoverage(inKeepMinLevel);
+    viewState = inViewState;
+    frameSize = inFrameSize;
+    keepMinLevel = inKeepMinLevel;
+    numEvaluated++;
+    evaluated = true;
+    
+    return std::tuple<int,QuadTreeNew::ImportantNodeSet>(targetLevel,nodes);
+}
+
+int QuadCoverageShare::getNumEvaluated()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return numEvaluated;
+}
+
+int QuadCoverageShare::getNumShared()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return numShared;
+}
+
+QuadCoverageManager::QuadCoverageManager()
+{
+}
+
+QuadCoverageManager::~QuadCoverageManager()
+{
+}
+
+QuadCoverageShareRef QuadCoverageManager::addUser(const SamplingParams &params)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    
+    for (auto share : shares)
+        if (share->params.coverageSameAs(params)) {
+            share->numUsers++;
+            return share;
+        }
+    
+    QuadCoverageShareRef share(new QuadCoverageShare(params));
+    share->numUsers = 1;
+    shares.push_back(share);
+    
+    return share;
+}
+
+void QuadCoverageManager::removeUser(QuadCoverageShareRef share)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    
+    auto it = std::find(shares.begin(),shares.end(),share);
+    if (it != shares.end() && --share->numUsers <= 0)
+        shares.erase(it);
+}
+
+}
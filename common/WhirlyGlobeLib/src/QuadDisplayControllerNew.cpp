@@ -20,6 +20,8 @@
 
 #import "QuadDisplayControllerNew.h"
 #import "WhirlyKitLog.h"
+#import "Profiler.h"
+#import "QuadCoverageManager.h"
 
 namespace WhirlyKit
 {
@@ -46,6 +48,14 @@ QuadDisplayControllerNew::QuadDisplayControllerNew(QuadDataStructure *dataStruct
     keepMinLevel = true;
     keepMinLevelHeight = 0.0;
     scene = renderer->getScene();
+    frameSize = Point2f(0.0,0.0);
+    viewGen = 0;
+    predictGen = 0;
+    predicting = false;
+    updateCount = 0;
+    prefetchLookAhead = 0.0;
+    maxPrefetchTiles = 32;
+    viewChangeTime = 0.0;
 }
     
 QuadDisplayControllerNew::~QuadDisplayControllerNew()
@@ -146,15 +156,163 @@ void QuadDisplayControllerNew::start()
     
 void QuadDisplayControllerNew::stop(PlatformThreadInfo *threadInfo,ChangeSet &changes)
 {
+    const size_t firstChange = changes.size();
     loader->quadLoaderShutdown(threadInfo,changes);
+    SetChangePriority(changes,ChangePriorityLoading,firstChange);
     dataStructure = NULL;
     loader = NULL;
     
     scene = NULL;
 }
     
+// Node keys in sorted order, for quick lookups ignoring importance
+static std::vector<uint64_t> SortedNodeKeys(const QuadTreeNew::ImportantNodeSet &nodes)
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(nodes.size());
+    for (const auto &node : nodes)
+        keys.push_back(node.key());
+    std::sort(keys.begin(),keys.end());
+    
+    return keys;
+}
+
+void QuadDisplayControllerNew::setPrefetch(TimeInterval lookAhead,int inMaxPrefetchTiles)
+{
+    prefetchLookAhead = lookAhead;
+    maxPrefetchTiles = inMaxPrefetchTiles;
+    if (prefetchLookAhead <= 0.0) {
+        prefetchNodes.clear();
+        prefetchOnlyKeys.clear();
+    }
+}
+
+TimeInterval QuadDisplayControllerNew::getPrefetchLookAhead()
+{
+    return prefetchLookAhead;
+}
+
+bool QuadDisplayControllerNew::isPrefetchOnly(const QuadTreeNew::Node &node)
+{
+    return std::binary_search(prefetchOnlyKeys.begin(),prefetchOnlyKeys.end(),node.key());
+}
+
+// Don't extrapolate too far out from what we know
+static const double MaxPrefetchSteps = 4.0;
+
+ViewStateRef QuadDisplayControllerNew::predictViewState(ViewStateRef prevState,TimeInterval dt)
+{
+    if (dt <= 0.0)
+        return ViewStateRef();
+    const double steps = std::min(prefetchLookAhead / dt, MaxPrefetchSteps);
+    
+    // Split the model matrices into rotation and translation and carry each forward
+    const Eigen::Matrix4d &mat0 = prevState->modelMatrix, &mat1 = viewState->modelMatrix;
+    const Eigen::Matrix3d rot0 = mat0.topLeftCorner<3,3>(), rot1 = mat1.topLeftCorner<3,3>();
+    const Eigen::Vector3d trans0 = mat0.topRightCorner<3,1>(), trans1 = mat1.topRightCorner<3,1>();
+    const Eigen::AngleAxisd rotDelta(rot1 * rot0.transpose());
+    Eigen::Matrix4d modelMat = Eigen::Matrix4d::Identity();
+    modelMat.topLeftCorner<3,3>() = Eigen::AngleAxisd(rotDelta.angle() * steps,rotDelta.axis()).toRotationMatrix() * rot1;
+    modelMat.topRightCorner<3,1>() = trans1 + (trans1 - trans0) * steps;
+    
+    // Importance only looks at the generic view state, so that's all we build
+    ViewStateRef newState(new ViewState(*viewState));
+    newState->modelMatrix = modelMat;
+    newState->invModelMatrix = modelMat.inverse();
+    for (unsigned int ii=0;ii<newState->viewMatrices.size();ii++) {
+        newState->fullMatrices[ii] = newState->viewMatrices[ii] * modelMat;
+        newState->invFullMatrices[ii] = newState->fullMatrices[ii].inverse();
+        newState->fullNormalMatrices[ii] = newState->invFullMatrices[ii].transpose();
+    }
+    Eigen::Vector4d eyeVec4 = newState->invFullMatrices[0] * Eigen::Vector4d(0,0,1,0);
+    newState->eyeVec = Point3d(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
+    eyeVec4 = newState->invModelMatrix * Eigen::Vector4d(0,0,1,0);
+    newState->eyeVecModel = Point3d(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
+    const Eigen::Vector4d eyePos4 = newState->invFullMatrices[0] * Eigen::Vector4d(0,0,0,1);
+    newState->eyePos = Point3d(eyePos4.x(),eyePos4.y(),eyePos4.z());
+    
+    return newState;
+}
+
+void QuadDisplayControllerNew::updatePrefetch(ViewStateRef prevState,TimeInterval dt,bool localKeepMinLevel,const QuadTreeNew::ImportantNodeSet &newNodes)
+{
+    static const ProfileID profID = Profiler::RegisterName("Tile Prefetch");
+    static const ProfileID profCountID = Profiler::RegisterName("Tile Prefetch Count");
+    ProfileScope profScope(profID);
+    
+    prefetchNodes.clear();
+    ViewStateRef predictState = predictViewState(prevState,dt);
+    if (!predictState)
+        return;
+    
+    // Evaluate the predicted view.  Its importance values are cached separately from the real view's.
+    ViewStateRef realState = viewState;
+    viewState = predictState;
+    predictGen++;
+    predicting = true;
+    QuadTreeNew::ImportantNodeSet predictNodes = std::get<1>(evalCoverage(localKeepMinLevel));
+    predicting = false;
+    viewState = realState;
+    
+    // Most important first, skipping what we're already loading
+    const std::vector<uint64_t> loadKeys = SortedNodeKeys(newNodes);
+    for (auto it = predictNodes.rbegin(); it != predictNodes.rend() && prefetchNodes.size() < (size_t)maxPrefetchTiles; ++it) {
+        if (std::binary_search(loadKeys.begin(),loadKeys.end(),it->key()))
+            continue;
+        
+        // Squash the importance so these sort behind anything actually visible
+        QuadTreeNew::ImportantNode node(*it);
+        node.importance = std::max(node.importance,0.0);
+        node.importance = node.importance / (node.importance + 1.0);
+        prefetchNodes.insert(node);
+    }
+    
+    Profiler::RecordCount(profCountID,prefetchNodes.size());
+}
+
+void QuadDisplayControllerNew::setCoverageShare(QuadCoverageShareRef share)
+{
+    coverageShare = share;
+}
+
+std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadDisplayControllerNew::evalCoverage(bool localKeepMinLevel)
+{
+    // Nodes to load are different for single level vs regular loading
+    QuadTreeNew::ImportantNodeSet newNodes;
+    int targetLevel = -1;
+    if (singleLevel) {
+        std::tie(targetLevel,newNodes) = calcCoverageVisible(minImportancePerLevel, maxTiles, levelLoads, localKeepMinLevel);
+    } else {
+        newNodes = calcCoverageImportance(minImportancePerLevel,maxTiles,true);
+        // Just take the highest level as target
+        for (auto node : newNodes)
+            targetLevel = std::max(targetLevel,node.level);
+    }
+    
+    return std::tuple<int,QuadTreeNew::ImportantNodeSet>(targetLevel,newNodes);
+}
+
+typedef std::pair<uint64_t,const QuadTreeNew::ImportantNode *> NodeByKey;
+
+// Sort the nodes by key so we can compare sets without caring about importance
+static void SortNodesByKey(const QuadTreeNew::ImportantNodeSet &nodes,std::vector<NodeByKey> &sorted)
+{
+    sorted.reserve(nodes.size());
+    for (const auto &node : nodes)
+        sorted.push_back(NodeByKey(node.key(),&node));
+    std::sort(sorted.begin(),sorted.end(),
+              [](const NodeByKey &a,const NodeByKey &b) { return a.first < b.first; });
+    // The same node can show up with different importance values
+    sorted.erase(std::unique(sorted.begin(),sorted.end(),
+                             [](const NodeByKey &a,const NodeByKey &b) { return a.first == b.first; }),
+                 sorted.end());
+}
+
 bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewStateRef inViewState,ChangeSet &changes)
 {
+    static const ProfileID profID = Profiler::RegisterName("Tile View Update");
+    ProfileScope profScope(profID);
+    
     if (!scene)
         return true;
     
@@ -162,7 +320,22 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
     if (!inViewState)
         return true;
     
+    // Cached importance values are only good if the view hasn't moved
+    const Point2f newFrameSize = renderer->getFramebufferSize();
+    const TimeInterval now = TimeGetCurrent();
+    const bool viewChanged = !viewState || newFrameSize != frameSize || !viewState->isSameAs(inViewState.get());
+    if (viewChanged)
+        viewGen++;
+    updateCount++;
+
+    // Keep the last distinct view around for extrapolating the camera
+    const ViewStateRef prevViewState = (viewChanged && newFrameSize == frameSize) ? viewState : ViewStateRef();
+    const TimeInterval prevViewTime = viewChangeTime;
+    if (viewChanged)
+        viewChangeTime = now;
+
     viewState = inViewState;
+    frameSize = newFrameSize;
     dataStructure->newViewState(viewState);
     
     // We may want to force the min level in, always
@@ -174,16 +347,34 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
             localKeepMinLevel = globeViewState->heightAboveGlobe > keepMinLevelHeight;
     }
     
-    // Nodes to load are different for single level vs regular loading
+    // Someone else may have already done the work for this view
     QuadTreeNew::ImportantNodeSet newNodes;
     int targetLevel = -1;
-    if (singleLevel) {
-        std::tie(targetLevel,newNodes) = calcCoverageVisible(minImportancePerLevel, maxTiles, levelLoads, localKeepMinLevel);
-    } else {
-        newNodes = calcCoverageImportance(minImportancePerLevel,maxTiles,true);
-        // Just take the highest level as target
-        for (auto node : newNodes)
-            targetLevel = std::max(targetLevel,node.level);
+    bool evaluated = true;
+    if (coverageShare)
+        std::tie(targetLevel,newNodes) = coverageShare->getCoverage(this, viewState, frameSize, localKeepMinLevel, evaluated);
+    else
+        std::tie(targetLevel,newNodes) = evalCoverage(localKeepMinLevel);
+    
+    // Load ahead of a moving camera, if we're set up to.
+    // Predictions are dropped once the camera has been still for a while.
+    if (prefetchLookAhead > 0.0) {
+        if (prevViewState)
+            updatePrefetch(prevViewState, now - prevViewTime, localKeepMinLevel, newNodes);
+        else if (now - viewChangeTime > prefetchLookAhead)
+            prefetchNodes.clear();
+        
+        // Anything that's actually visible gets loaded as such
+        prefetchOnlyKeys.clear();
+        if (!prefetchNodes.empty()) {
+            const std::vector<uint64_t> loadKeys = SortedNodeKeys(newNodes);
+            for (const auto &node : prefetchNodes)
+                if (!std::binary_search(loadKeys.begin(),loadKeys.end(),node.key())) {
+                    newNodes.insert(node);
+                    prefetchOnlyKeys.push_back(node.key());
+                }
+            std::sort(prefetchOnlyKeys.begin(),prefetchOnlyKeys.end());
+        }
     }
     
 //    wkLogLevel(Debug,"Selected level %d for %d nodes",targetLevel,(int)newNodes.size());
@@ -191,31 +382,44 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
 //        wkLogLevel(Debug," %d: (%d,%d), import = %f",node.level,node.x,node.y,node.importance);
 //    }
     
+    // Anything we didn't look at this time is probably out of view, so drop it
+    if (evaluated) {
+        std::vector<QuadTreeNew::Node> staleNodes;
+        for (const auto &it : nodeCache)
+            if (it.second.lastUpdate != updateCount)
+                staleNodes.push_back(it.first);
+        for (const auto &node : staleNodes)
+            nodeCache.erase(node);
+    }
+
     QuadTreeNew::ImportantNodeSet toAdd,toUpdate;
     QuadTreeNew::NodeSet toRemove;
     
-    // Need a version of new and old that has no importance values, since those change
-    QuadTreeNew::NodeSet testNewNodes;
-    for (auto node : newNodes)
-        testNewNodes.insert(node);
-    QuadTreeNew::NodeSet testCurrentNodes;
-    for (auto node : currentNodes)
-        testCurrentNodes.insert(node);
-    
-    // Nodes to remove
-    for (auto node : currentNodes)
-        if (testNewNodes.find(node) == testNewNodes.end())
-            toRemove.insert(node);
-    
-    // Nodes to add and nodes to update importance for
-    for (auto node : newNodes)
-        if (testCurrentNodes.find(node) == testCurrentNodes.end())
-            toAdd.insert(node);
-        else
-            toUpdate.insert(node);
+    // Compare new and old by node key alone, since importance values change
+    std::vector<NodeByKey> sortedNew,sortedCurrent;
+    SortNodesByKey(newNodes,sortedNew);
+    SortNodesByKey(currentNodes,sortedCurrent);
+    
+    // Walk the two lists together to find adds, removes, and importance updates
+    auto newIt = sortedNew.begin(), curIt = sortedCurrent.begin();
+    while (newIt != sortedNew.end() || curIt != sortedCurrent.end()) {
+        if (curIt == sortedCurrent.end() || (newIt != sortedNew.end() && newIt->first < curIt->first)) {
+            toAdd.insert(*newIt->second);
+            ++newIt;
+        } else if (newIt == sortedNew.end() || curIt->first < newIt->first) {
+            toRemove.insert(*curIt->second);
+            ++curIt;
+        } else {
+            toUpdate.insert(*newIt->second);
+            ++newIt;  ++curIt;
+        }
+    }
     
+    // Everything the loader does goes in at the same priority, so it stays in order
+    const size_t firstChange = changes.size();
     QuadTreeNew::NodeSet removesToKeep;
     removesToKeep = loader->quadLoaderUpdate(threadInfo, toAdd, toRemove, toUpdate, targetLevel,changes);
+    SetChangePriority(changes, ChangePriorityLoading, firstChange);
     
     bool needsDelayCheck = !removesToKeep.empty();
     
@@ -229,14 +433,31 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
     
 void QuadDisplayControllerNew::preSceneFlush(ChangeSet &changes)
 {
+    const size_t firstChange = changes.size();
     loader->quadLoaderPreSceenFlush(changes);
+    SetChangePriority(changes,ChangePriorityLoading,firstChange);
 }
     
 // MARK: QuadTreeNew methods
-    
+
+QuadDisplayControllerNew::NodeCacheEntry &QuadDisplayControllerNew::cacheEntryForNode(const Node &node)
+{
+    NodeCacheEntry &entry = nodeCache[node];
+    entry.lastUpdate = updateCount;
+
+    return entry;
+}
+
 // Calculate importance for a given node
 double QuadDisplayControllerNew::importance(const Node &node)
 {
+    NodeCacheEntry &entry = cacheEntryForNode(node);
+    double &cacheImport = predicting ? entry.predictImportance : entry.importance;
+    int &cacheGen = predicting ? entry.predictGen : entry.viewGen;
+    const int curGen = predicting ? predictGen : viewGen;
+    if (cacheGen == curGen)
+        return cacheImport;
+
     QuadTreeIdentifier ident;
     ident.level = node.level;  ident.x = node.x;  ident.y = node.y;
     Point2d ll,ur;
@@ -244,12 +465,16 @@ double QuadDisplayControllerNew::importance(const Node &node)
     Mbr mbr(mbrD);
     
     // Is this a valid tile?
-    if (!mbr.inside(mbr.mid())) {
-        return -1.0;
+    double import = -1.0;
+    if (mbr.inside(mbr.mid())) {
+        // Note: Add back the mutable attributes?
+        import = dataStructure->importanceForTile(ident, mbr, viewState, frameSize, entry.dispSolid);
     }
-    
-    // Note: Add back the mutable attributes?
-    return dataStructure->importanceForTile(ident, mbr, viewState, renderer->getFramebufferSize());
+
+    cacheImport = import;
+    cacheGen = curGen;
+
+    return import;
 }
 
 // Pure visibility check
@@ -266,7 +491,8 @@ bool QuadDisplayControllerNew::visible(const Node &node) {
     }
     
     // Note: Add back the mutable attributes?
-    return dataStructure->visibilityForTile(ident, mbr, viewState, renderer->getFramebufferSize());
+    NodeCacheEntry &entry = cacheEntryForNode(node);
+    return dataStructure->visibilityForTile(ident, mbr, viewState, frameSize, entry.dispSolid);
 }
 
     
@@ -20,6 +20,8 @@
 
 #import "QuadImageFrameLoader.h"
 #import "WhirlyKitLog.h"
+#import "DrawableStateChange.h"
+#import "Profiler.h"
 
 namespace WhirlyKit
 {
@@ -60,13 +62,20 @@ QuadFrameInfoRef QIFFrameAsset::getFrameInfo()
     return frameInfo;
 }
     
+void QIFFrameAsset::setState(QuadImageFrameLoader *loader,State newState)
+{
+    if (loader && (state == Loading) != (newState == Loading))
+        loader->numFetching += newState == Loading ? 1 : -1;
+    state = newState;
+}
+    
 void QIFFrameAsset::setupFetch(QuadImageFrameLoader *loader)
 {
-    state = Loading;
+    setState(loader,Loading);
 }
 
 void QIFFrameAsset::clear(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,QIFBatchOps *batchOps,ChangeSet &changes) {
-    state = Empty;
+    setState(loader,Empty);
     for (auto texID : texIDs)
         changes.push_back(new RemTextureReq(texID));
     texIDs.clear();
@@ -84,12 +93,12 @@ bool QIFFrameAsset::updateFetching(PlatformThreadInfo *threadInfo,QuadImageFrame
 
 void QIFFrameAsset::cancelFetch(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,QIFBatchOps *batchOps)
 {
-    state = Empty;
+    setState(loader,Empty);
 }
 
 void QIFFrameAsset::loadSuccess(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,const std::vector<Texture *> &texs)
 {
-    state = Loaded;
+    setState(loader,Loaded);
     texIDs.clear();
     for (auto tex : texs)
         texIDs.push_back(tex->getId());
@@ -97,13 +106,13 @@ void QIFFrameAsset::loadSuccess(PlatformThreadInfo *threadInfo,QuadImageFrameLoa
 
 void QIFFrameAsset::loadFailed(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader)
 {
-    state = Empty;
+    setState(loader,Empty);
 }
     
-void QIFFrameAsset::loadSkipped()
+void QIFFrameAsset::loadSkipped(QuadImageFrameLoader *loader)
 {
     loadReturnSet = true;
-    state = Loaded;
+    setState(loader,Loaded);
 }
 
 void QIFFrameAsset::setLoadReturn(const RawDataRef &data)
@@ -213,10 +222,14 @@ bool QIFTileAsset::anyFramesLoaded(QuadImageFrameLoader *loader)
 
 void QIFTileAsset::setImportance(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,double import)
 {
+    ident.importance = import;
+
+    // Only the outstanding fetches need to hear about it.
+    // Queued ones pick up the new value when they're scored.
     for (auto frame : frames) {
-        frame->updateFetching(threadInfo,loader, frame->getPriority(), import);
+        if (frame->getState() == QIFFrameAsset::Loading)
+            frame->updateFetching(threadInfo,loader, loader->calcLoadPriority(ident,frame->getFrameInfo()->frameIndex), import);
     }
-    ident.importance = import;
 }
 
 // Clear out the individual frames, loads and all
@@ -313,11 +326,29 @@ void QIFTileAsset::setupContents(QuadImageFrameLoader *loader,
     }
 }
 
+void QIFTileAsset::resetContents(QuadImageFrameLoader *loader,
+                                 LoadedTileNewRef loadedTile,
+                                 int defaultDrawPriority,
+                                 const std::vector<SimpleIdentity> &shaderIDs,
+                                 ChangeSet &changes)
+{
+    // Instances are tied to their master when they're added, so they have to go too
+    for (auto drawIDs : instanceDrawIDs) {
+        for (auto drawID : drawIDs) {
+            changes.push_back(new RemDrawableReq(drawID));
+        }
+    }
+    instanceDrawIDs.clear();
+    
+    setupContents(loader,loadedTile,defaultDrawPriority,shaderIDs,changes);
+}
+
 void QIFTileAsset::setColor(QuadImageFrameLoader *loader,const RGBAColor &newColor,ChangeSet &changes)
 {
+    DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
     for (auto drawIDs : instanceDrawIDs) {
         for (auto drawID : drawIDs) {
-            changes.push_back(new ColorChangeRequest(drawID,newColor));
+            stateReq->addColor(drawID,newColor);
         }
     }
 }
@@ -479,6 +510,29 @@ bool QIFTileAsset::anyFramesLoaded(const std::set<QuadFrameInfoRef> &frameInfos)
     return false;
 }
     
+int QIFTileAsset::activeFrameStatus(const std::vector<bool> &activeFrames)
+{
+    int status = 0;
+    for (unsigned int ii=0;ii<frames.size() && ii<activeFrames.size();ii++) {
+        if (!activeFrames[ii])
+            continue;
+        switch (frames[ii]->getState()) {
+            case QIFFrameAsset::Loading:
+                status |= FramesLoading;
+                break;
+            case QIFFrameAsset::Loaded:
+                status |= FramesLoaded;
+                break;
+            default:
+                break;
+        }
+        if (status == (FramesLoading|FramesLoaded))
+            break;
+    }
+    
+    return status;
+}
+
 bool QIFTileAsset::isFrameLoading(QuadFrameInfoRef frameInfo)
 {
     for (const auto &frame : frames) {
@@ -504,6 +558,11 @@ void QIFTileAsset::cancelFetches(PlatformThreadInfo *threadInfo,QuadImageFrameLo
 }
 
 
+QIFPendingFetch::QIFPendingFetch()
+: queueTime(0.0)
+{
+}
+
 QIFTileState::QIFTileState(int numFrames,const QuadTreeNew::Node &node)
 : node(node), enable(false)
 {
@@ -663,16 +722,18 @@ void QIFRenderState::updateScene(Scene *scene,
                 attrs.insert(SingleVertexAttribute(u_colorNameID,color4));
                 
                 // Turn it all on
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (auto drawID : tile->instanceDrawIDs[focusID]) {
-                    changes.push_back(new OnOffChangeRequest(drawID,true));
+                    stateReq->addOnOff(drawID,true);
                     changes.push_back(new DrawUniformsChangeRequest(drawID,attrs));
                 }
             }
             
             // Just turn the geometry off if we've got nothing
             if (!enable) {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (auto drawID : tile->instanceDrawIDs[focusID]) {
-                    changes.push_back(new OnOffChangeRequest(drawID,false));
+                    stateReq->addOnOff(drawID,false);
                     changes.push_back(new DrawTexChangeRequest(drawID,0,EmptyIdentity));
                     changes.push_back(new DrawTexChangeRequest(drawID,1,EmptyIdentity));
                 }
@@ -689,6 +750,7 @@ QuadImageFrameLoader::QuadImageFrameLoader(const SamplingParams &params,Mode mod
     baseDrawPriority(100), drawPriorityPerLevel(1),
     colorChanged(false),
     color(RGBAColor(255,255,255,255)),
+    maxFetchesInFlight(0), numFetching(0),
     control(NULL), builder(NULL),
     changesSinceLastFlush(true),
     compManager(NULL),
@@ -820,6 +882,49 @@ int QuadImageFrameLoader::calcLoadPriority(const QuadTreeNew::ImportantNode &ide
     
     return restPriority;
 }
+
+// Weights for the fetch score.  The units are doublings of screen area.
+static const double FetchScoreLevelWeight = 0.5;       // Per level below the min zoom
+static const double FetchScorePriorityWeight = 4.0;    // Per step of calcLoadPriority
+static const double FetchScoreFrameWeight = 1.0;       // Per frame away from the nearest focus
+static const double FetchScoreAgeWeight = 1.0;         // Per second spent waiting
+
+double QuadImageFrameLoader::calcFetchScore(const QuadTreeNew::ImportantNode &ident,int frame,TimeInterval age)
+{
+    // Importance is screen area, which varies over orders of magnitude
+    double score = log2(1.0 + std::max(ident.importance,0.0));
+    
+    // Lower levels fill in for everything under them
+    score -= FetchScoreLevelWeight * std::max(ident.level - params.minZoom,0);
+    
+    if (frame >= 0 && getNumFrames() > 1) {
+        // Respect the coarse rules for the load mode
+        score -= FetchScorePriorityWeight * calcLoadPriority(ident,frame);
+        
+        // And then prefer the frames closest to what's being displayed
+        if (nearFramePriority > -1) {
+            double frameDist = MAXFLOAT;
+            for (auto focusFrame : curFrames)
+                frameDist = std::min(frameDist,std::abs(frame - focusFrame));
+            score -= FetchScoreFrameWeight * frameDist;
+        }
+    }
+    
+    // Nothing should wait forever
+    score += FetchScoreAgeWeight * std::max(age,0.0);
+    
+    return score;
+}
+
+void QuadImageFrameLoader::setMaxFetchesInFlight(int maxFetches)
+{
+    maxFetchesInFlight = maxFetches;
+}
+
+int QuadImageFrameLoader::getMaxFetchesInFlight()
+{
+    return maxFetchesInFlight;
+}
     
 void QuadImageFrameLoader::setColor(RGBAColor &inColor,ChangeSet *changes)
 {
@@ -944,13 +1049,15 @@ void QuadImageFrameLoader::reload(PlatformThreadInfo *threadInfo,int frameIndex,
     
     // Look through the tiles and:
     //  Cancel outstanding fetches (that match our frame)
-    //  Start new requests
+    //  Queue up new requests
+    TimeInterval now = control ? control->getScene()->getCurrentTime() : 0.0;
     for (auto it: tiles) {
         QIFTileAssetRef tile = it.second;
         
         tile->cancelFetches(threadInfo, this, frame, batchOps);
-        tile->startFetching(threadInfo, this, frame, batchOps, changes);
+        queueFetch(it.first, frame, now);
     }
+    dispatchFetches(threadInfo, batchOps, changes);
     
     // Process all the fetches and cancels at once
     // We're not making any visual changes here, just messing with loading so no ChangeSet
@@ -975,10 +1082,10 @@ QIFTileAssetRef QuadImageFrameLoader::addNewTile(PlatformThreadInfo *threadInfo,
     }
     
     if (debugMode)
-        wkLogLevel(Debug,"Starting fetch for tile %d: (%d,%d)",ident.level,ident.x,ident.y);
+        wkLogLevel(Debug,"Queueing fetch for tile %d: (%d,%d)",ident.level,ident.x,ident.y);
     
-    // Normal remote data fetching
-    newTile->startFetching(threadInfo,this, NULL, batchOps, changes);
+    // Normal remote data fetching, once it's this tile's turn
+    queueFetch(ident, NULL, control->getScene()->getCurrentTime());
         
     return newTile;
 }
@@ -992,17 +1099,104 @@ void QuadImageFrameLoader::removeTile(PlatformThreadInfo *threadInfo,const QuadT
             wkLogLevel(Debug,"Unloading tile %d: (%d,%d)",ident.level,ident.x,ident.y);
         
         it->second->clear(threadInfo, this, batchOps, changes);
+        if (builder)
+            builder->removeElevationChunk(ident);
         
         batchOps->deletes.push_back(QuadTreeIdentifier(ident.x,ident.y,ident.level));
         
         tiles.erase(it);
     }
+    
+    // Anything we hadn't asked for yet never goes out
+    auto pendingIt = pendingFetches.find(ident);
+    if (pendingIt != pendingFetches.end()) {
+        static const ProfileID cancelID = Profiler::RegisterName("Tile Fetch Dropped");
+        Profiler::RecordCount(cancelID, pendingIt->second.frames.size());
+        pendingFetches.erase(pendingIt);
+    }
+}
+
+void QuadImageFrameLoader::queueFetch(const QuadTreeNew::Node &ident,QuadFrameInfoRef frame,TimeInterval now)
+{
+    QIFPendingFetch &pending = pendingFetches[ident];
+    if (pending.frames.empty())
+        pending.queueTime = now;
+
+    int numFrames = getNumFrames();
+    if (frame)
+        pending.frames.insert(frame->frameIndex);
+    else if (numFrames == 0)
+        pending.frames.insert(-1);
+    else
+        for (int ii=0;ii<numFrames;ii++)
+            pending.frames.insert(ii);
+}
+
+// A single tile frame waiting to be fetched
+typedef struct
+{
+    double score;
+    QuadTreeNew::Node ident;
+    int frame;
+} QIFFetchCandidate;
+
+void QuadImageFrameLoader::dispatchFetches(PlatformThreadInfo *threadInfo,QIFBatchOps *batchOps,ChangeSet &changes)
+{
+    if (pendingFetches.empty())
+        return;
+    
+    static const ProfileID profID = Profiler::RegisterName("Tile Fetch Dispatch");
+    ProfileScope profScope(profID);
+    
+    // How many we're allowed to start, if there's a limit
+    int toStart = -1;
+    if (maxFetchesInFlight > 0) {
+        toStart = maxFetchesInFlight - numFetchesInFlight();
+        if (toStart <= 0)
+            return;
+    }
+    
+    // Score everything that's waiting.  Importance may have changed since it was queued.
+    TimeInterval now = control->getScene()->getCurrentTime();
+    std::vector<QIFFetchCandidate> candidates;
+    for (const auto &it : pendingFetches) {
+        auto tileIt = tiles.find(it.first);
+        if (tileIt == tiles.end())
+            continue;
+        const QuadTreeNew::ImportantNode ident = tileIt->second->getIdent();
+        for (int frame : it.second.frames)
+            candidates.push_back(QIFFetchCandidate{calcFetchScore(ident,frame,now - it.second.queueTime),it.first,frame});
+    }
+    
+    auto byScore = [](const QIFFetchCandidate &a,const QIFFetchCandidate &b) { return a.score > b.score; };
+    if (toStart >= 0 && (size_t)toStart < candidates.size()) {
+        std::partial_sort(candidates.begin(),candidates.begin()+toStart,candidates.end(),byScore);
+        candidates.resize(toStart);
+    } else
+        std::sort(candidates.begin(),candidates.end(),byScore);
+    
+    // Start them in order and take them out of the queue
+    for (const auto &candidate : candidates) {
+        auto pendingIt = pendingFetches.find(candidate.ident);
+        pendingIt->second.frames.erase(candidate.frame);
+        if (pendingIt->second.frames.empty())
+            pendingFetches.erase(pendingIt);
+        
+        auto tile = tiles.find(candidate.ident)->second;
+        if (debugMode)
+            wkLogLevel(Debug,"Starting fetch for tile %d: (%d,%d) frame %d, score = %f",candidate.ident.level,candidate.ident.x,candidate.ident.y,candidate.frame,candidate.score);
+        tile->startFetching(threadInfo, this, candidate.frame >= 0 ? getFrameInfo(candidate.frame) : QuadFrameInfoRef(), batchOps, changes);
+    }
 }
     
     
 void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLoaderReturn *loadReturn,ChangeSet &changes)
 {
+    static const ProfileID profID = Profiler::RegisterName("Tile Merge");
+    ProfileScope profScope(profID);
+    
     changesSinceLastFlush = true;
+    const size_t firstChange = changes.size();
 
     bool failed = false;
     
@@ -1047,6 +1241,21 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
         }
     }
 
+    // Elevation goes to the builder, which rebuilds any tiles that should be using it.
+    // Their instances have to be rebuilt as well.  Render state goes out on the next flush.
+    if (!failed && loadReturn->elevChunk && builder) {
+        LoadedTileVec rebuiltTiles = builder->addElevationChunk(ident, loadReturn->elevChunk, changes);
+        if (mode != Object) {
+            for (auto loadedTile : rebuiltTiles) {
+                auto rebuiltIt = tiles.find(loadedTile->ident);
+                if (rebuiltIt != tiles.end()) {
+                    int defaultDrawPriority = baseDrawPriority + drawPriorityPerLevel * loadedTile->ident.level;
+                    rebuiltIt->second->resetContents(this,loadedTile,defaultDrawPriority,shaderIDs,changes);
+                }
+            }
+        }
+    }
+
     // If there is a tile, then notify it
     if (it != tiles.end()) {
         auto tile = it->second;
@@ -1073,17 +1282,29 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
         loadReturn->compObjs.clear();
         loadReturn->ovlCompObjs.clear();
     }
+    
+    // That fetch is done one way or another, so something else can go
+    if (!pendingFetches.empty()) {
+        QIFBatchOps *batchOps = makeBatchOps(threadInfo);
+        dispatchFetches(threadInfo, batchOps, changes);
+        processBatchOps(threadInfo, batchOps);
+        delete batchOps;
+    }
+    
+    // Loading can wait a frame if the renderer is on a budget
+    SetChangePriority(changes, ChangePriorityLoading, firstChange);
 }
     
 // Figure out what needs to be on/off for the non-frame cases
 void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
 {
-    // See if there's any loading happening
+    // See if there's any loading happening.  Tiles we're only prefetching don't hold up the switch.
     bool allLoaded = true;
     for (auto it : tiles) {
         auto tileID = it.first;
         auto tile = it.second;
-        if (tileID.level == targetLevel && tile->anyFramesLoading(this)) {
+        if (tileID.level == targetLevel && (tile->anyFramesLoading(this) || pendingFetches.count(tileID)) &&
+            !(control && control->isPrefetchOnly(tileID))) {
             allLoaded = false;
             break;
         }
@@ -1161,9 +1382,10 @@ void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
                 }
                 int relY = tileIDY - frameIdentY * (1<<relLevel);
                 
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (unsigned int focusID = 0;focusID<getNumFocus();focusID++) {
                     for (auto drawID : tile->getInstanceDrawIDs(focusID)) {
-                        changes.push_back(new OnOffChangeRequest(drawID,true));
+                        stateReq->addOnOff(drawID,true);
                         int texIDCount = 0;
                         for (auto texID : texIDs) {
                             changes.push_back(new DrawTexChangeRequest(drawID,texIDCount,texID,0,0,relLevel,relX,relY));
@@ -1172,9 +1394,10 @@ void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
                     }
                 }
             } else {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (unsigned int focusID = 0;focusID<getNumFocus();focusID++) {
                     for (auto drawID : tile->getInstanceDrawIDs(focusID)) {
-                        changes.push_back(new OnOffChangeRequest(drawID,false));
+                        stateReq->addOnOff(drawID,false);
                     }
                 }
             }
@@ -1278,6 +1501,29 @@ void QuadImageFrameLoader::setBuilder(QuadTileBuilder *inBuilder,QuadDisplayCont
     compManager = (ComponentManager *)control->getScene()->getManager(kWKComponentManager);
 }
 
+// What the unload check knows about a node
+typedef enum {UnloadCheckLoading=1<<0,UnloadCheckLoaded=1<<1,UnloadCheckUnloading=1<<2} UnloadCheckBits;
+
+// Look for an ancestor of the node with all the given status bits, nearest first.
+// Only the levels in the mask are checked, which keeps it cheap when the interesting nodes are on a few levels.
+static bool UnloadCheckFindAbove(const QuadTreeNew::Node &node,int bits,uint64_t levelMask,
+                                 const QuadTreeNodeMap<int> &nodeStatus,QuadTreeNew::Node &found)
+{
+    for (int level = node.level-1;level >= 0;level--) {
+        if (!(levelMask & ((uint64_t)1 << level)))
+            continue;
+        const int shift = node.level - level;
+        QuadTreeNew::Node parent(node.x >> shift,node.y >> shift,level);
+        auto it = nodeStatus.find(parent);
+        if (it != nodeStatus.end() && (it->second & bits) == bits) {
+            found = parent;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
 /// Before we tell the delegate to unload tiles, see if they want to keep them around
 /// Returns the tiles we want to preserve after all
 QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *builder,
@@ -1285,66 +1531,85 @@ QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *b
         const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
         int targetLevel)
 {
+    static const ProfileID profID = Profiler::RegisterName("Tile Unload Check");
+    ProfileScope profScope(profID);
+
     QuadTreeNew::NodeSet toKeep;
 
     // Not initialized yet
-    if (!this->builder)
+    if (!this->builder || unloadTiles.empty())
         return toKeep;
     
-    auto theActiveFrames = getActiveFrames();
-    
-    // List all the tiles that we're going to load or are loading
-    QuadTreeNew::NodeSet allLoads;
-    for (auto node : loadTiles)
-        allLoads.insert(node);
-    for (auto node : tiles)
-        if (node.second->anyFramesLoading(theActiveFrames))
-            allLoads.insert(node.first);
-    
-    // For all those loading or will be loading nodes, nail down their parents
-    for (auto node : allLoads) {
-        auto parent = node;
-        while (parent.level > 0) {
-            parent.level -= 1; parent.x /= 2;  parent.y /= 2;
-            if (unloadTiles.find(parent) != unloadTiles.end())
-            {
-                auto it = tiles.find(parent);
-                // Nail down the parent that's loaded, but don't care otherwise
-                if (it != tiles.end() && it->second->anyFramesLoaded(theActiveFrames)) {
-                    toKeep.insert(parent);
-                    break;
-                }
-            }
+    // Which frames we care about, in the same order as each tile's frames
+    const auto theActiveFrames = getActiveFrames();
+    std::vector<bool> activeFrames(frames.size(),false);
+    for (unsigned int ii=0;ii<frames.size();ii++)
+        activeFrames[ii] = theActiveFrames.find(frames[ii]) != theActiveFrames.end();
+    
+    // Status for every node we're interested in, along with which levels they're on.
+    // Each tile's frames are looked at once.
+    //  Loading:  Going to load, loading, or waiting to load
+    //  Loaded: We've got something for at least one of the active frames
+    //  Unloading: On the way out
+    QuadTreeNodeMap<int> nodeStatus;
+    nodeStatus.reserve(loadTiles.size() + pendingFetches.size() + tiles.size());
+    uint64_t loadingLevels = 0;
+    for (const auto &node : loadTiles) {
+        nodeStatus[node] |= UnloadCheckLoading;
+        loadingLevels |= (uint64_t)1 << node.level;
+    }
+    for (const auto &it : pendingFetches) {
+        nodeStatus[it.first] |= UnloadCheckLoading;
+        loadingLevels |= (uint64_t)1 << it.first.level;
+    }
+    for (const auto &it : tiles) {
+        const int frameStatus = it.second->activeFrameStatus(activeFrames);
+        int status = 0;
+        if (frameStatus & QIFTileAsset::FramesLoading) {
+            status |= UnloadCheckLoading;
+            loadingLevels |= (uint64_t)1 << it.first.level;
         }
+        if (frameStatus & QIFTileAsset::FramesLoaded)
+            status |= UnloadCheckLoaded;
+        if (status)
+            nodeStatus[it.first] |= status;
     }
     
-    // Now check all the unloads to see if their parents are loading
-    for (auto node : unloadTiles) {
-        auto it = tiles.find(node);
-        if (it == tiles.end())
-            continue;
-        // If this tile (to be unloaded) isn't loaded, then we don't care about it
-        if (!it->second->anyFramesLoaded(theActiveFrames))
-            continue;
-        
-        // Check that it's not already being kept around
-        if (toKeep.find(node) == toKeep.end()) {
-            auto parent = node;
-            while (parent.level > 0) {
-                parent.level -= 1; parent.x /= 2;  parent.y /= 2;
-                if (allLoads.find(parent) != allLoads.end()) {
-                    toKeep.insert(node);
-                    break;
-                }
-            }
+    // The only unloads we might keep are those with something loaded
+    std::vector<QuadTreeNew::Node> loadedUnloads;
+    uint64_t loadedUnloadLevels = 0;
+    for (const auto &node : unloadTiles) {
+        auto it = nodeStatus.find(node);
+        if (it != nodeStatus.end() && (it->second & UnloadCheckLoaded)) {
+            it->second |= UnloadCheckUnloading;
+            loadedUnloads.push_back(node);
+            loadedUnloadLevels |= (uint64_t)1 << node.level;
         }
-        
-        // Lastly, hold anything that might be used for an overlay
-        if (curOvlLevel != targetLevel) {
-            if (node.level == curOvlLevel && !it->second->getOvlCompObjs().empty()) {
-                if (toKeep.find(node) == toKeep.end())
-                    toKeep.insert(node);
-            }
+    }
+    if (loadedUnloads.empty())
+        return toKeep;
+    
+    // For all those loading or will be loading nodes, nail down the nearest parent that's loaded
+    QuadTreeNew::Node parent;
+    for (const auto &it : nodeStatus)
+        if ((it.second & UnloadCheckLoading) &&
+            UnloadCheckFindAbove(it.first,UnloadCheckLoaded|UnloadCheckUnloading,loadedUnloadLevels,nodeStatus,parent))
+            toKeep.insert(parent);
+    
+    // Now check the loaded unloads to see if their parents are loading
+    for (const auto &node : loadedUnloads)
+        if (toKeep.find(node) == toKeep.end() &&
+            UnloadCheckFindAbove(node,UnloadCheckLoading,loadingLevels,nodeStatus,parent))
+            toKeep.insert(node);
+
+    // Lastly, hold anything that might be used for an overlay
+    if (curOvlLevel != targetLevel) {
+        for (const auto &node : loadedUnloads) {
+            if (node.level != curOvlLevel)
+                continue;
+            auto it = tiles.find(node);
+            if (!it->second->getOvlCompObjs().empty())
+                toKeep.insert(node);
         }
     }
     
@@ -1357,12 +1622,14 @@ void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
                          const WhirlyKit::TileBuilderDelegateInfo &updates,
                          ChangeSet &changes)
 {
+    static const ProfileID profID = Profiler::RegisterName("Tile Builder Load");
+    ProfileScope profScope(profID);
+    
     // Not initialized yet
     if (!this->builder)
         return;
     
-    // Only handling loads and unloads for now
-    if (updates.loadTiles.empty() && updates.unloadTiles.empty())
+    if (updates.loadTiles.empty() && updates.unloadTiles.empty() && updates.changeTiles.empty())
         return;
     
     bool somethingChanged = false;
@@ -1395,8 +1662,19 @@ void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
         somethingChanged = true;
     }
 
+    // Importance changed for tiles we already have.
+    // Outstanding fetches are updated in place and queued ones are rescored below.
+    for (const auto &node : updates.changeTiles) {
+        auto it = tiles.find(node);
+        if (it != tiles.end() && it->second->getIdent().importance != node.importance)
+            it->second->setImportance(threadInfo,this,node.importance);
+    }
+
     builderLoadAdditional(threadInfo,builder,updates,changes);
     
+    // Start whatever's next in line
+    dispatchFetches(threadInfo,batchOps,changes);
+    
     // Process all the fetches and cancels at once
     processBatchOps(threadInfo,batchOps);
     delete batchOps;
@@ -1424,7 +1702,7 @@ void QuadImageFrameLoader::updateLoadingStatus()
 //            wkLogLevel(Debug,"  Tile %d: (%d,%d)  for %d",tile.first.level,tile.first.x,tile.first.y,(long)this);
             numTilesLoading++;
         }
-    this->loadingStatus = numTilesLoading != 0;
+    this->loadingStatus = numTilesLoading != 0 || !pendingFetches.empty();
 }
 
 /// Called right before the layer thread flushes all its current changes
@@ -1481,7 +1759,10 @@ void QuadImageFrameLoader::updateForFrame(RendererFrameInfo *frameInfo)
     TimeInterval now = control->getScene()->getCurrentTime();
     renderState.updateScene(frameInfo->scene, curFrames, now, flipY, color, changes);
 
-    frameInfo->scene->addChangeRequests(changes);
+    // The tiles should switch over together, even if change processing is on a budget
+    SetChangePriority(changes,ChangePriorityLoading);
+    if (!changes.empty())
+        frameInfo->scene->addChangeRequests(changes,true);
 }
 
 QuadImageFrameLoader::FrameStats::FrameStats()
@@ -1545,6 +1826,7 @@ void QuadImageFrameLoader::cleanup(PlatformThreadInfo *threadInfo,ChangeSet &cha
         tile.second->clear(threadInfo,this, batchOps, changes);
     }
     tiles.clear();
+    pendingFetches.clear();
 
     processBatchOps(threadInfo,batchOps);
     delete batchOps;
@@ -43,6 +43,7 @@ void QuadLoaderReturn::clear()
     images.clear();
     compObjs.clear();
     ovlCompObjs.clear();
+    elevChunk.reset();
 }
     
 }
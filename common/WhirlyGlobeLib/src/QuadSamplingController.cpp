@@ -20,6 +20,8 @@
 
 #import "QuadSamplingController.h"
 #import "WhirlyKitLog.h"
+#import "DrawableStateChange.h"
+#import "QuadCoverageManager.h"
 
 namespace WhirlyKit
 {
@@ -29,6 +31,9 @@ QuadSamplingController::QuadSamplingController()
     debugMode = false;
     builderStarted = false;
     valid = true;
+    scene = NULL;
+    renderer = NULL;
+    solidCache = NULL;
 }
 QuadSamplingController::~QuadSamplingController()
 {
@@ -39,11 +44,13 @@ void QuadSamplingController::start(const SamplingParams &inParams,Scene *inScene
     params = inParams;
     scene = inScene;
     renderer = inRenderer;
+    solidCache = (DisplaySolidCache *)scene->getManager(kWKDisplaySolidCache);
     
     builder = QuadTileBuilderRef(new QuadTileBuilder(params.coordSys,this));
     builder->setBuildGeom(params.generateGeom);
     builder->setCoverPoles(params.coverPoles);
     builder->setEdgeMatching(params.edgeMatching);
+    builder->setIncludeElev(params.includeElev);
     builder->setSingleLevel(params.singleLevel);
     
     displayControl = QuadDisplayControllerNewRef(new QuadDisplayControllerNew(this,builder.get(),renderer));
@@ -66,10 +73,24 @@ void QuadSamplingController::start(const SamplingParams &inParams,Scene *inScene
         importance[params.minZoom] = params.minImportanceTop;
     displayControl->setMinImportancePerLevel(importance);
     displayControl->setMaxTiles(params.maxTiles);
+    displayControl->setPrefetch(params.prefetchLookAhead,params.maxPrefetchTiles);
+    
+    // Other samplers may be covering the same tiles for different reasons
+    QuadCoverageManager *coverageManager = (QuadCoverageManager *)scene->getManager(kWKQuadCoverageManager);
+    if (coverageManager) {
+        coverageShare = coverageManager->addUser(params);
+        displayControl->setCoverageShare(coverageShare);
+    }
 }
 
 void QuadSamplingController::stop()
 {
+    if (coverageShare) {
+        QuadCoverageManager *coverageManager = (QuadCoverageManager *)scene->getManager(kWKQuadCoverageManager);
+        if (coverageManager)
+            coverageManager->removeUser(coverageShare);
+        coverageShare = NULL;
+    }
     builder = NULL;
     displayControl = NULL;
     builderDelegates.clear();
@@ -171,16 +192,32 @@ int QuadSamplingController::getMaxZoom()
     return params.maxZoom;
 }
 
+void QuadSamplingController::updateDisplaySolid(const QuadTreeIdentifier &ident,const Mbr &mbr,DisplaySolidRef &dispSolid)
+{
+    if (!solidCache)
+        return;
+    
+    // Terrain moves the tile's volume up (or down), so the solid changes as elevation comes in
+    double minZ = 0.0, maxZ = 0.0;
+    if (params.includeElev && builder)
+        builder->getElevationRange(QuadTreeNew::Node(ident), minZ, maxZ);
+    
+    if (!dispSolid || dispSolid->minZ != (float)minZ || dispSolid->maxZ != (float)maxZ)
+        dispSolid = solidCache->getDisplaySolid(ident, mbr, minZ, maxZ, params.coordSys, scene->getCoordAdapter());
+}
+
 double QuadSamplingController::importanceForTile(const QuadTreeIdentifier &ident,
                                  const Mbr &mbr,
                                  ViewStateRef viewState,
-                                 const Point2f &frameSize)
+                                 const Point2f &frameSize,
+                                 DisplaySolidRef &dispSolid)
 {
     // World spanning level 0 nodes sometimes have problems evaluating
     if (params.minImportanceTop == 0.0 && ident.level == 0)
         return MAXFLOAT;
     
-    DisplaySolidRef dispSolid;
+    // Other sampling controllers may have already built this one
+    updateDisplaySolid(ident, mbr, dispSolid);
     double import = ScreenImportance(viewState.get(), frameSize, viewState->eyeVec, 1, params.coordSys.get(), scene->getCoordAdapter(), mbr, ident, dispSolid);
     
     return import;
@@ -193,12 +230,13 @@ void QuadSamplingController::newViewState(ViewStateRef viewState)
 bool QuadSamplingController::visibilityForTile(const QuadTreeIdentifier &ident,
                                const Mbr &mbr,
                                ViewStateRef viewState,
-                               const Point2f &frameSize)
+                               const Point2f &frameSize,
+                               DisplaySolidRef &dispSolid)
 {
     if (ident.level == 0)
         return true;
     
-    DisplaySolidRef dispSolid;
+    updateDisplaySolid(ident, mbr, dispSolid);
     return TileIsOnScreen(viewState.get(), frameSize,  params.coordSys.get(), scene->getCoordAdapter(), mbr, ident, dispSolid);
 }
     
@@ -245,9 +283,12 @@ void QuadSamplingController::builderLoad(PlatformThreadInfo *threadInfo,
     }
 
     // Disable the tiles.  The delegates will instance them.
-    for (auto tile : updates.loadTiles) {
-        for (auto di : tile->drawInfo) {
-            changes.push_back(new OnOffChangeRequest(di.drawID,false));
+    if (!updates.loadTiles.empty()) {
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+        for (auto tile : updates.loadTiles) {
+            for (auto di : tile->drawInfo) {
+                stateReq->addOnOff(di.drawID,false);
+            }
         }
     }
     
@@ -28,12 +28,14 @@ SamplingParams::SamplingParams()
     minZoom(0), maxZoom(0),
     maxTiles(128),
     minImportance(256*256), minImportanceTop(0.0),
-    coverPoles(true), edgeMatching(true),
+    coverPoles(true), edgeMatching(true), includeElev(false),
     tessX(10), tessY(10),
     singleLevel(false),
     forceMinLevel(true),
     forceMinLevelHeight(0.0),
-    generateGeom(true)
+    generateGeom(true),
+    prefetchLookAhead(0.0),
+    maxPrefetchTiles(32)
 {
 }
 
@@ -56,6 +58,7 @@ bool SamplingParams::operator == (const SamplingParams &that) const
         maxTiles == that.maxTiles &&
         minImportance == that.minImportance && minImportanceTop == that.minImportanceTop &&
         coverPoles == that.coverPoles && edgeMatching == that.edgeMatching &&
+        includeElev == that.includeElev &&
         tessX == that.tessX && tessY == that.tessY &&
         singleLevel == that.singleLevel &&
         forceMinLevel == that.forceMinLevel &&
@@ -63,6 +66,29 @@ bool SamplingParams::operator == (const SamplingParams &that) const
         clipBounds == that.clipBounds &&
         generateGeom == that.generateGeom &&
         levelLoads == that.levelLoads &&
+        importancePerLevel == that.importancePerLevel &&
+        prefetchLookAhead == that.prefetchLookAhead &&
+        maxPrefetchTiles == that.maxPrefetchTiles;
+}
+    
+bool SamplingParams::coverageSameAs(const SamplingParams &that) const
+{
+    if (!coordSys || !that.coordSys)
+        return !coordSys && !that.coordSys;
+    
+    if (!coordSys->isSameAs(that.coordSys.get()))
+        return false;
+    
+    return coordBounds == that.coordBounds &&
+        minZoom == that.minZoom && maxZoom == that.maxZoom &&
+        maxTiles == that.maxTiles &&
+        minImportance == that.minImportance && minImportanceTop == that.minImportanceTop &&
+        singleLevel == that.singleLevel &&
+        includeElev == that.includeElev &&
+        forceMinLevel == that.forceMinLevel &&
+        forceMinLevelHeight == that.forceMinLevelHeight &&
+        clipBounds == that.clipBounds &&
+        levelLoads == that.levelLoads &&
         importancePerLevel == that.importancePerLevel;
 }
     
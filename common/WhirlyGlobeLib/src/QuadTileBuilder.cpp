@@ -108,6 +108,31 @@ int QuadTileBuilder::getDrawPriorityPerLevel() const
     return geomSettings.drawPriorityPerLevel;
 }
 
+void QuadTileBuilder::setIncludeElev(bool includeElev)
+{
+    geomSettings.includeElev = includeElev;
+}
+
+bool QuadTileBuilder::getIncludeElev() const
+{
+    return geomSettings.includeElev;
+}
+
+LoadedTileVec QuadTileBuilder::addElevationChunk(const QuadTreeNew::Node &ident,ElevationChunkRef chunk,ChangeSet &changes)
+{
+    return geomManage.addElevationChunk(ident,chunk,changes);
+}
+
+void QuadTileBuilder::removeElevationChunk(const QuadTreeNew::Node &ident)
+{
+    geomManage.removeElevationChunk(ident);
+}
+
+bool QuadTileBuilder::getElevationRange(const QuadTreeNew::Node &ident,double &minZ,double &maxZ)
+{
+    return geomManage.getElevationRange(ident,minZ,maxZ);
+}
+
 void QuadTileBuilder::setSingleLevel(bool singleLevel)
 {
     geomSettings.singleLevel = singleLevel;
@@ -65,6 +65,41 @@ bool QuadTreeNew::Node::operator!=(const WhirlyKit::QuadTreeNew::Node &that) con
     return level != that.level || x != that.x || y != that.y;
 }
 
+// Spread the low 29 bits out so there's a zero between each one
+static uint64_t SpreadBits(uint64_t val)
+{
+    val &= 0x1fffffff;
+    val = (val | (val << 16)) & 0x0000ffff0000ffffULL;
+    val = (val | (val << 8)) & 0x00ff00ff00ff00ffULL;
+    val = (val | (val << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    val = (val | (val << 2)) & 0x3333333333333333ULL;
+    val = (val | (val << 1)) & 0x5555555555555555ULL;
+    return val;
+}
+
+// Reverse of SpreadBits
+static uint64_t CompactBits(uint64_t val)
+{
+    val &= 0x5555555555555555ULL;
+    val = (val | (val >> 1)) & 0x3333333333333333ULL;
+    val = (val | (val >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+    val = (val | (val >> 4)) & 0x00ff00ff00ff00ffULL;
+    val = (val | (val >> 8)) & 0x0000ffff0000ffffULL;
+    val = (val | (val >> 16)) & 0x00000000ffffffffULL;
+    return val;
+}
+
+uint64_t QuadTreeNew::Node::key() const
+{
+    return ((uint64_t)level << 58) | SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+QuadTreeNew::Node QuadTreeNew::Node::FromKey(uint64_t key)
+{
+    const uint64_t bits = key & ((1ULL << 58)-1);
+    return Node((int)CompactBits(bits),(int)CompactBits(bits >> 1),(int)(key >> 58));
+}
+
 MbrD QuadTreeNew::generateMbrForNode(const Node &node)
 {
     MbrD outMbr;
@@ -173,64 +208,91 @@ void QuadTreeNew::evalNodeImportance(ImportantNode node,const std::vector<double
     }
 }
     
-bool QuadTreeNew::evalNodeVisible(ImportantNode node,const std::vector<double> &minImportance,int maxNodes,const std::set<int> &levelsToLoad,int maxLevel,ImportantNodeSet &visibleSet)
+std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadTreeNew::calcCoverageVisible(const std::vector<double> &minImportance,int maxNodes,const std::vector<int> &levelLoads,bool keepMinLevel)
 {
-    if (node.level > maxLevel)
-        return true;
-
-    // These are used for sorting elsewhere, so let's keep 'em around
-    node.importance = importance(node);
+    // We walk the tree a level at a time, evaluating each node once.
+    // A node can be part of the importance pass (which tells us the target level)
+    //  and/or the visibility pass (which gives us the nodes to load per level).
+    class EvalNode
+    {
+    public:
+        EvalNode(const ImportantNode &node,bool inImport,bool inVisible) : node(node), inImport(inImport), inVisible(inVisible) { }
+        ImportantNode node;
+        bool inImport,inVisible;
+    };
+    std::vector<EvalNode> levelNodes,nextNodes;
+    levelNodes.push_back(EvalNode(ImportantNode(0,0,0),true,true));
 
-    if (node.level == minLevel && node.importance < minImportance[node.level])
-        return true;
+    // Levels we'll load no matter which level is chosen.
+    // Relative levels depend on the target level, which we don't know yet.
+    std::vector<bool> alwaysLoad(maxLevel+1,false);
+    if (keepMinLevel)
+        alwaysLoad[minLevel] = true;
+    for (int level : levelLoads)
+        if (level >= 0 && level < maxLevel)
+            alwaysLoad[level] = true;
 
-    // Skip anything we wouldn't have evaluated in the first pass
-    if (node.level != minLevel && node.level <= maxLevel && node.importance == 0.0)
-        return true;
+    std::vector<std::vector<ImportantNode> > visibleNodes;
+    int targetLevel = -1;
+    // First level we always load that has more visible nodes than we could possibly load
+    int overflowLevel = maxLevel+1;
+    for (int level = 0;!levelNodes.empty();level++) {
+        visibleNodes.resize(level+1);
+        std::vector<ImportantNode> &levelVisible = visibleNodes[level];
+        bool anyImport = false;
+        for (auto &evalNode : levelNodes) {
+            ImportantNode &node = evalNode.node;
+            node.importance = importance(node);
 
-    // Only add to the visible set if we want it
-    if (levelsToLoad.find(node.level) != levelsToLoad.end())
-        visibleSet.insert(node);
+            // Same test as evalNodeImportance
+            if (evalNode.inImport && node.importance < minImportance[level] && minImportance[level] != MAXFLOAT)
+                evalNode.inImport = false;
+            if (evalNode.inImport) {
+                anyImport = true;
+                if (level >= minLevel)
+                    targetLevel = std::max(targetLevel,level);
+            }
 
-    // Exceeded the number of nodes we can plausible load.  Fail.
-    if (visibleSet.size() > maxNodes)
-        return false;
-    
-    // Test the children
-    if (node.level < maxLevel) {
-        for (int iy=0;iy<2;iy++) {
-            int indY = 2*node.y + iy;
-            for (int ix=0;ix<2;ix++) {
-                int indX = 2*node.x + ix;
-                ImportantNode childNode(indX,indY,node.level+1);
-                if (!evalNodeVisible(childNode,minImportance,maxNodes,levelsToLoad,maxLevel,visibleSet))
-                    return false;
+            // Skip anything below the min importance at the min level or invisible elsewhere
+            if (evalNode.inVisible) {
+                if (level == minLevel ? node.importance < minImportance[level] : node.importance == 0.0)
+                    evalNode.inVisible = false;
+                else
+                    levelVisible.push_back(node);
             }
         }
-    }
-    
-    return true;
-}
-    
-std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadTreeNew::calcCoverageVisible(const std::vector<double> &minImportance,int maxNodes,const std::vector<int> &levelLoads,bool keepMinLevel)
-{
-    ImportantNodeSet sortedNodes;
 
-    // Start at the lowest level and work our way to higher resolution
-    ImportantNode node(0,0,0);
-    evalNodeImportance(node,minImportance,sortedNodes);
+        // If a level we always load has too many visible nodes, nothing below it can be chosen.
+        // Other levels can overflow and still leave a deeper level that fits.
+        if (alwaysLoad[level] && levelVisible.size() > (size_t)maxNodes)
+            overflowLevel = std::min(overflowLevel,level);
+        // We only need visible nodes down to the target level
+        const bool visibleChildren = level < overflowLevel && (anyImport || level < minLevel);
 
-    // Max level is the one we want to load (or try anyway)
-    int targetLevel = -1;
-    for (auto node: sortedNodes)
-        targetLevel = std::max(targetLevel,node.level);
+        nextNodes.clear();
+        if (level < maxLevel)
+            for (const auto &evalNode : levelNodes) {
+                const bool inVisible = evalNode.inVisible && visibleChildren;
+                if (!evalNode.inImport && !inVisible)
+                    continue;
+                const ImportantNode &node = evalNode.node;
+                for (int iy=0;iy<2;iy++)
+                    for (int ix=0;ix<2;ix++)
+                        nextNodes.push_back(EvalNode(ImportantNode(2*node.x+ix,2*node.y+iy,level+1),evalNode.inImport,inVisible));
+            }
+        levelNodes.swap(nextNodes);
+    }
 
+    // Max level is the one we want to load (or try anyway)
     targetLevel = std::max(targetLevel,minLevel);
     
     // Try to load the target level (and anything else we're required to)
     int chosenLevel = targetLevel;
     ImportantNodeSet chosenNodes;
-    while (chosenLevel >= minLevel) {
+    for (;chosenLevel >= minLevel;chosenLevel--) {
+        if (chosenLevel >= overflowLevel)
+            continue;
+
         // Resolve the offsets and such if they are there
         std::set<int> levelsToLoad;
         if (keepMinLevel)
@@ -243,21 +305,19 @@ std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadTreeNew::calcCoverageVisible(c
                 levelsToLoad.insert(level);
         }
 
-        // Get visibility for all the nodes down to our target level
-        // Also make sure we're not exceeding our maximum as we go
-        ImportantNodeSet levelNodes;
-        bool success = true;
-        ImportantNode node(0,0,0);
-        if (!evalNodeVisible(node,minImportance,maxNodes,levelsToLoad,chosenLevel,levelNodes)) {
-            success = false;
-        }
+        // Make sure we're not exceeding our maximum
+        size_t numNodes = 0;
+        for (int level : levelsToLoad)
+            if (level <= chosenLevel && (size_t)level < visibleNodes.size())
+                numNodes += visibleNodes[level].size();
+        if (numNodes > (size_t)maxNodes)
+            continue;
 
         // Kept within the limit, so return these nodes
-        if (success) {
-            chosenNodes = levelNodes;
-            break;
-        }
-        chosenLevel--;
+        for (int level : levelsToLoad)
+            if (level <= chosenLevel && (size_t)level < visibleNodes.size())
+                chosenNodes.insert(visibleNodes[level].begin(),visibleNodes[level].end());
+        break;
     }
 
     return {chosenLevel,chosenNodes};
@@ -84,7 +84,7 @@ bool RawDataReader::getDouble(double &val)
     size_t dataSize = sizeof(double);
     if (pos+dataSize > rawData->getLen())
         return false;
-    val = *((int *)(rawData->getRawData()+pos));
+    memcpy(&val, rawData->getRawData()+pos, dataSize);
     pos += dataSize;
     
     return true;
@@ -103,6 +103,22 @@ bool RawDataReader::getString(std::string &str)
     return true;
 }
 
+bool RawDataReader::getInt64(int64_t &val)
+{
+    return getBytes(&val, sizeof(int64_t));
+}
+
+bool RawDataReader::getBytes(void *bytes,unsigned long len)
+{
+    if (pos+len > rawData->getLen())
+        return false;
+    if (len > 0)
+        memcpy(bytes, rawData->getRawData()+pos, len);
+    pos += len;
+    
+    return true;
+}
+
 
 MutableRawData::MutableRawData()
 {
@@ -162,6 +178,20 @@ void MutableRawData::addString(const std::string &str)
     memset(&data[start+len], 0, extra);
 }
 
+void MutableRawData::addInt64(int64_t iVal)
+{
+    addBytes(&iVal, sizeof(int64_t));
+}
+
+void MutableRawData::addBytes(const void *bytes,unsigned long len)
+{
+    if (len == 0)
+        return;
+    size_t start = data.size();
+    data.resize(data.size()+len);
+    memcpy(&data[start], bytes, len);
+}
+
     
 RawDataWrapper *RawDataFromFile(FILE *fp,unsigned int dataLen)
 {
@@ -41,6 +41,9 @@
 #import "GeometryManager.h"
 #import "FontTextureManager.h"
 #import "ComponentManager.h"
+#import "ScreenImportance.h"
+#import "QuadCoverageManager.h"
+#import "Profiler.h"
 
 namespace WhirlyKit
 {
@@ -80,8 +83,14 @@ Scene::Scene(CoordSystemDisplayAdapter *adapter)
     addManager(kWKGeometryManager, new GeometryManager());
     // Components (groups of things)
     addManager(kWKComponentManager, MakeComponentManager());
+    // Tile display solids, shared between quad sampling controllers
+    addManager(kWKDisplaySolidCache, new DisplaySolidCache());
+    // Quad tree coverage, shared between sampling controllers
+    addManager(kWKQuadCoverageManager, new QuadCoverageManager());
     
     overlapMargin = 0.0;
+    
+    updateDrawIndexBounds();
 }
 
 Scene::~Scene()
@@ -102,6 +111,7 @@ Scene::~Scene()
         // Note: Tear down change requests?
         delete theChangeRequests[ii];
     }
+    changeQueue.clear();
     
     activeModels.clear();
     
@@ -121,31 +131,51 @@ void Scene::setDisplayAdapter(CoordSystemDisplayAdapter *newCoordAdapter)
 {
     std::lock_guard<std::mutex> guardLock(coordAdapterLock);
     coordAdapter = newCoordAdapter;
+    
+    updateDrawIndexBounds();
 }
     
-// Add change requests to our list
-void Scene::addChangeRequests(const ChangeSet &newChanges)
+void Scene::updateDrawIndexBounds()
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
-    
-    for (ChangeRequest *change : newChanges)
+    // Drawable MBRs may be geographic or local, so cover both
+    MbrD bounds(Point2d(-M_PI,-M_PI/2.0),Point2d(M_PI,M_PI/2.0));
+    Point3f ll,ur;
+    if (coordAdapter && coordAdapter->getBounds(ll,ur))
     {
-        if (change && change->when > 0.0)
-            timedChangeRequests.insert(change);
-        else
-            changeRequests.push_back(change);
+        bounds.addPoint(Point2d(ll.x(),ll.y()));
+        bounds.addPoint(Point2d(ur.x(),ur.y()));
     }
+    drawIndex.setBounds(bounds);
+}
+    
+// Add change requests to our list
+void Scene::addChangeRequests(const ChangeSet &newChanges,bool atomic)
+{
+    ChangeRecorderRef recorder = std::atomic_load(&changeRecorder);
+    if (recorder)
+        recorder->recordChanges(newChanges,TimeGetCurrent());
+
+    changeQueue.push(newChanges,atomic);
 }
 
 // Add a single change request
 void Scene::addChangeRequest(ChangeRequest *newChange)
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
+    ChangeRecorderRef recorder = std::atomic_load(&changeRecorder);
+    if (recorder)
+        recorder->recordChanges(ChangeSet(1,newChange),TimeGetCurrent());
 
-    if (newChange && newChange->when > 0.0)
-        timedChangeRequests.insert(newChange);
-    else
-        changeRequests.push_back(newChange);
+    changeQueue.push(newChange);
+}
+
+void Scene::setChangeRecorder(ChangeRecorderRef recorder)
+{
+    std::atomic_store(&changeRecorder,recorder);
+}
+
+ChangeRecorderRef Scene::getChangeRecorder()
+{
+    return std::atomic_load(&changeRecorder);
 }
 
 DrawableRef Scene::getDrawable(SimpleIdentity drawId)
@@ -269,20 +299,20 @@ int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeI
 {
     ChangeSet preRequests;
 
+    // Pick up whatever the other threads have handed us
+    changeQueue.drain(changeRequests);
+    
+    // Just doing the ones that require a pre-process
+    for (unsigned int ii=0;ii<changeRequests.size();ii++)
     {
-        std::lock_guard<std::mutex> guardLock(changeRequestLock);
-        // Just doing the ones that require a pre-process
-        for (unsigned int ii=0;ii<changeRequests.size();ii++)
-        {
-            ChangeRequest *req = changeRequests[ii];
-            if (req && req->needPreExecute()) {
-                preRequests.push_back(req);
-                changeRequests[ii] = NULL;
-            }
+        ChangeRequest *req = changeRequests[ii];
+        if (req && req->needPreExecute()) {
+            preRequests.push_back(req);
+            changeRequests[ii] = NULL;
         }
     }
 
-    // Run these outside of the lock, since they might use the lock
+    // These may add more change requests
     for (auto req : preRequests) {
         req->execute(this,renderer,view);
         delete req;
@@ -291,53 +321,75 @@ int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeI
     return preRequests.size();
 }
 
-// Process outstanding changes.
-// We'll grab the lock and we're only expecting to be called in the rendering thread
-int Scene::processChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInterval now)
+// Higher priority first, stable for the rest
+class ChangePrioritySorter
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
-    // See if any of the timed changes are ready
-    std::vector<ChangeRequest *> toMove;
-    for (ChangeRequest *req : timedChangeRequests)
+public:
+    bool operator () (const ChangeRequest *a,const ChangeRequest *b) const
     {
-        if (now >= req->when)
-            toMove.push_back(req);
-        else
-            break;
+        return a->priority > b->priority;
     }
-    for (ChangeRequest *req : toMove)
+};
+
+// Process outstanding changes.
+// We're only expecting to be called in the rendering thread
+int Scene::processChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInterval now,int budgetMicros)
+{
+    static const ProfileID profID = Profiler::RegisterName("Change Processing");
+    static const ProfileID profCountID = Profiler::RegisterName("Changes Executed");
+    ProfileScope profScope(profID);
+    
+    // Changes recorded from here on go with the next frame
+    ChangeRecorderRef recorder = std::atomic_load(&changeRecorder);
+    if (recorder)
+        recorder->recordFrame(now,view);
+    
+    // Pick up anything new and see if any of the timed changes are ready
+    changeQueue.drain(changeRequests);
+    changeQueue.drainTimed(now,changeRequests);
+    
+    // Clear out the ones the pre-process already ran
+    changeRequests.erase(std::remove(changeRequests.begin(),changeRequests.end(),(ChangeRequest *)NULL),changeRequests.end());
+    
+    // Working on a budget, so the important ones go first
+    if (budgetMicros > 0)
+        std::stable_sort(changeRequests.begin(),changeRequests.end(),ChangePrioritySorter());
+    
+    TimeInterval startTime = budgetMicros > 0 ? TimeGetCurrent() : 0.0;
+    unsigned int numChanges = 0;
+    while (numChanges < changeRequests.size())
     {
-        timedChangeRequests.erase(req);
-        changeRequests.push_back(req);
+        ChangeRequest *req = changeRequests[numChanges++];
+        req->execute(this,renderer,view);
+        delete req;
+        
+        if (budgetMicros > 0 && (TimeGetCurrent() - startTime) * 1e6 >= budgetMicros)
+            break;
     }
+    changeRequests.erase(changeRequests.begin(),changeRequests.begin()+numChanges);
+    Profiler::RecordCount(profCountID,numChanges);
     
-    for (unsigned int ii=0;ii<changeRequests.size();ii++)
+    // Keep track of how long it takes to work through a backlog
+    changeStats.backlog = (int)changeRequests.size();
+    if (changeStats.backlog > 0)
     {
-        ChangeRequest *req = changeRequests[ii];
-        if (req) {
-            req->execute(this,renderer,view);
-            delete req;
-        }
+        changeStats.maxBacklog = std::max(changeStats.maxBacklog,changeStats.backlog);
+        changeStats.backlogFrames++;
+        changeStats.totalBacklogFrames++;
+    } else if (changeStats.backlogFrames > 0)
+    {
+        // Count the frame that finished it off
+        changeStats.lastDrainFrames = changeStats.backlogFrames + 1;
+        changeStats.maxDrainFrames = std::max(changeStats.maxDrainFrames,changeStats.lastDrainFrames);
+        changeStats.backlogFrames = 0;
     }
-    int numChanges = changeRequests.size();
-    changeRequests.clear();
     
     return numChanges;
 }
     
 bool Scene::hasChanges(TimeInterval now)
 {
-    bool changes = false;
-    if (changeRequestLock.try_lock())
-    {
-        changes = !changeRequests.empty();
-        
-        if (!changes)
-            if (timedChangeRequests.size() > 0)
-                changes = now >= (*timedChangeRequests.begin())->when;
-
-        changeRequestLock.unlock();
-    }
+    bool changes = !changeRequests.empty() || changeQueue.hasChanges(now);
     
     // How about the active models?
     bool activeModelsUpdates = false;
@@ -350,6 +402,21 @@ bool Scene::hasChanges(TimeInterval now)
     return changes || activeModelsUpdates;
 }
 
+ChangeProcessingStats::ChangeProcessingStats()
+: backlog(0), maxBacklog(0), backlogFrames(0), lastDrainFrames(0), maxDrainFrames(0), totalBacklogFrames(0)
+{
+}
+
+int Scene::getNumChangeRequests()
+{
+    return (int)changeRequests.size() + changeQueue.getQueueDepth();
+}
+
+ChangeQueueStats Scene::getChangeQueueStats()
+{
+    return changeQueue.getStats();
+}
+
 // Add a single sub texture map
 void Scene::addSubTexture(const SubTexture &subTex)
 {
@@ -407,19 +474,93 @@ SubTexture Scene::getSubTexture(SimpleIdentity subTexId)
 void Scene::addDrawable(DrawableRef draw)
 {
     drawables[draw->getId()] = draw;
+    
+    // Instances are drawn somewhere other than their master's MBR and moving drawables don't stay put.
+    // Offscreen and calculation drawables need to run regardless of the view.
+    // Builders turn off cullByMbr for anything that sticks up off the surface or is sized on screen.
+    bool cullable = draw->getRenderTarget() == EmptyIdentity && draw->getCalculationProgram() == EmptyIdentity;
+    if (!cullable || dynamic_cast<BasicDrawableInstance *>(draw.get()))
+        cullable = false;
+    else {
+        BasicDrawable *basicDraw = dynamic_cast<BasicDrawable *>(draw.get());
+        if (basicDraw && (basicDraw->hasMotion() || !basicDraw->cullByMbr))
+            cullable = false;
+    }
+    drawIndex.addDrawable(draw.get(),cullable);
+}
+
+void Scene::stopCullingDrawable(Drawable *draw)
+{
+    if (drawables.find(draw->getId()) != drawables.end())
+        drawIndex.addDrawable(draw,false);
 }
     
 void Scene::remDrawable(DrawableRef draw)
 {
+    drawIndex.removeDrawable(draw->getId());
+    
     auto it = drawables.find(draw->getId());
     if (it != drawables.end())
         drawables.erase(it);
 }
     
+void Scene::applyDrawableStates(SceneRenderer *renderer,const SimpleIdentity *drawIDs,size_t numIDs,const DrawableState &state)
+{
+    // Look them all up first
+    std::vector<DrawableRef> draws;
+    draws.reserve(numIDs);
+    for (size_t ii=0;ii<numIDs;ii++)
+    {
+        auto it = drawables.find(drawIDs[ii]);
+        if (it != drawables.end())
+            draws.push_back(it->second);
+    }
+    
+    for (const DrawableRef &draw : draws)
+    {
+        if (state.hasOnOff)
+            SetDrawableOnOff(draw.get(),state.onOff);
+        if (state.hasFade)
+            SetDrawableFade(draw.get(),state.fadeUp,state.fadeDown);
+        if (state.hasUniforms)
+            SetDrawableUniforms(draw.get(),state.uniforms);
+        if (state.hasDrawPriority)
+            SetDrawableDrawPriority(renderer,draw,state.drawPriority);
+    }
+    if (state.hasFade && !draws.empty())
+        renderer->setRenderUntil(std::max(state.fadeUp,state.fadeDown));
+    
+    if (state.remove)
+        for (const DrawableRef &draw : draws)
+        {
+            renderer->removeDrawable(draw,true);
+            remDrawable(draw);
+        }
+}
+    
+void Scene::findDrawablesInView(const Eigen::Matrix4d &mvpMat,std::vector<Drawable *> &draws)
+{
+    if (!coordAdapter)
+    {
+        for (auto it : drawables)
+            draws.push_back(it.second.get());
+        return;
+    }
+    
+    drawIndex.findDrawables(DrawableCullTest(coordAdapter,mvpMat),draws);
+}
+    
 void Scene::dumpStats()
 {
     wkLogLevel(Verbose,"Scene: %ld drawables",drawables.size());
+    wkLogLevel(Verbose,"Scene: %d spatially indexed drawables, %d always drawn",drawIndex.numIndexed(),drawIndex.numUnbounded());
     wkLogLevel(Verbose,"Scene: %d active models",(int)activeModels.size());
+    ChangeQueueStats queueStats = changeQueue.getStats();
+    wkLogLevel(Verbose,"Scene: %d change requests queued (max %d), %d delayed",queueStats.queueDepth,queueStats.maxQueueDepth,queueStats.numTimed);
+    wkLogLevel(Verbose,"Scene: %llu change requests in %llu batches, %llu contended pushes",
+               (unsigned long long)queueStats.numRequests,(unsigned long long)queueStats.numBatches,(unsigned long long)queueStats.numContended);
+    wkLogLevel(Verbose,"Scene: %d change requests left over (max %d), last backlog took %d frames (max %d)",
+               changeStats.backlog,changeStats.maxBacklog,changeStats.lastDrainFrames,changeStats.maxDrainFrames);
     wkLogLevel(Verbose,"Scene: %ld textures",textures.size());
     wkLogLevel(Verbose,"Scene: %ld sub textures",subTextureMap.size());
 }
@@ -482,8 +623,36 @@ void Scene::removeProgram(SimpleIdentity progId)
 
 void AddTextureReq::setupForRenderer(const RenderSetupInfo *setupInfo)
 {
-    if (texRef)
-        texRef->createInRenderer(setupInfo);
+    if (!texRef)
+        return;
+    
+    // The renderer may toss the data once it's uploaded, so grab it now
+    if (ChangeRecorder::IsRecording())
+    {
+        MutableRawDataRef texData(new MutableRawData());
+        if (ChangeRecorder::RecordTexture(texData.get(),texRef.get()))
+            recordData = texData;
+    }
+    
+    texRef->createInRenderer(setupInfo);
+}
+
+bool AddTextureReq::record(MutableRawData *data) const
+{
+    if (recordData)
+    {
+        data->addInt(ChangeRecordAddTexture);
+        data->addBytes(recordData->getRawData(),recordData->getLen());
+        return true;
+    }
+    
+    MutableRawData texData;
+    if (!texRef || !ChangeRecorder::RecordTexture(&texData,texRef.get()))
+        return false;
+    data->addInt(ChangeRecordAddTexture);
+    data->addBytes(texData.getRawData(),texData.getLen());
+    
+    return true;
 }
     
 TextureBase *AddTextureReq::getTex()
@@ -515,11 +684,47 @@ void RemTextureReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View
     } else
         wkLogLevel(Warn,"RemTextureReq: No such texture.");
 }
+
+bool RemTextureReq::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordRemTexture);
+    data->addInt64(texture);
+    
+    return true;
+}
     
 void AddDrawableReq::setupForRenderer(const RenderSetupInfo *setupInfo)
 {
-    if (drawRef)
-        drawRef->setupForRenderer(setupInfo);
+    if (!drawRef)
+        return;
+    
+    // Setting up for the renderer tosses the geometry, so grab it now
+    if (ChangeRecorder::IsRecording())
+    {
+        MutableRawDataRef drawData(new MutableRawData());
+        if (ChangeRecorder::RecordDrawable(drawData.get(),drawRef.get()))
+            recordData = drawData;
+    }
+    
+    drawRef->setupForRenderer(setupInfo);
+}
+
+bool AddDrawableReq::record(MutableRawData *data) const
+{
+    if (recordData)
+    {
+        data->addInt(ChangeRecordAddDrawable);
+        data->addBytes(recordData->getRawData(),recordData->getLen());
+        return true;
+    }
+    
+    MutableRawData drawData;
+    if (!drawRef || !ChangeRecorder::RecordDrawable(&drawData,drawRef.get()))
+        return false;
+    data->addInt(ChangeRecordAddDrawable);
+    data->addBytes(drawData.getRawData(),drawData.getLen());
+    
+    return true;
 }
 
 AddDrawableReq::~AddDrawableReq()
@@ -572,6 +777,14 @@ void RemDrawableReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::Vie
         wkLogLevel(Warn,"Missing drawable for RemDrawableReq: %llu", drawID);
 }
 
+bool RemDrawableReq::record(MutableRawData *data) const
+{
+    data->addInt(ChangeRecordRemDrawable);
+    data->addInt64(drawID);
+    
+    return true;
+}
+
 void AddProgramReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *view)
 {
     scene->addProgram(program);
@@ -21,6 +21,7 @@
 #import "SceneGraphManager.h"
 #import "SceneRenderer.h"
 #import "WhirlyKitLog.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 
@@ -136,20 +137,19 @@ void SceneGraphManager::update(ViewStateRef viewState,ChangeSet &changes)
     std::set_difference(activeDrawIDs.begin(), activeDrawIDs.end(), shouldBeOn.begin(), shouldBeOn.end(),
                         std::inserter(toRemove, toRemove.end()));
     
-    for (SimpleIDSet::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
-    {
-        SimpleIdentity drawId = *it;
-        changes.push_back(new OnOffChangeRequest(drawId,false));
-    }
-    
     // And which ones to add
     SimpleIDSet toAdd;
     std::set_difference(shouldBeOn.begin(),shouldBeOn.end(),activeDrawIDs.begin(),activeDrawIDs.end(),
                         std::inserter(toAdd, toAdd.end()));
-    for (SimpleIDSet::iterator it = toAdd.begin(); it != toAdd.end(); ++it)
+    
+    if (!toRemove.empty() || !toAdd.empty())
     {
-        SimpleIdentity drawId = *it;
-        changes.push_back(new OnOffChangeRequest(drawId,true));
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+        stateReq->reserve(toRemove.size() + toAdd.size());
+        for (SimpleIDSet::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
+            stateReq->addOnOff(*it,false);
+        for (SimpleIDSet::iterator it = toAdd.begin(); it != toAdd.end(); ++it)
+            stateReq->addOnOff(*it,true);
     }
     
     activeDrawIDs = shouldBeOn;
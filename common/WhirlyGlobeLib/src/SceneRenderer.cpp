@@ -19,11 +19,14 @@
  */
 
 #import "SceneRenderer.h"
+#import "Profiler.h"
 
 using namespace Eigen;
 
 namespace WhirlyKit
 {
+
+static const ProfileID ProfOffsetCulling = Profiler::RegisterName("Offset Culling");
     
 // Compare two matrices float by float
 // The default comparison seems to have an epsilon and the cwise version isn't getting picked up
@@ -141,6 +144,12 @@ void SceneRenderer::init()
     perfInterval = 0.0;
     useViewChanged = true;
     triggerDraw = true;
+    useDrawableCulling = true;
+    changeBudget = 0;
+    drawListDirty = false;
+    drawListZBufferMode = zBufferOff;
+    frameStamp = 0;
+    viewVersion = 0;
     frameCount = 0;
     frameCountLastChanged = 0;
     frameCountStart = 0.0;
@@ -192,6 +201,12 @@ void SceneRenderer::setPerfInterval(int howLong)
 void SceneRenderer::setUseViewChanged(bool newVal)
     { useViewChanged = newVal; }
 
+void SceneRenderer::setUseDrawableCulling(bool newVal)
+    { useDrawableCulling = newVal; }
+
+void SceneRenderer::setChangeBudget(int budgetMicros)
+    { changeBudget = budgetMicros; }
+
 void SceneRenderer::setView(View *newView)
     { theView = newView; }
     
@@ -376,6 +391,9 @@ void SceneRenderer::removeContinuousRenderRequest(SimpleIdentity drawID)
 
 void SceneRenderer::setScene(WhirlyKit::Scene *newScene)
 {
+    // Drawables from the old scene are no longer valid
+    clearDrawList();
+
     scene = newScene;
     if (scene)
     {
@@ -487,7 +505,7 @@ int SceneRenderer::processScene(TimeInterval now)
     if (!scene)
         return 0;
     
-    return scene->processChanges(theView,this,now);
+    return scene->processChanges(theView,this,now,changeBudget);
 }
 
 bool SceneRenderer::hasChanges()
@@ -499,5 +517,234 @@ bool SceneRenderer::hasChanges()
     
     return frameCount - frameCountLastChanged <= extraFrames;
 }
+
+SceneRenderer::DrawListEntry::DrawListEntry(Drawable *draw)
+: drawable(draw), drawPriority(0), requestZBuffer(false), programID(EmptyIdentity), texID(EmptyIdentity),
+  frameStamp(0), offsetMask(0), isOn(false), matViewVersion(0)
+{
+    updateSortKeys();
+    localMat = localMat.Identity();
+}
+
+bool SceneRenderer::DrawListEntry::updateSortKeys()
+{
+    SimpleIdentity newTexID = EmptyIdentity;
+    BasicDrawable *basicDraw = dynamic_cast<BasicDrawable *>(drawable);
+    if (basicDraw && !basicDraw->texInfo.empty())
+        newTexID = basicDraw->texInfo[0].texId;
+    
+    bool changed = drawPriority != drawable->getDrawPriority() || requestZBuffer != drawable->getRequestZBuffer() ||
+                   programID != drawable->getProgram() || texID != newTexID;
+    drawPriority = drawable->getDrawPriority();
+    requestZBuffer = drawable->getRequestZBuffer();
+    programID = drawable->getProgram();
+    texID = newTexID;
+    
+    return changed;
+}
+
+// Sort by draw priority, then group by state to cut down on program and texture changes
+class DrawListSortStruct
+{
+public:
+    DrawListSortStruct(bool useZBuffer) : useZBuffer(useZBuffer) { }
+    
+    bool operator()(const SceneRenderer::DrawListEntry &a, const SceneRenderer::DrawListEntry &b) const
+    {
+        if (a.drawPriority != b.drawPriority)
+            return a.drawPriority < b.drawPriority;
+        // Alpha stuff goes at the end
+        if (useZBuffer && a.requestZBuffer != b.requestZBuffer)
+            return !a.requestZBuffer;
+        if (a.programID != b.programID)
+            return a.programID < b.programID;
+        if (a.texID != b.texID)
+            return a.texID < b.texID;
+        
+        return a.drawable->getId() < b.drawable->getId();
+    }
+    
+    bool useZBuffer;
+};
+
+void SceneRenderer::addToDrawList(Drawable *draw)
+{
+    // Get rid of an existing entry, if there is one
+    auto it = drawListPos.find(draw->getId());
+    if (it != drawListPos.end())
+        drawList[it->second].drawable = NULL;
+    
+    // It'll be sorted into place on the next frame
+    drawListPos[draw->getId()] = drawList.size();
+    drawList.push_back(DrawListEntry(draw));
+    drawListDirty = true;
+}
+
+void SceneRenderer::removeFromDrawList(SimpleIdentity drawID)
+{
+    auto it = drawListPos.find(drawID);
+    if (it != drawListPos.end())
+    {
+        drawList[it->second].drawable = NULL;
+        drawListPos.erase(it);
+        drawListDirty = true;
+    }
+}
+
+void SceneRenderer::drawableSortKeysChanged(SimpleIdentity drawID)
+{
+    auto it = drawListPos.find(drawID);
+    if (it == drawListPos.end())
+        return;
+    
+    // It'll be sorted into its new place on the next frame
+    if (drawList[it->second].updateSortKeys())
+        drawListDirty = true;
+}
+
+void SceneRenderer::clearDrawList()
+{
+    drawList.clear();
+    drawListPos.clear();
+    drawListDirty = false;
+}
+
+void SceneRenderer::updateDrawList()
+{
+    if (zBufferMode != drawListZBufferMode)
+    {
+        drawListZBufferMode = zBufferMode;
+        drawListDirty = true;
+    }
+    if (!drawListDirty)
+        return;
+    drawListDirty = false;
+    
+    // Clear out the removed entries and put everything in render order
+    drawList.erase(std::remove_if(drawList.begin(),drawList.end(),
+                                  [](const DrawListEntry &entry) { return entry.drawable == NULL; }),
+                   drawList.end());
+    std::sort(drawList.begin(),drawList.end(),DrawListSortStruct(zBufferMode == zBufferOffDefault));
+    
+    for (unsigned int ii=0;ii<drawList.size();ii++)
+        drawListPos[drawList[ii].drawable->getId()] = ii;
+}
+
+int SceneRenderer::cullDrawList(RendererFrameInfo *frameInfo)
+{
+    frameStamp++;
+    
+    // Work through the available offset matrices (only 1 if we're not wrapping)
+    // Wrapped maps can have several and each one needs its own pass through the spatial index,
+    //  so we farm those out to a few worker threads.
+    const std::vector<Matrix4d> &offsetMats = frameInfo->offsetMatrices;
+    unsigned int numOffsets = std::min((unsigned int)offsetMats.size(),64u);
+    bool viewChanged = offsetInfo.size() != numOffsets;
+    offsetInfo.resize(numOffsets);
+    offsetCandidates.resize(numOffsets);
+    offsetChanged.resize(numOffsets);
+    if (numOffsets > 1 && !offsetPool)
+        offsetPool = WorkerPoolRef(new WorkerPool(WorkerPool::DefaultNumThreads(3)));
+    if (offsetPool)
+        offsetPool->parallelFor(numOffsets,[&](int off) {
+            setupOffset(off,offsetMats[off],frameInfo->modelTrans4d,frameInfo->viewTrans4d,frameInfo->projMat4d);
+        });
+    else
+        for (unsigned int off=0;off<numOffsets;off++)
+            setupOffset(off,offsetMats[off],frameInfo->modelTrans4d,frameInfo->viewTrans4d,frameInfo->projMat4d);
     
+    // Merge the candidates into the retained draw list
+    int numCandidates = 0;
+    for (unsigned int off=0;off<numOffsets;off++)
+    {
+        if (offsetChanged[off])
+            viewChanged = true;
+        std::vector<Drawable *> &candidateDrawables = offsetCandidates[off];
+        numCandidates += (int)candidateDrawables.size();
+        
+        // Mark the ones that are on in the retained draw list
+        for (Drawable *draw : candidateDrawables)
+        {
+            auto it = drawListPos.find(draw->getId());
+            if (it == drawListPos.end())
+                continue;
+            DrawListEntry &entry = drawList[it->second];
+            if (entry.frameStamp != frameStamp)
+            {
+                // On/off doesn't depend on the offset, so only check once a frame
+                entry.frameStamp = frameStamp;
+                entry.offsetMask = 0;
+                entry.isOn = draw->isOn(frameInfo);
+            }
+            if (entry.isOn)
+                entry.offsetMask |= (uint64_t)1 << off;
+        }
+    }
+    if (viewChanged)
+        viewVersion++;
+    
+    return numCandidates;
+}
+
+void SceneRenderer::setupOffset(unsigned int off,const Matrix4d &offsetMat,const Matrix4d &modelTrans4d,const Matrix4d &viewTrans4d,const Matrix4d &projMat4d)
+{
+    ProfileScope profScope(ProfOffsetCulling);
+    
+    // Tweak with the appropriate offset matrix
+    OffsetMatrices &offMats = offsetInfo[off];
+    Matrix4d offMvMat4d = viewTrans4d * offsetMat * modelTrans4d;
+    Matrix4d offPvMat4d = projMat4d * viewTrans4d * offsetMat;
+    Matrix4d offMvpMat4d = projMat4d * offMvMat4d;
+    offsetChanged[off] = offMvpMat4d != offMats.mvpMat4d || offMvMat4d != offMats.mvMat4d;
+    if (offsetChanged[off])
+    {
+        offMats.mvpMat4d = offMvpMat4d;
+        offMats.mvMat4d = offMvMat4d;
+        offMats.mvNormalMat4d = offMvMat4d.inverse().transpose();
+        offMats.pvMat4d = offPvMat4d;
+        offMats.mvpMat = Matrix4dToMatrix4f(offMvpMat4d);
+        offMats.mvpInvMat = Matrix4dToMatrix4f(offMvpMat4d.inverse());
+        offMats.mvMat = Matrix4dToMatrix4f(offMvMat4d);
+        offMats.mvNormalMat = Matrix4dToMatrix4f(offMats.mvNormalMat4d);
+    }
+
+    // Only consider the drawables that might overlap this view.
+    // The spatial index tests each drawable's MBR against this offset's frustum,
+    //  so offsets that can't see a given copy of the world don't pick it up.
+    std::vector<Drawable *> &candidateDrawables = offsetCandidates[off];
+    candidateDrawables.clear();
+    if (useDrawableCulling)
+        scene->findDrawablesInView(offMats.mvpMat4d,candidateDrawables);
+    else
+        for (auto it : scene->getDrawables())
+            candidateDrawables.push_back(it.second.get());
+}
+
+const SceneRenderer::DrawMatrices &SceneRenderer::matricesForEntry(DrawListEntry &entry,unsigned int off)
+{
+    const Matrix4d *localMat = entry.drawable->getMatrix();
+    if (!localMat)
+        return offsetInfo[off];
+    
+    // Only redo the matrix products if the view or the drawable's matrix changed
+    if (entry.matViewVersion != viewVersion || entry.localMats.size() != offsetInfo.size() || entry.localMat != *localMat)
+    {
+        entry.matViewVersion = viewVersion;
+        entry.localMat = *localMat;
+        entry.localMats.resize(offsetInfo.size());
+        for (unsigned int ii=0;ii<offsetInfo.size();ii++)
+        {
+            Matrix4d mvpMat = offsetInfo[ii].mvpMat4d * (*localMat);
+            Matrix4d mvMat = offsetInfo[ii].mvMat4d * (*localMat);
+            DrawMatrices &mats = entry.localMats[ii];
+            mats.mvpMat = Matrix4dToMatrix4f(mvpMat);
+            mats.mvpInvMat = Matrix4dToMatrix4f(mvpMat.inverse());
+            mats.mvMat = Matrix4dToMatrix4f(mvMat);
+            mats.mvNormalMat = Matrix4dToMatrix4f(mvMat.inverse().transpose());
+        }
+    }
+    
+    return entry.localMats[off];
+}
+
 }
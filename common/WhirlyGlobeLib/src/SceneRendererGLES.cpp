@@ -37,6 +37,24 @@ using namespace WhirlyKit;
 
 namespace WhirlyKit
 {
+
+// Names for the performance timer and profiler, interned once
+static const ProfileID ProfRenderFrame = Profiler::RegisterName("Render Frame");
+static const ProfileID ProfRenderSetup = Profiler::RegisterName("Render Setup");
+static const ProfileID ProfScenePreprocessing = Profiler::RegisterName("Scene preprocessing");
+static const ProfileID ProfPreprocessChanges = Profiler::RegisterName("Preprocess Changes");
+static const ProfileID ProfActiveModelRuns = Profiler::RegisterName("Active Model Runs");
+static const ProfileID ProfActiveModels = Profiler::RegisterName("Active Models");
+static const ProfileID ProfSceneChanges = Profiler::RegisterName("Scene changes");
+static const ProfileID ProfSceneProcessing = Profiler::RegisterName("Scene processing");
+static const ProfileID ProfChangeBacklog = Profiler::RegisterName("Change backlog");
+static const ProfileID ProfDrawListUpdate = Profiler::RegisterName("Draw List Update");
+static const ProfileID ProfCullingCandidates = Profiler::RegisterName("Culling Candidates");
+static const ProfileID ProfCalculationShaders = Profiler::RegisterName("Calculation Shaders");
+static const ProfileID ProfDrawExecution = Profiler::RegisterName("Draw Execution");
+static const ProfileID ProfDrawablesDrawn = Profiler::RegisterName("Drawables drawn");
+static const ProfileID ProfPresentRenderbuffer = Profiler::RegisterName("Present Renderbuffer");
+static const ProfileID ProfCulling = Profiler::RegisterName("Culling");
     
 RendererFrameInfoGLES::RendererFrameInfoGLES()
 : glesVersion(0)
@@ -123,6 +141,7 @@ void SceneRendererGLES::setScene(Scene *newScene)
 {
     SceneRenderer::setScene(newScene);
     SceneGLES *sceneGL = (SceneGLES *)newScene;
+    
     setupInfo.memManager = sceneGL->getMemManager();
 }
     
@@ -148,58 +167,22 @@ SceneRendererGLES::~SceneRendererGLES()
 {
 }
 
-// Keep track of a drawable and the MVP we're supposed to use with it
-class DrawableContainer
+void SceneRendererGLES::addDrawable(DrawableRef newDrawable)
 {
-public:
-    DrawableContainer(DrawableGLES *draw) : drawable(draw) { mvpMat = mvpMat.Identity(); mvMat = mvMat.Identity();  mvNormalMat = mvNormalMat.Identity(); }
-    DrawableContainer(DrawableGLES *draw,Matrix4d mvpMat,Matrix4d mvMat,Matrix4d mvNormalMat) : drawable(draw), mvpMat(mvpMat), mvMat(mvMat), mvNormalMat(mvNormalMat) { }
+    SceneRenderer::addDrawable(newDrawable);
     
-    DrawableGLES *drawable;
-    Matrix4d mvpMat,mvMat,mvNormalMat;
-};
+    // We can only draw our own drawables
+    if (dynamic_cast<DrawableGLES *>(newDrawable.get()))
+        addToDrawList(newDrawable.get());
+}
 
-// Alpha stuff goes at the end
-// Otherwise sort by draw priority
-class DrawListSortStruct2
+void SceneRendererGLES::removeDrawable(DrawableRef draw,bool teardown)
 {
-public:
-    DrawListSortStruct2(bool useZBuffer,RendererFrameInfo *frameInfo) : useZBuffer(useZBuffer), frameInfo(frameInfo)
-    {
-    }
-    DrawListSortStruct2() { }
-    DrawListSortStruct2(const DrawListSortStruct2 &that) : useZBuffer(that.useZBuffer), frameInfo(that.frameInfo)
-    {
-    }
-    DrawListSortStruct2 & operator = (const DrawListSortStruct2 &that)
-    {
-        useZBuffer= that.useZBuffer;
-        frameInfo = that.frameInfo;
-        return *this;
-    }
-    bool operator()(const DrawableContainer &conA, const DrawableContainer &conB)
-    {
-        Drawable *a = conA.drawable;
-        Drawable *b = conB.drawable;
-
-        if (a->getDrawPriority() == b->getDrawPriority())
-        {
-            if (useZBuffer)
-            {
-                bool bufferA = a->getRequestZBuffer();
-                bool bufferB = b->getRequestZBuffer();
-                if (bufferA != bufferB)
-                    return !bufferA;
-            }
-        }
-        
-        return a->getDrawPriority() < b->getDrawPriority();
-    }
-    
-    bool useZBuffer;
-    RendererFrameInfo *frameInfo;
-};
+    removeFromDrawList(draw->getId());
     
+    SceneRenderer::removeDrawable(draw,teardown);
+}
+
 void SceneRendererGLES::setExtraFrameMode(bool newMode)
 {
     extraFrameMode = newMode;
@@ -218,6 +201,8 @@ void SceneRendererGLES::render(TimeInterval duration)
         return;
     
     frameCount++;
+    Profiler::BeginFrame();
+    bool profiling = perfInterval > 0 || Profiler::IsEnabled();
         
     theView->animate();
     
@@ -225,11 +210,11 @@ void SceneRendererGLES::render(TimeInterval duration)
 
     lastDraw = now;
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Render Frame");
+    if (profiling)
+        perfTimer.startTiming(ProfRenderFrame);
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Render Setup");
+    if (profiling)
+        perfTimer.startTiming(ProfRenderSetup);
     
     //    if (!renderSetup)
     {
@@ -288,8 +273,8 @@ void SceneRendererGLES::render(TimeInterval duration)
         CheckGLError("SceneRendererES2: glEnable(GL_CULL_FACE)");
     }
     
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Render Setup");
+    if (profiling)
+        perfTimer.stopTiming(ProfRenderSetup);
     
     if (scene)
     {
@@ -318,6 +303,9 @@ void SceneRendererGLES::render(TimeInterval duration)
         Matrix4f pvMat4f = Matrix4dToMatrix4f(pvMat);
         baseFrameInfo.pvMat = pvMat4f;
         baseFrameInfo.pvMat4d = pvMat;
+        // Reuse the offset matrix storage from last frame
+        offsetMatStore.clear();
+        baseFrameInfo.offsetMatrices.swap(offsetMatStore);
         theView->getOffsetMatrices(baseFrameInfo.offsetMatrices, frameSize, overlapMarginX);
         Point2d screenSize = theView->screenSizeInDisplayCoords(frameSize);
         baseFrameInfo.screenSizeInDisplayCoords = screenSize;
@@ -338,20 +326,20 @@ void SceneRendererGLES::render(TimeInterval duration)
         baseFrameInfo.heightAboveSurface = theView->heightAboveSurface();
         baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
         
-        if (perfInterval > 0)
-            perfTimer.startTiming("Scene preprocessing");
+        if (profiling)
+            perfTimer.startTiming(ProfScenePreprocessing);
         
         // Run the preprocess for the changes.  These modify things the active models need.
         int numPreProcessChanges = scene->preProcessChanges(theView, this, now);
         
-        if (perfInterval > 0)
-            perfTimer.addCount("Preprocess Changes", numPreProcessChanges);
+        if (profiling)
+            perfTimer.addCount(ProfPreprocessChanges, numPreProcessChanges);
         
-        if (perfInterval > 0)
-            perfTimer.stopTiming("Scene preprocessing");
+        if (profiling)
+            perfTimer.stopTiming(ProfScenePreprocessing);
         
-        if (perfInterval > 0)
-            perfTimer.startTiming("Active Model Runs");
+        if (profiling)
+            perfTimer.startTiming(ProfActiveModelRuns);
         
         // Let the active models to their thing
         // That thing had better not take too long
@@ -359,89 +347,48 @@ void SceneRendererGLES::render(TimeInterval duration)
             activeModel->updateForFrame(&baseFrameInfo);
             // Note: We were setting the GL context here.  Do we need to?
         }
-        if (perfInterval > 0)
-            perfTimer.addCount("Active Models", (int)scene->activeModels.size());
+        if (profiling)
+            perfTimer.addCount(ProfActiveModels, (int)scene->activeModels.size());
         
-        if (perfInterval > 0)
-            perfTimer.stopTiming("Active Model Runs");
+        if (profiling)
+            perfTimer.stopTiming(ProfActiveModelRuns);
         
-        if (perfInterval > 0)
-            perfTimer.addCount("Scene changes", (int)scene->changeRequests.size());
+        if (profiling)
+            perfTimer.addCount(ProfSceneChanges, scene->getNumChangeRequests());
         
-        if (perfInterval > 0)
-            perfTimer.startTiming("Scene processing");
+        if (profiling)
+            perfTimer.startTiming(ProfSceneProcessing);
         
         // Merge any outstanding changes into the scenegraph
-        scene->processChanges(theView,this,now);
+        scene->processChanges(theView,this,now,changeBudget);
         
-        if (perfInterval > 0)
-            perfTimer.stopTiming("Scene processing");
+        if (profiling)
+            perfTimer.addCount(ProfChangeBacklog, scene->getChangeProcessingStats().backlog);
         
-        // Work through the available offset matrices (only 1 if we're not wrapping)
-        std::vector<Matrix4d> &offsetMats = baseFrameInfo.offsetMatrices;
-        // Turn these drawables in to a vector
-        std::vector<DrawableContainer> drawList;
-        std::vector<DrawableRef> screenDrawables;
-        std::vector<DrawableRef> generatedDrawables;
-        std::vector<Matrix4d> mvpMats;
-        std::vector<Matrix4d> mvpInvMats;
-        std::vector<Matrix4f> mvpMats4f;
-        std::vector<Matrix4f> mvpInvMats4f;
-        mvpMats.resize(offsetMats.size());
-        mvpInvMats.resize(offsetMats.size());
-        mvpMats4f.resize(offsetMats.size());
-        mvpInvMats4f.resize(offsetMats.size());
-        bool calcPassDone = false;
-        for (unsigned int off=0;off<offsetMats.size();off++)
+        if (profiling)
+            perfTimer.stopTiming(ProfSceneProcessing);
+        
+        // Put any new drawables into place.  Nothing to do if nothing changed.
+        if (profiling)
+            perfTimer.startTiming(ProfDrawListUpdate);
+        updateDrawList();
+        if (profiling)
+            perfTimer.stopTiming(ProfDrawListUpdate);
+        
+        // Work out what's visible in each of the offsets
+        if (profiling)
+            perfTimer.startTiming(ProfCulling);
+        int numCandidates = cullDrawList(&baseFrameInfo);
+        if (profiling)
         {
-            RendererFrameInfo offFrameInfo(baseFrameInfo);
-            // Tweak with the appropriate offset matrix
-            modelAndViewMat4d = viewTrans4d * offsetMats[off] * modelTrans4d;
-            pvMat = projMat4d * viewTrans4d * offsetMats[off];
-            modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
-            mvpMats[off] = projMat4d * modelAndViewMat4d;
-            mvpInvMats[off] = (Eigen::Matrix4d)mvpMats[off].inverse();
-            mvpMats4f[off] = Matrix4dToMatrix4f(mvpMats[off]);
-            mvpInvMats4f[off] = Matrix4dToMatrix4f(mvpInvMats[off]);
-            modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
-            modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
-            Matrix4d &thisMvpMat = mvpMats[off];
-            offFrameInfo.mvpMat = mvpMats4f[off];
-            offFrameInfo.mvpInvMat = mvpInvMats4f[off];
-            mvpNormalMat4f = Matrix4dToMatrix4f(mvpMats[off].inverse().transpose());
-            offFrameInfo.mvpNormalMat = mvpNormalMat4f;
-            offFrameInfo.viewModelNormalMat = modelAndViewNormalMat;
-            offFrameInfo.viewAndModelMat4d = modelAndViewMat4d;
-            offFrameInfo.viewAndModelMat = modelAndViewMat;
-            Matrix4f pvMat4f = Matrix4dToMatrix4f(pvMat);
-            offFrameInfo.pvMat = pvMat4f;
-            offFrameInfo.pvMat4d = pvMat;
-            
-            const DrawableRefSet &rawDrawables = scene->getDrawables();
-            for (auto it : rawDrawables)
-            {
-                DrawableGLESRef theDrawable = std::dynamic_pointer_cast<DrawableGLES>(it.second);
-                if (theDrawable->isOn(&offFrameInfo))
-                {
-                    const Matrix4d *localMat = theDrawable->getMatrix();
-                    if (localMat)
-                    {
-                        Eigen::Matrix4d newMvpMat = thisMvpMat * (*localMat);
-                        Eigen::Matrix4d newMvMat = modelAndViewMat4d * (*localMat);
-                        Eigen::Matrix4d newMvNormalMat = newMvMat.inverse().transpose();
-                        drawList.push_back(DrawableContainer(theDrawable.get(),newMvpMat,newMvMat,newMvNormalMat));
-                    } else
-                        drawList.push_back(DrawableContainer(theDrawable.get(),thisMvpMat,modelAndViewMat4d,modelAndViewNormalMat4d));
-                }
-            }
+            perfTimer.addCount(ProfCullingCandidates, numCandidates);
+            perfTimer.stopTiming(ProfCulling);
         }
         
-        // Sort the drawables (possibly multiple of the same if we have offset matrices)
-        bool sortLinesToEnd = (zBufferMode == zBufferOffDefault);
-        std::sort(drawList.begin(),drawList.end(),DrawListSortStruct2(sortLinesToEnd,&baseFrameInfo));
+        bool calcPassDone = false;
         
-        if (perfInterval > 0)
-            perfTimer.startTiming("Calculation Shaders");
+        if (profiling)
+            perfTimer.startTiming(ProfCalculationShaders);
         
         // Run any calculation shaders
         // These should be independent of screen space, so we only run them once and ignore offsets.
@@ -449,7 +396,7 @@ void SceneRendererGLES::render(TimeInterval duration)
             // But do we have any
             bool haveCalcShader = false;
             for (unsigned int ii=0;ii<drawList.size();ii++)
-                if (drawList[ii].drawable->getCalculationProgram() != EmptyIdentity) {
+                if (entryIsVisible(drawList[ii]) && drawList[ii].drawable->getCalculationProgram() != EmptyIdentity) {
                     haveCalcShader = true;
                     break;
                 }
@@ -462,7 +409,10 @@ void SceneRendererGLES::render(TimeInterval duration)
                 glEnable(GL_RASTERIZER_DISCARD);
                 
                 for (unsigned int ii=0;ii<drawList.size();ii++) {
-                    DrawableContainer &drawContain = drawList[ii];
+                    DrawListEntry &drawContain = drawList[ii];
+                    if (!entryIsVisible(drawContain))
+                        continue;
+                    DrawableGLES *drawGL = dynamic_cast<DrawableGLES *>(drawContain.drawable);
                     SimpleIdentity calcProgID = drawContain.drawable->getCalculationProgram();
                     
                     // Figure out the program to use for drawing
@@ -479,7 +429,7 @@ void SceneRendererGLES::render(TimeInterval duration)
                     drawContain.drawable->runTweakers(&baseFrameInfo);
                     
                     // Run the calculation phase
-                    drawContain.drawable->calculate(&baseFrameInfo,scene);
+                    drawGL->calculate(&baseFrameInfo,scene);
                 }
                 
                 glDisable(GL_RASTERIZER_DISCARD);
@@ -488,11 +438,11 @@ void SceneRendererGLES::render(TimeInterval duration)
             calcPassDone = true;
         }
         
-        if (perfInterval > 0)
-            perfTimer.stopTiming("Calculation Shaders");
+        if (profiling)
+            perfTimer.stopTiming(ProfCalculationShaders);
         
-        if (perfInterval > 0)
-            perfTimer.startTiming("Draw Execution");
+        if (profiling)
+            perfTimer.startTiming(ProfDrawExecution);
         
         SimpleIdentity curProgramId = EmptyIdentity;
         
@@ -513,8 +463,15 @@ void SceneRendererGLES::render(TimeInterval duration)
             bool depthMaskOn = (zBufferMode == zBufferOn);
             for (unsigned int ii=0;ii<drawList.size();ii++)
             {
-                DrawableContainer &drawContain = drawList[ii];
-                                
+                DrawListEntry &drawContain = drawList[ii];
+                if (!entryIsVisible(drawContain))
+                    continue;
+                DrawableGLES *drawGL = dynamic_cast<DrawableGLES *>(drawContain.drawable);
+                
+                // Only draw drawables that are active for the current render target
+                if (drawContain.drawable->getRenderTarget() != renderTarget->getId())
+                    continue;
+                
                 // For this mode we turn the z buffer off until we get a request to turn it on
                 if (zBufferMode == zBufferOffDefault)
                 {
@@ -536,72 +493,65 @@ void SceneRendererGLES::render(TimeInterval duration)
                         glDepthMask(GL_FALSE);
                 }
                 
-                // Set up transforms to use right now
-                Matrix4f currentMvpMat = Matrix4dToMatrix4f(drawContain.mvpMat);
-                Matrix4f currentMvpInvMat = Matrix4dToMatrix4f(drawContain.mvpMat.inverse());
-                Matrix4f currentMvMat = Matrix4dToMatrix4f(drawContain.mvMat);
-                Matrix4f currentMvNormalMat = Matrix4dToMatrix4f(drawContain.mvNormalMat);
-                baseFrameInfo.mvpMat = currentMvpMat;
-                baseFrameInfo.mvpInvMat = currentMvpInvMat;
-                baseFrameInfo.viewAndModelMat = currentMvMat;
-                baseFrameInfo.viewModelNormalMat = currentMvNormalMat;
-                
                 // Figure out the program to use for drawing
                 SimpleIdentity drawProgramId = drawContain.drawable->getProgram();
                 if (drawProgramId == EmptyIdentity) {
                     wkLogLevel(Error, "Drawable missing program ID.  Skipping.");
                     continue;
                 }
-                if (drawProgramId != curProgramId)
+                
+                // Draw once for each offset it showed up in
+                for (unsigned int off=0;off<offsetInfo.size() && off<64;off++)
                 {
-                    curProgramId = drawProgramId;
-                    ProgramGLES *program = (ProgramGLES *)scene->getProgram(drawProgramId);
-                    if (program)
-                    {
-                        //                    [renderStateOptimizer setUseProgram:program->getProgram()];
-                        glUseProgram(program->getProgram());
-                        // Assign the lights if we need to
-                        if (program->hasLights() && (lights.size() > 0))
-                            program->setLights(lights, lightsLastUpdated, &defaultMat, currentMvpMat);
-                        // Explicitly turn the lights on
-                        program->setUniform(u_numLightsNameID, (int)lights.size());
-                        
-                        baseFrameInfo.program = program;
-                    } else {
-                        wkLogLevel(Error, "Missing OpenGL ES Program.");
+                    if (!(drawContain.offsetMask & ((uint64_t)1 << off)))
                         continue;
+                    
+                    // Set up transforms to use right now
+                    const DrawMatrices &mats = matricesForEntry(drawContain,off);
+                    baseFrameInfo.mvpMat = mats.mvpMat;
+                    baseFrameInfo.mvpInvMat = mats.mvpInvMat;
+                    baseFrameInfo.viewAndModelMat = mats.mvMat;
+                    baseFrameInfo.viewModelNormalMat = mats.mvNormalMat;
+                    
+                    if (drawProgramId != curProgramId)
+                    {
+                        ProgramGLES *program = (ProgramGLES *)scene->getProgram(drawProgramId);
+                        if (program)
+                        {
+                            curProgramId = drawProgramId;
+                            glUseProgram(program->getProgram());
+                            // Assign the lights if we need to
+                            if (program->hasLights() && (lights.size() > 0))
+                                program->setLights(lights, lightsLastUpdated, &defaultMat, baseFrameInfo.mvpMat);
+                            // Explicitly turn the lights on
+                            program->setUniform(u_numLightsNameID, (int)lights.size());
+                            
+                            baseFrameInfo.program = program;
+                        } else {
+                            wkLogLevel(Error, "Missing OpenGL ES Program.");
+                            break;
+                        }
                     }
+                    
+                    // Run any tweakers right here
+                    drawContain.drawable->runTweakers(&baseFrameInfo);
+                    
+                    // Draw using the given program
+                    drawGL->draw(&baseFrameInfo,scene);
+                    
+                    numDrawables++;
                 }
-                if (drawProgramId == EmptyIdentity)
-                    continue;
-                
-                // Only draw drawables that are active for the current render target
-                if (drawContain.drawable->getRenderTarget() != renderTarget->getId())
-                    continue;
-                
-                // Run any tweakers right here
-                drawContain.drawable->runTweakers(&baseFrameInfo);
-                
-                // Draw using the given program
-                drawContain.drawable->draw(&baseFrameInfo,scene);
-                
-                // If we had a local matrix, set the frame info back to the general one
-                //            if (localMat)
-                //                offFrameInfo.mvpMat = mvpMat;
-                
-                numDrawables++;
             }
         }
         
-        if (perfInterval > 0)
-            perfTimer.addCount("Drawables drawn", numDrawables);
+        if (profiling)
+            perfTimer.addCount(ProfDrawablesDrawn, numDrawables);
         
-        if (perfInterval > 0)
-            perfTimer.stopTiming("Draw Execution");
+        if (profiling)
+            perfTimer.stopTiming(ProfDrawExecution);
         
-        // Anything generated needs to be cleaned up
-        generatedDrawables.clear();
-        drawList.clear();
+        // Hang on to the offset matrix storage for next frame
+        offsetMatStore.swap(baseFrameInfo.offsetMatrices);
     }
     
     //    if (perfInterval > 0)
@@ -613,8 +563,8 @@ void SceneRendererGLES::render(TimeInterval duration)
     //    if (perfInterval > 0)
     //        perfTimer.stopTiming("glFinish");
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Present Renderbuffer");
+    if (profiling)
+        perfTimer.startTiming(ProfPresentRenderbuffer);
 
 #ifndef __ANDROID__
     // Explicitly discard the depth buffer
@@ -629,11 +579,11 @@ void SceneRendererGLES::render(TimeInterval duration)
     // Snapshots tend to be platform specific
     snapshotCallback(now);
     
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Present Renderbuffer");
+    if (profiling)
+        perfTimer.stopTiming(ProfPresentRenderbuffer);
     
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Render Frame");
+    if (profiling)
+        perfTimer.stopTiming(ProfRenderFrame);
     
     // Update the frames per sec
     if (perfInterval > 0 && frameCount > perfInterval)
@@ -707,5 +657,15 @@ DynamicTextureRef SceneRendererGLES::makeDynamicTexture(const std::string &name)
     return DynamicTextureRef(new DynamicTextureGLES(name));
 }
 
+TextureRef SceneRendererGLES::makeTexture(const std::string &name) const
+{
+    return TextureRef(new TextureGLES(name));
+}
+
+SharedTrianglesRef SceneRendererGLES::makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const
+{
+    return SharedTrianglesRef(new SharedTrianglesGLES(tris));
+}
+
 }
 
@@ -0,0 +1,359 @@
+/*
+ *  SceneRendererHeadless.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "SceneRendererHeadless.h"
+#import "MaplyView.h"
+#import "Profiler.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+// Names for the performance timer and profiler, interned once
+static const ProfileID ProfRenderFrame = Profiler::RegisterName("Render Frame");
+static const ProfileID ProfScenePreprocessing = Profiler::RegisterName("Scene preprocessing");
+static const ProfileID ProfActiveModelRuns = Profiler::RegisterName("Active Model Runs");
+static const ProfileID ProfSceneProcessing = Profiler::RegisterName("Scene processing");
+static const ProfileID ProfCulling = Profiler::RegisterName("Culling");
+static const ProfileID ProfCullingCandidates = Profiler::RegisterName("Culling Candidates");
+static const ProfileID ProfSorting = Profiler::RegisterName("Sorting");
+static const ProfileID ProfDrawExecution = Profiler::RegisterName("Draw Execution");
+static const ProfileID ProfDrawablesDrawn = Profiler::RegisterName("Drawables drawn");
+
+SceneHeadless::SceneHeadless(CoordSystemDisplayAdapter *adapter)
+: Scene(adapter)
+{
+}
+
+void SceneHeadless::teardown()
+{
+    for (auto it : drawables)
+        it.second->teardownForRenderer(setupInfo,this);
+    drawables.clear();
+    for (auto it : textures)
+        it.second->destroyInRenderer(setupInfo,this);
+    textures.clear();
+}
+
+RenderTargetHeadless::RenderTargetHeadless()
+: targetTexID(EmptyIdentity)
+{
+}
+
+RenderTargetHeadless::RenderTargetHeadless(SimpleIdentity newID)
+: RenderTarget(newID), targetTexID(EmptyIdentity)
+{
+}
+
+bool RenderTargetHeadless::init(SceneRenderer *renderer,Scene *scene,SimpleIdentity inTargetTexID)
+{
+    targetTexID = inTargetTexID;
+    isSetup = true;
+
+    return true;
+}
+
+bool RenderTargetHeadless::setTargetTexture(SceneRenderer *renderer,Scene *scene,SimpleIdentity newTargetTexID)
+{
+    targetTexID = newTargetTexID;
+
+    return true;
+}
+
+void RenderTargetHeadless::setClearColor(const RGBAColor &color)
+{
+    color.asUnitFloats(clearColor);
+}
+
+void RenderTargetHeadless::clear()
+{
+    isSetup = false;
+}
+
+HeadlessFrameStats::HeadlessFrameStats()
+: numChanges(0), numActiveModels(0), numOffsets(0), numCandidates(0), numCommands(0),
+  numProgramChanges(0), numTextureChanges(0)
+{
+}
+
+SceneRendererHeadless::SceneRendererHeadless(int width,int height)
+{
+    init();
+    framebufferWidth = width;
+    framebufferHeight = height;
+
+    RenderTargetRef defaultTarget(new RenderTargetHeadless(EmptyIdentity));
+    defaultTarget->width = width;
+    defaultTarget->height = height;
+    defaultTarget->clearEveryFrame = true;
+    defaultTarget->blendEnable = true;
+    renderTargets.push_back(defaultTarget);
+}
+
+SceneRendererHeadless::~SceneRendererHeadless()
+{
+}
+
+SceneRenderer::Type SceneRendererHeadless::getType()
+{
+    return SceneRenderer::RenderHeadless;
+}
+
+const RenderSetupInfo *SceneRendererHeadless::getRenderSetupInfo() const
+{
+    return &setupInfo;
+}
+
+void SceneRendererHeadless::addDrawable(DrawableRef newDrawable)
+{
+    SceneRenderer::addDrawable(newDrawable);
+
+    addToDrawList(newDrawable.get());
+}
+
+void SceneRendererHeadless::removeDrawable(DrawableRef draw,bool teardown)
+{
+    removeFromDrawList(draw->getId());
+
+    SceneRenderer::removeDrawable(draw,teardown);
+}
+
+void SceneRendererHeadless::render(TimeInterval duration)
+{
+    if (!scene || !theView)
+        return;
+
+    frameCount++;
+    Profiler::BeginFrame();
+    bool profiling = perfInterval > 0 || Profiler::IsEnabled();
+    frameStats = HeadlessFrameStats();
+
+    theView->animate();
+
+    TimeInterval now = scene->getCurrentTime();
+    lastDraw = now;
+
+    if (profiling)
+        perfTimer.startTiming(ProfRenderFrame);
+
+    // See if we're dealing with a globe or map view
+    Maply::MapView *mapView = dynamic_cast<Maply::MapView *>(theView);
+    float overlapMarginX = 0.0;
+    if (mapView)
+        overlapMarginX = scene->getOverlapMargin();
+
+    // Get the model, view and projection matrices
+    Matrix4d modelTrans4d = theView->calcModelMatrix();
+    Matrix4d viewTrans4d = theView->calcViewMatrix();
+    Point2f frameSize(framebufferWidth,framebufferHeight);
+    Matrix4d projMat4d = theView->calcProjectionMatrix(frameSize,0.0);
+    Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
+    Matrix4d pvMat4d = projMat4d * viewTrans4d;
+    Matrix4d mvpMat4d = projMat4d * modelAndViewMat4d;
+
+    RendererFrameInfo baseFrameInfo;
+    baseFrameInfo.sceneRenderer = this;
+    baseFrameInfo.theView = theView;
+    baseFrameInfo.viewTrans = Matrix4dToMatrix4f(viewTrans4d);
+    baseFrameInfo.viewTrans4d = viewTrans4d;
+    baseFrameInfo.modelTrans = Matrix4dToMatrix4f(modelTrans4d);
+    baseFrameInfo.modelTrans4d = modelTrans4d;
+    baseFrameInfo.scene = scene;
+    baseFrameInfo.frameLen = duration;
+    baseFrameInfo.currentTime = now;
+    baseFrameInfo.projMat = Matrix4dToMatrix4f(projMat4d);
+    baseFrameInfo.projMat4d = projMat4d;
+    baseFrameInfo.mvpMat = Matrix4dToMatrix4f(mvpMat4d);
+    baseFrameInfo.mvpInvMat = Matrix4dToMatrix4f(mvpMat4d.inverse());
+    baseFrameInfo.mvpNormalMat = Matrix4dToMatrix4f(mvpMat4d.inverse().transpose());
+    baseFrameInfo.viewModelNormalMat = Matrix4dToMatrix4f(modelAndViewMat4d.inverse().transpose());
+    baseFrameInfo.viewAndModelMat = Matrix4dToMatrix4f(modelAndViewMat4d);
+    baseFrameInfo.viewAndModelMat4d = modelAndViewMat4d;
+    baseFrameInfo.pvMat = Matrix4dToMatrix4f(pvMat4d);
+    baseFrameInfo.pvMat4d = pvMat4d;
+    theView->getOffsetMatrices(baseFrameInfo.offsetMatrices, frameSize, overlapMarginX);
+    baseFrameInfo.screenSizeInDisplayCoords = theView->screenSizeInDisplayCoords(frameSize);
+    baseFrameInfo.lights = &lights;
+    Matrix4f modelTransInv = baseFrameInfo.modelTrans.inverse();
+    Vector4f eyeVec4 = modelTransInv * Vector4f(0,0,1,0);
+    baseFrameInfo.eyeVec = Vector3f(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
+    Vector4f fullEyeVec4 = baseFrameInfo.viewAndModelMat.inverse() * Vector4f(0,0,1,0);
+    baseFrameInfo.fullEyeVec = -Vector3f(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
+    Vector4d eyeVec4d = modelTrans4d.inverse() * Vector4d(0,0,1,0.0);
+    baseFrameInfo.heightAboveSurface = theView->heightAboveSurface();
+    baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
+
+    // Changes and active models, same as the real renderers
+    if (profiling)
+        perfTimer.startTiming(ProfScenePreprocessing);
+    scene->preProcessChanges(theView, this, now);
+    if (profiling)
+        perfTimer.stopTiming(ProfScenePreprocessing);
+
+    if (profiling)
+        perfTimer.startTiming(ProfActiveModelRuns);
+    for (auto activeModel : scene->activeModels)
+        activeModel->updateForFrame(&baseFrameInfo);
+    frameStats.numActiveModels = (int)scene->activeModels.size();
+    if (profiling)
+        perfTimer.stopTiming(ProfActiveModelRuns);
+
+    if (profiling)
+        perfTimer.startTiming(ProfSceneProcessing);
+    frameStats.numChanges = scene->processChanges(theView,this,now,changeBudget);
+    if (profiling)
+        perfTimer.stopTiming(ProfSceneProcessing);
+
+    // Put any new drawables into place, same as the GLES renderer
+    if (profiling)
+        perfTimer.startTiming(ProfSorting);
+    updateDrawList();
+    if (profiling)
+        perfTimer.stopTiming(ProfSorting);
+
+    // Figure out what's visible in each of the offsets
+    if (profiling)
+        perfTimer.startTiming(ProfCulling);
+    frameStats.numCandidates = cullDrawList(&baseFrameInfo);
+    frameStats.numOffsets = (int)offsetInfo.size();
+    if (profiling)
+    {
+        perfTimer.addCount(ProfCullingCandidates, frameStats.numCandidates);
+        perfTimer.stopTiming(ProfCulling);
+    }
+
+    // Record what we would have drawn, render target by render target
+    if (profiling)
+        perfTimer.startTiming(ProfDrawExecution);
+    commands.clear();
+    for (auto renderTarget : renderTargets)
+    {
+        SimpleIdentity lastProgramID = EmptyIdentity,lastTexID = EmptyIdentity;
+        for (DrawListEntry &entry : drawList)
+        {
+            if (!entryIsVisible(entry))
+                continue;
+            Drawable *draw = entry.drawable;
+            if (draw->getRenderTarget() != renderTarget->getId())
+                continue;
+
+            // Tweakers are the only per-draw CPU work the real renderers do
+            draw->runTweakers(&baseFrameInfo);
+
+            int numPoints = 0,numTris = 0;
+            BasicDrawableHeadless *basicDraw = dynamic_cast<BasicDrawableHeadless *>(draw);
+            if (basicDraw)
+            {
+                numPoints = basicDraw->getNumPoints();
+                numTris = basicDraw->getNumTris();
+            }
+
+            for (unsigned int off=0;off<offsetInfo.size();off++)
+            {
+                if (!(entry.offsetMask & ((uint64_t)1 << off)))
+                    continue;
+
+                HeadlessDrawCommand cmd;
+                cmd.drawID = draw->getId();
+                cmd.programID = entry.programID;
+                cmd.texID = entry.texID;
+                cmd.renderTargetID = renderTarget->getId();
+                cmd.drawPriority = entry.drawPriority;
+                cmd.offset = off;
+                cmd.numPoints = numPoints;
+                cmd.numTris = numTris;
+                if (cmd.programID != lastProgramID)
+                    frameStats.numProgramChanges++;
+                if (cmd.texID != lastTexID)
+                    frameStats.numTextureChanges++;
+                lastProgramID = cmd.programID;
+                lastTexID = cmd.texID;
+                commands.push_back(cmd);
+            }
+        }
+    }
+    frameStats.numCommands = (int)commands.size();
+    numDrawables = frameStats.numCommands;
+    if (profiling)
+    {
+        perfTimer.addCount(ProfDrawablesDrawn, numDrawables);
+        perfTimer.stopTiming(ProfDrawExecution);
+        perfTimer.stopTiming(ProfRenderFrame);
+    }
+
+    if (perfInterval > 0 && frameCount > (unsigned int)perfInterval)
+    {
+        frameCount = 0;
+        perfTimer.log();
+        perfTimer.clear();
+    }
+}
+
+BasicDrawableBuilderRef SceneRendererHeadless::makeBasicDrawableBuilder(const std::string &name) const
+{
+    return BasicDrawableBuilderRef(new BasicDrawableBuilderHeadless(name));
+}
+
+BasicDrawableInstanceBuilderRef SceneRendererHeadless::makeBasicDrawableInstanceBuilder(const std::string &name) const
+{
+    return BasicDrawableInstanceBuilderRef(new BasicDrawableInstanceBuilderHeadless(name));
+}
+
+BillboardDrawableBuilderRef SceneRendererHeadless::makeBillboardDrawableBuilder(const std::string &name) const
+{
+    return BillboardDrawableBuilderRef(new BillboardDrawableBuilderHeadless(name));
+}
+
+ScreenSpaceDrawableBuilderRef SceneRendererHeadless::makeScreenSpaceDrawableBuilder(const std::string &name) const
+{
+    return ScreenSpaceDrawableBuilderRef(new ScreenSpaceDrawableBuilderHeadless(name));
+}
+
+ParticleSystemDrawableBuilderRef SceneRendererHeadless::makeParticleSystemDrawableBuilder(const std::string &name) const
+{
+    return ParticleSystemDrawableBuilderRef(new ParticleSystemDrawableBuilderHeadless(name));
+}
+
+WideVectorDrawableBuilderRef SceneRendererHeadless::makeWideVectorDrawableBuilder(const std::string &name) const
+{
+    return WideVectorDrawableBuilderRef(new WideVectorDrawableBuilderHeadless(name));
+}
+
+RenderTargetRef SceneRendererHeadless::makeRenderTarget() const
+{
+    return RenderTargetRef(new RenderTargetHeadless());
+}
+
+DynamicTextureRef SceneRendererHeadless::makeDynamicTexture(const std::string &name) const
+{
+    return DynamicTextureRef(new DynamicTextureHeadless(name));
+}
+
+TextureRef SceneRendererHeadless::makeTexture(const std::string &name) const
+{
+    return TextureRef(new TextureHeadless(name));
+}
+
+SharedTrianglesRef SceneRendererHeadless::makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const
+{
+    return SharedTrianglesRef(new SharedTriangles(tris));
+}
+
+}
@@ -54,15 +54,16 @@ int calcNumSamples(const Point3d &p0,const Point3d &p1,CoordSystem *srcSystem,Co
 }
 
 DisplaySolid::DisplaySolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMbr,float minZ,float maxZ,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter)
-    : valid(false)
+    : valid(false), minZ(minZ), maxZ(maxZ)
 {
-    // Start with the corner points in the source
+    // Start with the corner points in the source.
+    // The surface sits at the top of the height range, since that's what faces the viewer.
     WhirlyKit::CoordSystem *displaySystem = coordAdapter->getCoordSystem();
     Point3dVector srcBounds;
-    srcBounds.push_back(Point3d(nodeMbr.ll().x(),nodeMbr.ll().y(),minZ));
-    srcBounds.push_back(Point3d(nodeMbr.ur().x(),nodeMbr.ll().y(),minZ));
-    srcBounds.push_back(Point3d(nodeMbr.ur().x(),nodeMbr.ur().y(),minZ));
-    srcBounds.push_back(Point3d(nodeMbr.ll().x(),nodeMbr.ur().y(),minZ));
+    srcBounds.push_back(Point3d(nodeMbr.ll().x(),nodeMbr.ll().y(),maxZ));
+    srcBounds.push_back(Point3d(nodeMbr.ur().x(),nodeMbr.ll().y(),maxZ));
+    srcBounds.push_back(Point3d(nodeMbr.ur().x(),nodeMbr.ur().y(),maxZ));
+    srcBounds.push_back(Point3d(nodeMbr.ll().x(),nodeMbr.ur().y(),maxZ));
 
     // Number of samples in X and Y we need for a decent surface
     int numSamplesX = std::max(calcNumSamples(srcBounds[0],srcBounds[1],srcSystem,coordAdapter,nodeIdent.level),
@@ -86,18 +87,24 @@ DisplaySolid::DisplaySolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMb
         }
     }
     
+    // Keep the samples in one block so we can project them all at once
+    dispPts.resize(4,dispPoints.size());
+    for (unsigned int ii=0;ii<dispPoints.size();ii++)
+        dispPts.col(ii) = Vector4d(dispPoints[ii].x(),dispPoints[ii].y(),dispPoints[ii].z(),1.0);
+    
     // Build polygons out of those samples (in display space)
     polys.reserve(numSamplesX*numSamplesY);
+    polyIndices.reserve(numSamplesX*numSamplesY);
     for (int ix=0;ix<numSamplesX-1;ix++) {
         for (int iy=0;iy<numSamplesY-1;iy++) {
             // Surface polygon
+            std::vector<int> indices = {iy*numSamplesX+ix, (iy+1)*numSamplesX+ix, (iy+1)*numSamplesX+(ix+1), iy*numSamplesX+(ix+1)};
             Point3dVector poly;
             poly.reserve(4);
-            poly.push_back(dispPoints[iy*numSamplesX+ix]);
-            poly.push_back(dispPoints[(iy+1)*numSamplesX+ix]);
-            poly.push_back(dispPoints[(iy+1)*numSamplesX+(ix+1)]);
-            poly.push_back(dispPoints[iy*numSamplesX+(ix+1)]);
+            for (int idx : indices)
+                poly.push_back(dispPoints[idx]);
             polys.push_back(poly);
+            polyIndices.push_back(indices);
             
             // And a normal
             if (coordAdapter->isFlat())
@@ -116,78 +123,65 @@ DisplaySolid::DisplaySolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMb
     valid = true;
 }
 
-double PolyImportance(const Point3dVector &poly,const Point3d &norm,ViewState *viewState,const WhirlyKit::Point2f &frameSize)
+// Importance for a single polygon that's already been projected into clip space
+double PolyImportance(const Point3dVector &poly,const Vector4dVector &pts,const Point3d &norm,ViewState *viewState,int offi,const WhirlyKit::Point2f &frameSize)
 {
-    double import = 0.0;
+    double origArea = PolygonArea(poly,norm);
+    origArea = std::abs(origArea);
     
-    for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+    // The points are in clip space, so clip!
+    Vector4dVector clipSpacePts;
+    clipSpacePts.reserve(2*pts.size());
+    ClipHomogeneousPolygon(pts,clipSpacePts);
+    
+    // Outside the viewing frustum, so ignore it
+    if (clipSpacePts.empty())
+        return 0.0;
+    
+    // Project to the screen
+    Point2dVector screenPts;
+    screenPts.reserve(clipSpacePts.size());
+    Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
+    for (unsigned int ii=0;ii<clipSpacePts.size();ii++)
     {
-        double origArea = PolygonArea(poly,norm);
-        origArea = std::abs(origArea);
-        
-        Vector4dVector pts;
-        pts.reserve(poly.size());
-        for (unsigned int ii=0;ii<poly.size();ii++)
-        {
-            const Point3d &pt = poly[ii];
-            // Run through the model transform
-            Vector4d modPt = viewState->fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-            // And then the projection matrix.  Now we're in clip space
-            Vector4d projPt = viewState->projMatrix * modPt;
-            pts.push_back(projPt);
-        }
-        
-        // The points are in clip space, so clip!
-        Vector4dVector clipSpacePts;
-        clipSpacePts.reserve(2*pts.size());
-        ClipHomogeneousPolygon(pts,clipSpacePts);
-        
-        // Outside the viewing frustum, so ignore it
-        if (clipSpacePts.empty())
-            continue;
-        
-        // Project to the screen
-        Point2dVector screenPts;
-        screenPts.reserve(clipSpacePts.size());
-        Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
-        for (unsigned int ii=0;ii<clipSpacePts.size();ii++)
-        {
-            Vector4d &outPt = clipSpacePts[ii];
-            Point2d screenPt(outPt.x()/outPt.w() * halfFrameSize.x()+halfFrameSize.x(),outPt.y()/outPt.w() * halfFrameSize.y()+halfFrameSize.y());
-            screenPts.push_back(screenPt);
-        }
-        
-        double screenArea = CalcLoopArea(screenPts);
-        if (std::isnan(screenArea))
-            screenArea = 0.0;
-        // The polygon came out backwards, so toss it
-        if (screenArea <= 0.0)
-            continue;
-        
-        // Now project the screen points back into model space
-        Point3dVector backPts;
-        backPts.reserve(screenPts.size());
-        for (unsigned int ii=0;ii<screenPts.size();ii++)
-        {
-            Vector4d modelPt = viewState->invProjMatrix * clipSpacePts[ii];
-            Vector4d backPt = viewState->invFullMatrices[offi] * modelPt;
-            backPts.push_back(Point3d(backPt.x(),backPt.y(),backPt.z()));
-        }
-        // Then calculate the area
-        double backArea = PolygonArea(backPts,norm);
-        backArea = std::abs(backArea);
-        
-        // Now we know how much of the original polygon made it out to the screen
-        // We can scale its importance accordingly.
-        // This gets rid of small slices of big tiles not getting loaded
-        double scale = (backArea == 0.0) ? 1.0 : origArea / backArea;
-
-        double newImport =  std::abs(screenArea) * scale;
-        if (newImport > import)
-            import = newImport;
+        Vector4d &outPt = clipSpacePts[ii];
+        Point2d screenPt(outPt.x()/outPt.w() * halfFrameSize.x()+halfFrameSize.x(),outPt.y()/outPt.w() * halfFrameSize.y()+halfFrameSize.y());
+        screenPts.push_back(screenPt);
     }
     
-    return import;
+    double screenArea = CalcLoopArea(screenPts);
+    if (std::isnan(screenArea))
+        screenArea = 0.0;
+    // The polygon came out backwards, so toss it
+    if (screenArea <= 0.0)
+        return 0.0;
+    
+    // Now project the screen points back into model space
+    Point3dVector backPts;
+    backPts.reserve(screenPts.size());
+    for (unsigned int ii=0;ii<screenPts.size();ii++)
+    {
+        Vector4d modelPt = viewState->invProjMatrix * clipSpacePts[ii];
+        Vector4d backPt = viewState->invFullMatrices[offi] * modelPt;
+        backPts.push_back(Point3d(backPt.x(),backPt.y(),backPt.z()));
+    }
+    // Then calculate the area
+    double backArea = PolygonArea(backPts,norm);
+    backArea = std::abs(backArea);
+    
+    // Now we know how much of the original polygon made it out to the screen
+    // We can scale its importance accordingly.
+    // This gets rid of small slices of big tiles not getting loaded
+    double scale = (backArea == 0.0) ? 1.0 : origArea / backArea;
+
+    return std::abs(screenArea) * scale;
+}
+
+void DisplaySolid::projectPoints(ViewState *viewState,int offi,Eigen::Matrix<double,4,Eigen::Dynamic> &clipPts)
+{
+    // Model and projection matrices together, then all the points in one go
+    const Matrix4d mat = viewState->projMatrix * viewState->fullMatrices[offi];
+    clipPts.noalias() = mat * dispPts;
 }
 
 bool DisplaySolid::isInside(const Point3d &pt)
@@ -208,15 +202,39 @@ double DisplaySolid::importanceForViewState(ViewState *viewState,const Point2f &
             return MAXFLOAT;
     }
     
-    // Now work through the polygons and project each to the screen
-    double totalImport = 0.0;
+    // Only the polygons facing us count
+    std::vector<bool> facing(polys.size());
+    bool anyFacing = false;
     for (unsigned int ii=0;ii<polys.size();ii++)
     {
-        if (normals[ii].dot(eyePos) >= 0.0) {
-            double import = PolyImportance(polys[ii], normals[ii], viewState, frameSize);
-            totalImport += import;
+        facing[ii] = normals[ii].dot(eyePos) >= 0.0;
+        anyFacing |= facing[ii];
+    }
+    if (!anyFacing)
+        return 0.0;
+    
+    // Project the samples to the screen and work through the polygons
+    // Each polygon takes its biggest importance over all the view matrices
+    std::vector<double> polyImport(polys.size(),0.0);
+    Eigen::Matrix<double,4,Eigen::Dynamic> clipPts;
+    Vector4dVector pts;
+    for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+    {
+        projectPoints(viewState,offi,clipPts);
+        for (unsigned int ii=0;ii<polys.size();ii++)
+        {
+            if (!facing[ii])
+                continue;
+            pts.clear();
+            for (int idx : polyIndices[ii])
+                pts.push_back(clipPts.col(idx));
+            double import = PolyImportance(polys[ii], pts, normals[ii], viewState, offi, frameSize);
+            polyImport[ii] = std::max(polyImport[ii],import);
         }
     }
+    double totalImport = 0.0;
+    for (double import : polyImport)
+        totalImport += import;
     
     // The flat map case is optimized to only evaluate one poly, since there's no curvature
     double scaleFactor = (polys.size() > 1 ? 0.5 : 1.0);
@@ -233,25 +251,16 @@ bool DisplaySolid::isOnScreenForViewState(ViewState *viewState,const Point2f &fr
             return MAXFLOAT;
     }
     
+    Eigen::Matrix<double,4,Eigen::Dynamic> clipPts;
+    Vector4dVector pts;
     for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
     {
+        projectPoints(viewState,offi,clipPts);
         for (unsigned int ii=0;ii<polys.size();ii++)
         {
-            const Point3dVector &poly = polys[ii];
-            double origArea = PolygonArea(poly,normals[ii]);
-            origArea = std::abs(origArea);
-            
-            Vector4dVector pts;
-            pts.reserve(poly.size());
-            for (unsigned int ii=0;ii<poly.size();ii++)
-            {
-                const Point3d &pt = poly[ii];
-                // Run through the model transform
-                Vector4d modPt = viewState->fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-                // And then the projection matrix.  Now we're in clip space
-                Vector4d projPt = viewState->projMatrix * modPt;
-                pts.push_back(projPt);
-            }
+            pts.clear();
+            for (int idx : polyIndices[ii])
+                pts.push_back(clipPts.col(idx));
             
             // The points are in clip space, so clip!
             Vector4dVector clipSpacePts;
@@ -318,4 +327,134 @@ double ScreenImportance(ViewState *viewState,const WhirlyKit::Point2f &frameSize
     return import;
 }
     
+DisplaySolidCache::DisplaySolidCache(int maxEntries)
+    : maxEntries(maxEntries), numHits(0), numMisses(0)
+{
+}
+
+DisplaySolidCache::~DisplaySolidCache()
+{
+}
+
+bool DisplaySolidCache::Key::operator == (const Key &that) const
+{
+    return srcSystem == that.srcSystem && coordAdapter == that.coordAdapter &&
+        x == that.x && y == that.y && level == that.level &&
+        minZ == that.minZ && maxZ == that.maxZ &&
+        ll == that.ll && ur == that.ur;
+}
+
+size_t DisplaySolidCache::KeyHash::operator () (const Key &key) const
+{
+    size_t hash = std::hash<void *>()(key.srcSystem);
+    const auto combine = [&hash](size_t val) { hash ^= val + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    combine(std::hash<void *>()(key.coordAdapter));
+    combine(QuadTreeNew::Node(key.x,key.y,key.level).key());
+    combine(std::hash<float>()(key.minZ));
+    combine(std::hash<float>()(key.maxZ));
+    
+    return hash;
+}
+
+DisplaySolidRef DisplaySolidCache::getDisplaySolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMbr,float minZ,float maxZ,CoordSystemRef srcSystem,CoordSystemDisplayAdapter *coordAdapter)
+{
+    Key key;
+    key.coordAdapter = coordAdapter;
+    key.x = nodeIdent.x;  key.y = nodeIdent.y;  key.level = nodeIdent.level;
+    key.minZ = minZ;  key.maxZ = maxZ;
+    key.ll = nodeMbr.ll();  key.ur = nodeMbr.ur();
+    
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        srcSystem = canonicalSystemNoLock(srcSystem);
+        key.srcSystem = srcSystem.get();
+        auto it = entryMap.find(key);
+        if (it != entryMap.end()) {
+            numHits++;
+            // Move it to the front
+            entries.splice(entries.begin(),entries,it->second);
+            return it->second->dispSolid;
+        }
+        numMisses++;
+    }
+    
+    // Building these is the expensive part, so do it outside the lock
+    DisplaySolidRef dispSolid(new DisplaySolid(nodeIdent,nodeMbr,minZ,maxZ,srcSystem.get(),coordAdapter));
+    
+    std::lock_guard<std::mutex> guardLock(lock);
+    // Someone else may have gotten there first
+    auto it = entryMap.find(key);
+    if (it != entryMap.end())
+        return it->second->dispSolid;
+    
+    Entry entry;
+    entry.key = key;
+    entry.srcSystem = srcSystem;
+    entry.dispSolid = dispSolid;
+    entries.push_front(entry);
+    entryMap[key] = entries.begin();
+    trimNoLock();
+    
+    return dispSolid;
+}
+
+CoordSystemRef DisplaySolidCache::canonicalSystemNoLock(CoordSystemRef srcSystem)
+{
+    for (const auto &system : srcSystems)
+        if (system == srcSystem || system->isSameAs(srcSystem.get()))
+            return system;
+    srcSystems.push_back(srcSystem);
+    
+    return srcSystem;
+}
+
+void DisplaySolidCache::trimNoLock()
+{
+    while (entries.size() > (size_t)maxEntries) {
+        entryMap.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+void DisplaySolidCache::setMaxEntries(int newMaxEntries)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxEntries = std::max(newMaxEntries,0);
+    trimNoLock();
+}
+
+int DisplaySolidCache::getMaxEntries()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return maxEntries;
+}
+
+int DisplaySolidCache::getNumEntries()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return entries.size();
+}
+
+int64_t DisplaySolidCache::getNumHits()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return numHits;
+}
+
+int64_t DisplaySolidCache::getNumMisses()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return numMisses;
+}
+
+void DisplaySolidCache::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    entries.clear();
+    entryMap.clear();
+    srcSystems.clear();
+    numHits = 0;
+    numMisses = 0;
+}
+    
 }
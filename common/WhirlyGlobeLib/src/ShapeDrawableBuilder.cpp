@@ -81,6 +81,8 @@ void ShapeDrawableBuilder::addPoints(Point3dVector &pts,RGBAColor color,Mbr mbr,
 
         drawable = sceneRender->makeBasicDrawableBuilder("Shape Manager");
         shapeInfo.setupBasicDrawable(drawable);
+        // Shapes can sit well above the surface
+        drawable->setCullByMbr(false);
         drawMbr.reset();
         drawable->setType(primType);
         // Adjust according to the vector info
@@ -184,6 +186,7 @@ void ShapeDrawableBuilderTri::setupNewDrawable()
 {
     drawable = sceneRender->makeBasicDrawableBuilder("Shape Layer");
     shapeInfo.setupBasicDrawable(drawable);
+    drawable->setCullByMbr(false);
     if (clipCoords)
         drawable->setClipCoords(true);
     drawMbr.reset();
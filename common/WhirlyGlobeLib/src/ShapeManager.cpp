@@ -29,6 +29,7 @@
 #import "GeometryManager.h"
 #import "FlatMath.h"
 #import "WhirlyKitLog.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -37,8 +38,10 @@ namespace WhirlyKit {
 
 void ShapeSceneRep::enableContents(WhirlyKit::SelectionManager *selectManager, bool enable, ChangeSet &changes)
 {
+    DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+    stateReq->reserve(drawIDs.size());
     for (const SimpleIdentity idIt : drawIDs){
-        changes.push_back(new OnOffChangeRequest(idIt, enable));
+        stateReq->addOnOff(idIt, enable);
         if (selectManager)
             for (const SimpleIdentity it : selectIDs)
                 selectManager->enableSelectable(it, enable);
@@ -763,8 +766,9 @@ void ShapeManager::removeShapes(SimpleIDSet &shapeIDs,ChangeSet &changes)
 
             TimeInterval removeTime = 0.0;
             if (shapeRep->fade > 0.0) {
+                DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
                 for (SimpleIDSet::iterator idIt = shapeRep->drawIDs.begin(); idIt != shapeRep->drawIDs.end(); ++idIt)
-                    changes.push_back(new FadeChangeRequest(*idIt, curTime, curTime+shapeRep->fade));
+                    stateReq->addFade(*idIt, curTime, curTime+shapeRep->fade);
             }
             
 			shapeRep->clearContents(selectManager, changes, removeTime);
@@ -24,6 +24,7 @@
 #import "SphericalEarthChunkManager.h"
 #import "WhirlyKitLog.h"
 #import "SharedAttributes.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 
@@ -423,8 +424,9 @@ bool SphericalChunkManager::modifyDrawPriority(SimpleIdentity chunkID,int drawPr
         }
     }
     
+    DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
     for (SimpleIDSet::iterator it = drawIDs.begin(); it != drawIDs.end(); ++it)
-        changes.push_back(new DrawPriorityChangeRequest(*it,drawPriority));
+        stateReq->addDrawPriority(*it,drawPriority);
     
     return true;
 }
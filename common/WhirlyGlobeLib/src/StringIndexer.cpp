@@ -60,6 +60,36 @@ std::string StringIndexer::getString(StringIdentity strID)
     
     return index.identToString[strID];
 }
+
+bool StringIndexer::findStringID(const std::string &str,StringIdentity &strID)
+{
+    StringIndexer &index = getInstance();
+    
+    std::lock_guard<std::mutex> lock(index.mutex);
+    
+    auto it = index.stringToIdent.find(str);
+    if (it == index.stringToIdent.end())
+        return false;
+    
+    strID = it->second;
+    return true;
+}
+
+StringIdentity StringIndexer::findStringIDs(const std::vector<std::string> &strs,std::vector<StringIdentity> &strIDs)
+{
+    StringIndexer &index = getInstance();
+    
+    std::lock_guard<std::mutex> lock(index.mutex);
+    
+    StringIdentity numStrings = index.identToString.size();
+    strIDs.resize(strs.size());
+    for (unsigned int ii=0;ii<strs.size();ii++) {
+        auto it = index.stringToIdent.find(strs[ii]);
+        strIDs[ii] = it == index.stringToIdent.end() ? numStrings : it->second;
+    }
+    
+    return numStrings;
+}
     
 // Shared global string IDs speed things up a lot
 StringIdentity baseMapNameIDs[WhirlyKitMaxTextures];
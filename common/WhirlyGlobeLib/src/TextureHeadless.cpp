@@ -0,0 +1,80 @@
+/*
+ *  TextureHeadless.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "TextureHeadless.h"
+
+namespace WhirlyKit
+{
+
+TextureHeadless::TextureHeadless(const std::string &name)
+: TextureBase(name), Texture(name), created(false), uploadSize(0)
+{
+}
+
+TextureHeadless::TextureHeadless(const std::string &name,RawDataRef texData,bool isPVRTC)
+: TextureBase(name), Texture(name,texData,isPVRTC), created(false), uploadSize(0)
+{
+}
+
+bool TextureHeadless::createInRenderer(const RenderSetupInfo *setupInfo)
+{
+    if (!texData && !isEmptyTexture)
+        return false;
+
+    // We'll only create this once
+    if (created)
+        return true;
+    created = true;
+
+    RawDataRef convertedData = processData();
+    if (convertedData)
+        uploadSize = convertedData->getLen();
+    texData.reset();
+
+    return true;
+}
+
+void TextureHeadless::destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene)
+{
+    created = false;
+}
+
+DynamicTextureHeadless::DynamicTextureHeadless(const std::string &name)
+: TextureBase(name), DynamicTexture(name)
+{
+}
+
+bool DynamicTextureHeadless::createInRenderer(const RenderSetupInfo *setupInfo)
+{
+    return true;
+}
+
+void DynamicTextureHeadless::destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene)
+{
+}
+
+void DynamicTextureHeadless::addTextureData(int startX,int startY,int width,int height,RawDataRef data)
+{
+}
+
+void DynamicTextureHeadless::clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
+{
+}
+
+}
@@ -25,6 +25,7 @@
 #import "GridClipper.h"
 #import "SharedAttributes.h"
 #import "Platform.h"
+#import "DrawableStateChange.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -758,19 +759,21 @@ void VectorManager::changeVectors(SimpleIdentity vecID,const VectorInfo &vecInfo
         SimpleIDSet allIDs = sceneRep->drawIDs;
         allIDs.insert(sceneRep->instIDs.begin(),sceneRep->instIDs.end());
 
+        DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(changes);
+        stateReq->reserve(4*allIDs.size());
         for (SimpleIDSet::iterator idIt = allIDs.begin();idIt != allIDs.end(); ++idIt)
         {
             // Changed color
-            changes.push_back(new ColorChangeRequest(*idIt, vecInfo.color));
+            stateReq->addColor(*idIt, vecInfo.color);
             
             // Changed visibility
-            changes.push_back(new VisibilityChangeRequest(*idIt, vecInfo.minVis, vecInfo.maxVis));
+            stateReq->addVisibility(*idIt, vecInfo.minVis, vecInfo.maxVis);
             
             // Changed line width
-            changes.push_back(new LineWidthChangeRequest(*idIt, vecInfo.lineWidth));
+            stateReq->addLineWidth(*idIt, vecInfo.lineWidth);
             
             // Changed draw priority
-            changes.push_back(new DrawPriorityChangeRequest(*idIt, vecInfo.drawPriority));
+            stateReq->addDrawPriority(*idIt, vecInfo.drawPriority);
         }
     }
 }
@@ -780,6 +783,7 @@ void VectorManager::removeVectors(SimpleIDSet &vecIDs,ChangeSet &changes)
     std::lock_guard<std::mutex> guardLock(vectorLock);
 
     TimeInterval curTime = scene->getCurrentTime();
+    SimpleIDSet remIDs;
     for (SimpleIDSet::iterator vit = vecIDs.begin(); vit != vecIDs.end(); ++vit)
     {
         VectorSceneRep dummyRep(*vit);
@@ -795,27 +799,36 @@ void VectorManager::removeVectors(SimpleIDSet &vecIDs,ChangeSet &changes)
             TimeInterval removeTime = 0.0;
             if (sceneRep->fade > 0.0)
             {
-                for (SimpleIDSet::iterator idIt = allIDs.begin();
-                     idIt != allIDs.end(); ++idIt)
-                    changes.push_back(new FadeChangeRequest(*idIt, curTime, curTime+sceneRep->fade));
+                DrawableState fadeState;
+                fadeState.setFade(curTime, curTime+sceneRep->fade);
+                BulkDrawableStateReq::AddTo(changes, fadeState)->addDrawIDs(allIDs);
                 
                 removeTime = curTime + sceneRep->fade;
             }
             
-            for (SimpleIDSet::iterator idIt = allIDs.begin();
-                 idIt != allIDs.end(); ++idIt)
-                changes.push_back(new RemDrawableReq(*idIt));
+            remIDs.insert(allIDs.begin(),allIDs.end());
             vectorReps.erase(it);
             
             delete sceneRep;
         }
     }
+    
+    // Remove all the drawables in one go
+    if (!remIDs.empty())
+    {
+        DrawableState remState;
+        remState.setRemove();
+        BulkDrawableStateReq::AddTo(changes, remState)->addDrawIDs(remIDs);
+    }
 }
     
 void VectorManager::enableVectors(SimpleIDSet &vecIDs,bool enable,ChangeSet &changes)
 {
     std::lock_guard<std::mutex> guardLock(vectorLock);
 
+    DrawableState state;
+    state.setOnOff(enable);
+    BulkDrawableStateReq *stateReq = NULL;
     for (SimpleIDSet::iterator vIt = vecIDs.begin();vIt != vecIDs.end();++vIt)
     {
         VectorSceneRep dummyRep(*vIt);
@@ -824,10 +837,10 @@ void VectorManager::enableVectors(SimpleIDSet &vecIDs,bool enable,ChangeSet &cha
         {
             VectorSceneRep *sceneRep = *it;
             
-            SimpleIDSet allIDs = sceneRep->drawIDs;
-            allIDs.insert(sceneRep->instIDs.begin(),sceneRep->instIDs.end());
-            for (SimpleIDSet::iterator idIt = allIDs.begin(); idIt != allIDs.end(); ++idIt)
-                changes.push_back(new OnOffChangeRequest(*idIt,enable));
+            if (!stateReq)
+                stateReq = BulkDrawableStateReq::AddTo(changes, state);
+            stateReq->addDrawIDs(sceneRep->drawIDs);
+            stateReq->addDrawIDs(sceneRep->instIDs);
         }
     }    
 }
@@ -252,6 +252,8 @@ int VertexAttribute::numElements() const
             return 0;
             break;
     }
+    
+    return 0;
 }
 
 /// Return the size of a single element
@@ -281,6 +283,8 @@ int VertexAttribute::size() const
             return 0;
             break;
     }
+    
+    return 0;
 }
 
 SingleVertexAttributeInfo::SingleVertexAttributeInfo()
@@ -319,6 +323,8 @@ int SingleVertexAttributeInfo::size() const
             return 0;
             break;
     }
+    
+    return 0;
 }
 
 SingleVertexAttribute::SingleVertexAttribute()
@@ -168,6 +168,8 @@ GLboolean VertexAttributeGLES::glNormalize() const
             return GL_FALSE;
             break;
     }
+    
+    return GL_FALSE;
 }
 
 /// Whether or not glVertexAttribPointer will normalize the data
@@ -189,6 +191,8 @@ GLboolean SingleVertexAttributeInfoGLES::glNormalize() const
             return GL_FALSE;
             break;
     }
+    
+    return GL_FALSE;
 }
 
 void VertexAttributeGLES::glSetDefault(int index) const
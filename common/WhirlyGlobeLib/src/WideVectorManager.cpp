@@ -23,6 +23,7 @@
 #import "FlatMath.h"
 #import "WhirlyKitLog.h"
 #import "SharedAttributes.h"
+#import "DrawableStateChange.h"
 
 using namespace WhirlyKit;
 using namespace Eigen;
@@ -717,20 +718,20 @@ WideVectorSceneRep::~WideVectorSceneRep()
 
 void WideVectorSceneRep::enableContents(bool enable,ChangeSet &changes)
 {
-    SimpleIDSet allIDs = drawIDs;
-    allIDs.insert(instIDs.begin(),instIDs.end());
-    for (SimpleIDSet::iterator it = allIDs.begin();
-         it != allIDs.end(); ++it)
-        changes.push_back(new OnOffChangeRequest(*it,enable));
+    DrawableState state;
+    state.setOnOff(enable);
+    BulkDrawableStateReq *stateReq = BulkDrawableStateReq::AddTo(changes, state);
+    stateReq->addDrawIDs(drawIDs);
+    stateReq->addDrawIDs(instIDs);
 }
 
 void WideVectorSceneRep::clearContents(ChangeSet &changes,TimeInterval when)
 {
-    SimpleIDSet allIDs = drawIDs;
-    allIDs.insert(instIDs.begin(),instIDs.end());
-    for (SimpleIDSet::iterator it = allIDs.begin();
-         it != allIDs.end(); ++it)
-        changes.push_back(new RemDrawableReq(*it,when));
+    DrawableState state;
+    state.setRemove();
+    BulkDrawableStateReq *stateReq = BulkDrawableStateReq::AddTo(changes, state, when);
+    stateReq->addDrawIDs(drawIDs);
+    stateReq->addDrawIDs(instIDs);
 }
 
 WideVectorManager::WideVectorManager()
@@ -817,13 +818,7 @@ void WideVectorManager::enableVectors(SimpleIDSet &vecIDs,bool enable,ChangeSet
         WideVectorSceneRep dummyRep(*vit);
         WideVectorSceneRepSet::iterator it = sceneReps.find(&dummyRep);
         if (it != sceneReps.end())
-        {
-            WideVectorSceneRep *vecRep = *it;
-            SimpleIDSet allIDs = vecRep->drawIDs;
-            allIDs.insert(vecRep->instIDs.begin(),vecRep->instIDs.end());
-            for (SimpleIDSet::iterator idIt = allIDs.begin(); idIt != allIDs.end(); ++idIt)
-                changes.push_back(new OnOffChangeRequest(*idIt,enable));
-        }
+            (*it)->enableContents(enable, changes);
     }
 }
     
@@ -890,11 +885,11 @@ void WideVectorManager::removeVectors(SimpleIDSet &vecIDs,ChangeSet &changes)
             TimeInterval removeTime = 0.0;
             if (sceneRep->fade > 0.0)
             {
-                SimpleIDSet allIDs = sceneRep->drawIDs;
-                allIDs.insert(sceneRep->instIDs.begin(),sceneRep->instIDs.end());
-                for (SimpleIDSet::iterator it = allIDs.begin();
-                     it != allIDs.end(); ++it)
-                    changes.push_back(new FadeChangeRequest(*it, curTime, curTime+sceneRep->fade));
+                DrawableState fadeState;
+                fadeState.setFade(curTime, curTime+sceneRep->fade);
+                BulkDrawableStateReq *stateReq = BulkDrawableStateReq::AddTo(changes, fadeState);
+                stateReq->addDrawIDs(sceneRep->drawIDs);
+                stateReq->addDrawIDs(sceneRep->instIDs);
                 
                 removeTime = curTime + sceneRep->fade;
             }
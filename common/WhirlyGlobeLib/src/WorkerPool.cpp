@@ -0,0 +1,108 @@
+/*
+ *  WorkerPool.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import "WorkerPool.h"
+
+namespace WhirlyKit
+{
+
+WorkerPool::WorkerPool(int numThreads)
+: curFunc(NULL), curCount(0), nextJob(0), pending(0), generation(0), shutdown(false)
+{
+    for (int ii=0;ii<numThreads;ii++)
+        threads.push_back(std::thread(&WorkerPool::workerMain,this));
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        shutdown = true;
+    }
+    workCond.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+int WorkerPool::DefaultNumThreads(int maxThreads)
+{
+    int numCores = (int)std::thread::hardware_concurrency();
+    return std::max(0,std::min(maxThreads,numCores-1));
+}
+
+void WorkerPool::parallelFor(int count,const std::function<void(int)> &func)
+{
+    if (count <= 0)
+        return;
+
+    // Not worth waking anyone up for, or the workers are busy with another caller
+    std::unique_lock<std::mutex> runGuard(runLock,std::defer_lock);
+    if (threads.empty() || count == 1 || !runGuard.try_lock())
+    {
+        for (int ii=0;ii<count;ii++)
+            func(ii);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        curFunc = &func;
+        curCount = count;
+        nextJob = 0;
+        pending = (int)threads.size();
+        generation++;
+    }
+    workCond.notify_all();
+
+    // Pitch in while we wait
+    for (int ii = nextJob++; ii < count; ii = nextJob++)
+        func(ii);
+
+    // Every worker has to check in before func can go out of scope
+    std::unique_lock<std::mutex> guardLock(lock);
+    doneCond.wait(guardLock,[this]{ return pending == 0; });
+    curFunc = NULL;
+}
+
+void WorkerPool::workerMain()
+{
+    unsigned int lastGeneration = 0;
+
+    std::unique_lock<std::mutex> guardLock(lock);
+    while (true)
+    {
+        workCond.wait(guardLock,[this,lastGeneration]{ return shutdown || generation != lastGeneration; });
+        if (shutdown)
+            break;
+        lastGeneration = generation;
+        const std::function<void(int)> *func = curFunc;
+        int count = curCount;
+        guardLock.unlock();
+
+        for (int ii = nextJob++; ii < count; ii = nextJob++)
+            (*func)(ii);
+
+        guardLock.lock();
+        if (--pending == 0)
+            doneCond.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ *  BenchmarkPlatform.cpp
+ *  WhirlyGlobeLib Benchmarks
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// Desktop versions of the few platform hooks the toolkit needs.
+// The benchmarks link these in place of the iOS or Android versions.
+// Dictionaries come from the Android version (Dictionary_Android.cpp), which is plain C++.
+
+#import <chrono>
+#import <cstdarg>
+#import <cstdio>
+#import "Platform.h"
+#import "WhirlyKitLog.h"
+#import "ComponentManager.h"
+
+namespace WhirlyKit
+{
+
+TimeInterval TimeGetCurrent()
+{
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+float DeviceScreenScale()
+{
+    return 1.0;
+}
+
+// Component objects don't need anything platform specific here
+class ComponentManagerBenchmark : public ComponentManager
+{
+protected:
+    virtual ComponentObjectRef makeComponentObject()
+    {
+        return ComponentObjectRef(new ComponentObject());
+    }
+};
+
+ComponentManager *MakeComponentManager()
+{
+    return new ComponentManagerBenchmark();
+}
+
+}
+
+void wkLog(const char *formatStr,...)
+{
+    va_list args;
+    va_start(args, formatStr);
+    vfprintf(stderr, formatStr, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
+
+static const char *levels[] = {"Verbose","Debug","Info","Warn","Error"};
+
+void wkLogLevel(WKLogLevel level,const char *formatStr,...)
+{
+    // Benchmarks only care about problems
+    if (level < Warn)
+        return;
+
+    va_list args;
+    va_start(args, formatStr);
+    fprintf(stderr, "%s: ", levels[level]);
+    vfprintf(stderr, formatStr, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
@@ -0,0 +1,380 @@
+/*
+ *  MapboxVectorFilterTest.cpp
+ *  WhirlyGlobeLib Benchmarks
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// Checks that MapboxVectorFilterSet gives the same answers as testing each
+//  MapboxVectorFilter on its own, which is what the style layers used to do.
+// Runs a set of filters like the ones in real style sheets, plus randomly built ones,
+//  over the same features as platform dictionaries and as vector tile attributes.
+//
+// Built as filtertest by the CMakeLists.txt in this directory and run by ctest.
+
+#import <cstdio>
+#import <cstring>
+#import <deque>
+#import <random>
+#import <string>
+#import <vector>
+#import "MapboxVectorFilter.h"
+#import "MapboxVectorStyleSetC.h"
+#import "MaplyVectorStyleC.h"
+#import "SceneRendererHeadless.h"
+#import "SphericalMercator.h"
+#import "Dictionary_Android.h"
+
+using namespace WhirlyKit;
+
+// Filters the way style sheets tend to write them.  Some tests show up more than once,
+//  which is what the filter set shares.
+static const char *StyleFilters[] = {
+    "[\"==\",\"$type\",\"Polygon\"]",
+    "[\"!=\",\"$type\",\"Point\"]",
+    "[\"all\",[\"==\",\"$type\",\"LineString\"],[\"in\",\"class\",\"motorway\",\"trunk\"]]",
+    "[\"all\",[\"==\",\"$type\",\"LineString\"],[\"!in\",\"class\",\"motorway\",\"trunk\",\"primary\"],[\"!=\",\"brunnel\",\"tunnel\"]]",
+    "[\"all\",[\"==\",\"$type\",\"LineString\"],[\"==\",\"brunnel\",\"tunnel\"],[\"in\",\"class\",\"motorway\",\"trunk\"]]",
+    "[\"any\",[\"==\",\"class\",\"park\"],[\"==\",\"class\",\"wood\"]]",
+    "[\"all\",[\"==\",\"$type\",\"Polygon\"],[\"any\",[\"==\",\"class\",\"park\"],[\"==\",\"class\",\"wood\"]]]",
+    "[\"none\",[\"has\",\"name\"],[\"==\",\"rank\",1]]",
+    "[\"has\",\"name\"]",
+    "[\"!has\",\"name\"]",
+    "[\"all\",[\"has\",\"name\"],[\"!has\",\"brunnel\"]]",
+    "[\"==\",\"rank\",3]",
+    "[\"==\",\"rank\",\"3\"]",
+    "[\"!=\",\"rank\",3]",
+    "[\">\",\"rank\",2]",
+    "[\">=\",\"rank\",2.5]",
+    "[\"<\",\"rank\",4]",
+    "[\"<=\",\"rank\",2]",
+    "[\"<\",\"class\",\"park\"]",
+    "[\"==\",\"oneway\",1]",
+    "[\"==\",\"oneway\",\"1\"]",
+    "[\"in\",\"rank\",1,2,\"3\"]",
+    "[\"!in\",\"rank\",1,2]",
+    "[\"in\",\"oneway\",1,\"yes\"]",
+    "[\"==\",\"admin_level\",2]",
+    "[\"all\",[\"<=\",\"admin_level\",4],[\"!=\",\"maritime\",1],[\"==\",\"$type\",\"LineString\"]]",
+    "[\"==\",\"class\",\"park\"]",
+    "[\"all\"]",
+    "[\"any\"]",
+    "[\"all\",[\"any\",[\"==\",\"class\",\"park\"],[\"has\",\"name\"]],[\"any\",[\"==\",\"class\",\"park\"],[\"has\",\"name\"]]]",
+};
+
+static const char *Classes[] = {"motorway","trunk","primary","street","path","park","wood","grass","school","cafe"};
+static const int NumClasses = sizeof(Classes)/sizeof(Classes[0]);
+static const char *Keys[] = {"class","rank","oneway","name","brunnel","admin_level","maritime"};
+static const int NumKeys = sizeof(Keys)/sizeof(Keys[0]);
+
+static std::mt19937 randGen(17);
+
+// A single test on one of the attributes we make up
+static std::string RandomTest()
+{
+    char str[200];
+    const char *class1 = Classes[randGen()%NumClasses], *class2 = Classes[randGen()%NumClasses];
+    const char *key = Keys[randGen()%NumKeys];
+    switch (randGen()%12)
+    {
+        case 0: snprintf(str,200,"[\"==\",\"class\",\"%s\"]",class1); break;
+        case 1: snprintf(str,200,"[\"!=\",\"class\",\"%s\"]",class1); break;
+        case 2: snprintf(str,200,"[\"in\",\"class\",\"%s\",\"%s\"]",class1,class2); break;
+        case 3: snprintf(str,200,"[\"!in\",\"class\",\"%s\",\"%s\"]",class1,class2); break;
+        case 4: snprintf(str,200,"[\"has\",\"%s\"]",key); break;
+        case 5: snprintf(str,200,"[\"!has\",\"%s\"]",key); break;
+        case 6: snprintf(str,200,"[\">\",\"rank\",%d]",(int)(randGen()%5)); break;
+        case 7: snprintf(str,200,"[\"<=\",\"rank\",%d.5]",(int)(randGen()%5)); break;
+        case 8: snprintf(str,200,"[\"==\",\"rank\",\"%d\"]",(int)(randGen()%5)); break;
+        case 9: snprintf(str,200,"[\"==\",\"$type\",\"%s\"]",randGen()%2 ? "Polygon" : "LineString"); break;
+        case 10: snprintf(str,200,"[\"==\",\"oneway\",%d]",(int)(randGen()%2)); break;
+        default: snprintf(str,200,"[\"in\",\"rank\",%d,\"%d\"]",(int)(randGen()%5),(int)(randGen()%5)); break;
+    }
+    return str;
+}
+
+static std::string RandomFilter(int depth)
+{
+    if (depth == 0 || randGen()%3 == 0)
+        return RandomTest();
+    static const char *combos[] = {"all","any","none"};
+    std::string str = std::string("[\"") + combos[randGen()%3] + "\"";
+    int numSub = 1 + randGen()%3;
+    for (int ii=0;ii<numSub;ii++)
+        str += "," + RandomFilter(depth-1);
+    return str + "]";
+}
+
+// Filters only need the style set to parse enums, so there's no platform behind this one
+class TestStyleSet : public MapboxVectorStyleSetImpl
+{
+public:
+    TestStyleSet(Scene *scene,CoordSystem *coordSys,VectorStyleSettingsImplRef settings)
+    : MapboxVectorStyleSetImpl(scene,coordSys,settings) { }
+
+    virtual SimpleIdentity makeCircleTexture(PlatformThreadInfo *inst,double radius,const RGBAColor &fillColor,
+                                             const RGBAColor &strokeColor,float strokeWidth,Point2f *circleSize)
+        { return EmptyIdentity; }
+    virtual SimpleIdentity makeLineTexture(PlatformThreadInfo *inst,const std::vector<double> &dashComponents)
+        { return EmptyIdentity; }
+    virtual LabelInfoRef makeLabelInfo(PlatformThreadInfo *inst,const std::string &fontName,float fontSize)
+        { return LabelInfoRef(); }
+    virtual SingleLabelRef makeSingleLabel(PlatformThreadInfo *inst,const std::string &text)
+        { return SingleLabelRef(); }
+    virtual void addSelectionObject(SimpleIdentity selectID,VectorObjectRef vecObj,ComponentObjectRef compObj)
+        { }
+    virtual double calculateTextWidth(PlatformThreadInfo *inInst,LabelInfoRef labelInfo,const std::string &testStr)
+        { return 0.0; }
+    virtual ComponentObjectRef makeComponentObject(PlatformThreadInfo *inst)
+        { return ComponentObjectRef(); }
+};
+
+// One attribute of a made up feature
+class TestAttr
+{
+public:
+    int key;
+    MVTValue::Type type;
+    std::string strVal;
+    int intVal;
+    double doubleVal;
+};
+
+class TestFeature
+{
+public:
+    int geomType;
+    std::vector<TestAttr> attrs;
+};
+
+static TestFeature RandomFeature()
+{
+    TestFeature feat;
+    feat.geomType = 1 + randGen()%3;
+    for (int key=0;key<NumKeys;key++)
+    {
+        if (randGen()%4 == 0)
+            continue;
+        TestAttr attr;
+        attr.key = key;
+        attr.type = MVTValue::Int;
+        attr.intVal = 0;
+        attr.doubleVal = 0.0;
+        switch (key)
+        {
+            case 0:
+                attr.type = MVTValue::String;
+                attr.strVal = Classes[randGen()%NumClasses];
+                break;
+            case 1:
+                // Ranks show up as numbers or strings, depending on who made the tiles
+                switch (randGen()%3)
+                {
+                    case 0:
+                        attr.type = MVTValue::String;
+                        attr.strVal = std::to_string(randGen()%5);
+                        break;
+                    case 1:
+                        attr.type = MVTValue::Double;
+                        attr.doubleVal = (randGen()%10) / 2.0;
+                        break;
+                    default:
+                        attr.intVal = randGen()%5;
+                        break;
+                }
+                break;
+            case 2:
+                if (randGen()%3 == 0)
+                {
+                    attr.type = MVTValue::String;
+                    attr.strVal = randGen()%2 ? "1" : "yes";
+                } else
+                    attr.intVal = randGen()%2;
+                break;
+            case 3:
+                attr.type = MVTValue::String;
+                attr.strVal = "Some Name";
+                break;
+            case 4:
+                attr.type = MVTValue::String;
+                attr.strVal = randGen()%2 ? "tunnel" : "bridge";
+                break;
+            default:
+                attr.intVal = randGen()%6;
+                break;
+        }
+        feat.attrs.push_back(attr);
+    }
+
+    return feat;
+}
+
+// The feature as a regular platform dictionary
+static MutableDictionaryRef MakeDictionary(const TestFeature &feat)
+{
+    MutableDictionary_AndroidRef dict(new MutableDictionary_Android());
+    dict->setString("layer_name","road");
+    dict->setInt("layer_order",0);
+    dict->setInt("geometry_type",feat.geomType);
+    for (const TestAttr &attr : feat.attrs)
+    {
+        switch (attr.type)
+        {
+            case MVTValue::String:
+                dict->setString(Keys[attr.key],attr.strVal);
+                break;
+            case MVTValue::Double:
+                dict->setDouble(Keys[attr.key],attr.doubleVal);
+                break;
+            default:
+                dict->setInt(Keys[attr.key],attr.intVal);
+                break;
+        }
+    }
+
+    return dict;
+}
+
+int main(int argc,char *argv[])
+{
+    // Style sets want a scene to look things up in, though the filters don't use it
+    SphericalMercatorDisplayAdapter *coordAdapter = new SphericalMercatorDisplayAdapter(0.0,GeoCoord::CoordFromDegrees(-180.0,-85.0511),GeoCoord::CoordFromDegrees(180.0,85.0511));
+    SceneHeadless *scene = new SceneHeadless(coordAdapter);
+    VectorStyleSettingsImplRef settings(new VectorStyleSettingsImpl(1.0));
+    MapboxVectorStyleSetImpl *styleSet = new TestStyleSet(scene,coordAdapter->getCoordSystem(),settings);
+
+    std::vector<std::string> filterStrs(StyleFilters,StyleFilters+sizeof(StyleFilters)/sizeof(StyleFilters[0]));
+    for (int ii=0;ii<200;ii++)
+        filterStrs.push_back(RandomFilter(3));
+    std::string json = "{\"filters\":[";
+    for (unsigned int ii=0;ii<filterStrs.size();ii++)
+        json += (ii ? "," : "") + filterStrs[ii];
+    json += "]}";
+    MutableDictionary_Android filterDict;
+    if (!filterDict.parseJSON(json))
+    {
+        fprintf(stderr,"Couldn't parse the test filters\n");
+        return 1;
+    }
+    std::vector<MapboxVectorFilterRef> filters;
+    MapboxVectorFilterSet filterSet;
+    // Every few layers has no filter at all
+    for (DictionaryEntryRef entry : filterDict.getArray("filters"))
+    {
+        MapboxVectorFilterRef filter;
+        if (filters.size() % 7 != 6)
+        {
+            filter = MapboxVectorFilterRef(new MapboxVectorFilter());
+            if (!filter->parse(entry->getArray(),styleSet))
+            {
+                fprintf(stderr,"Couldn't parse filter %d\n",(int)filters.size());
+                return 1;
+            }
+        }
+        filters.push_back(filter);
+        filterSet.addFilter(filter);
+    }
+
+    // The same features, in both forms
+    std::vector<TestFeature> testFeats;
+    for (int ii=0;ii<2000;ii++)
+        testFeats.push_back(RandomFeature());
+
+    std::vector<DictionaryRef> feats;
+    for (const TestFeature &feat : testFeats)
+        feats.push_back(MakeDictionary(feat));
+
+    // Vector tile attributes point into a layer's tables, which point into the tile data
+    std::deque<std::string> tileStrings;
+    MVTLayer layer;
+    tileStrings.push_back("road");
+    layer.name = MVTStringRef(tileStrings.back().data(),tileStrings.back().size());
+    for (const char *key : Keys)
+        layer.keys.push_back(MVTStringRef(key,strlen(key)));
+    std::vector<std::vector<uint32_t> > featTags;
+    for (const TestFeature &feat : testFeats)
+    {
+        std::vector<uint32_t> tags;
+        for (const TestAttr &attr : feat.attrs)
+        {
+            MVTValue val;
+            val.type = attr.type;
+            val.intVal = attr.intVal;
+            val.doubleVal = attr.doubleVal;
+            if (attr.type == MVTValue::String)
+            {
+                tileStrings.push_back(attr.strVal);
+                val.stringVal = MVTStringRef(tileStrings.back().data(),tileStrings.back().size());
+            }
+            tags.push_back(attr.key);
+            tags.push_back(layer.values.size());
+            layer.values.push_back(val);
+        }
+        featTags.push_back(tags);
+    }
+    MVTAttributeTableRef attrTable(new MVTAttributeTable(layer,0));
+    for (unsigned int ii=0;ii<testFeats.size();ii++)
+        feats.push_back(DictionaryRef(new MVTFeatureAttributes(attrTable,testFeats[ii].geomType,featTags[ii])));
+
+    // Test all the filters together and every third one on its own
+    std::vector<int> allFilters,someFilters;
+    for (unsigned int ii=0;ii<filters.size();ii++)
+    {
+        allFilters.push_back(ii);
+        if (ii % 3 == 1)
+            someFilters.push_back(ii);
+    }
+
+    QuadTreeIdentifier tileID(0,0,0);
+    int numMismatches = 0;
+    std::vector<int> passed;
+    for (unsigned int ii=0;ii<feats.size();ii++)
+    {
+        for (const std::vector<int> *which : {&allFilters,&someFilters})
+        {
+            std::vector<int> expected;
+            for (int filterIdx : *which)
+                if (!filters[filterIdx] || filters[filterIdx]->testFeature(feats[ii],tileID))
+                    expected.push_back(filterIdx);
+
+            filterSet.testFeature(feats[ii],tileID,*which,passed);
+
+            if (passed != expected)
+            {
+                if (numMismatches < 10)
+                {
+                    std::vector<int>::const_iterator exIt = expected.begin(),passIt = passed.begin();
+                    while (exIt != expected.end() && passIt != passed.end() && *exIt == *passIt)
+                    {
+                        exIt++;  passIt++;
+                    }
+                    int badFilter = (exIt != expected.end() && (passIt == passed.end() || *exIt < *passIt)) ? *exIt : *passIt;
+                    fprintf(stderr,"Feature %d (%s) differs on filter %d: %s\n",(int)(ii % testFeats.size()),
+                            ii < testFeats.size() ? "dictionary" : "vector tile",badFilter,filterStrs[badFilter].c_str());
+                }
+                numMismatches++;
+            }
+        }
+    }
+
+    printf("%d filters (%d nodes after sharing) over %d features: %d mismatches\n",
+           filterSet.numFilters(),filterSet.numNodes(),(int)feats.size(),numMismatches);
+
+    delete styleSet;
+    delete scene;
+    delete coordAdapter;
+
+    return numMismatches == 0 ? 0 : 1;
+}
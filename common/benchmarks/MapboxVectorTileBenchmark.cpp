@@ -0,0 +1,483 @@
+/*
+ *  MapboxVectorTileBenchmark.cpp
+ *  WhirlyGlobeLib Benchmarks
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// Compares the protobuf decode of Mapbox Vector Tiles with MapboxVectorTileReader,
+//  which walks the wire format directly.  Both decode every feature's tags and
+//  geometry in the layers we want and skip the others; the checksums have to match.
+//
+// Pass tile files (uncompressed .mvt/.pbf) or directories of them to run over real data.
+// With no tiles we make up a corpus that looks roughly like a dense street map.
+//
+// Built as mvtbench by the CMakeLists.txt in this directory.  Run with --help for options.
+
+#import <algorithm>
+#import <chrono>
+#import <cstdio>
+#import <cstdlib>
+#import <cstring>
+#import <dirent.h>
+#import <random>
+#import <set>
+#import <string>
+#import <sys/stat.h>
+#import <vector>
+#import "MapboxVectorTileReader.h"
+#import "vector_tile.pb.h"
+#import "WhirlyVector.h"
+
+using namespace WhirlyKit;
+
+// Settings from the command line
+class BenchmarkOptions
+{
+public:
+    BenchmarkOptions()
+    : numTiles(64), featuresPerTile(4000), repeats(10), seed(1)
+    { }
+
+    std::vector<std::string> paths;
+    std::set<std::string> skipLayers;
+    bool skipSet = false;
+    int numTiles;
+    int featuresPerTile;
+    int repeats;
+    unsigned int seed;
+};
+
+static void PrintUsage(const char *name)
+{
+    fprintf(stderr,"usage: %s [options] [tile files or directories]\n",name);
+    fprintf(stderr,"  --skip a,b,c    Layers to skip, as a style would (default building,housenum_label)\n");
+    fprintf(stderr,"  --tiles N       Synthetic tiles to make if none are given (default 64)\n");
+    fprintf(stderr,"  --features N    Features per synthetic tile (default 4000)\n");
+    fprintf(stderr,"  --repeats N     Times to decode the corpus (default 10)\n");
+    fprintf(stderr,"  --seed N        Random seed for the synthetic tiles (default 1)\n");
+}
+
+static bool ParseOptions(int argc,char *argv[],BenchmarkOptions &opts)
+{
+    for (int ii=1;ii<argc;ii++)
+    {
+        const char *arg = argv[ii];
+        bool hasNext = ii+1 < argc;
+        if (!strcmp(arg,"--skip") && hasNext)
+        {
+            opts.skipSet = true;
+            std::string names = argv[++ii];
+            size_t start = 0;
+            while (start <= names.size())
+            {
+                size_t comma = names.find(',',start);
+                if (comma == std::string::npos)
+                    comma = names.size();
+                if (comma > start)
+                    opts.skipLayers.insert(names.substr(start,comma-start));
+                start = comma+1;
+            }
+        } else if (!strcmp(arg,"--tiles") && hasNext)
+            opts.numTiles = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--features") && hasNext)
+            opts.featuresPerTile = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--repeats") && hasNext)
+            opts.repeats = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--seed") && hasNext)
+            opts.seed = atoi(argv[++ii]);
+        else if (arg[0] != '-')
+            opts.paths.push_back(arg);
+        else
+            return false;
+    }
+    if (!opts.skipSet)
+        opts.skipLayers = {"building","housenum_label"};
+
+    return opts.numTiles > 0 && opts.featuresPerTile > 0 && opts.repeats > 0;
+}
+
+static bool ReadFile(const std::string &path,std::string &data)
+{
+    FILE *fp = fopen(path.c_str(),"rb");
+    if (!fp)
+        return false;
+    data.clear();
+    char buf[65536];
+    size_t len;
+    while ((len = fread(buf,1,sizeof(buf),fp)) > 0)
+        data.append(buf,len);
+    fclose(fp);
+
+    return true;
+}
+
+// Pull in the given files and everything in the given directories
+static void LoadCorpus(const std::vector<std::string> &paths,std::vector<std::string> &tiles)
+{
+    for (const auto &path : paths)
+    {
+        struct stat info;
+        if (stat(path.c_str(),&info) != 0)
+        {
+            fprintf(stderr,"Can't find %s\n",path.c_str());
+            continue;
+        }
+        std::vector<std::string> files;
+        if (S_ISDIR(info.st_mode))
+        {
+            DIR *dir = opendir(path.c_str());
+            while (struct dirent *entry = dir ? readdir(dir) : NULL)
+                if (entry->d_name[0] != '.')
+                    files.push_back(path + "/" + entry->d_name);
+            if (dir)
+                closedir(dir);
+            std::sort(files.begin(),files.end());
+        } else
+            files.push_back(path);
+
+        for (const auto &file : files)
+        {
+            std::string data;
+            if (!ReadFile(file,data) || data.empty())
+                continue;
+            if (data.size() > 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b)
+            {
+                fprintf(stderr,"Skipping %s, which is gzipped.  Decompress it first.\n",file.c_str());
+                continue;
+            }
+            tiles.push_back(data);
+        }
+    }
+}
+
+static inline uint32_t ZigZag(int32_t val)
+{
+    return (uint32_t)((val << 1) ^ (val >> 31));
+}
+
+static inline uint32_t Command(int cmd,int count)
+{
+    return (uint32_t)((count << 3) | cmd);
+}
+
+// Make up a tile with the usual sort of layers in roughly the usual proportions
+static std::string MakeTile(std::mt19937 &randGen,int numFeatures)
+{
+    static const char *layerNames[] = {"water","landuse","road","building","poi_label","place_label","housenum_label","transportation_name"};
+    static const int geomTypes[] = {3,3,2,3,1,1,1,2};
+    static const double shares[] = {0.03,0.07,0.25,0.35,0.1,0.02,0.13,0.05};
+    static const char *classes[] = {"street","primary","secondary","residential","park","wood","grass","school","cafe","restaurant","bank","pharmacy"};
+    std::uniform_int_distribution<int> coordDist(0,4095);
+    std::uniform_int_distribution<int> stepDist(-60,60);
+    std::uniform_int_distribution<int> classDist(0,11);
+
+    vector_tile::Tile tile;
+    for (int li=0;li<8;li++)
+    {
+        vector_tile::Tile_Layer *layer = tile.add_layers();
+        layer->set_name(layerNames[li]);
+        layer->set_version(2);
+        layer->set_extent(4096);
+        for (const char *key : {"class","name","osm_id","rank","oneway"})
+            layer->add_keys(key);
+
+        // Shared values for the classes, then a unique name and ID per feature
+        for (const char *className : classes)
+            layer->add_values()->set_string_value(className);
+        for (int rank=0;rank<8;rank++)
+            layer->add_values()->set_int_value(rank);
+        layer->add_values()->set_bool_value(true);
+        layer->add_values()->set_bool_value(false);
+
+        int layerFeatures = std::max((int)(numFeatures * shares[li]),1);
+        for (int fi=0;fi<layerFeatures;fi++)
+        {
+            vector_tile::Tile_Feature *feat = layer->add_features();
+            feat->set_id(fi+1);
+            feat->set_type((vector_tile::Tile_GeomType)geomTypes[li]);
+
+            feat->add_tags(0);  feat->add_tags(classDist(randGen));
+            feat->add_tags(3);  feat->add_tags(12 + classDist(randGen) % 8);
+            if (geomTypes[li] == 2)
+            {
+                feat->add_tags(4);  feat->add_tags(20 + fi % 2);
+            }
+            if (geomTypes[li] != 3 || fi % 4 == 0)
+            {
+                char name[64];
+                snprintf(name,sizeof(name),"%s %d Street",classes[fi % 12],fi);
+                feat->add_tags(1);  feat->add_tags(layer->values_size());
+                layer->add_values()->set_string_value(name);
+                feat->add_tags(2);  feat->add_tags(layer->values_size());
+                layer->add_values()->set_uint_value(1000000 + fi);
+            }
+
+            // Geometry: a point, a wandering line or a closed ring (sometimes with a hole)
+            int x = coordDist(randGen), y = coordDist(randGen);
+            feat->add_geometry(Command(1,1));
+            feat->add_geometry(ZigZag(x));  feat->add_geometry(ZigZag(y));
+            if (geomTypes[li] == 1)
+                continue;
+            int numPts = geomTypes[li] == 2 ? 4 + classDist(randGen) : 3 + classDist(randGen) / 2;
+            feat->add_geometry(Command(2,numPts));
+            for (int pi=0;pi<numPts;pi++)
+            {
+                feat->add_geometry(ZigZag(stepDist(randGen)));
+                feat->add_geometry(ZigZag(stepDist(randGen)));
+            }
+            if (geomTypes[li] == 3)
+            {
+                feat->add_geometry(Command(7,1));
+                if (fi % 5 == 0)
+                {
+                    feat->add_geometry(Command(1,1));
+                    feat->add_geometry(ZigZag(5));  feat->add_geometry(ZigZag(5));
+                    feat->add_geometry(Command(2,2));
+                    feat->add_geometry(ZigZag(10));  feat->add_geometry(ZigZag(0));
+                    feat->add_geometry(ZigZag(0));  feat->add_geometry(ZigZag(10));
+                    feat->add_geometry(Command(7,1));
+                }
+            }
+        }
+    }
+
+    std::string data;
+    tile.SerializeToString(&data);
+    return data;
+}
+
+// What we pull out of a corpus, to make sure both decoders saw the same things
+class DecodeResults
+{
+public:
+    DecodeResults() : numLayers(0), numFeatures(0), numTags(0), numPoints(0), tagSum(0), coordSum(0.0) { }
+
+    bool operator == (const DecodeResults &that) const
+    {
+        return numLayers == that.numLayers && numFeatures == that.numFeatures && numTags == that.numTags &&
+               numPoints == that.numPoints && tagSum == that.tagSum && coordSum == that.coordSum;
+    }
+
+    size_t numLayers,numFeatures,numTags,numPoints;
+    uint64_t tagSum;
+    double coordSum;
+};
+
+// Run the geometry commands into points, the same way the tile parser does
+static void DecodeGeometry(const uint32_t *geom,int geomSize,double scale,std::vector<Point2f> &pts,DecodeResults &results)
+{
+    pts.clear();
+    double x = 0.0, y = 0.0;
+    unsigned length = 0;
+    int cmd = -1;
+    for (int k=0;k<geomSize;)
+    {
+        if (!length)
+        {
+            cmd = geom[k] & 0x7;
+            length = geom[k++] >> 3;
+            if (cmd == 2)
+                pts.reserve(pts.size()+length+1);
+            continue;
+        }
+        length--;
+        if (cmd == 1 || cmd == 2)
+        {
+            if (k+1 >= geomSize)
+                break;
+            int32_t dx = geom[k++], dy = geom[k++];
+            x += ((dx >> 1) ^ (-(dx & 1))) / scale;
+            y += ((dy >> 1) ^ (-(dy & 1))) / scale;
+            pts.push_back(Point2f(x,y));
+        } else if (cmd == 7 && !pts.empty())
+            pts.push_back(pts.front());
+    }
+
+    results.numPoints += pts.size();
+    for (const auto &pt : pts)
+        results.coordSum += pt.x() + pt.y();
+}
+
+static void DecodeProtobuf(const std::string &data,const std::set<std::string> &skipLayers,std::vector<Point2f> &pts,DecodeResults &results)
+{
+    vector_tile::Tile tile;
+    if (!tile.ParseFromArray(data.data(),(int)data.size()))
+        return;
+    for (int li=0;li<tile.layers_size();li++)
+    {
+        const vector_tile::Tile_Layer &layer = tile.layers(li);
+        if (skipLayers.find(layer.name()) != skipLayers.end())
+            continue;
+        results.numLayers++;
+        double scale = layer.extent() / 256.0;
+        for (int fi=0;fi<layer.features_size();fi++)
+        {
+            const vector_tile::Tile_Feature &feat = layer.features(fi);
+            results.numFeatures++;
+            for (int ti=0;ti+1<feat.tags_size();ti+=2)
+            {
+                uint32_t keyIdx = feat.tags(ti), valIdx = feat.tags(ti+1);
+                if (keyIdx >= (uint32_t)layer.keys_size() || valIdx >= (uint32_t)layer.values_size())
+                    continue;
+                const std::string &key = layer.keys(keyIdx);
+                const vector_tile::Tile_Value &value = layer.values(valIdx);
+                results.numTags++;
+                results.tagSum += key.size();
+                if (value.has_string_value())
+                    results.tagSum += value.string_value().size();
+                else if (value.has_int_value())
+                    results.tagSum += value.int_value();
+                else if (value.has_uint_value())
+                    results.tagSum += value.uint_value();
+                else if (value.has_sint_value())
+                    results.tagSum += value.sint_value();
+                else if (value.has_bool_value())
+                    results.tagSum += value.bool_value();
+                else if (value.has_double_value())
+                    results.tagSum += (uint64_t)value.double_value();
+                else if (value.has_float_value())
+                    results.tagSum += (uint64_t)value.float_value();
+            }
+            DecodeGeometry(feat.geometry().data(),feat.geometry_size(),scale,pts,results);
+        }
+    }
+}
+
+static void DecodeReader(const std::string &data,const std::set<std::string> &skipLayers,std::vector<uint32_t> &tags,std::vector<uint32_t> &geom,std::vector<Point2f> &pts,DecodeResults &results)
+{
+    MapboxVectorTileReader reader(data.data(),data.size());
+    MVTLayer layer;
+    while (reader.nextLayer(layer))
+    {
+        if (skipLayers.find(layer.name.str()) != skipLayers.end())
+            continue;
+        if (!layer.decodeTables())
+            return;
+        results.numLayers++;
+        double scale = layer.extent / 256.0;
+        MVTFeature feat;
+        while (layer.nextFeature(feat))
+        {
+            results.numFeatures++;
+            if (!feat.decodeTags(tags))
+                return;
+            for (unsigned int ti=0;ti+1<tags.size();ti+=2)
+            {
+                uint32_t keyIdx = tags[ti], valIdx = tags[ti+1];
+                if (keyIdx >= layer.keys.size() || valIdx >= layer.values.size())
+                    continue;
+                const MVTStringRef &key = layer.keys[keyIdx];
+                const MVTValue &value = layer.values[valIdx];
+                results.numTags++;
+                results.tagSum += key.len;
+                switch (value.type)
+                {
+                    case MVTValue::String:
+                        results.tagSum += value.stringVal.len;
+                        break;
+                    case MVTValue::Float:
+                    case MVTValue::Double:
+                        results.tagSum += (uint64_t)value.doubleVal;
+                        break;
+                    case MVTValue::Int:
+                    case MVTValue::UInt:
+                    case MVTValue::SInt:
+                    case MVTValue::Bool:
+                        results.tagSum += value.intVal;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if (!feat.decodeGeometry(geom))
+                return;
+            DecodeGeometry(geom.data(),(int)geom.size(),scale,pts,results);
+        }
+    }
+}
+
+int main(int argc,char *argv[])
+{
+    BenchmarkOptions opts;
+    if (!ParseOptions(argc,argv,opts))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> tiles;
+    LoadCorpus(opts.paths,tiles);
+    if (!opts.paths.empty() && tiles.empty())
+    {
+        fprintf(stderr,"No usable tiles found\n");
+        return 1;
+    }
+    bool synthetic = tiles.empty();
+    if (synthetic)
+    {
+        std::mt19937 randGen(opts.seed);
+        for (int ii=0;ii<opts.numTiles;ii++)
+            tiles.push_back(MakeTile(randGen,opts.featuresPerTile));
+    }
+    size_t totalBytes = 0;
+    for (const auto &tile : tiles)
+        totalBytes += tile.size();
+
+    printf("Vector tile decode: %d %s tiles, %.1f KB on average\n",(int)tiles.size(),synthetic ? "synthetic" : "real",totalBytes / 1024.0 / tiles.size());
+
+    int failures = 0;
+    std::set<std::string> noSkips;
+    for (int pass=0;pass<2;pass++)
+    {
+        const std::set<std::string> &skips = pass == 0 ? noSkips : opts.skipLayers;
+        if (pass == 1 && skips.empty())
+            break;
+
+        std::vector<uint32_t> tags,geom;
+        std::vector<Point2f> pts;
+        DecodeResults protoResults,readerResults;
+        double protoTime = 0.0,readerTime = 0.0;
+        for (int rep=0;rep<opts.repeats;rep++)
+        {
+            DecodeResults protoRep,readerRep;
+            auto start = std::chrono::steady_clock::now();
+            for (const auto &tile : tiles)
+                DecodeProtobuf(tile,skips,pts,protoRep);
+            auto mid = std::chrono::steady_clock::now();
+            for (const auto &tile : tiles)
+                DecodeReader(tile,skips,tags,geom,pts,readerRep);
+            auto end = std::chrono::steady_clock::now();
+            protoTime += std::chrono::duration<double>(mid - start).count();
+            readerTime += std::chrono::duration<double>(end - mid).count();
+            protoResults = protoRep;
+            readerResults = readerRep;
+        }
+
+        double numDecodes = (double)tiles.size() * opts.repeats;
+        printf("  %s: %d layers, %d features, %d tags, %d points per pass\n",pass == 0 ? "all layers" : "skipping layers",
+               (int)readerResults.numLayers,(int)readerResults.numFeatures,(int)readerResults.numTags,(int)readerResults.numPoints);
+        printf("    protobuf: %8.1f us per tile  %7.1f MB/s\n",protoTime / numDecodes * 1e6,totalBytes * opts.repeats / protoTime / 1e6);
+        printf("    reader:   %8.1f us per tile  %7.1f MB/s\n",readerTime / numDecodes * 1e6,totalBytes * opts.repeats / readerTime / 1e6);
+        printf("    speedup:  %8.2fx\n",readerTime > 0.0 ? protoTime / readerTime : 0.0);
+        if (!(protoResults == readerResults))
+        {
+            printf("    decoders disagree\n");
+            failures++;
+        }
+    }
+
+    return failures ? 1 : 0;
+}
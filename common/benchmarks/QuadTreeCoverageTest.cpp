@@ -0,0 +1,204 @@
+/*
+ *  QuadTreeCoverageTest.cpp
+ *  WhirlyGlobeLib Benchmarks
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// Checks that QuadTreeNew::calcCoverageVisible picks the same level and tiles as
+//  the implementation it replaced, which redid the visibility walk for each level it tried.
+// Runs tilted and flat views over a range of tile budgets, level loads and min levels,
+//  including budgets small enough that some levels don't fit.
+//
+// Built as coveragetest by the CMakeLists.txt in this directory and run by ctest.
+
+#import <cstdio>
+#import <random>
+#import <set>
+#import <vector>
+#import "QuadTreeNew.h"
+
+using namespace Eigen;
+using namespace WhirlyKit;
+
+// A camera looking down at the unit square, possibly tilted so tiles near
+//  the bottom of the screen look bigger than the ones near the top
+class TestQuadTree : public QuadTreeNew
+{
+public:
+    TestQuadTree(int minLevel,int maxLevel,const Point2d &center,const Point2d &halfSize,double pixelsPerUnit,double tilt)
+    : QuadTreeNew(MbrD(Point2d(0.0,0.0),Point2d(1.0,1.0)),minLevel,maxLevel),
+      center(center), halfSize(halfSize), pixelsPerUnit(pixelsPerUnit), tilt(tilt)
+    {
+    }
+
+    virtual double importance(const Node &node)
+    {
+        MbrD tileMbr = generateMbrForNode(node);
+        Point2d ll = tileMbr.ll(),ur = tileMbr.ur();
+        if (ur.x() < center.x()-halfSize.x() || ll.x() > center.x()+halfSize.x() ||
+            ur.y() < center.y()-halfSize.y() || ll.y() > center.y()+halfSize.y())
+            return 0.0;
+
+        // Closest part of the tile to the bottom of the screen
+        double closeY = std::max(ll.y(),center.y()-halfSize.y());
+        double scale = pixelsPerUnit * (1.0 + tilt * (center.y()+halfSize.y() - closeY) / (2.0*halfSize.y()));
+        double tileSize = (ur.x() - ll.x()) * scale;
+
+        return tileSize * tileSize;
+    }
+
+    virtual bool visible(const Node &node)
+    {
+        return importance(node) > 0.0;
+    }
+
+    Point2d center,halfSize;
+    double pixelsPerUnit,tilt;
+};
+
+// This is the visibility walk calcCoverageVisible used to do for each level it tried
+static bool OldEvalNodeVisible(QuadTreeNew *tree,QuadTreeNew::ImportantNode node,const std::vector<double> &minImportance,
+                               size_t maxNodes,const std::set<int> &levelsToLoad,int maxLevel,
+                               QuadTreeNew::ImportantNodeSet &visibleSet)
+{
+    node.importance = tree->importance(node);
+
+    if (node.level == tree->minLevel && node.importance < minImportance[node.level])
+        return true;
+
+    if (node.level != tree->minLevel && node.level <= maxLevel && node.importance == 0.0)
+        return true;
+
+    if (levelsToLoad.find(node.level) != levelsToLoad.end())
+        visibleSet.insert(node);
+
+    if (visibleSet.size() > maxNodes)
+        return false;
+
+    if (node.level < maxLevel) {
+        for (int iy=0;iy<2;iy++)
+            for (int ix=0;ix<2;ix++) {
+                QuadTreeNew::ImportantNode childNode(2*node.x + ix,2*node.y + iy,node.level+1);
+                if (!OldEvalNodeVisible(tree,childNode,minImportance,maxNodes,levelsToLoad,maxLevel,visibleSet))
+                    return false;
+            }
+    }
+
+    return true;
+}
+
+static std::tuple<int,QuadTreeNew::ImportantNodeSet> OldCalcCoverageVisible(QuadTreeNew *tree,const std::vector<double> &minImportance,
+                                                                          int maxNodes,const std::vector<int> &levelLoads,bool keepMinLevel)
+{
+    QuadTreeNew::ImportantNodeSet sortedNodes;
+    tree->evalNodeImportance(QuadTreeNew::ImportantNode(0,0,0),minImportance,sortedNodes);
+
+    int targetLevel = -1;
+    for (auto node: sortedNodes)
+        targetLevel = std::max(targetLevel,node.level);
+    targetLevel = std::max(targetLevel,tree->minLevel);
+
+    int chosenLevel = targetLevel;
+    QuadTreeNew::ImportantNodeSet chosenNodes;
+    while (chosenLevel >= tree->minLevel) {
+        std::set<int> levelsToLoad;
+        if (keepMinLevel)
+            levelsToLoad.insert(tree->minLevel);
+        levelsToLoad.insert(chosenLevel);
+        for (int level : levelLoads) {
+            if (level < 0)
+                level = targetLevel + level;
+            if (level >= 0 && level < tree->maxLevel)
+                levelsToLoad.insert(level);
+        }
+
+        QuadTreeNew::ImportantNodeSet levelNodes;
+        if (OldEvalNodeVisible(tree,QuadTreeNew::ImportantNode(0,0,0),minImportance,maxNodes,levelsToLoad,chosenLevel,levelNodes)) {
+            chosenNodes = levelNodes;
+            break;
+        }
+        chosenLevel--;
+    }
+
+    return std::make_tuple(chosenLevel,chosenNodes);
+}
+
+// Just the tile identities, since ImportantNode equality is loose about them
+static std::set<QuadTreeNew::Node> NodesOf(const QuadTreeNew::ImportantNodeSet &nodes)
+{
+    std::set<QuadTreeNew::Node> ret;
+    for (const auto &node : nodes)
+        ret.insert(node);
+    return ret;
+}
+
+int main(int argc,char *argv[])
+{
+    const int maxLevel = 14;
+    const std::vector<std::vector<int> > allLevelLoads = {{},{-1},{-3,-1},{3},{2,-2}};
+    const std::vector<int> budgets = {1,4,8,16,24,32,64,128,256};
+
+    std::mt19937 randGen(5);
+    std::uniform_real_distribution<double> unitDist(0.0,1.0);
+
+    int numCases = 0,numMismatches = 0,numOverBudget = 0;
+    for (int view=0;view<60;view++)
+    {
+        // Zoom from most of the world down to a city, flat and tilted
+        Point2d center(0.1 + 0.8*unitDist(randGen),0.1 + 0.8*unitDist(randGen));
+        double viewSize = pow(2.0,-10.0*unitDist(randGen));
+        Point2d halfSize(viewSize * 0.5,viewSize * 0.5 * (0.5 + unitDist(randGen)));
+        double pixelsPerUnit = 1024.0 / viewSize;
+        double tilt = (view % 3) * 2.0;
+
+        for (int minLevel : {0,2})
+        {
+            TestQuadTree tree(minLevel,maxLevel,center,halfSize,pixelsPerUnit,tilt);
+
+            // Same way the sampling controller sets them up
+            std::vector<double> minImportance(maxLevel+1,256.0*256.0);
+            for (int level=0;level<minLevel;level++)
+                minImportance[level] = MAXFLOAT;
+            minImportance[minLevel] = 0.0;
+
+            for (int maxNodes : budgets)
+                for (const auto &levelLoads : allLevelLoads)
+                    for (bool keepMinLevel : {false,true})
+                    {
+                        int oldLevel,newLevel;
+                        QuadTreeNew::ImportantNodeSet oldNodes,newNodes;
+                        std::tie(oldLevel,oldNodes) = OldCalcCoverageVisible(&tree,minImportance,maxNodes,levelLoads,keepMinLevel);
+                        std::tie(newLevel,newNodes) = tree.calcCoverageVisible(minImportance,maxNodes,levelLoads,keepMinLevel);
+                        numCases++;
+                        if (oldLevel < tree.minLevel)
+                            numOverBudget++;
+
+                        if (oldLevel != newLevel || oldNodes.size() != newNodes.size() || NodesOf(oldNodes) != NodesOf(newNodes))
+                        {
+                            if (numMismatches < 10)
+                                fprintf(stderr,"View %d, min level %d, %d nodes, %d level loads, keep min %s: level %d (%d nodes) should be %d (%d nodes)\n",
+                                        view,minLevel,maxNodes,(int)levelLoads.size(),keepMinLevel ? "yes" : "no",
+                                        newLevel,(int)newNodes.size(),oldLevel,(int)oldNodes.size());
+                            numMismatches++;
+                        }
+                    }
+        }
+    }
+
+    printf("%d coverage cases (%d with nothing in budget): %d mismatches\n",numCases,numOverBudget,numMismatches);
+
+    return numMismatches == 0 ? 0 : 1;
+}
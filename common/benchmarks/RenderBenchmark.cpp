@@ -0,0 +1,384 @@
+/*
+ *  RenderBenchmark.cpp
+ *  WhirlyGlobeLib Benchmarks
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// Renderer benchmark.  Builds a synthetic tiled map, flies a camera over it
+//  with the headless renderer and reports frame time percentiles.
+// It can also replay a recording of the changes (and view) from a real session.
+//
+// Built as renderbench by the CMakeLists.txt in this directory.  Run with --help for options.
+
+#import <algorithm>
+#import <chrono>
+#import <cstdio>
+#import <cstdlib>
+#import <cstring>
+#import <thread>
+#import <vector>
+#import "SceneRendererHeadless.h"
+#import "SphericalMercator.h"
+#import "MaplyView.h"
+#import "DrawableStateChange.h"
+#import "Profiler.h"
+#import "ChangeRecorder.h"
+
+using namespace Eigen;
+using namespace WhirlyKit;
+
+// A single camera position, in geographic degrees plus height
+class CameraPos
+{
+public:
+    double lon,lat,height;
+};
+
+// Settings from the command line
+class BenchmarkOptions
+{
+public:
+    BenchmarkOptions()
+    : numFrames(600), tileLevel(6), width(1920), height(1080), churn(true),
+      cullDrawables(true), changeBudget(0), realTime(false)
+    { }
+
+    int numFrames;
+    int tileLevel;
+    int width,height;
+    bool churn;
+    bool cullDrawables;
+    int changeBudget;
+    std::string pathFile;
+    std::string traceFile;
+    std::string recordFile;
+    std::string replayFile;
+    bool realTime;
+};
+
+static void PrintUsage(const char *name)
+{
+    fprintf(stderr,"usage: %s [options]\n",name);
+    fprintf(stderr,"  --frames N      Number of frames to render (default 600)\n");
+    fprintf(stderr,"  --level N       Tile level for the synthetic map, 4^N tiles (default 6)\n");
+    fprintf(stderr,"  --size WxH      Framebuffer size (default 1920x1080)\n");
+    fprintf(stderr,"  --path FILE     Camera path, one 'lon lat height' line per frame (degrees)\n");
+    fprintf(stderr,"  --no-churn      Don't change the scene while flying around\n");
+    fprintf(stderr,"  --no-cull       Turn off spatial culling\n");
+    fprintf(stderr,"  --budget N      Change processing budget in microseconds\n");
+    fprintf(stderr,"  --trace FILE    Write a Chrome trace of the run\n");
+    fprintf(stderr,"  --record FILE   Record the changes and view for each frame\n");
+    fprintf(stderr,"  --replay FILE   Replay a recording instead of the synthetic map\n");
+    fprintf(stderr,"  --realtime      Replay at the recorded speed rather than flat out\n");
+}
+
+static bool ParseOptions(int argc,char *argv[],BenchmarkOptions &opts)
+{
+    for (int ii=1;ii<argc;ii++)
+    {
+        const char *arg = argv[ii];
+        bool hasNext = ii+1 < argc;
+        if (!strcmp(arg,"--frames") && hasNext)
+            opts.numFrames = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--level") && hasNext)
+            opts.tileLevel = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--size") && hasNext)
+        {
+            if (sscanf(argv[++ii],"%dx%d",&opts.width,&opts.height) != 2)
+                return false;
+        } else if (!strcmp(arg,"--path") && hasNext)
+            opts.pathFile = argv[++ii];
+        else if (!strcmp(arg,"--no-churn"))
+            opts.churn = false;
+        else if (!strcmp(arg,"--no-cull"))
+            opts.cullDrawables = false;
+        else if (!strcmp(arg,"--budget") && hasNext)
+            opts.changeBudget = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--trace") && hasNext)
+            opts.traceFile = argv[++ii];
+        else if (!strcmp(arg,"--record") && hasNext)
+            opts.recordFile = argv[++ii];
+        else if (!strcmp(arg,"--replay") && hasNext)
+            opts.replayFile = argv[++ii];
+        else if (!strcmp(arg,"--realtime"))
+            opts.realTime = true;
+        else
+            return false;
+    }
+
+    return opts.numFrames > 0 && opts.tileLevel >= 0 && opts.tileLevel <= 10;
+}
+
+// Read a recorded camera path
+static bool ReadCameraPath(const std::string &fileName,std::vector<CameraPos> &path)
+{
+    FILE *fp = fopen(fileName.c_str(),"r");
+    if (!fp)
+        return false;
+
+    char line[1024];
+    while (fgets(line,sizeof(line),fp))
+    {
+        CameraPos pos;
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line,"%lf %lf %lf",&pos.lon,&pos.lat,&pos.height) == 3)
+            path.push_back(pos);
+    }
+    fclose(fp);
+
+    return !path.empty();
+}
+
+// Make up a path that pans around the world and zooms in and out
+static void MakeCameraPath(int numFrames,std::vector<CameraPos> &path)
+{
+    for (int ii=0;ii<numFrames;ii++)
+    {
+        double t = ii / (double)numFrames;
+        CameraPos pos;
+        pos.lon = -180.0 + 540.0 * t;
+        pos.lat = 50.0 * sin(t * 4.0 * M_PI);
+        pos.height = 0.05 + 1.5 * (0.5 + 0.5 * cos(t * 6.0 * M_PI));
+        path.push_back(pos);
+    }
+}
+
+// Build one tile's worth of geometry, a small grid over its bounds
+static BasicDrawable *MakeTile(SceneRenderer *renderer,CoordSystemDisplayAdapter *coordAdapter,
+                               const Point2d &ll,const Point2d &ur,SimpleIdentity texID,SimpleIdentity progID,int drawPriority)
+{
+    const int GridSize = 4;
+
+    BasicDrawableBuilderRef builder = renderer->makeBasicDrawableBuilder("Benchmark Tile");
+    builder->setType(Triangles);
+    builder->reserve((GridSize+1)*(GridSize+1),GridSize*GridSize*2);
+    builder->setTexId(0,texID);
+    builder->setProgram(progID);
+    builder->setDrawPriority(drawPriority);
+    builder->setLocalMbr(Mbr(Point2f(ll.x(),ll.y()),Point2f(ur.x(),ur.y())));
+    for (int iy=0;iy<=GridSize;iy++)
+        for (int ix=0;ix<=GridSize;ix++)
+        {
+            Point3d localPt(ll.x() + ix * (ur.x()-ll.x()) / GridSize,ll.y() + iy * (ur.y()-ll.y()) / GridSize,0.0);
+            builder->addPoint(coordAdapter->localToDisplay(localPt));
+            builder->addTexCoord(0,TexCoord(ix / (float)GridSize,iy / (float)GridSize));
+        }
+    for (int iy=0;iy<GridSize;iy++)
+        for (int ix=0;ix<GridSize;ix++)
+        {
+            int base = iy*(GridSize+1)+ix;
+            builder->addTriangle(BasicDrawable::Triangle(base,base+1,base+GridSize+2));
+            builder->addTriangle(BasicDrawable::Triangle(base,base+GridSize+2,base+GridSize+1));
+        }
+
+    return builder->getDrawable();
+}
+
+static double Percentile(const std::vector<double> &sorted,double pct)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t which = std::min(sorted.size()-1,(size_t)(pct / 100.0 * sorted.size()));
+    return sorted[which];
+}
+
+int main(int argc,char *argv[])
+{
+    BenchmarkOptions opts;
+    if (!ParseOptions(argc,argv,opts))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // A replay brings its own camera path
+    bool replaying = !opts.replayFile.empty();
+    std::vector<CameraPos> path;
+    if (!opts.pathFile.empty() && !replaying)
+    {
+        if (!ReadCameraPath(opts.pathFile,path))
+        {
+            fprintf(stderr,"Unable to read camera path from %s\n",opts.pathFile.c_str());
+            return 1;
+        }
+    } else if (!replaying)
+        MakeCameraPath(opts.numFrames,path);
+
+    if (!opts.traceFile.empty())
+        Profiler::SetEnabled(true);
+
+    // Flat map in spherical mercator, like most of the apps that use this
+    SphericalMercatorDisplayAdapter *coordAdapter = new SphericalMercatorDisplayAdapter(0.0,GeoCoord::CoordFromDegrees(-180.0,-85.0511),GeoCoord::CoordFromDegrees(180.0,85.0511));
+    CoordSystem *coordSys = coordAdapter->getCoordSystem();
+    SceneHeadless *scene = new SceneHeadless(coordAdapter);
+    Maply::MapView *mapView = new Maply::MapView(coordAdapter);
+    mapView->setWrap(true);
+    SceneRendererHeadless *renderer = new SceneRendererHeadless(opts.width,opts.height);
+    renderer->setScene(scene);
+    renderer->setView(mapView);
+    renderer->setUseDrawableCulling(opts.cullDrawables);
+    renderer->setChangeBudget(opts.changeBudget);
+
+    ChangeRecorderRef recorder;
+    if (!opts.recordFile.empty())
+    {
+        recorder = ChangeRecorderRef(new ChangeRecorder());
+        if (!recorder->open(opts.recordFile))
+        {
+            fprintf(stderr,"Unable to record to %s\n",opts.recordFile.c_str());
+            return 1;
+        }
+        scene->setChangeRecorder(recorder);
+    }
+
+    ChangeReplayer replayer(renderer,coordAdapter);
+    if (replaying && !replayer.open(opts.replayFile))
+    {
+        fprintf(stderr,"Unable to read recording from %s\n",opts.replayFile.c_str());
+        return 1;
+    }
+
+    // A handful of textures and programs so the sort has something to do
+    const int NumTextures = replaying ? 0 : 16;
+    const int NumPrograms = 3;
+    ChangeSet changes;
+    std::vector<SimpleIdentity> texIDs;
+    for (int ii=0;ii<NumTextures;ii++)
+    {
+        TextureHeadless *tex = new TextureHeadless("Benchmark Texture");
+        RawDataRef texData(new MutableRawData(4*4*4));
+        tex->texData = texData;
+        tex->setWidth(4);
+        tex->setHeight(4);
+        texIDs.push_back(tex->getId());
+        changes.push_back(new AddTextureReq(tex));
+    }
+
+    // Tiles covering the whole world
+    Point3d llLocal = coordSys->geographicToLocal3d(GeoCoord::CoordFromDegrees(-180.0,-85.0511));
+    Point3d urLocal = coordSys->geographicToLocal3d(GeoCoord::CoordFromDegrees(180.0,85.0511));
+    int numTilesSide = replaying ? 0 : 1<<opts.tileLevel;
+    std::vector<SimpleIdentity> tileIDs;
+    for (int iy=0;iy<numTilesSide;iy++)
+        for (int ix=0;ix<numTilesSide;ix++)
+        {
+            Point2d ll(llLocal.x() + ix * (urLocal.x()-llLocal.x()) / numTilesSide,llLocal.y() + iy * (urLocal.y()-llLocal.y()) / numTilesSide);
+            Point2d ur(llLocal.x() + (ix+1) * (urLocal.x()-llLocal.x()) / numTilesSide,llLocal.y() + (iy+1) * (urLocal.y()-llLocal.y()) / numTilesSide);
+            int which = iy*numTilesSide+ix;
+            BasicDrawable *draw = MakeTile(renderer,coordAdapter,ll,ur,texIDs[which % NumTextures],which % NumPrograms + 1,which % 4);
+            tileIDs.push_back(draw->getId());
+            changes.push_back(new AddDrawableReq(draw));
+        }
+    if (!changes.empty())
+        scene->addChangeRequests(changes);
+
+    // Fly the camera around
+    std::vector<double> frameTimes;
+    frameTimes.reserve(path.size());
+    double totalCommands = 0.0,totalCandidates = 0.0,totalChanges = 0.0;
+    TimeInterval now = 1.0,replayStart = 0.0;
+    auto wallStart = std::chrono::steady_clock::now();
+    for (unsigned int frame=0;replaying || frame<path.size();frame++)
+    {
+        if (replaying)
+        {
+            // The recording has the changes and view for each frame
+            ChangeReplayFrame replayFrame;
+            if (!replayer.nextFrame(replayFrame))
+                break;
+            if (!replayFrame.changes.empty())
+                scene->addChangeRequests(replayFrame.changes);
+            if (replayFrame.hasView)
+                mapView->setLoc(Point3d(replayFrame.eyePos.x(),replayFrame.eyePos.y(),replayFrame.heightAboveSurface));
+            if (frame == 0)
+                replayStart = replayFrame.time;
+            now = replayFrame.time;
+            if (opts.realTime)
+                std::this_thread::sleep_until(wallStart + std::chrono::duration<double>(now - replayStart));
+        } else {
+            const CameraPos &pos = path[frame];
+            Point3d loc = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord::CoordFromDegrees(pos.lon,pos.lat)));
+            mapView->setLoc(Point3d(loc.x(),loc.y(),pos.height));
+            now += 1.0/60.0;
+        }
+        scene->setCurrentTime(now);
+
+        // Turn a few tiles on and off, as a tile loader would
+        if (opts.churn && !replaying && frame % 10 == 0 && !tileIDs.empty())
+        {
+            ChangeSet frameChanges;
+            DrawableStateChangeRequest *stateReq = DrawableStateChangeRequest::AddTo(frameChanges);
+            for (unsigned int ii=frame % 97;ii<tileIDs.size();ii+=97)
+                stateReq->addOnOff(tileIDs[ii],(frame / 10) % 2 == 0);
+            scene->addChangeRequests(frameChanges);
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        renderer->render(1.0/60.0);
+        auto endTime = std::chrono::steady_clock::now();
+        frameTimes.push_back(std::chrono::duration<double,std::milli>(endTime-startTime).count());
+
+        const HeadlessFrameStats &stats = renderer->getFrameStats();
+        totalCommands += stats.numCommands;
+        totalCandidates += stats.numCandidates;
+        totalChanges += stats.numChanges;
+    }
+
+    // The first frame takes all the setup, so report it separately
+    double firstFrame = frameTimes.empty() ? 0.0 : frameTimes.front();
+    std::vector<double> sortedTimes(frameTimes.begin() + std::min((size_t)1,frameTimes.size()),frameTimes.end());
+    std::sort(sortedTimes.begin(),sortedTimes.end());
+    double sum = 0.0;
+    for (double t : sortedTimes)
+        sum += t;
+    int numFrames = (int)frameTimes.size();
+
+    printf("Headless render benchmark\n");
+    printf("  tiles: %d  frames: %d  size: %dx%d  culling: %s  churn: %s\n",
+           (int)tileIDs.size(),numFrames,opts.width,opts.height,opts.cullDrawables ? "on" : "off",opts.churn && !replaying ? "on" : "off");
+    printf("  first frame: %.3f ms\n",firstFrame);
+    printf("  frame time (ms): mean %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+           sortedTimes.empty() ? 0.0 : sum / sortedTimes.size(),
+           Percentile(sortedTimes,50.0),Percentile(sortedTimes,90.0),Percentile(sortedTimes,99.0),
+           sortedTimes.empty() ? 0.0 : sortedTimes.back());
+    printf("  per frame: %.1f draw calls  %.1f culling candidates  %.1f changes\n",
+           totalCommands / std::max(numFrames,1),totalCandidates / std::max(numFrames,1),totalChanges / std::max(numFrames,1));
+
+    if (replaying)
+        printf("  replayed %d changes from %s, skipped %d\n",replayer.getNumReplayed(),opts.replayFile.c_str(),replayer.getNumSkipped());
+    if (recorder)
+    {
+        scene->setChangeRecorder(ChangeRecorderRef());
+        recorder->close();
+        printf("  recorded %d changes to %s, %d unsupported\n",recorder->getNumRecorded(),opts.recordFile.c_str(),recorder->getNumUnsupported());
+    }
+
+    if (!opts.traceFile.empty())
+    {
+        if (Profiler::ExportChromeTrace(opts.traceFile))
+            printf("  trace written to %s\n",opts.traceFile.c_str());
+    }
+
+    renderer->setScene(NULL);
+    scene->teardown();
+    delete renderer;
+    delete mapView;
+    delete scene;
+    delete coordAdapter;
+
+    return 0;
+}
@@ -0,0 +1,336 @@
+/*
+ *  UnloadCheckBenchmark.cpp
+ *  WhirlyGlobeLib Benchmarks
+ *
+ *  Copyright 2011-2019 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// Micro-benchmark for QuadImageFrameLoader::builderUnloadCheck.
+// Builds synthetic coverage sets for a camera panning and zooming over a tile pyramid,
+//  fills in random frame states and times the unload check against the
+//  straightforward version it replaced.  The keep sets have to match.
+//
+// Built as unloadbench by the CMakeLists.txt in this directory.  Run with --help for options.
+
+#import <algorithm>
+#import <chrono>
+#import <cstdio>
+#import <cstdlib>
+#import <cstring>
+#import <random>
+#import <vector>
+#import "QuadImageFrameLoader.h"
+#import "SphericalMercator.h"
+
+using namespace Eigen;
+using namespace WhirlyKit;
+
+// Settings from the command line
+class BenchmarkOptions
+{
+public:
+    BenchmarkOptions()
+    : numFrames(16), depth(16), window(12), steps(200), repeats(5), seed(1)
+    { }
+
+    int numFrames;
+    int depth;
+    int window;
+    int steps;
+    int repeats;
+    unsigned int seed;
+};
+
+static void PrintUsage(const char *name)
+{
+    fprintf(stderr,"usage: %s [options]\n",name);
+    fprintf(stderr,"  --frames N      Frames per tile (default 16)\n");
+    fprintf(stderr,"  --depth N       Deepest level the camera zooms to (default 16)\n");
+    fprintf(stderr,"  --window N      Tiles on a side covered at each level (default 12)\n");
+    fprintf(stderr,"  --steps N       Number of camera moves (default 200)\n");
+    fprintf(stderr,"  --repeats N     Times to run the check per move (default 5)\n");
+    fprintf(stderr,"  --seed N        Random seed for the frame states (default 1)\n");
+}
+
+static bool ParseOptions(int argc,char *argv[],BenchmarkOptions &opts)
+{
+    for (int ii=1;ii<argc;ii++)
+    {
+        const char *arg = argv[ii];
+        bool hasNext = ii+1 < argc;
+        if (!strcmp(arg,"--frames") && hasNext)
+            opts.numFrames = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--depth") && hasNext)
+            opts.depth = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--window") && hasNext)
+            opts.window = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--steps") && hasNext)
+            opts.steps = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--repeats") && hasNext)
+            opts.repeats = atoi(argv[++ii]);
+        else if (!strcmp(arg,"--seed") && hasNext)
+            opts.seed = atoi(argv[++ii]);
+        else
+            return false;
+    }
+
+    return opts.numFrames > 0 && opts.depth > 0 && opts.depth <= 29 && opts.window > 0 && opts.steps > 0 && opts.repeats > 0;
+}
+
+// Tile asset that just uses the base frame assets
+class BenchTileAsset : public QIFTileAsset
+{
+public:
+    BenchTileAsset(const QuadTreeNew::ImportantNode &ident) : QIFTileAsset(ident) { }
+
+protected:
+    virtual QIFFrameAssetRef makeFrameAsset(PlatformThreadInfo *threadInfo,QuadFrameInfoRef frameInfo,QuadImageFrameLoader *) override
+    {
+        return QIFFrameAssetRef(new QIFFrameAsset(frameInfo));
+    }
+};
+
+// Loader we can fill in directly, with no fetcher or scene behind it
+class BenchLoader : public QuadImageFrameLoader
+{
+public:
+    BenchLoader(const SamplingParams &params,int numFrames,QuadTileBuilder *inBuilder)
+    : QuadImageFrameLoader(params,numFrames > 1 ? MultiFrame : SingleFrame)
+    {
+        for (int ii=0;ii<numFrames;ii++)
+        {
+            QuadFrameInfoRef frame(new QuadFrameInfo());
+            frame->frameIndex = ii;
+            frames.push_back(frame);
+        }
+        // The unload check only wants to know we're set up
+        builder = inBuilder;
+    }
+
+    // Add a tile with frames in the given states
+    void addTile(const QuadTreeNew::Node &node,const std::vector<QIFFrameAsset::State> &states)
+    {
+        std::vector<Texture *> noTexs;
+        auto tile = makeTileAsset(NULL,QuadTreeNew::ImportantNode(node,1.0));
+        for (unsigned int ii=0;ii<states.size();ii++)
+        {
+            auto frame = tile->getFrame(ii);
+            if (states[ii] == QIFFrameAsset::Loading)
+                frame->setupFetch(this);
+            else if (states[ii] == QIFFrameAsset::Loaded)
+                frame->loadSuccess(NULL,this,noTexs);
+        }
+        tiles[node] = tile;
+    }
+
+    void clearTiles()
+    {
+        tiles.clear();
+    }
+
+    // The unload check as it was, walking up from every node with set lookups
+    QuadTreeNew::NodeSet referenceUnloadCheck(const QuadTreeNew::ImportantNodeSet &loadTiles,
+                                              const QuadTreeNew::NodeSet &unloadTiles,
+                                              int targetLevel)
+    {
+        QuadTreeNew::NodeSet toKeep;
+        auto theActiveFrames = getActiveFrames();
+
+        QuadTreeNew::NodeSet allLoads;
+        for (auto node : loadTiles)
+            allLoads.insert(node);
+        for (auto node : tiles)
+            if (node.second->anyFramesLoading(theActiveFrames))
+                allLoads.insert(node.first);
+
+        for (auto node : allLoads)
+        {
+            auto parent = node;
+            while (parent.level > 0)
+            {
+                parent.level -= 1; parent.x /= 2;  parent.y /= 2;
+                if (unloadTiles.find(parent) != unloadTiles.end())
+                {
+                    auto it = tiles.find(parent);
+                    if (it != tiles.end() && it->second->anyFramesLoaded(theActiveFrames))
+                    {
+                        toKeep.insert(parent);
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (auto node : unloadTiles)
+        {
+            auto it = tiles.find(node);
+            if (it == tiles.end())
+                continue;
+            if (!it->second->anyFramesLoaded(theActiveFrames))
+                continue;
+
+            if (toKeep.find(node) == toKeep.end())
+            {
+                auto parent = node;
+                while (parent.level > 0)
+                {
+                    parent.level -= 1; parent.x /= 2;  parent.y /= 2;
+                    if (allLoads.find(parent) != allLoads.end())
+                    {
+                        toKeep.insert(node);
+                        break;
+                    }
+                }
+            }
+        }
+
+        return toKeep;
+    }
+
+protected:
+    virtual QIFTileAssetRef makeTileAsset(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident) override
+    {
+        auto tile = QIFTileAssetRef(new BenchTileAsset(ident));
+        tile->setupFrames(threadInfo,this,frames.size());
+        return tile;
+    }
+
+    virtual QIFBatchOps *makeBatchOps(PlatformThreadInfo *threadInfo) override
+    {
+        return new QIFBatchOps();
+    }
+
+    virtual void processBatchOps(PlatformThreadInfo *threadInfo,QIFBatchOps *) override
+    {
+    }
+};
+
+// Tiles a camera over the given spot would cover, a window at each level down to depth
+static void MakeCoverage(double cx,double cy,int depth,int window,QuadTreeNew::NodeSet &nodes)
+{
+    nodes.clear();
+    for (int level=0;level<=depth;level++)
+    {
+        int numSide = 1<<level;
+        int ix = (int)(cx * numSide), iy = (int)(cy * numSide);
+        int sx = std::max(ix - window/2,0), sy = std::max(iy - window/2,0);
+        int ex = std::min(sx + window,numSide), ey = std::min(sy + window,numSide);
+        for (int y=sy;y<ey;y++)
+            for (int x=sx;x<ex;x++)
+                nodes.insert(QuadTreeNew::Node(x,y,level));
+    }
+}
+
+int main(int argc,char *argv[])
+{
+    BenchmarkOptions opts;
+    if (!ParseOptions(argc,argv,opts))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    CoordSystemRef coordSys(new SphericalMercatorCoordSystem());
+    SamplingParams params;
+    params.coordSys = coordSys;
+    params.minZoom = 0;
+    params.maxZoom = opts.depth;
+
+    // The builder is never used, it just has to be there
+    QuadTileBuilder *builder = new QuadTileBuilder(coordSys,NULL);
+    BenchLoader loader(params,opts.numFrames,builder);
+
+    std::mt19937 randGen(opts.seed);
+    std::uniform_real_distribution<double> unitDist(0.0,1.0);
+
+    // The camera wanders around and zooms in and out
+    double cx = 0.5, cy = 0.5;
+    int depth = std::max(opts.depth/2,1);
+    QuadTreeNew::NodeSet curNodes,newNodes;
+    MakeCoverage(cx,cy,depth,opts.window,curNodes);
+
+    double newTime = 0.0,refTime = 0.0;
+    int totalKeep = 0,mismatches = 0;
+    size_t totalTiles = 0;
+    for (int step=0;step<opts.steps;step++)
+    {
+        // Move a few tiles' worth at the current level
+        double tileSize = 1.0 / (1<<depth);
+        cx = std::min(std::max(cx + (unitDist(randGen) - 0.5) * 4.0 * tileSize,0.0),1.0 - 1e-9);
+        cy = std::min(std::max(cy + (unitDist(randGen) - 0.5) * 4.0 * tileSize,0.0),1.0 - 1e-9);
+        double zoom = unitDist(randGen);
+        if (zoom < 0.3 && depth < opts.depth)
+            depth++;
+        else if (zoom > 0.8 && depth > 1)
+            depth--;
+        MakeCoverage(cx,cy,depth,opts.window,newNodes);
+
+        // What's there now, with frames in a mix of states
+        loader.clearTiles();
+        std::vector<QIFFrameAsset::State> states(opts.numFrames);
+        for (const auto &node : curNodes)
+        {
+            for (auto &state : states)
+            {
+                double which = unitDist(randGen);
+                state = which < 0.6 ? QIFFrameAsset::Loaded : (which < 0.85 ? QIFFrameAsset::Loading : QIFFrameAsset::Empty);
+            }
+            loader.addTile(node,states);
+        }
+        totalTiles += curNodes.size();
+
+        QuadTreeNew::ImportantNodeSet loadTiles;
+        QuadTreeNew::NodeSet unloadTiles;
+        for (const auto &node : newNodes)
+            if (curNodes.find(node) == curNodes.end())
+                loadTiles.insert(QuadTreeNew::ImportantNode(node,1.0));
+        for (const auto &node : curNodes)
+            if (newNodes.find(node) == newNodes.end())
+                unloadTiles.insert(node);
+
+        QuadTreeNew::NodeSet newKeep,refKeep;
+        auto start = std::chrono::steady_clock::now();
+        for (int ii=0;ii<opts.repeats;ii++)
+            newKeep = loader.builderUnloadCheck(builder,loadTiles,unloadTiles,depth);
+        auto mid = std::chrono::steady_clock::now();
+        for (int ii=0;ii<opts.repeats;ii++)
+            refKeep = loader.referenceUnloadCheck(loadTiles,unloadTiles,depth);
+        auto end = std::chrono::steady_clock::now();
+        newTime += std::chrono::duration<double>(mid - start).count();
+        refTime += std::chrono::duration<double>(end - mid).count();
+
+        if (newKeep != refKeep)
+            mismatches++;
+        totalKeep += newKeep.size();
+
+        curNodes.swap(newNodes);
+    }
+    loader.clearTiles();
+
+    int numChecks = opts.steps * opts.repeats;
+    printf("Unload check: %d frames, %.0f tiles on average, %.1f kept on average\n",opts.numFrames,(double)totalTiles / opts.steps,(double)totalKeep / opts.steps);
+    printf("  current:   %8.1f us per check\n",newTime / numChecks * 1e6);
+    printf("  reference: %8.1f us per check\n",refTime / numChecks * 1e6);
+    printf("  speedup:   %8.2fx\n",newTime > 0.0 ? refTime / newTime : 0.0);
+    if (mismatches > 0)
+    {
+        printf("  %d of %d keep sets didn't match\n",mismatches,opts.steps);
+        return 1;
+    }
+
+    delete builder;
+
+    return 0;
+}
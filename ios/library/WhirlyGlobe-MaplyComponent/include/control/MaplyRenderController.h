@@ -89,6 +89,33 @@ typedef NS_ENUM(NSInteger, MaplyRenderType) {
  */
 @property (nonatomic,assign) int screenObjectDrawPriorityOffset;
 
+/**
+ Limit the time spent applying changes each frame.
+ 
+ Loading lots of data can produce more changes than the renderer can apply in one frame.  If this is set (in microseconds) the renderer stops once it's used up that much time and leaves the rest for later frames.  Interactive changes, like screen space layout, go ahead of tile loading.
+ 
+ Defaults to 0, which means no limit.
+ */
+@property (nonatomic,assign) int changeBudget;
+
+/**
+ Record where the time goes in the renderer and the loading threads.
+ 
+ When this is on each thread keeps its most recent timings in a small buffer.  Call exportProfile: to write them out.  This is shared by all the render controllers in the app.
+ 
+ Defaults to off.
+ */
+@property (nonatomic,assign) bool profilingEnabled;
+
+/**
+ Write out what's been recorded since profiling was turned on.
+ 
+ The file is a Chrome trace, which can be opened with chrome://tracing or Perfetto.  Each frame is tagged so timings can be lined up across threads.
+ 
+ @return Returns false if the file couldn't be written.
+ */
+- (bool)exportProfile:(NSString *__nonnull)fileName;
+
 /**
  Clear all the currently active lights.
  
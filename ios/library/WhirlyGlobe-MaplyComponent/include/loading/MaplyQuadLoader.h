@@ -58,6 +58,14 @@
 /// You can set it and the system will deal with the results
 @property (nonatomic,strong) NSError * __nullable error;
 
+/** Elevation for the tile, as a grid of heights.
+ 
+    The data is sizeX*sizeY floats, in meters, spanning the tile edge to edge.
+    Rows run from the north down, the same as image data.
+    This only displaces the tile geometry if the sampling params have includeElev set.
+  */
+- (void)setElevationGrid:(NSData * __nonnull)elevData sizeX:(int)sizeX sizeY:(int)sizeY;
+
 @end
 
 /**
@@ -109,6 +117,15 @@
 /// Set for a lot of debugging output
 @property (nonatomic,assign) bool debugMode;
 
+/**
+ Limit the number of tile frames being fetched at once.
+ 
+ The rest wait their turn, most important first.  Tiles that scroll out of view before their turn are never fetched.
+ 
+ Default value is 0, which means no limit.
+ */
+@property (nonatomic) int maxFetchesInFlight;
+
 /// View controller this is attached to.
 /// Useful for delegate calls that might not be tracking that.
 @property (nonatomic,readonly,weak,nullable) NSObject<MaplyRenderControllerProtocol> *viewC;
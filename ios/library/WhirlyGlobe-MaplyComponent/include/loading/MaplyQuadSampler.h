@@ -57,6 +57,9 @@
 /// If set, generate skirt geometry to hide the edges between levels
 @property (nonatomic) bool edgeMatching;
 
+/// If set, displace the tile geometry by whatever elevation the loaders provide
+@property (nonatomic) bool includeElev;
+
 /// Tesselation values per level for breaking down the coordinate system (e.g. globe)
 @property (nonatomic) int tessX,tessY;
 
@@ -81,6 +84,16 @@
  */
 @property (nonatomic,nullable,strong) NSArray *levelLoads;
 
+/**
+ Load tiles for where the camera is headed.
+ 
+ If set, the camera's motion is extrapolated this many seconds out and the tiles it would need there are loaded too.  Those are fetched after the visible tiles.  0 turns this off, which is the default.
+ */
+@property (nonatomic) double prefetchLookAhead;
+
+/// Maximum number of tiles to load ahead of the camera.  This is separate from maxTiles.
+@property (nonatomic) int maxPrefetchTiles;
+
 /**
  Set the min importance for just one level.
  
@@ -66,6 +66,9 @@
         
     /// Used to be screen objects were always drawn last.  Now that's optional.
     int screenDrawPriorityOffset;
+
+    /// Time (in microseconds) the renderer can spend on changes each frame.  0 means no limit.
+    int changeBudget;
     
     /// The thread this render controller started on.  Usually it'll be the main thread.
     NSThread * __weak mainThread;
@@ -192,6 +192,31 @@ using namespace WhirlyKit;
     return renderControl.screenObjectDrawPriorityOffset;
 }
 
+- (void)setChangeBudget:(int)changeBudget
+{
+    renderControl.changeBudget = changeBudget;
+}
+
+- (int)changeBudget
+{
+    return renderControl.changeBudget;
+}
+
+- (void)setProfilingEnabled:(bool)profilingEnabled
+{
+    renderControl.profilingEnabled = profilingEnabled;
+}
+
+- (bool)profilingEnabled
+{
+    return renderControl.profilingEnabled;
+}
+
+- (bool)exportProfile:(NSString *)fileName
+{
+    return [renderControl exportProfile:fileName];
+}
+
 // Kick off the analytics logic.  First we need the server name.
 - (void)startAnalytics
 {
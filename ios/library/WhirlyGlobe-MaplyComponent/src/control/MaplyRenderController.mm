@@ -31,6 +31,7 @@
 #import "SceneRendererMTL.h"
 #import "MaplyActiveObject_private.h"
 #import "MaplyRenderTarget_private.h"
+#import "Profiler.h"
 
 using namespace WhirlyKit;
 using namespace Eigen;
@@ -212,6 +213,7 @@ using namespace Eigen;
 
     sceneRenderer->setZBufferMode(zBufferOffDefault);
     sceneRenderer->setClearColor([[UIColor blackColor] asRGBAColor]);
+    sceneRenderer->setChangeBudget(changeBudget);
     
     // Turn on the model matrix optimization for drawing
     sceneRenderer->setUseViewChanged(true);
@@ -281,6 +283,36 @@ using namespace Eigen;
     return screenDrawPriorityOffset;
 }
 
+- (void)setChangeBudget:(int)budgetMicros
+{
+    changeBudget = budgetMicros;
+    if (sceneRenderer)
+        sceneRenderer->setChangeBudget(changeBudget);
+}
+
+- (int)changeBudget
+{
+    return changeBudget;
+}
+
+- (void)setProfilingEnabled:(bool)profilingEnabled
+{
+    Profiler::SetEnabled(profilingEnabled);
+}
+
+- (bool)profilingEnabled
+{
+    return Profiler::IsEnabled();
+}
+
+- (bool)exportProfile:(NSString *)fileName
+{
+    if (!fileName)
+        return false;
+    
+    return Profiler::ExportChromeTrace([fileName cStringUsingEncoding:NSUTF8StringEncoding]);
+}
+
 - (UIImage *)renderToImage
 {
     if (!sceneRenderer)
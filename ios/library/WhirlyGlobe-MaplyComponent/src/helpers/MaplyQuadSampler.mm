@@ -121,6 +121,16 @@ using namespace WhirlyKit;
     params.edgeMatching = edgeMatching;
 }
 
+- (bool)includeElev
+{
+    return params.includeElev;
+}
+
+- (void)setIncludeElev:(bool)includeElev
+{
+    params.includeElev = includeElev;
+}
+
 - (int)tessX
 {
     return params.tessX;
@@ -194,6 +204,26 @@ using namespace WhirlyKit;
         params.levelLoads.push_back([num integerValue]);
 }
 
+- (double)prefetchLookAhead
+{
+    return params.prefetchLookAhead;
+}
+
+- (void)setPrefetchLookAhead:(double)prefetchLookAhead
+{
+    params.prefetchLookAhead = prefetchLookAhead;
+}
+
+- (int)maxPrefetchTiles
+{
+    return params.maxPrefetchTiles;
+}
+
+- (void)setMaxPrefetchTiles:(int)maxPrefetchTiles
+{
+    params.maxPrefetchTiles = maxPrefetchTiles;
+}
+
 - (bool)isEqualTo:(MaplySamplingParams *__nonnull)other
 {
     return params == other->params;
@@ -90,6 +90,15 @@ using namespace WhirlyKit;
     loadReturn->hasError = true;
 }
 
+- (void)setElevationGrid:(NSData *)elevData sizeX:(int)sizeX sizeY:(int)sizeY
+{
+    if (sizeX < 2 || sizeY < 2 || [elevData length] != sizeX*sizeY*sizeof(float))
+        return;
+    
+    const float *elevs = (const float *)[elevData bytes];
+    loadReturn->elevChunk = ElevationChunkRef(new ElevationGridChunk(sizeX,sizeY,std::vector<float>(elevs,elevs+sizeX*sizeY)));
+}
+
 @end
 
 @implementation MaplyQuadLoaderBase
@@ -108,6 +117,22 @@ using namespace WhirlyKit;
     return true;
 }
 
+- (void)setMaxFetchesInFlight:(int)maxFetchesInFlight
+{
+    if (!loader)
+        return;
+    
+    loader->setMaxFetchesInFlight(maxFetchesInFlight);
+}
+
+- (int)maxFetchesInFlight
+{
+    if (!loader)
+        return 0;
+    
+    return loader->getMaxFetchesInFlight();
+}
+
 - (bool)isLoading
 {
     // Maybe we're still setting up
@@ -305,7 +330,7 @@ using namespace WhirlyKit;
     [self performSelector:@selector(mergeFetchRequest:) onThread:self->samplingLayer.layerThread withObject:loadData waitUntilDone:NO];
 }
 
-// Called on SamplingLayer.layerThread
+// Called on a random dispatch queue
 - (void)fetchRequestFail:(MaplyTileFetchRequest *)request tileID:(MaplyTileID)tileID frame:(int)frame error:(NSError *)error
 {
     if (!loader || !valid)
@@ -313,6 +338,38 @@ using namespace WhirlyKit;
     // Note: Need to do something more here for single frame cases
     
     NSLog(@"MaplyQuadLoader: Failed to fetch tile %d: (%d,%d) frame %d because:\n%@",tileID.level,tileID.x,tileID.y,frame,[error localizedDescription]);
+    
+    // Tell the loader so the frame stops counting as in flight.
+    // The generation is set here, like the success case, so a reload in the mean time will catch it.
+    MaplyLoaderReturn *loadReturn = [self makeLoaderReturn];
+    loadReturn.tileID = tileID;
+    loadReturn.error = error;
+    
+    [self performSelector:@selector(mergeFetchFail:) onThread:self->samplingLayer.layerThread withObject:@[loadReturn,@(frame)] waitUntilDone:NO];
+}
+
+// Called on the SamplingLayer.LayerThread
+- (void)mergeFetchFail:(NSArray *)failInfo
+{
+    if (!loader || !valid)
+        return;
+    
+    MaplyLoaderReturn *loadReturn = failInfo[0];
+    int frame = [failInfo[1] intValue];
+    QuadFrameInfoRef frameInfo = loader->getFrameInfo(frame);
+    if (!frameInfo)
+        return;
+    loadReturn->loadReturn->frame = frameInfo;
+    
+    // Same check as a successful fetch, so we don't fail a frame we've since stopped loading
+    QuadTreeIdentifier tileID = loadReturn->loadReturn->ident;
+    if (!loader->isFrameLoading(tileID,frameInfo)) {
+        if (_debugMode)
+            NSLog(@"MaplyQuadImageLoader: Dropping failed tile %d: (%d,%d) frame %d",tileID.level,tileID.x,tileID.y,frame);
+        return;
+    }
+    
+    [self mergeLoadedTile:loadReturn];
 }
 
 - (void)tileUnloaded:(MaplyTileID)tileID {
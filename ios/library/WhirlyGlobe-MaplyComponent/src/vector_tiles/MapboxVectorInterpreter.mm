@@ -94,6 +94,8 @@ static int BackImageWidth = 16, BackImageHeight = 16;
     imageTileParser = MapboxVectorTileParserRef(new MapboxVectorTileParser(imageStyle));
     imageTileParser->localCoords = true;
     vecTileParser = MapboxVectorTileParserRef(new MapboxVectorTileParser(vecStyle));
+    // Fills and lines for dense tiles can be built in parallel
+    vecTileParser->buildPool = WorkerPoolRef(new WorkerPool(WorkerPool::DefaultNumThreads(3)));
     
     return self;
 }
@@ -112,6 +114,8 @@ static int BackImageWidth = 16, BackImageHeight = 16;
         vecStyle = VectorStyleDelegateImplRef(new VectorStyleDelegateWrapper(viewC,inVectorStyle));
 
     vecTileParser = MapboxVectorTileParserRef(new MapboxVectorTileParser(vecStyle));
+    // Fills and lines for dense tiles can be built in parallel
+    vecTileParser->buildPool = WorkerPoolRef(new WorkerPool(WorkerPool::DefaultNumThreads(3)));
     
     return self;
 }
@@ -449,6 +449,10 @@ void MapboxVectorStyleSetImpl_iOS::addSelectionObject(SimpleIdentity selectID,Ve
     
     ComponentManager_iOS *compManage_iOS = (ComponentManager_iOS *)compManage;
     
+    // The app will see the attributes as an NSDictionary, so they can't be the shared vector tile ones
+    if (vecObj->getAttributes() && !std::dynamic_pointer_cast<iosMutableDictionary>(vecObj->getAttributes()))
+        vecObj = vecObj->deepCopy();
+    
     MaplyVectorObject *vectorObj = [[MaplyVectorObject alloc] initWithRef:vecObj];
     compManage_iOS->addSelectObject(selectID, vectorObj);
 }
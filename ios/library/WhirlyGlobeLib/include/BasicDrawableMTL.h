@@ -39,6 +39,23 @@ public:
     RawDataRef blockData;
 };
     
+/** Metal version of the shared triangles.
+    The index buffer is made by the first drawable that needs it.
+  */
+class SharedTrianglesMTL : public SharedTriangles
+{
+public:
+    SharedTrianglesMTL(const std::vector<BasicDrawable::Triangle> &tris);
+    
+    /// Return the index buffer, creating it if need be
+    id<MTLBuffer> getBuffer(id<MTLDevice> mtlDevice);
+    
+protected:
+    std::mutex lock;
+    id<MTLBuffer> triBuffer;
+};
+typedef std::shared_ptr<SharedTrianglesMTL> SharedTrianglesMTLRef;
+    
 /** Metal Version of the BasicDrawable.
  */
 class BasicDrawableMTL : virtual public BasicDrawable, virtual public DrawableMTL
@@ -86,6 +103,7 @@ public:
 
     bool setupForMTL;
     std::vector<Triangle> tris;
+    SharedTrianglesMTLRef sharedTris;  // If set, we draw with these rather than tris
     int numPts,numTris;
     id<MTLRenderPipelineState> renderState; // Cacheable render state
     MTLVertexDescriptor *vertDesc;     // Description of vertices
@@ -75,7 +75,7 @@ public:
     virtual void loadFailed(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader) override;
     
     // We're not bothering to load it, but pretend like it succeeded
-    virtual void loadSkipped() override;
+    virtual void loadSkipped(QuadImageFrameLoader *loader) override;
 
 protected:
     // Returned by the TileFetcher
@@ -132,6 +132,10 @@ public:
     /// Construct a renderer-specific dynamic texture
     virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const;
     
+    /// Construct a renderer-specific texture
+    virtual TextureRef makeTexture(const std::string &name) const;
+    virtual SharedTrianglesRef makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const;
+    
     /// Set up the buffer for general uniforms and attach it to its vertex/fragment buffers
     void setupUniformBuffer(RendererFrameInfoMTL *frameInfo,id<MTLRenderCommandEncoder> cmdEncode,CoordSystemDisplayAdapter *coordAdapter,int texLevel);
 
@@ -99,7 +99,12 @@ BasicDrawable *BasicDrawableBuilderMTL::getDrawable()
         ptsAttr->reserve(points.size());
         for (auto pt : points)
             ptsAttr->addVector3f(pt);
-        draw->tris = tris;
+        if (sharedTris) {
+            draw->sharedTris = std::dynamic_pointer_cast<SharedTrianglesMTL>(sharedTris);
+            if (!draw->sharedTris)
+                draw->tris = sharedTris->getTriangles();
+        } else
+            draw->tris = tris;
         
         drawableGotten = true;
     }
@@ -31,6 +31,22 @@ using namespace Eigen;
 namespace WhirlyKit
 {
     
+SharedTrianglesMTL::SharedTrianglesMTL(const std::vector<BasicDrawable::Triangle> &tris)
+: SharedTriangles(tris), triBuffer(nil)
+{
+}
+
+id<MTLBuffer> SharedTrianglesMTL::getBuffer(id<MTLDevice> mtlDevice)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (!triBuffer && !tris.empty()) {
+        triBuffer = [mtlDevice newBufferWithBytes:&tris[0] length:3*2*tris.size() options:MTLStorageModeShared];
+        [triBuffer setLabel:@"Shared tri buffer"];
+    }
+    
+    return triBuffer;
+}
+
 BasicDrawableMTL::BasicDrawableMTL(const std::string &name)
     : BasicDrawable(name), Drawable(name), triBuffer(nil), setupForMTL(false), vertDesc(nil), renderState(nil), numPts(0), numTris(0)
 {
@@ -76,7 +92,11 @@ void BasicDrawableMTL::setupForRenderer(const RenderSetupInfo *inSetupInfo)
     // Note: Could use 1 byte some of the time
     int bufferSize = 3*2*tris.size();
     numTris = tris.size();
-    if (bufferSize > 0) {
+    if (sharedTris) {
+        // Other drawables are using the same buffer
+        triBuffer = sharedTris->getBuffer(setupInfo->mtlDevice);
+        numTris = sharedTris->getNumTris();
+    } else if (bufferSize > 0) {
         triBuffer = [setupInfo->mtlDevice newBufferWithBytes:&tris[0] length:bufferSize options:MTLStorageModeShared];
         if (!name.empty())
             [triBuffer setLabel:[NSString stringWithFormat:@"%s tri buffer",name.c_str()]];
@@ -106,9 +106,9 @@ void QIFFrameAsset_ios::loadFailed(PlatformThreadInfo *threadInfo,QuadImageFrame
     request = nil;
 }
     
-void QIFFrameAsset_ios::loadSkipped()
+void QIFFrameAsset_ios::loadSkipped(QuadImageFrameLoader *loader)
 {
-    QIFFrameAsset::loadSkipped();
+    QIFFrameAsset::loadSkipped(loader);
     request = nil;
 }
     
@@ -163,7 +163,7 @@ void QIFTileAsset_ios::startFetching(PlatformThreadInfo *threadInfo,QuadImageFra
                         [batchOps->toStart addObject:request];
                     }
                 } else
-                    frameAsset->loadSkipped();
+                    frameAsset->loadSkipped(loader);
             }
             whichFrame++;
         }
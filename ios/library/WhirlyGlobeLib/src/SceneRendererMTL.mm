@@ -32,11 +32,32 @@
 #import "DefaultShadersMTL.h"
 #import "RawData_NSData.h"
 #import "RenderTargetMTL.h"
+#import "Profiler.h"
 
 using namespace Eigen;
 
 namespace WhirlyKit
 {
+
+// Names for the performance timer and profiler, interned once
+static const ProfileID ProfRenderFrame = Profiler::RegisterName("Render Frame");
+static const ProfileID ProfRenderSetup = Profiler::RegisterName("Render Setup");
+static const ProfileID ProfScenePreprocessing = Profiler::RegisterName("Scene preprocessing");
+static const ProfileID ProfPreprocessChanges = Profiler::RegisterName("Preprocess Changes");
+static const ProfileID ProfActiveModelRuns = Profiler::RegisterName("Active Model Runs");
+static const ProfileID ProfActiveModels = Profiler::RegisterName("Active Models");
+static const ProfileID ProfSceneChanges = Profiler::RegisterName("Scene changes");
+static const ProfileID ProfSceneProcessing = Profiler::RegisterName("Scene processing");
+static const ProfileID ProfDrawablesDrawn = Profiler::RegisterName("Drawables drawn");
+static const ProfileID ProfEncodeRenderTarget = Profiler::RegisterName("Encode Render Target");
+static const ProfileID ProfWaitForRender = Profiler::RegisterName("Wait for Render");
+// One per work group type, in the same order as WorkGroup::GroupType
+static const ProfileID ProfWorkGroups[] = {
+    Profiler::RegisterName("Work Group: Calculation"),
+    Profiler::RegisterName("Work Group: Offscreen"),
+    Profiler::RegisterName("Work Group: Reduce"),
+    Profiler::RegisterName("Work Group: Screen Render")
+};
     
 RendererFrameInfoMTL::RendererFrameInfoMTL()
 {
@@ -299,6 +320,8 @@ void SceneRendererMTL::render(TimeInterval duration,
     SceneMTL *sceneMTL = (SceneMTL *)scene;
     
     frameCount++;
+    Profiler::BeginFrame();
+    bool profiling = perfInterval > 0 || Profiler::IsEnabled();
     
     TimeInterval now = scene->getCurrentTime();
 
@@ -311,11 +334,11 @@ void SceneRendererMTL::render(TimeInterval duration,
     
     lastDraw = now;
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Render Frame");
+    if (profiling)
+        perfTimer.startTiming(ProfRenderFrame);
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Render Setup");
+    if (profiling)
+        perfTimer.startTiming(ProfRenderSetup);
 
     // See if we're dealing with a globe or map view
     Maply::MapView *mapView = dynamic_cast<Maply::MapView *>(theView);
@@ -343,8 +366,8 @@ void SceneRendererMTL::render(TimeInterval duration,
     Eigen::Matrix4d modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
     Eigen::Matrix4f modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
 
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Render Setup");
+    if (profiling)
+        perfTimer.stopTiming(ProfRenderSetup);
 
     // Note: Make this more general
     auto defaultTarget = renderTargets.back();
@@ -400,37 +423,37 @@ void SceneRendererMTL::render(TimeInterval duration,
     baseFrameInfo.heightAboveSurface = theView->heightAboveSurface();
     baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Scene preprocessing");
+    if (profiling)
+        perfTimer.startTiming(ProfScenePreprocessing);
     
     // Run the preprocess for the changes.  These modify things the active models need.
     int numPreProcessChanges = preProcessScene(now);;
     
-    if (perfInterval > 0)
-        perfTimer.addCount("Preprocess Changes", numPreProcessChanges);
+    if (profiling)
+        perfTimer.addCount(ProfPreprocessChanges, numPreProcessChanges);
     
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Scene preprocessing");
+    if (profiling)
+        perfTimer.stopTiming(ProfScenePreprocessing);
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Active Model Runs");
+    if (profiling)
+        perfTimer.startTiming(ProfActiveModelRuns);
     
     // Let the active models to their thing
     // That thing had better not take too long
     for (auto activeModel : scene->activeModels) {
         activeModel->updateForFrame(&baseFrameInfo);
     }
-    if (perfInterval > 0)
-        perfTimer.addCount("Active Models", (int)scene->activeModels.size());
+    if (profiling)
+        perfTimer.addCount(ProfActiveModels, (int)scene->activeModels.size());
     
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Active Model Runs");
+    if (profiling)
+        perfTimer.stopTiming(ProfActiveModelRuns);
     
-    if (perfInterval > 0)
-        perfTimer.addCount("Scene changes", (int)scene->changeRequests.size());
+    if (profiling)
+        perfTimer.addCount(ProfSceneChanges, scene->getNumChangeRequests());
     
-    if (perfInterval > 0)
-        perfTimer.startTiming("Scene processing");
+    if (profiling)
+        perfTimer.startTiming(ProfSceneProcessing);
     
     // Merge any outstanding changes into the scenegraph
     processScene(now);
@@ -438,8 +461,8 @@ void SceneRendererMTL::render(TimeInterval duration,
     // Update our work groups accordingly
     updateWorkGroups(&baseFrameInfo);
     
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Scene processing");
+    if (profiling)
+        perfTimer.stopTiming(ProfSceneProcessing);
     
     // Work through the available offset matrices (only 1 if we're not wrapping)
     std::vector<Matrix4d> &offsetMats = baseFrameInfo.offsetMatrices;
@@ -481,10 +504,11 @@ void SceneRendererMTL::render(TimeInterval duration,
 
     // Workgroups force us to draw things in order
     for (auto &workGroup : workGroups) {
-        if (perfInterval > 0)
-            perfTimer.startTiming("Work Group: " + workGroup->name);
+        if (profiling)
+            perfTimer.startTiming(ProfWorkGroups[workGroup->groupType]);
 
         for (auto &targetContainer : workGroup->renderTargetContainers) {
+            ProfileScope encodeScope(ProfEncodeRenderTarget);
             RenderTargetMTLRef renderTarget;
             if (!targetContainer->renderTarget) {
                 // Need some sort of render target even if we're not really rendering
@@ -711,16 +735,21 @@ void SceneRendererMTL::render(TimeInterval duration,
             [cmdBuff commit];
             
             // This happens for offline rendering and we want to wait until the render finishes to return it
-            if (!drawGetter)
+            if (!drawGetter) {
+                ProfileScope waitScope(ProfWaitForRender);
                 [cmdBuff waitUntilCompleted];
+            }
         }
                 
-        if (perfInterval > 0)
-            perfTimer.stopTiming("Work Group: " + workGroup->name);
+        if (profiling)
+            perfTimer.stopTiming(ProfWorkGroups[workGroup->groupType]);
     }
         
-    if (perfInterval > 0)
-        perfTimer.stopTiming("Render Frame");
+    if (profiling)
+    {
+        perfTimer.addCount(ProfDrawablesDrawn, numDrawables);
+        perfTimer.stopTiming(ProfRenderFrame);
+    }
     
     // Update the frames per sec
     if (perfInterval > 0 && frameCount > perfInterval)
@@ -825,5 +854,15 @@ DynamicTextureRef SceneRendererMTL::makeDynamicTexture(const std::string &name)
     return DynamicTextureRef(new DynamicTextureMTL(name));
 }
 
+TextureRef SceneRendererMTL::makeTexture(const std::string &name) const
+{
+    return TextureRef(new TextureMTL(name));
+}
+
+SharedTrianglesRef SceneRendererMTL::makeSharedTriangles(const std::vector<BasicDrawable::Triangle> &tris) const
+{
+    return SharedTrianglesRef(new SharedTrianglesMTL(tris));
+}
+
     
 }